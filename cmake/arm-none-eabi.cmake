@@ -0,0 +1,37 @@
+# arm-none-eabi-gcc 交叉編譯 (STM32F103C8：Cortex-M3，無 FPU)
+#
+#   cmake -S . -B build-arm -DCMAKE_TOOLCHAIN_FILE=cmake/arm-none-eabi.cmake
+#
+# toolchain 不在 PATH 時以 -DARM_TOOLCHAIN_DIR=<安裝目錄>/bin 指定。
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(ARM_TOOLCHAIN_DIR "" CACHE PATH "arm-none-eabi-gcc 所在目錄 (空白 = 使用 PATH)")
+if(ARM_TOOLCHAIN_DIR)
+    set(ARM_TOOLCHAIN_PREFIX ${ARM_TOOLCHAIN_DIR}/arm-none-eabi-)
+else()
+    set(ARM_TOOLCHAIN_PREFIX arm-none-eabi-)
+endif()
+
+set(CMAKE_C_COMPILER ${ARM_TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_ASM_COMPILER ${ARM_TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_AR ${ARM_TOOLCHAIN_PREFIX}ar CACHE FILEPATH "")
+set(CMAKE_RANLIB ${ARM_TOOLCHAIN_PREFIX}ranlib CACHE FILEPATH "")
+set(CMAKE_NM ${ARM_TOOLCHAIN_PREFIX}nm CACHE FILEPATH "")
+set(CMAKE_OBJCOPY ${ARM_TOOLCHAIN_PREFIX}objcopy CACHE FILEPATH "")
+set(CMAKE_OBJDUMP ${ARM_TOOLCHAIN_PREFIX}objdump CACHE FILEPATH "")
+set(CMAKE_SIZE ${ARM_TOOLCHAIN_PREFIX}size CACHE FILEPATH "")
+
+# 沒有 OS，編譯器檢查只建立靜態函式庫，不連結
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+set(ARM_CPU_FLAGS "-mcpu=cortex-m3 -mthumb -mfloat-abi=soft")
+set(CMAKE_C_FLAGS_INIT "${ARM_CPU_FLAGS} --specs=nano.specs")
+set(CMAKE_ASM_FLAGS_INIT "${ARM_CPU_FLAGS} -x assembler-with-cpp")
+set(CMAKE_EXE_LINKER_FLAGS_INIT
+    "${ARM_CPU_FLAGS} --specs=nano.specs --specs=nosys.specs -static -Wl,--gc-sections")
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
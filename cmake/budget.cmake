@@ -0,0 +1,130 @@
+# 建置後的記憶體預算檢查 (每個韌體 target 的 POST_BUILD)：
+#   cmake -DSIZE= -DNM= -DELF= -DOBJECT_DIRS=<目錄;...>
+#         -DFLASH_ORIGIN= -DFLASH_BYTES= -DRAM_ORIGIN= -DRAM_BYTES=
+#         -DHEAP_BYTES= -DSTACK_BYTES=
+#         [-DOBJDUMP= -DSTACK_TOOL= -DIRQ_PRIORITIES=<中斷=優先權;...>] -P budget.cmake
+#
+# - flash：落在 FLASH 的 section 加上 .data 的初始值
+# - RAM：.data + .bss (不含 ._user_heap_stack) + heap + stack 預留
+# - stack：有 STACK_TOOL (tools/stack_depth.c) 時，最壞呼叫鏈加上中斷巢狀
+#   不得超過 stack 預留；沒有時只檢查 .su 中最大的單一 stack frame
+# 任一項超過預算時刪除 elf 並讓建置失敗。
+
+math(EXPR flash_begin "${FLASH_ORIGIN}")
+math(EXPR flash_end "${FLASH_ORIGIN} + ${FLASH_BYTES}")
+math(EXPR ram_begin "${RAM_ORIGIN}")
+math(EXPR ram_end "${RAM_ORIGIN} + ${RAM_BYTES}")
+
+execute_process(COMMAND ${SIZE} -A -d ${ELF}
+    OUTPUT_VARIABLE sections
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${SIZE} failed: ${result}")
+endif()
+
+set(flash_used 0)
+set(ram_static 0)
+string(REPLACE "\n" ";" lines "${sections}")
+foreach(line IN LISTS lines)
+    if(NOT line MATCHES "^([._A-Za-z0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)")
+        continue()
+    endif()
+    set(name ${CMAKE_MATCH_1})
+    set(bytes ${CMAKE_MATCH_2})
+    set(addr ${CMAKE_MATCH_3})
+    if(bytes EQUAL 0 OR name STREQUAL "._user_heap_stack")
+        continue()
+    endif()
+    if(addr GREATER_EQUAL flash_begin AND addr LESS flash_end)
+        math(EXPR flash_used "${flash_used} + ${bytes}")
+    elseif(addr GREATER_EQUAL ram_begin AND addr LESS ram_end)
+        math(EXPR ram_static "${ram_static} + ${bytes}")
+        if(name STREQUAL ".data")
+            math(EXPR flash_used "${flash_used} + ${bytes}") # 初始值存在 flash
+        endif()
+    endif()
+endforeach()
+
+set(su_files)
+foreach(dir IN LISTS OBJECT_DIRS)
+    file(GLOB_RECURSE found ${dir}/*.su)
+    list(APPEND su_files ${found})
+endforeach()
+
+set(stack_failed FALSE)
+if(STACK_TOOL)
+    set(priority_args)
+    foreach(priority IN LISTS IRQ_PRIORITIES)
+        list(APPEND priority_args -p ${priority})
+    endforeach()
+    execute_process(COMMAND ${OBJDUMP} -d ${ELF}
+        COMMAND ${STACK_TOOL} -s ${STACK_BYTES} ${priority_args} - ${su_files}
+        OUTPUT_VARIABLE stack_report
+        RESULTS_VARIABLE results)
+    list(GET results 0 objdump_result)
+    list(GET results 1 result)
+    if(NOT objdump_result EQUAL 0 OR (NOT result EQUAL 0 AND NOT result EQUAL 3))
+        message(FATAL_ERROR "stack analysis failed: ${results}")
+    endif()
+    if(result EQUAL 3)
+        set(stack_failed TRUE)
+    endif()
+    string(REGEX MATCH "worst case: [^\n]*" stack_line "${stack_report}")
+    string(REPLACE "worst case:" "worst case" stack_line "${stack_line}")
+else()
+    # 只算連結後仍存在的函式 (gc-sections 移除的不算)
+    execute_process(COMMAND ${NM} ${ELF}
+        OUTPUT_VARIABLE symbols
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${NM} failed: ${result}")
+    endif()
+    set(max_frame 0)
+    set(max_frame_name "-")
+    foreach(su IN LISTS su_files)
+        file(STRINGS ${su} entries)
+        foreach(entry IN LISTS entries)
+            if(NOT entry MATCHES ":([^:\t]+)\t([0-9]+)\t")
+                continue()
+            endif()
+            set(function ${CMAKE_MATCH_1})
+            set(frame ${CMAKE_MATCH_2})
+            if(frame GREATER max_frame)
+                string(FIND "${symbols}" " ${function}\n" linked)
+                if(NOT linked EQUAL -1)
+                    set(max_frame ${frame})
+                    set(max_frame_name ${function})
+                endif()
+            endif()
+        endforeach()
+    endforeach()
+    set(stack_line "largest frame ${max_frame} (${max_frame_name}) / ${STACK_BYTES}")
+    if(max_frame GREATER STACK_BYTES)
+        set(stack_failed TRUE)
+    endif()
+endif()
+
+math(EXPR ram_used "${ram_static} + ${HEAP_BYTES} + ${STACK_BYTES}")
+get_filename_component(elf_name ${ELF} NAME)
+message("${elf_name} budget:\n"
+    "  flash  ${flash_used} / ${FLASH_BYTES}\n"
+    "  RAM    ${ram_used} / ${RAM_BYTES} (static ${ram_static} + heap ${HEAP_BYTES} + stack ${STACK_BYTES})\n"
+    "  stack  ${stack_line}")
+
+set(failed)
+if(flash_used GREATER FLASH_BYTES)
+    list(APPEND failed "flash")
+endif()
+if(ram_used GREATER RAM_BYTES)
+    list(APPEND failed "RAM")
+endif()
+if(stack_failed)
+    list(APPEND failed "stack")
+endif()
+if(failed)
+    if(stack_report)
+        message("${stack_report}")
+    endif()
+    file(REMOVE ${ELF}) # 下次建置會重新連結並再次檢查
+    message(FATAL_ERROR "${elf_name}: over budget (${failed}); see cmake/devices/")
+endif()
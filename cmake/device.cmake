@@ -0,0 +1,89 @@
+# 載入裝置設定檔 (cmake/devices/<STM32_DEVICE>.cmake) 並推導其餘參數
+
+set(STM32_DEVICE stm32f103c8 CACHE STRING "cmake/devices/ 下的裝置設定檔名稱")
+include(${CMAKE_CURRENT_LIST_DIR}/devices/${STM32_DEVICE}.cmake)
+
+# STM32F101/102/103 的密度由 flash 大小決定 (RM0008 §1.3)；
+# 105/107 (connectivity line) 等例外由設定檔自行設定 DEVICE_DENSITY
+if(NOT DEVICE_DENSITY)
+    if(DEVICE_FLASH_KB LESS_EQUAL 32)
+        set(DEVICE_DENSITY LD)
+    elseif(DEVICE_FLASH_KB LESS_EQUAL 128)
+        set(DEVICE_DENSITY MD)
+    elseif(DEVICE_FLASH_KB LESS_EQUAL 512)
+        set(DEVICE_DENSITY HD)
+    else()
+        set(DEVICE_DENSITY XL)
+    endif()
+endif()
+set(DEVICE_DENSITY_DEFINE STM32F10X_${DEVICE_DENSITY})
+
+# flash 分成程式 (FLASH) 與最後的紀錄區 (STORE)；預算只計程式的部分
+if(NOT DEVICE_STORE_KB)
+    set(DEVICE_STORE_KB 0)
+endif()
+math(EXPR DEVICE_CODE_KB "${DEVICE_FLASH_KB} - ${DEVICE_STORE_KB}")
+math(EXPR store_origin "${DEVICE_FLASH_ORIGIN} + ${DEVICE_CODE_KB} * 1024"
+    OUTPUT_FORMAT HEXADECIMAL)
+string(TOUPPER ${store_origin} store_origin) # 與 CubeIDE 相同的 0x800F800 寫法
+string(REPLACE "0X" "0x" DEVICE_STORE_ORIGIN ${store_origin})
+math(EXPR DEVICE_FLASH_BYTES "${DEVICE_CODE_KB} * 1024")
+math(EXPR DEVICE_RAM_BYTES "${DEVICE_RAM_KB} * 1024")
+math(EXPR DEVICE_HEAP_BYTES "${DEVICE_HEAP_SIZE}")
+math(EXPR DEVICE_STACK_BYTES "${DEVICE_STACK_SIZE}")
+
+message(STATUS "Device: ${DEVICE_PART} (${DEVICE_DENSITY_DEFINE}), "
+    "${DEVICE_FLASH_KB} KB flash (${DEVICE_STORE_KB} KB store), ${DEVICE_RAM_KB} KB RAM, "
+    "heap ${DEVICE_HEAP_BYTES} B, stack ${DEVICE_STACK_BYTES} B")
+
+# CubeIDE 使用各專案自己的連結腳本，與設定檔不一致時 configure 失敗；
+# 沒有使用 STORE 區的專案 FLASH 為整個 flash
+function(device_check_linker_script path)
+    file(READ ${path} text)
+    set(expected
+        "_Min_Heap_Size = ${DEVICE_HEAP_SIZE};"
+        "_Min_Stack_Size = ${DEVICE_STACK_SIZE};"
+        "LENGTH = ${DEVICE_RAM_KB}K")
+    if(text MATCHES "STORE[ \t]+\\(")
+        list(APPEND expected
+            "LENGTH = ${DEVICE_CODE_KB}K"
+            "ORIGIN = ${DEVICE_STORE_ORIGIN},   LENGTH = ${DEVICE_STORE_KB}K")
+    else()
+        list(APPEND expected "LENGTH = ${DEVICE_FLASH_KB}K")
+    endif()
+    foreach(item IN LISTS expected)
+        string(FIND "${text}" "${item}" found)
+        if(found EQUAL -1)
+            message(FATAL_ERROR "${path} does not match cmake/devices/${STM32_DEVICE}.cmake "
+                "(missing \"${item}\")")
+        endif()
+    endforeach()
+endfunction()
+
+# CubeIDE 的 make stack (projects/<專案>/makefile.targets) 不經過 CMake，stack 預留與
+# 中斷優先權各自寫死一份；與設定檔、FIRMWARE_IRQ_PRIORITIES_<專案> 不一致時 configure 失敗
+function(device_check_makefile_targets path priorities)
+    file(READ ${path} text)
+    set(priority_args)
+    foreach(priority IN LISTS priorities)
+        list(APPEND priority_args "-p ${priority}")
+    endforeach()
+    string(JOIN " " priority_args ${priority_args})
+
+    foreach(item "STACK_RESERVE;${DEVICE_STACK_SIZE}" "STACK_PRIORITIES;${priority_args}")
+        list(GET item 0 variable)
+        list(LENGTH item length)
+        set(expected)
+        if(length GREATER 1)
+            list(GET item 1 expected)
+        endif()
+        if(NOT text MATCHES "\n${variable} :=[ \t]*([^\n]*)")
+            message(FATAL_ERROR "${path} does not define ${variable}")
+        endif()
+        string(STRIP "${CMAKE_MATCH_1}" actual)
+        if(NOT actual STREQUAL expected)
+            message(FATAL_ERROR "${path}: ${variable} is \"${actual}\", expected \"${expected}\" "
+                "(cmake/devices/${STM32_DEVICE}.cmake, FIRMWARE_IRQ_PRIORITIES in CMakeLists.txt)")
+        endif()
+    endforeach()
+endfunction()
@@ -0,0 +1,15 @@
+# STM32F103C8 (Blue Pill)：64 KB flash、20 KB SRAM
+#
+# 裝置設定檔只描述晶片與記憶體預算；密度 (STM32F10X_xx)、連結腳本的 MEMORY、
+# _Min_Heap_Size / _Min_Stack_Size 與建置後的預算檢查都由這裡的值推導。
+# 修改後需同步各專案 CubeIDE 用的 STM32F103C8TX_FLASH.ld 與 makefile.targets 的
+# STACK_RESERVE (configure 時會比對)。
+
+set(DEVICE_PART STM32F103C8Tx)
+set(DEVICE_FLASH_ORIGIN 0x08000000)
+set(DEVICE_FLASH_KB 64)
+set(DEVICE_STORE_KB 2)       # flash 最後的 STORE 區 (專案 5 的 store.c)，不放程式
+set(DEVICE_RAM_ORIGIN 0x20000000)
+set(DEVICE_RAM_KB 20)
+set(DEVICE_HEAP_SIZE 0x200)  # _Min_Heap_Size (newlib malloc / printf 用)
+set(DEVICE_STACK_SIZE 0x400) # _Min_Stack_Size (MSP，所有中斷共用)
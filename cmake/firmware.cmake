@@ -0,0 +1,145 @@
+# 韌體建置 (由 CMakeLists.txt 在使用 arm-none-eabi.cmake 時 include)
+
+enable_language(ASM)
+include(CheckCCompilerFlag)
+
+if(NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Debug CACHE STRING "Debug 或 Release" FORCE)
+endif()
+
+# 與 .cproject 的 Debug / Release 設定相同；LTO 時編譯階段不產生 .su，
+# 連結時的 -fstack-usage 會在 elf 旁輸出 <專案>.elf.ltrans*.su
+set(CMAKE_C_FLAGS_DEBUG "-O0 -g3 -DDEBUG")
+set(CMAKE_ASM_FLAGS_DEBUG "-g3 -DDEBUG")
+set(CMAKE_C_FLAGS_RELEASE "-Os -flto")
+set(CMAKE_ASM_FLAGS_RELEASE "")
+set(CMAKE_EXE_LINKER_FLAGS_RELEASE "-Os -flto -fstack-usage")
+
+add_compile_definitions(STM32 STM32F1 ${DEVICE_PART} ${DEVICE_DENSITY_DEFINE})
+add_compile_options(
+    $<$<COMPILE_LANGUAGE:C>:-ffunction-sections>
+    $<$<COMPILE_LANGUAGE:C>:-fdata-sections>
+    $<$<COMPILE_LANGUAGE:C>:-Wall>
+    $<$<COMPILE_LANGUAGE:C>:-fstack-usage>)
+check_c_compiler_flag(-fcyclomatic-complexity HAVE_CYCLOMATIC_COMPLEXITY) # ST 版 gcc 才有
+if(HAVE_CYCLOMATIC_COMPLEXITY)
+    add_compile_options($<$<COMPILE_LANGUAGE:C>:-fcyclomatic-complexity>)
+endif()
+
+# --- StdPeriph 驅動程式：所有專案共用一個靜態函式庫 ---
+file(GLOB STDPERIPH_SOURCES CONFIGURE_DEPENDS ${STDPERIPH_DIR}/src/*.c)
+add_library(stm32f10x_stdperiph STATIC ${STDPERIPH_SOURCES})
+target_include_directories(stm32f10x_stdperiph
+    PUBLIC ${STDPERIPH_DIR}/inc ${CMSIS_DEVICE_DIR} ${CMSIS_CORE_DIR}
+    PRIVATE ${STM32_REFERENCE_DIR}/Inc) # stm32f10x_conf.h (assert_param)
+target_compile_definitions(stm32f10x_stdperiph PRIVATE USE_STDPERIPH_DRIVER)
+
+# --- CMSIS：以 object 直接連結，不放進 archive ---
+# startup 的 "bl SystemInit" 是 weak 參照，不會從 archive 拉出 system_stm32f10x.o，
+# 放在靜態函式庫裡 SystemInit 會變成位址 0；system_stm32f10x.c 隨各專案的原始碼編譯
+add_library(stm32f10x_cmsis OBJECT
+    ${CMSIS_CORE_DIR}/core_cm3.c)
+target_include_directories(stm32f10x_cmsis PUBLIC ${CMSIS_DEVICE_DIR} ${CMSIS_CORE_DIR})
+
+# --- projects/common ---
+file(GLOB COMMON_SOURCES CONFIGURE_DEPENDS ${COMMON_DIR}/Src/*.c)
+add_library(common STATIC ${COMMON_SOURCES})
+target_include_directories(common
+    PUBLIC ${COMMON_DIR}/Inc
+    PRIVATE ${CMSIS_DEVICE_DIR} ${CMSIS_CORE_DIR})
+
+# 大小報告 (tools/build_report.c) 與 stack 深度分析 (tools/stack_depth.c)：
+# 需要主機的 C 編譯器；沒有時預算檢查只看單一 stack frame
+find_program(HOST_C_COMPILER NAMES cc gcc clang)
+if(HOST_C_COMPILER)
+    set(BUILD_REPORT_TOOL ${CMAKE_BINARY_DIR}/build_report${CMAKE_HOST_EXECUTABLE_SUFFIX})
+    set(STACK_DEPTH_TOOL ${CMAKE_BINARY_DIR}/stack_depth${CMAKE_HOST_EXECUTABLE_SUFFIX})
+    foreach(tool build_report stack_depth)
+        set(output ${CMAKE_BINARY_DIR}/${tool}${CMAKE_HOST_EXECUTABLE_SUFFIX})
+        add_custom_command(OUTPUT ${output}
+            COMMAND ${HOST_C_COMPILER} -O2 -o ${output} ${TOOLS_DIR}/${tool}.c
+            DEPENDS ${TOOLS_DIR}/${tool}.c
+            VERBATIM)
+        add_custom_target(${tool}_tool DEPENDS ${output})
+    endforeach()
+endif()
+
+# 所有專案共用由裝置設定檔產生的連結腳本
+set(DEVICE_LINKER_SCRIPT ${CMAKE_BINARY_DIR}/${STM32_DEVICE}.ld)
+configure_file(${CMAKE_SOURCE_DIR}/cmake/stm32f10x_flash.ld.in ${DEVICE_LINKER_SCRIPT} @ONLY)
+
+# 每個專案一個 <專案>.elf，另外輸出 .hex / .bin / .map，並檢查記憶體預算
+function(add_firmware name)
+    set(dir ${CMAKE_SOURCE_DIR}/projects/${name})
+    set(out ${CMAKE_BINARY_DIR}/${name})
+    set(linker_script ${DEVICE_LINKER_SCRIPT})
+    set(object_dirs
+        ${out}
+        ${CMAKE_BINARY_DIR}/CMakeFiles/${name}.dir
+        ${CMAKE_BINARY_DIR}/CMakeFiles/stm32f10x_stdperiph.dir
+        ${CMAKE_BINARY_DIR}/CMakeFiles/stm32f10x_cmsis.dir
+        ${CMAKE_BINARY_DIR}/CMakeFiles/common.dir)
+    string(REPLACE ";" "\\;" object_dirs "${object_dirs}")
+    string(REPLACE ";" "\\;" irq_priorities "${FIRMWARE_IRQ_PRIORITIES_${name}}")
+
+    device_check_linker_script(${dir}/STM32F103C8TX_FLASH.ld)
+
+    file(GLOB sources CONFIGURE_DEPENDS ${dir}/Src/*.c ${dir}/Startup/*.s)
+    add_executable(${name} ${sources} ${dir}/${CMSIS_SYSTEM_SOURCE})
+    set_target_properties(${name} PROPERTIES
+        OUTPUT_NAME ${name}
+        SUFFIX .elf
+        RUNTIME_OUTPUT_DIRECTORY ${out}
+        LINK_DEPENDS ${linker_script})
+    target_include_directories(${name} PRIVATE ${dir}/Inc)
+    target_link_libraries(${name} PRIVATE stm32f10x_cmsis stm32f10x_stdperiph)
+    if(name IN_LIST FIRMWARE_PROJECTS_WITH_COMMON)
+        target_link_libraries(${name} PRIVATE common)
+    endif()
+    target_link_options(${name} PRIVATE -T${linker_script} -Wl,-Map=${out}/${name}.map)
+
+    set(stack_args)
+    if(HOST_C_COMPILER)
+        add_dependencies(${name} stack_depth_tool)
+        set(stack_args
+            -DOBJDUMP=${CMAKE_OBJDUMP}
+            -DSTACK_TOOL=${STACK_DEPTH_TOOL})
+    endif()
+
+    add_custom_command(TARGET ${name} POST_BUILD
+        COMMAND ${CMAKE_OBJCOPY} -O ihex $<TARGET_FILE:${name}> ${out}/${name}.hex
+        COMMAND ${CMAKE_OBJCOPY} -O binary $<TARGET_FILE:${name}> ${out}/${name}.bin
+        COMMAND ${CMAKE_SIZE} $<TARGET_FILE:${name}>
+        COMMAND ${CMAKE_COMMAND}
+            -DSIZE=${CMAKE_SIZE}
+            -DNM=${CMAKE_NM}
+            -DELF=$<TARGET_FILE:${name}>
+            -DOBJECT_DIRS=${object_dirs}
+            -DFLASH_ORIGIN=${DEVICE_FLASH_ORIGIN}
+            -DFLASH_BYTES=${DEVICE_FLASH_BYTES}
+            -DRAM_ORIGIN=${DEVICE_RAM_ORIGIN}
+            -DRAM_BYTES=${DEVICE_RAM_BYTES}
+            -DHEAP_BYTES=${DEVICE_HEAP_BYTES}
+            -DSTACK_BYTES=${DEVICE_STACK_BYTES}
+            ${stack_args}
+            -DIRQ_PRIORITIES=${irq_priorities}
+            -P ${CMAKE_SOURCE_DIR}/cmake/budget.cmake
+        VERBATIM)
+
+    if(HOST_C_COMPILER)
+        add_custom_target(report-${name}
+            COMMAND ${CMAKE_COMMAND}
+                -DNM=${CMAKE_NM}
+                -DTOOL=${BUILD_REPORT_TOOL}
+                -DELF=$<TARGET_FILE:${name}>
+                -DPREFIX=${out}/${name}
+                -DOBJECT_DIRS=${object_dirs}
+                -P ${CMAKE_SOURCE_DIR}/cmake/report.cmake
+            DEPENDS ${name} build_report_tool
+            VERBATIM)
+    endif()
+endfunction()
+
+foreach(name IN LISTS FIRMWARE_PROJECTS)
+    add_firmware(${name})
+endforeach()
@@ -0,0 +1,198 @@
+# 主機建置 (由 CMakeLists.txt 在沒有指定 arm toolchain 時 include)
+#
+# 韌體裡不碰暫存器的程式碼編成主機函式庫，給 tools/ 的工具與 tests/ 的測試連結；
+# 需要暫存器的程式碼則與 tools/sim 的暫存器模擬器一起編成 sim_<專案>。
+#
+# 測試：ctest --test-dir build (tests/ 的單元測試與 tools/sim/scenarios 的情境)
+
+if(NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE RelWithDebInfo CACHE STRING "" FORCE)
+endif()
+
+add_compile_options(-Wall -Wextra)
+find_package(Threads REQUIRED)
+
+set(PARKING_DIR ${CMAKE_SOURCE_DIR}/projects/5)
+
+# --- projects/common (delay.c 使用 DWT 與 SystemCoreClock，只在韌體 / 模擬器中編譯) ---
+add_library(common_host STATIC
+    ${COMMON_DIR}/Src/cobs.c
+    ${COMMON_DIR}/Src/fmt.c)
+target_include_directories(common_host PUBLIC ${COMMON_DIR}/Inc)
+
+# --- 專案 5 的純邏輯：車位、閘門、距離濾波 ---
+add_library(parking_logic STATIC
+    ${PARKING_DIR}/Src/parking.c
+    ${PARKING_DIR}/Src/presence.c
+    ${PARKING_DIR}/Src/gate.c)
+target_include_directories(parking_logic PUBLIC ${PARKING_DIR}/Inc ${COMMON_DIR}/Inc)
+
+# --- tools/ ---
+add_executable(telemetry_decode ${TOOLS_DIR}/telemetry_decode.c)
+target_include_directories(telemetry_decode PRIVATE ${PARKING_DIR}/Inc)
+target_link_libraries(telemetry_decode PRIVATE common_host)
+
+add_executable(traffic_sim ${TOOLS_DIR}/traffic_sim.c)
+target_link_libraries(traffic_sim PRIVATE parking_logic Threads::Threads m)
+
+add_executable(build_report ${TOOLS_DIR}/build_report.c)
+add_executable(stack_depth ${TOOLS_DIR}/stack_depth.c)
+
+if(CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|i.86")
+    add_executable(echo_filter_bench ${TOOLS_DIR}/echo_filter_bench.c) # 使用 __rdtsc
+    target_link_libraries(echo_filter_bench PRIVATE parking_logic m)
+    add_executable(fmt_bench ${TOOLS_DIR}/fmt_bench.c)
+    target_link_libraries(fmt_bench PRIVATE common_host)
+endif()
+
+# --- 暫存器模擬器 (Linux x86-64，見 tools/sim/sim.h) ---
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux" AND CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64")
+    # 模擬器與韌體共用的 CMSIS / 驅動程式；sim/include 的 core_cm3.h 必須排在 CMSIS 之前
+    set(SIM_INCLUDE_DIRS
+        ${TOOLS_DIR}/sim/include
+        ${COMMON_DIR}/Inc
+        ${CMSIS_DEVICE_DIR}
+        ${CMSIS_CORE_DIR}
+        ${STDPERIPH_DIR}/inc)
+
+    file(GLOB SIM_SOURCES CONFIGURE_DEPENDS ${TOOLS_DIR}/sim/*.c)
+    # object library：sim_vectors.c 的 weak handler 必須直接連結，不能放進 archive
+    add_library(stm32_sim OBJECT
+        ${SIM_SOURCES}
+        ${STDPERIPH_DIR}/src/stm32f10x_bkp.c
+        ${STDPERIPH_DIR}/src/stm32f10x_crc.c
+        ${STDPERIPH_DIR}/src/stm32f10x_flash.c
+        ${STDPERIPH_DIR}/src/stm32f10x_rcc.c
+        ${STDPERIPH_DIR}/src/stm32f10x_rtc.c)
+    target_include_directories(stm32_sim PUBLIC ${SIM_INCLUDE_DIRS})
+    target_compile_definitions(stm32_sim PUBLIC ${DEVICE_DENSITY_DEFINE})
+    target_compile_options(stm32_sim PUBLIC -fno-pie)
+    # bkp、flash、rcc、rtc 使用 assert_param (stm32f10x_conf.h)
+    set_source_files_properties(
+        ${STDPERIPH_DIR}/src/stm32f10x_bkp.c
+        ${STDPERIPH_DIR}/src/stm32f10x_flash.c
+        ${STDPERIPH_DIR}/src/stm32f10x_rcc.c
+        ${STDPERIPH_DIR}/src/stm32f10x_rtc.c PROPERTIES
+        COMPILE_DEFINITIONS USE_STDPERIPH_DRIVER
+        INCLUDE_DIRECTORIES ${STM32_REFERENCE_DIR}/Inc)
+    # FLASH_ProgramHalfWord、BKP_WriteBackupRegister 等以 uint32_t 位址直接存取
+    # (模擬器的位址都在 4 GB 以下)
+    set_source_files_properties(
+        ${STDPERIPH_DIR}/src/stm32f10x_bkp.c
+        ${STDPERIPH_DIR}/src/stm32f10x_flash.c PROPERTIES
+        COMPILE_OPTIONS -Wno-int-to-pointer-cast)
+
+    file(GLOB SIM_COMMON_SOURCES CONFIGURE_DEPENDS ${COMMON_DIR}/Src/*.c)
+
+    foreach(name IN LISTS FIRMWARE_PROJECTS)
+        set(dir ${CMAKE_SOURCE_DIR}/projects/${name})
+        file(GLOB sources CONFIGURE_DEPENDS ${dir}/Src/*.c)
+        list(FILTER sources EXCLUDE REGEX "/(syscalls|sysmem)\\.c$")
+
+        add_executable(sim_${name} ${sources} ${dir}/${CMSIS_SYSTEM_SOURCE} ${SIM_COMMON_SOURCES})
+        target_include_directories(sim_${name} BEFORE PRIVATE ${TOOLS_DIR}/sim/include ${dir}/Inc)
+        target_compile_definitions(sim_${name} PRIVATE main=firmware_main)
+        target_link_libraries(sim_${name} PRIVATE stm32_sim)
+        # 韌體以 32-bit 位址設定 DMA，靜態變數必須位於 4 GB 以下
+        target_link_options(sim_${name} PRIVATE -no-pie)
+    endforeach()
+endif()
+
+# --- tests/ ---
+enable_testing()
+set(TESTS_DIR ${CMAKE_SOURCE_DIR}/tests)
+
+# host_test(<名稱> <函式庫>...)：tests/<名稱>.c 編成執行檔，回傳非 0 即失敗
+function(host_test name)
+    add_executable(${name} ${TESTS_DIR}/${name}.c)
+    target_link_libraries(${name} PRIVATE ${ARGN})
+    add_test(NAME ${name} COMMAND ${name})
+endfunction()
+
+host_test(test_fmt common_host)
+host_test(test_gate parking_logic)
+host_test(test_parking parking_logic)
+host_test(test_timebase parking_logic)
+host_test(test_units common_host m)
+
+# 基準測試以少量樣本執行一次，檢查 fmt 與 sprintf 的輸出相同
+if(TARGET fmt_bench)
+    add_test(NAME fmt_bench COMMAND fmt_bench 10000)
+endif()
+
+# sim_scenario_test(<專案> <情境>)：執行到 end 為止 (含 reboot 之後的各次開機)，
+# expect 不符或 sim_fatal (結束碼 1) 即失敗。映像檔等相對路徑的檔案寫在
+# build/scenarios/ 下，各情境使用不同的檔名，可以平行執行
+if(TARGET stm32_sim)
+    set(SCENARIO_DIR ${TOOLS_DIR}/sim/scenarios)
+    set(SCENARIO_WORK_DIR ${CMAKE_BINARY_DIR}/scenarios)
+    file(MAKE_DIRECTORY ${SCENARIO_WORK_DIR})
+
+    function(sim_scenario_test project scenario)
+        add_test(NAME scenario_${scenario}
+            COMMAND sim_${project} ${SCENARIO_DIR}/${scenario}.scn
+            WORKING_DIRECTORY ${SCENARIO_WORK_DIR})
+        set_tests_properties(scenario_${scenario} PROPERTIES TIMEOUT 120)
+    endfunction()
+
+    # sim_test(<名稱> <專案 5 的原始碼>... [ARGS <模擬器參數>...])：在模擬器上執行的
+    # 測試 (需要暫存器的程式碼)
+    function(sim_test name)
+        cmake_parse_arguments(PARSE_ARGV 1 SIM "" "" "ARGS")
+        list(TRANSFORM SIM_UNPARSED_ARGUMENTS PREPEND ${PARKING_DIR}/Src/)
+        add_executable(${name} ${TESTS_DIR}/${name}.c ${SIM_UNPARSED_ARGUMENTS}
+            ${PARKING_DIR}/${CMSIS_SYSTEM_SOURCE} ${SIM_COMMON_SOURCES})
+        target_include_directories(${name} BEFORE PRIVATE ${TOOLS_DIR}/sim/include
+            ${TOOLS_DIR}/sim ${PARKING_DIR}/Inc)
+        target_compile_definitions(${name} PRIVATE main=firmware_main)
+        target_link_libraries(${name} PRIVATE stm32_sim)
+        target_link_options(${name} PRIVATE -no-pie)
+        add_test(NAME ${name} COMMAND ${name} ${SIM_ARGS})
+        # 在 WFI 等不到中斷時模擬器會以結束碼 0 結束，不能當成通過
+        set_tests_properties(${name} PROPERTIES TIMEOUT 60
+            FAIL_REGULAR_EXPRESSION "nothing left to wake it")
+    endfunction()
+
+    # Echo 的邊緣以虛擬時間排定，-s 讓主機排程 (ctest -j) 造成的時間跳躍
+    # 小於脈寬，上升沿與下降沿不會在同一個 tick 內一起發生
+    sim_test(test_echo_capture echo_capture.c ARGS -s 0.001)
+    # 回繞前 16 µs 的等待在 -s 0.01 下約 1.6 ms，主機排程的延遲不會讓 TIM3 多跑一圈
+    sim_test(test_timebase_chain timebase.c ARGS -s 0.01)
+    sim_test(test_usart_tx usart_tx.c)
+    sim_test(test_usart_rx usart_rx.c usart_tx.c command.c gate.c)
+    sim_test(test_telemetry telemetry.c usart_tx.c)
+    set_property(TEST test_telemetry PROPERTY
+        ENVIRONMENT TELEMETRY_DECODE=$<TARGET_FILE:telemetry_decode>)
+    add_dependencies(test_telemetry telemetry_decode)
+
+    # delay 的 cycle 數：一般專案的 system_stm32f10x.c 以每個 SYSCLK_FREQ_* 各編一次
+    # (檔案內預設 72 MHz；另外定義的選項在 #if 串中排在前面，會優先採用)
+    set(DELAY_SYSCLK_OPTIONS HSE=8000000 24MHz=24000000 36MHz=36000000
+        48MHz=48000000 56MHz=56000000 72MHz=72000000)
+    foreach(option IN LISTS DELAY_SYSCLK_OPTIONS)
+        string(REPLACE "=" ";" option ${option})
+        list(GET option 0 freq)
+        list(GET option 1 hz)
+        set(name test_delay_${freq})
+        add_executable(${name} ${TESTS_DIR}/test_delay.c ${COMMON_DIR}/Src/delay.c
+            ${CMAKE_SOURCE_DIR}/projects/2-i/${CMSIS_SYSTEM_SOURCE})
+        target_include_directories(${name} BEFORE PRIVATE ${TOOLS_DIR}/sim/include
+            ${TOOLS_DIR}/sim)
+        target_compile_definitions(${name} PRIVATE main=firmware_main
+            SYSCLK_FREQ_${freq}=${hz} EXPECTED_SYSCLK_HZ=${hz})
+        target_link_libraries(${name} PRIVATE stm32_sim)
+        target_link_options(${name} PRIVATE -no-pie)
+        add_test(NAME ${name} COMMAND ${name})
+        set_tests_properties(${name} PROPERTIES TIMEOUT 60
+            FAIL_REGULAR_EXPRESSION "nothing left to wake it")
+    endforeach()
+
+    sim_scenario_test(5 boot)
+    sim_scenario_test(5 boot_fault)
+    sim_scenario_test(5 clock)
+    sim_scenario_test(5 parking)
+    sim_scenario_test(5 store)
+    sim_scenario_test(5 store_cut)
+    sim_scenario_test(5 backup)
+    sim_scenario_test(5 full_lot)
+endif()
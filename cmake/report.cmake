@@ -0,0 +1,37 @@
+# report-<專案> target 呼叫的腳本：
+#   cmake -DNM= -DTOOL= -DELF= -DPREFIX= -DOBJECT_DIRS=<目錄;...> -P report.cmake
+# OBJECT_DIRS 下的 .su / .cyclo 都會被收集 (含 elf 旁 LTO 連結產生的 .ltrans*.su)。
+#
+# 與 projects/5/makefile.targets 的 make report 相同：elf 比快照新時才輪替快照，
+# 重複執行只會再印一次上次的結果。
+
+set(snapshot ${PREFIX}.report.tsv)
+set(report ${PREFIX}.report.txt)
+
+if(${ELF} IS_NEWER_THAN ${snapshot} OR NOT EXISTS ${report})
+    execute_process(COMMAND ${NM} -S --size-sort ${ELF}
+        OUTPUT_FILE ${PREFIX}.nm
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${NM} failed: ${result}")
+    endif()
+
+    set(metrics)
+    foreach(dir IN LISTS OBJECT_DIRS)
+        file(GLOB_RECURSE found ${dir}/*.su ${dir}/*.cyclo)
+        list(APPEND metrics ${found})
+    endforeach()
+
+    if(EXISTS ${snapshot})
+        file(RENAME ${snapshot} ${snapshot}.prev)
+    endif()
+    execute_process(COMMAND ${TOOL} -p ${snapshot}.prev -o ${snapshot} ${PREFIX}.nm ${metrics}
+        OUTPUT_FILE ${report}
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${TOOL} failed: ${result}")
+    endif()
+endif()
+
+file(READ ${report} text)
+message("${text}")
@@ -1,9 +1,10 @@
 #include "stm32f10x.h"
-
-void delay_ms(uint16_t t);
+#include "delay.h"
 
 int main()
 {
+    delay_init();
+
     RCC->APB2ENR |= 0xFC; // 啟用 GPIO 連接埠的 clock
     RCC->APB1ENR |= (1 << 0);
     GPIOA->CRL |= 0xB;
@@ -17,23 +18,14 @@ int main()
     while (1) {
         // 順時針轉至 180 度
         TIM2->CCR1 = 2000;
-        delay_ms(10000);
+        delay_sleep_ms(10000);
 
         // 逆時針轉至 0 度
         TIM2->CCR1 = 1000;
-        delay_ms(10000);
+        delay_sleep_ms(10000);
 
         //		// 返回中心位置
         //		TIM2->CCR1 = 1500;
         //		delay_ms(10000);
     }
 }
-
-void delay_ms(uint16_t t)
-{
-    volatile unsigned long l = 0;
-
-    for (uint16_t i = 0; i < t; i++)
-        for (l = 0; l < 9000; l++)
-            ;
-}
@@ -1,24 +1,20 @@
 #include "stm32f10x.h"
+#include "delay.h"
 
-void delay_ms(uint16_t t);
 void usart1_sendByte(unsigned char c);
 
 int main()
 {
+    delay_init();
+
     RCC->APB2ENR |= (1 << 14) | (1 << 2);
     GPIOA->CRH |= 0x000000B0;
     USART1->CR1 = 0x200C;
     USART1->BRR = 7500;
 
     usart1_sendByte('A');
-}
-void delay_ms(uint16_t t)
-{
-    volatile unsigned long l = 0;
 
-    for (uint16_t i = 0; i < t; i++)
-        for (l = 0; l < 9000; l++)
-            ;
+    return 0;
 }
 
 void usart1_sendByte(unsigned char c)
@@ -1,33 +1,30 @@
 #include "stm32f10x.h"
+#include "delay.h"
+#include "fmt.h"
 #include <string.h>
 
-void delay_ms(uint16_t t);
 void usart1_sendByte(unsigned char c);
 void usart1_sendStr(char* str); // 字串輸出
 
 int main()
 {
+    delay_init();
+
     RCC->APB2ENR |= (1 << 14) | (1 << 2);
     GPIOA->CRH |= 0x000000B0;
     USART1->CR1 = 0x200C;
     USART1->BRR = 7500;
 
-    char tx_buffer[10]; // 緩衝區，用於存儲數字的字串表示
+    char tx_buffer[FMT_I32_MAX + 3]; // 緩衝區，用於存儲數字的字串表示
 
     for (int i = 0; i <= 20; i++) {
         // 將當前數字轉換為字串
-        sprintf(tx_buffer, "%d\r\n", i);
+        *fmt_str(fmt_i32(tx_buffer, i), "\r\n") = '\0';
         usart1_sendStr(tx_buffer);
-        delay_ms(1000);
+        delay_sleep_ms(1000);
     }
-}
-void delay_ms(uint16_t t)
-{
-    volatile unsigned long l = 0;
 
-    for (uint16_t i = 0; i < t; i++)
-        for (l = 0; l < 9000; l++)
-            ;
+    return 0;
 }
 
 void usart1_sendByte(unsigned char c)
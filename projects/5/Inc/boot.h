@@ -0,0 +1,73 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 開機流程與開機量測
+ *
+ * 專案 5 的 system_stm32f10x.c 沒有定義 SYSCLK_FREQ_72MHz，SystemInit 不等待
+ * HSE 起振，應用程式直接以 HSI 8 MHz 開始執行 (感測器、閘門、USART 都可用)。
+ * boot_init() 打開 HSE，之後由 RCC 的 ready 中斷 (EVENT_CLOCK) 在主迴圈推進：
+ *
+ *   HSE ready → 開啟 PLL (HSE x9) → PLL ready → clock_set_profile(RUN)
+ *
+ * kBootClockTimeout 內沒有完成時關掉 HSE / PLL、維持 HSI，記錄 fault 並從
+ * USART 送出一行 "BOOT FAULT HSE" (或 PLL)。
+ *
+ * 量測紀錄的時間都是自重置起算的 µs：main 之前由 startup 開啟的 DWT CYCCNT
+ * 以 HSI 換算，之後接 timebase_now_us()。以 BOOT 指令讀取 (boot_format)。
+ *
+ * startup 依連結腳本的 __copy_table / __zero_table 初始化 RAM，每個階段結束時
+ * 把 CYCCNT 存進 g_startup_cycles，boot_init() 換算成各階段的 cycle 數。
+ * 以 NOINIT 宣告的變數放在 .noinit，startup 不會清除，軟體重置與 watchdog
+ * 重置後仍保留 (上電後內容隨機，使用前必須自行檢查)。
+ */
+
+#define kBootClockTimeout 50000 // HSE 起振 + PLL 鎖定的期限 (µs)
+#define kBootTextMax 176        // boot_format() 最多輸出的字元數
+
+#define NOINIT __attribute__((section(".noinit")))
+
+// startup 的各階段，順序與 startup_stm32f103c8tx.s 的 BOOT_PHASE_* 相同
+typedef enum
+{
+    BOOT_PHASE_SYSTEM_INIT = 0,
+    BOOT_PHASE_DATA,   // 複製 .data
+    BOOT_PHASE_BSS,    // 清除 .bss
+    BOOT_PHASE_CTORS,  // __libc_init_array
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+typedef enum
+{
+    BOOT_FAULT_NONE = 0,
+    BOOT_FAULT_HSE,  // HSE 沒有起振 (晶振或負載電容)
+    BOOT_FAULT_PLL   // PLL 沒有鎖定
+} boot_fault_t;
+
+typedef struct
+{
+    uint32_t main_us;        // 重置 → main (時基啟動)
+    uint32_t hse_ready_us;   // 0：未就緒
+    uint32_t pll_ready_us;
+    uint32_t run_us;         // 切換到 72 MHz
+    uint32_t first_ping_us;  // 第一次 Trig
+    uint32_t phase_cycles[BOOT_PHASE_COUNT]; // startup 各階段，0：沒有經過 startup
+    uint8_t reset_flags;     // RCC->CSR bit 26 ~ 31 (PIN POR SFT IWDG WWDG LPWR)
+    uint8_t fault;           // boot_fault_t
+} boot_metrics_t;
+
+// startup 在 SystemInit 之前呼叫，此時 .data / .bss 尚未初始化
+void boot_start_cycle_counter(void);
+extern NOINIT uint32_t g_startup_cycles[BOOT_PHASE_COUNT];
+
+void boot_init(void);   // 在 clock_init()、timebase_init() 之後
+void boot_poll(uint32_t now_us);
+bool boot_next_deadline(uint32_t *deadline_us);
+void boot_mark_ping(uint32_t now_us);
+const boot_metrics_t *boot_metrics(void);
+char *boot_format(char *out);
+
+#endif /* BOOT_H */
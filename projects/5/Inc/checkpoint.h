@@ -0,0 +1,44 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 備份區快照：車輛數與最後一次進出的時間
+ *
+ * 寫在 BKP 資料暫存器 (DR1 ~ DR10)，重置後保留，接 VBAT 電池時斷電也保留。
+ * 每次寫入只是幾次 APB1 存取 (數 µs)，主迴圈在每次進出後呼叫
+ * checkpoint_set()；flash 紀錄區 (store.h) 寫入慢，只定期更新一次。
+ *
+ * 兩組暫存器輪流寫入，每組 5 個 half-word：
+ *
+ *   seq | occupied + capacity << 8 | 時間低 16 bit | 時間高 16 bit | check
+ *
+ * check 最後寫入，寫到一半的那組不會被採用；開機時取 check 正確且 seq
+ * 較新的一組。
+ *
+ * 時間為 RTC 的秒數 (LSE 32.768 kHz，自 RTC 第一次啟動起算)。RTC 已在
+ * 計數時 (VBAT 保留) 直接使用；否則 checkpoint_init() 打開 LSE，起振
+ * (約 1 s) 後由 RCC 的 LSE ready 中斷 (EVENT_CLOCK) 喚醒主迴圈，
+ * checkpoint_poll() 設定 RTC。LSE 就緒前的事件時間記為 0 (CKPT 的 last=0)。
+ * RTCSEL 已選了 LSI 或 HSE / 128 時 (只能由備份區重置改回) checkpoint_init()
+ * 會重置備份區，再把讀到的快照寫回。
+ */
+
+#define kCheckpointTextMax 80 // checkpoint_format() 最多輸出的字元數
+
+typedef struct
+{
+    uint8_t occupied;
+    uint8_t capacity;
+    uint32_t event_s;  // 最後一次變更時的 RTC 秒數 (0：RTC 尚未啟動)
+} checkpoint_t;
+
+void checkpoint_init(void);
+void checkpoint_poll(void);
+bool checkpoint_get(checkpoint_t *checkpoint);
+void checkpoint_set(uint8_t occupied, uint8_t capacity);
+char *checkpoint_format(char *out);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,68 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 時脈樹管理
+ *
+ * 匯流排、計時器與 USART 的時脈一律由目前的 RCC 設定 (RCC_GetClocksFreq)
+ * 算出，不寫死在程式裡；開機時為 HSI (見 boot.h)。
+ * 執行期可在兩組 SYSCLK 設定間切換：
+ *
+ *   CLOCK_PROFILE_RUN   HSE 8 MHz x 9 (PLL) = 72 MHz，APB1 /2、APB2 /1
+ *                       (與 SystemInit 的 SetSysClockTo72 相同)
+ *   CLOCK_PROFILE_IDLE  HSI 8 MHz 不除頻，HSE 與 PLL 關閉
+ *
+ * 切換前以 CLOCK_EVENT_PRE_CHANGE 依登記順序通知 listener，讓驅動程式停下
+ * 依賴時脈的傳輸；切換後以 CLOCK_EVENT_POST_CHANGE 依相反順序通知，
+ * 以新的頻率重算 PSC / BRR / SysTick (先登記的驅動程式最後恢復)。
+ * clock_set_profile() 只能在主迴圈呼叫。
+ *
+ * clock_start_hse() / clock_start_pll() 不等待 ready：RCC 的 ready 中斷
+ * 發出 EVENT_CLOCK，主迴圈再以 clock_hse_ready() / clock_pll_ready() 確認，
+ * 全部就緒後以 clock_set_profile(CLOCK_PROFILE_RUN) 切換 (見 boot.c)。
+ */
+
+#define kClockMaxListeners 4
+
+typedef enum
+{
+    CLOCK_PROFILE_RUN = 0,
+    CLOCK_PROFILE_IDLE
+} clock_profile_t;
+
+typedef enum
+{
+    CLOCK_EVENT_PRE_CHANGE = 0,
+    CLOCK_EVENT_POST_CHANGE
+} clock_event_t;
+
+typedef struct
+{
+    uint32_t sysclk_hz;
+    uint32_t hclk_hz;      // 核心、SysTick、DMA
+    uint32_t pclk1_hz;     // APB1
+    uint32_t pclk2_hz;     // APB2 (USART1)
+    uint32_t tim_apb1_hz;  // TIM2 ~ TIM4：APB1 有除頻時為 PCLK1 x2
+    uint32_t tim_apb2_hz;  // TIM1
+} clock_freqs_t;
+
+typedef void (*clock_listener_t)(clock_event_t event,
+        const clock_freqs_t *freqs);
+
+void clock_init(void);
+const clock_freqs_t *clock_freqs(void);
+clock_profile_t clock_profile(void);
+bool clock_add_listener(clock_listener_t listener);
+bool clock_set_profile(clock_profile_t profile);
+
+// 非同步啟動 HSE / PLL
+void clock_start_hse(void);
+void clock_start_pll(void);
+bool clock_hse_ready(void);
+bool clock_pll_ready(void);
+void clock_cancel_start(void);
+
+#endif /* CLOCK_H */
@@ -0,0 +1,45 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+#include "gate.h"
+
+/*
+ * USART 遠端指令 (一行一個指令，不分大小寫)
+ *
+ *   Q                  查詢目前車輛數 / 容量
+ *   CAP <n>            設定容量 (1 ~ 99)
+ *   OPEN ENTRY|EXIT    手動開啟閘門一次 (不影響計數)
+ *   RATE <ms>          設定遙測回報週期 (100 ~ 60000 ms)
+ *   MODE TEXT|BIN      遙測格式：文字行或二進位 frame (見 telemetry.h)
+ *   LOAD               查詢上一個遙測週期的 CPU 負載 ("LOAD 12.3%")
+ *   ECHO               查詢最近一次量到的距離 (mm) 與丟棄的 Echo 數
+ *                      ("ECHO entry=1502 exit=3005 drop=0")
+ *   BRIGHT <n>         七段顯示器亮度 (0 ~ 8，8 為全亮)
+ *   TEMP <°C>          設定氣溫，用於音速補償 (-40 ~ 85)
+ *   CLOCK RUN|IDLE     切換 SYSCLK：72 MHz (PLL) 或 8 MHz (HSI)，見 clock.h
+ *   BOOT               查詢開機量測紀錄 ("BOOT main=... fault=NONE")，見 boot.h
+ *   STORE              查詢 flash 紀錄區 ("STORE gen=.. used=.. bad=.. writes=.. err=..")
+ *   CKPT               查詢備份區快照 ("CKPT rtc=RUN now=.. last=.. seq=.. saves=..")，
+ *                      LSE 就緒前 (rtc=START) 的進出記為 last=0
+ *
+ * 成功回覆 "OK"，查詢回覆 "OCC <車輛數>/<容量>"，其餘回覆 "ERR"。
+ */
+
+typedef struct
+{
+    volatile int *remaining_spaces;
+    int *capacity;
+    uint32_t *telemetry_period_us;
+    uint8_t *telemetry_mode;   // telemetry_mode_t
+    const uint16_t *cpu_load_permille;
+    gate_t *entry_gate;
+    gate_t *exit_gate;
+    int8_t *temperature_c;
+    const uint32_t *last_echo_us; // 各感測器最近一次的 Echo 脈寬
+} command_context_t;
+
+void command_execute(const command_context_t *ctx, const char *line,
+        uint32_t now_us);
+
+#endif /* COMMAND_H */
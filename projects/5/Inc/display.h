@@ -0,0 +1,41 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 七段顯示器驅動 (GPIOB)
+ *
+ * 由 SysTick 中斷刷新：每個 slot 對 GPIOB->BSRR 寫入一個預先算好的字組，
+ * 主迴圈只在數值改變時呼叫 display_set_number()，不碰刷新路徑。
+ *
+ * - 靜態接線：每一位數有自己的 a-g 段 (本專案: 個位 PB0-6、十位 PB8-14)
+ * - 多工接線：a-g 段共用，每一位數有一支位數選擇腳 (高電位有效)
+ *
+ * 亮度以每位數 kDisplayDimSteps 個 slot 中點亮的比例調整 (軟體 PWM)，
+ * 閃爍也在中斷內處理。靜態接線且最高亮度時不需要 PWM：閃爍時 SysTick
+ * 只在亮暗交替時中斷 (2 Hz)，不閃爍時停掉 SysTick。
+ */
+
+#define kDisplayMaxDigits 8
+#define kDisplayDimSteps 8      // 亮度等級 0 ~ kDisplayDimSteps
+#define kDisplayRefreshHz 100   // 每位數每秒刷新次數
+#define kDisplayBlinkHalfMs 500 // 閃爍時亮 / 暗各持續多久
+
+typedef struct
+{
+    uint8_t digits;
+    bool multiplexed;
+    // 靜態：每位數 a 段所在的 bit；多工：只使用 [0]
+    uint8_t segment_shift[kDisplayMaxDigits];
+    // 多工：每位數的選擇腳 (bit mask)，靜態接線時不使用
+    uint16_t select_mask[kDisplayMaxDigits];
+} display_panel_t;
+
+void display_init(const display_panel_t *panel);
+void display_set_number(int value);
+void display_set_blink(bool enable);
+void display_set_brightness(uint8_t level);
+
+#endif /* DISPLAY_H */
@@ -0,0 +1,60 @@
+#ifndef ECHO_CAPTURE_H
+#define ECHO_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 超音波 Echo 脈寬量測 (TIM2 Input Capture)
+ *
+ * - 入口 Echo: PA2 = TIM2_CH3
+ * - 出口 Echo: PA1 = TIM2_CH2
+ *
+ * TIM2 同時負責出口 Servo 的 PWM (CH1)，必須先設定成 1 MHz 計數，
+ * 因此邊緣時間戳由硬體鎖存，解析度 1 µs。
+ * F1 的通用計時器不支援雙邊緣捕捉，ISR 每次捕捉後切換 CCxP 極性。
+ * 完成的脈寬經由 single-producer/single-consumer 佇列交給主迴圈。
+ *
+ * 脈寬可能超過一個 TIM2 週期 (Servo 的 20 ms)。不開 update 中斷計算溢位
+ * (否則每秒多喚醒 50 次)，整數個週期改由兩次 ISR 之間 timebase 的經過時間
+ * 推算，見 echo_capture_width()。
+ *
+ * 時脈切換期間 TIM2 與 timebase 以錯誤的速度計數：切換前以
+ * echo_capture_suspend() 停止捕捉，重新載入 PSC 後 echo_capture_resume()
+ * 丟棄量測到一半的脈寬 (計入 echo_capture_dropped())，從上升沿重來。
+ */
+
+#define kEchoQueueSize 8 // 必須是 2 的次方
+
+typedef enum
+{
+    ECHO_ENTRY = 0,
+    ECHO_EXIT,
+    ECHO_SENSOR_COUNT
+} echo_sensor_t;
+
+typedef struct
+{
+    uint8_t sensor;    // echo_sensor_t
+    uint32_t width_us; // Echo 高電位寬度
+} echo_sample_t;
+
+// 上升沿與下降沿的 CCR 只能得到脈寬除以 TIM2 週期 (period tick) 的餘數；
+// elapsed_us 是兩次 ISR 之間 timebase 的經過時間，與餘數的差四捨五入成
+// 整數個週期。兩次 ISR 的延遲相差小於半個週期時結果正確
+static inline uint32_t echo_capture_width(uint32_t rise_ccr, uint32_t fall_ccr,
+        uint32_t elapsed_us, uint32_t period)
+{
+    uint32_t rest = (fall_ccr + period - rise_ccr) % period;
+    int32_t extra = (int32_t) (elapsed_us - rest) + (int32_t) (period / 2);
+
+    return rest + (extra > 0 ? (uint32_t) extra / period * period : 0);
+}
+
+void echo_capture_init(void);
+bool echo_capture_pop(echo_sample_t *sample);
+uint32_t echo_capture_dropped(void);
+void echo_capture_suspend(void);
+void echo_capture_resume(void);
+
+#endif /* ECHO_CAPTURE_H */
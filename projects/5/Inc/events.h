@@ -0,0 +1,27 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+/*
+ * 事件排程核心
+ *
+ * ISR 以 events_post() 設定事件位元，主迴圈處理完工作後呼叫
+ * events_wait()：沒有事件時以 __WFI 進入 sleep mode，被中斷喚醒後
+ * 回傳並清除所有待處理的事件。定時工作以 timebase_set_alarm() 喚醒。
+ *
+ * 睡眠時間累計在 events_idle_us()，可用來計算 CPU 負載。
+ */
+
+#define EVENT_ECHO (1u << 0)   // Echo 佇列有新樣本
+#define EVENT_RX (1u << 1)     // USART 收到一段資料
+#define EVENT_TIMER (1u << 2)  // timebase alarm 到期
+#define EVENT_CLOCK (1u << 3)  // RCC：HSE、PLL 或 LSE ready
+#define EVENT_ALL 0xFFFFFFFFu
+
+void events_post(uint32_t events);
+uint32_t events_wait(void);
+uint32_t events_idle_us(void);
+uint32_t events_wakeups(void);
+
+#endif /* EVENTS_H */
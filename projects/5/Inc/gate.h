@@ -0,0 +1,61 @@
+#ifndef GATE_H
+#define GATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 閘門 Servo 狀態機 (非阻塞)
+ *
+ *   CLOSED -> OPENING -> OPEN -> CLOSING -> CLOSED
+ *
+ * 每次 gate_request() 代表一台車要通過；狀態轉換的時間點由 timebase
+ * 決定，主迴圈每輪呼叫 gate_update() 即可，不會阻塞其他工作。
+ * 開啟期間若又有車到達，閘門保持開啟直到所有 pending 的車都通過。
+ */
+
+typedef enum
+{
+    GATE_CLOSED = 0,
+    GATE_OPENING,
+    GATE_OPEN,
+    GATE_CLOSING
+} gate_state_t;
+
+typedef struct
+{
+    volatile uint16_t *ccr; // Servo PWM 的 CCR 暫存器
+    uint16_t open_pulse;
+    uint16_t closed_pulse;
+    uint32_t travel_us;     // Servo 轉動所需時間
+    uint32_t hold_us;       // 每台車保持開啟的時間
+
+    gate_state_t state;
+    uint32_t deadline_us;   // 目前狀態結束的時間點
+    uint16_t pending;       // 尚未通過的車輛數
+    uint32_t requested;     // 累計請求數
+    uint32_t served;        // 累計已放行數
+} gate_t;
+
+void gate_init(gate_t *gate, volatile uint16_t *ccr, uint16_t open_pulse,
+        uint16_t closed_pulse, uint32_t travel_us, uint32_t hold_us);
+void gate_request(gate_t *gate, uint32_t now_us);
+void gate_update(gate_t *gate, uint32_t now_us);
+
+static inline bool gate_is_idle(const gate_t *gate)
+{
+    return gate->state == GATE_CLOSED && gate->pending == 0;
+}
+
+// 閘門下一次需要處理的時間點；閒置時回傳 false
+static inline bool gate_next_deadline(const gate_t *gate, uint32_t *deadline_us)
+{
+    if (gate->state == GATE_CLOSED)
+    {
+        return false;
+    }
+    *deadline_us = gate->deadline_us;
+    return true;
+}
+
+#endif /* GATE_H */
@@ -0,0 +1,59 @@
+#ifndef PARKING_H
+#define PARKING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "echo_capture.h"
+#include "gate.h"
+#include "presence.h"
+
+/*
+ * 停車場控制邏輯：感測器觸發排程、回波判斷進出、車位計數
+ *
+ * 不直接存取暫存器 (Trig 脈衝與回波量測由呼叫端負責)，
+ * 因此主機端的車流模擬 (tools/traffic_sim.c) 與韌體共用同一份程式。
+ *
+ * 觸發排程：
+ * - 有車接近 (單筆距離或中位數 < kApproachMm) 或停在感測器前時，
+ *   該感測器每 active_gap_us 量測一次；淨空後間隔逐次加倍到 idle_gap_us
+ * - 兩顆感測器共用同一個「發波時段」：一次只有一顆發波，
+ *   下一次發波至少間隔 kPingCycle，避免彼此收到對方的回波
+ *
+ * 每顆感測器的距離經過 presence.h 的濾波；車子到達 (PRESENCE_ARRIVED)
+ * 時計數並開門，每台車只計數一次。車位已滿時保留這台車，
+ * 在它離開前一有空位就計數。
+ */
+
+#define kIdleGap 500 * 1000        // 淨空時的量測間隔 (500 ms)
+#define kActiveGap 60 * 1000       // 有車時的量測間隔 (60 ms)
+#define kPingCycle 60 * 1000       // HC-SR04 建議的最短量測週期，兩顆感測器共用
+#define kServoDelay 450            // Servo 閘門開啟後延遲多久關閉 (ms)
+#define kServoTravel 150           // Servo 轉動所需時間 (ms)，包含在 kServoDelay 內
+#define kDefaultCapacity 20        // 預設停車格數
+
+typedef struct
+{
+    volatile int *remaining_spaces;
+    int *capacity;
+    gate_t *entry_gate;
+    gate_t *exit_gate;
+    uint32_t idle_gap_us;
+    uint32_t active_gap_us;
+    const int8_t *temperature_c;              // 音速溫度補償用的氣溫
+
+    uint32_t next_trigger_us[ECHO_SENSOR_COUNT];
+    uint32_t gap_us[ECHO_SENSOR_COUNT];       // 目前的量測間隔
+    presence_t presence[ECHO_SENSOR_COUNT];
+    bool waiting[ECHO_SENSOR_COUNT];          // 已到達但還沒計數的車 (車位已滿)
+    uint32_t channel_free_us;                 // 下一次允許發波的時間點
+    uint8_t last_sensor;                      // 上一次發波的感測器
+    uint32_t last_echo_us[ECHO_SENSOR_COUNT]; // 最近一次的 Echo 脈寬 (遙測用)
+} parking_t;
+
+void parking_init(parking_t *lot, uint32_t now_us);
+uint8_t parking_poll_due(parking_t *lot, uint32_t now_us);
+uint32_t parking_next_trigger(const parking_t *lot);
+bool parking_on_echo(parking_t *lot, uint8_t sensor, uint32_t width_us,
+        uint32_t now_us);
+
+#endif /* PARKING_H */
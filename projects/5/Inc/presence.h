@@ -0,0 +1,54 @@
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#include <stdint.h>
+#include "units.h"
+
+/*
+ * 超音波距離濾波與車輛存在判斷 (全整數運算)
+ *
+ * - Echo 脈寬由 units_echo_to_mm() 依溫度補償的音速換算成 mm
+ * - 最近 kPresenceWindow 筆距離取中位數，單筆鬼影或漏波不會改變結果
+ * - 遲滯門檻：中位數 < kArriveMm 才算車子到達，> kDepartMm 才算離開，
+ *   停在門檻附近的車不會反覆觸發
+ *
+ *   CLEAR <-> APPROACH (中位數 < kApproachMm) -> OCCUPIED (< kArriveMm)
+ *   OCCUPIED -> CLEAR / APPROACH (> kDepartMm)
+ *
+ * 進入 OCCUPIED 時回傳 PRESENCE_ARRIVED，離開時回傳 PRESENCE_DEPARTED。
+ */
+
+#define kPresenceWindow 5       // 中位數視窗 (奇數)
+#define kArriveMm 1000          // 中位數小於此值視為車子到達
+#define kDepartMm 1200          // 中位數大於此值視為車子離開
+#define kApproachMm 2000        // 中位數小於此值視為有車接近
+#define kDefaultTemperature 20  // 預設氣溫 (°C)
+#define kMinTemperature (-40)
+#define kMaxTemperature 85
+
+typedef enum
+{
+    PRESENCE_CLEAR = 0,
+    PRESENCE_APPROACH,
+    PRESENCE_OCCUPIED
+} presence_state_t;
+
+typedef enum
+{
+    PRESENCE_NONE = 0,
+    PRESENCE_ARRIVED,
+    PRESENCE_DEPARTED
+} presence_event_t;
+
+typedef struct
+{
+    uint16_t window_mm[kPresenceWindow];
+    uint8_t next;           // 下一筆寫入的位置
+    uint16_t median_mm;
+    presence_state_t state;
+} presence_t;
+
+void presence_init(presence_t *presence);
+presence_event_t presence_update(presence_t *presence, uint16_t distance_mm);
+
+#endif /* PRESENCE_H */
@@ -0,0 +1,50 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Flash 紀錄區：斷電後保留的 key / value (車輛數與設定)
+ *
+ * 使用 flash 最後兩頁 (連結腳本的 STORE 區，見 cmake/devices/)，一次只有
+ * 一頁有效。每頁第 0 格為頁首，之後每格一筆紀錄，只往後追加 (append-only)：
+ *
+ *   頁首  magic | generation | CRC32
+ *   紀錄  key   | value      | CRC32      (每格 3 個 word，CRC 周邊計算)
+ *
+ * 同一個 key 以最後一筆有效紀錄為準。頁寫滿時把每個 key 的目前值複製到
+ * 另一頁 (必要時先清除)，最後才寫入 generation + 1 的頁首，兩頁輪流清除。
+ *
+ * 斷電安全：開機時 store_init() 取頁首有效且 generation 最新的一頁，
+ * CRC 不符的紀錄 (寫到一半) 略過，寫入位置接在最後一個非空白格之後；
+ * 複製到一半的頁沒有頁首，不會被採用。
+ *
+ * store_set() 只更新 RAM，值與 flash 相同時不寫入；第一次變更後
+ * kStoreCommitDelay 才由 store_poll() 一次寫入所有變更的 key，連續的變更
+ * 只佔一筆紀錄。寫入與清除期間 CPU 會停在 flash 存取上 (清除一頁約 20 ms)，
+ * 只能在主迴圈呼叫。
+ */
+
+#define kStoreBase 0x0800F800       // 與連結腳本的 STORE 區相同
+#define kStorePageSize 1024         // medium density 的 flash 頁大小
+#define kStorePageCount 2
+#define kStoreMaxKeys 8
+#define kStoreCommitDelay 2000000   // 第一次變更到寫入 flash 的時間 (µs)
+#define kStoreTextMax 80            // store_format() 最多輸出的字元數
+
+typedef enum
+{
+    STORE_KEY_OCCUPIED = 1,       // 場內車輛數
+    STORE_KEY_CAPACITY,           // 容量 (CAP)
+    STORE_KEY_TELEMETRY_PERIOD    // 遙測週期 µs (RATE)
+} store_key_t;
+
+void store_init(void);
+bool store_get(uint16_t key, uint32_t *value);
+void store_set(uint16_t key, uint32_t value, uint32_t now_us);
+void store_poll(uint32_t now_us);
+bool store_next_deadline(uint32_t *deadline_us);
+char *store_format(char *out);
+
+#endif /* STORE_H */
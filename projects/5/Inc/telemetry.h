@@ -0,0 +1,64 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 二進位遙測 frame
+ *
+ *   0x00 | COBS( payload | CRC32 ) | 0x00
+ *
+ * payload 固定 kTelemetryPayloadSize 個位元組 (little-endian)，
+ * CRC32 由 CRC 周邊 (CRC_CalcBlockCRC) 以 32-bit word 為單位計算：
+ * 多項式 0x04C11DB7、初值 0xFFFFFFFF、不反射、不做 final XOR。
+ * frame 前後都放分隔符號，夾雜的文字回覆 (OK/ERR) 不會污染下一個 frame。
+ *
+ * 本檔同時給 tools/telemetry_decode.c 使用，只能依賴標準標頭。
+ */
+
+#define kTelemetryVersion 2
+
+// payload 欄位位移
+#define kTelemetryOffVersion 0     // u8
+#define kTelemetryOffSeq 1         // u16
+#define kTelemetryOffTimestamp 3   // u32, µs
+#define kTelemetryOffOccupied 7    // u8
+#define kTelemetryOffCapacity 8    // u8
+#define kTelemetryOffEntryEcho 9   // u16, µs (飽和於 0xFFFF)
+#define kTelemetryOffExitEcho 11   // u16, µs
+#define kTelemetryOffGates 13      // u8, 低 4 bit 入口 / 高 4 bit 出口 (gate_state_t)
+#define kTelemetryOffEchoDropped 14  // u16
+#define kTelemetryOffTxRejected 16   // u16
+#define kTelemetryOffRxTruncated 18  // u16
+#define kTelemetryOffCpuLoad 20    // u16, 0.1 %
+#define kTelemetryOffWakeups 22    // u16, 上一個回報週期內的喚醒次數
+#define kTelemetryPayloadSize 24   // 必須是 4 的倍數 (CRC 以 word 計算)
+#define kTelemetryFrameSize (kTelemetryPayloadSize + 4)
+
+typedef enum
+{
+    TELEMETRY_TEXT = 0,
+    TELEMETRY_BINARY
+} telemetry_mode_t;
+
+typedef struct
+{
+    uint32_t timestamp_us;
+    uint8_t occupied;
+    uint8_t capacity;
+    uint32_t entry_echo_us;
+    uint32_t exit_echo_us;
+    uint8_t entry_gate;
+    uint8_t exit_gate;
+    uint32_t echo_dropped;
+    uint32_t tx_rejected;
+    uint32_t rx_truncated;
+    uint16_t cpu_load_permille;
+    uint32_t wakeups;
+} telemetry_record_t;
+
+void telemetry_init(void);
+bool telemetry_send(const telemetry_record_t *record);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,58 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 無中斷 (tickless) 的 µs 時基
+ *
+ * TIM3 (master) 以 1 MHz 計數，溢位時透過 TRGO 推動 TIM4 (slave,
+ * external clock mode 1, ITR2)，兩顆 16-bit 計時器串成 32-bit 的 µs 計數器，
+ * 約 71.6 分鐘回繞一次。TIM4 溢位 (即 32-bit 回繞) 的 update 中斷累計回繞
+ * 次數，timebase_now_us64() 以此組成單調遞增的 64-bit 時間，不需要定期取樣。
+ *
+ * 32-bit 時間請一律以下列 helper 比較，不要直接用 < 或 >=。
+ *
+ * timebase_set_alarm() 以 TIM3 CC1 比較中斷在指定時間點送出 EVENT_TIMER；
+ * 超過一個 TIM3 週期的等待會先提早喚醒，由呼叫端重新設定。
+ *
+ * TIM3 的 PSC 由 clock_freqs() 計算，時脈切換時自動重新設定 (需先 clock_init())。
+ */
+
+void timebase_init(void);
+uint32_t timebase_now_us(void);
+uint64_t timebase_now_us64(void);
+void timebase_set_alarm(uint32_t deadline_us);
+
+// a 是否晚於 b (回繞安全，兩者相差需小於 2^31 µs)
+static inline bool timebase_after(uint32_t a, uint32_t b)
+{
+    return (int32_t) (a - b) > 0;
+}
+
+// 從 since 到 now 經過的 µs (回繞安全)
+static inline uint32_t timebase_elapsed(uint32_t now, uint32_t since)
+{
+    return now - since;
+}
+
+// now 是否已到達 deadline
+static inline bool timebase_reached(uint32_t now, uint32_t deadline)
+{
+    return (int32_t) (now - deadline) >= 0;
+}
+
+// 以回繞次數與 32-bit 讀值組成 64-bit 時間。wrap_pending = 讀值之後看到
+// 尚未處理的 TIM4 update 旗標：讀值落在前半圈表示回繞發生在讀值之前
+static inline uint64_t timebase_join(uint32_t wraps, uint32_t now_us,
+        bool wrap_pending)
+{
+    if (wrap_pending && now_us < 0x80000000U)
+    {
+        wraps++;
+    }
+    return ((uint64_t) wraps << 32) | now_us;
+}
+
+#endif /* TIMEBASE_H */
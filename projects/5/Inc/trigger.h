@@ -0,0 +1,25 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdint.h>
+
+/*
+ * 超音波 Trig 脈衝 (TIM1 CH2/CH3 比較事件 + DMA 寫 GPIOC->BSRR)
+ *
+ * PC13/PC14 不是計時器輸出腳，因此由 TIM1 的比較事件觸發 DMA 直接寫
+ * BSRR 產生脈衝：
+ * - CH2 比較 -> DMA1 Channel 3：單次寫入所選感測器的 BSx (拉高 Trig)
+ * - CH3 比較 -> DMA1 Channel 6：循環寫入 BR13 | BR14 (拉低 Trig)
+ *
+ * CCR3 固定落後 CCR2 kTrigPulseTicks，脈寬由硬體決定，不受中斷影響，
+ * 也不需要 CPU 忙等。TIM1 同時產生入口 Servo 的 PWM (CH1)，
+ * CH2/CH3 只使用比較事件，不輸出到腳位。
+ */
+
+#define kTrigPulseTicks 12 // Trig 脈寬 (TIM1 tick = 1 µs)：規格最少 10 µs，留 DMA 延遲的餘裕
+#define kTrigLeadTicks 20  // 從 trigger_fire() 到脈衝開始的最短時間
+
+void trigger_init(void);
+void trigger_fire(uint8_t sensor);
+
+#endif /* TRIGGER_H */
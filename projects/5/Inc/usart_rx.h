@@ -0,0 +1,21 @@
+#ifndef USART_RX_H
+#define USART_RX_H
+
+#include <stdint.h>
+
+/*
+ * USART1 DMA 接收 (DMA1 Channel 5, circular mode)
+ *
+ * 位元組由 DMA 直接寫入環狀緩衝區，不產生逐字元中斷；
+ * USART IDLE 中斷只在一段傳輸結束時觸發一次，用來切分 frame。
+ * 一個 frame 以 '\r' / '\n' 或線路閒置作為結尾，由主迴圈取出。
+ */
+
+#define kUsartRxBufferSize 64  // 必須大於兩次 poll 之間可能收到的位元組數
+#define kUsartRxFrameSize 32   // 單一 frame 最大長度 (含結尾 '\0')
+
+void usart_rx_init(void);
+uint16_t usart_rx_get_frame(char *frame, uint16_t size);
+uint32_t usart_rx_truncated(void);
+
+#endif /* USART_RX_H */
@@ -0,0 +1,39 @@
+#ifndef USART_TX_H
+#define USART_TX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * USART1 DMA 傳送 (DMA1 Channel 4)
+ *
+ * 傳送緩衝區是 bip-buffer：每筆資料保證在緩衝區內連續，
+ * 因此每段資料只需要一次 DMA 傳輸，呼叫端也可以先 usart_tx_reserve()
+ * 取得緩衝區內的位置直接寫入，再 usart_tx_commit()，不需要額外複製。
+ *
+ * 空間不足時整筆拒收並計入統計，不會覆蓋尚未送出的資料。
+ *
+ * 改變 BRR (時脈切換) 前以 usart_tx_suspend() 停止 DMA request 並等待
+ * 移位中的字元送完，之後 usart_tx_resume() 從下一個位元組繼續。
+ */
+
+#define kUsartTxBufferSize 256
+
+typedef struct
+{
+    uint32_t sent_bytes;     // 已交給 DMA 的位元組
+    uint32_t dropped_bytes;  // 因空間不足被拒收的位元組
+    uint32_t rejected;       // 被拒收的筆數
+    uint16_t high_water;     // 緩衝區最高使用量
+} usart_tx_stats_t;
+
+void usart_tx_init(void);
+bool usart_tx_write(const void *data, uint16_t len);
+char *usart_tx_reserve(uint16_t len);
+void usart_tx_commit(uint16_t len);
+uint16_t usart_tx_pending(void);
+void usart_tx_suspend(void);
+void usart_tx_resume(void);
+void usart_tx_get_stats(usart_tx_stats_t *stats);
+
+#endif /* USART_TX_H */
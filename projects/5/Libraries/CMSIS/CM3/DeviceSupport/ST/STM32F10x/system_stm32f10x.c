@@ -111,7 +111,7 @@
 /* #define SYSCLK_FREQ_36MHz  36000000 */
 /* #define SYSCLK_FREQ_48MHz  48000000 */
 /* #define SYSCLK_FREQ_56MHz  56000000 */
-#define SYSCLK_FREQ_72MHz  72000000
+/* #define SYSCLK_FREQ_72MHz  72000000 */ /* HSI boot: PLL is started by boot.c */
 #endif
 
 /*!< Uncomment the following line if you need to use external SRAM mounted
@@ -0,0 +1,162 @@
+#include "stm32f10x.h"
+#include "boot.h"
+#include "clock.h"
+#include "timebase.h"
+#include "usart_tx.h"
+#include "fmt.h"
+
+// CMSIS 1.30 的 core_cm3.h 沒有定義 DWT
+#define DWT_CTRL   (*(volatile uint32_t *) 0xE0001000UL)
+#define DWT_CYCCNT (*(volatile uint32_t *) 0xE0001004UL)
+#define DWT_CTRL_CYCCNTENA (1UL << 0)
+
+#define kResetFlagsShift 26 // RCC->CSR 的重置原因旗標
+
+typedef enum
+{
+    BOOT_STAGE_HSE = 0,
+    BOOT_STAGE_PLL,
+    BOOT_STAGE_DONE
+} boot_stage_t;
+
+static const char *const kFaultNames[] = { "NONE", "HSE", "PLL" };
+
+NOINIT uint32_t g_startup_cycles[BOOT_PHASE_COUNT]; // startup 寫入，不能被清除
+
+static boot_metrics_t g_metrics;
+static boot_stage_t g_stage = BOOT_STAGE_DONE;
+static uint32_t g_origin_us;  // timebase 0 對應的重置後時間
+static uint32_t g_start_us;   // 開始等待 HSE 的 timebase 時間
+
+static uint32_t since_reset(uint32_t now_us)
+{
+    return g_origin_us + now_us;
+}
+
+void boot_start_cycle_counter(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+// 沒有經過 startup (除錯器直接跳到 main) 時 CYCCNT 未啟動，main_us 記為 0
+void boot_init(void)
+{
+    uint32_t now_us = timebase_now_us();
+
+    if ((DWT_CTRL & DWT_CTRL_CYCCNTENA) != 0)
+    {
+        uint32_t previous = 0;
+
+        g_metrics.main_us = DWT_CYCCNT / (clock_freqs()->hclk_hz / 1000000);
+        for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++)
+        {
+            g_metrics.phase_cycles[i] = g_startup_cycles[i] - previous;
+            previous = g_startup_cycles[i];
+        }
+    }
+    g_origin_us = g_metrics.main_us - now_us;
+    g_metrics.reset_flags = RCC->CSR >> kResetFlagsShift;
+    RCC->CSR |= RCC_CSR_RMVF;
+
+    // SystemInit 已經切到 PLL (其他 system_stm32f10x.c 設定) 時不必再啟動
+    if (clock_profile() == CLOCK_PROFILE_RUN)
+    {
+        g_metrics.run_us = g_metrics.main_us;
+        return;
+    }
+    g_start_us = now_us;
+    g_stage = BOOT_STAGE_HSE;
+    clock_start_hse();
+}
+
+// 由 EVENT_CLOCK 或 boot_next_deadline() 的 alarm 喚醒後呼叫；沒有事時直接返回
+void boot_poll(uint32_t now_us)
+{
+    if (g_stage == BOOT_STAGE_HSE && clock_hse_ready())
+    {
+        g_metrics.hse_ready_us = since_reset(now_us);
+        clock_start_pll();
+        g_stage = BOOT_STAGE_PLL;
+    }
+    if (g_stage == BOOT_STAGE_PLL && clock_pll_ready())
+    {
+        g_metrics.pll_ready_us = since_reset(now_us);
+        if (clock_set_profile(CLOCK_PROFILE_RUN))
+        {
+            g_metrics.run_us = since_reset(timebase_now_us());
+        }
+        else
+        {
+            g_metrics.fault = BOOT_FAULT_PLL;
+        }
+        g_stage = BOOT_STAGE_DONE;
+    }
+    if (g_stage != BOOT_STAGE_DONE
+            && timebase_elapsed(now_us, g_start_us) >= kBootClockTimeout)
+    {
+        clock_cancel_start();
+        g_metrics.fault = g_stage == BOOT_STAGE_HSE ? BOOT_FAULT_HSE :
+                BOOT_FAULT_PLL;
+        g_stage = BOOT_STAGE_DONE;
+
+        char line[20];
+        char *end = fmt_str(line, "BOOT FAULT ");
+        end = fmt_str(end, kFaultNames[g_metrics.fault]);
+        end = fmt_str(end, "\r\n");
+        usart_tx_write(line, end - line);
+    }
+}
+
+bool boot_next_deadline(uint32_t *deadline_us)
+{
+    if (g_stage == BOOT_STAGE_DONE)
+    {
+        return false;
+    }
+    *deadline_us = g_start_us + kBootClockTimeout;
+    return true;
+}
+
+void boot_mark_ping(uint32_t now_us)
+{
+    if (g_metrics.first_ping_us == 0)
+    {
+        g_metrics.first_ping_us = since_reset(now_us);
+    }
+}
+
+const boot_metrics_t *boot_metrics(void)
+{
+    return &g_metrics;
+}
+
+// "BOOT main=<µs> hse=<µs> pll=<µs> run=<µs> ping=<µs> rst=<hex> clk=<MHz> fault=<名稱>
+//  init=<SystemInit>,<.data>,<.bss>,<ctors>" (startup 各階段的 cycle 數)
+char *boot_format(char *out)
+{
+    static const char *const kLabels[] =
+    { "BOOT main=", " hse=", " pll=", " run=", " ping=" };
+    const uint32_t times[] =
+    { g_metrics.main_us, g_metrics.hse_ready_us, g_metrics.pll_ready_us,
+            g_metrics.run_us, g_metrics.first_ping_us };
+
+    for (uint8_t i = 0; i < sizeof(times) / sizeof(times[0]); i++)
+    {
+        out = fmt_str(out, kLabels[i]);
+        out = fmt_u32(out, times[i], 1);
+    }
+    out = fmt_str(out, " rst=");
+    out = fmt_write(out, FMT_HEX(2), g_metrics.reset_flags);
+    out = fmt_str(out, " clk=");
+    out = fmt_u32(out, clock_freqs()->sysclk_hz / 1000000, 1);
+    out = fmt_str(out, " fault=");
+    out = fmt_str(out, kFaultNames[g_metrics.fault]);
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        out = fmt_str(out, i == 0 ? " init=" : ",");
+        out = fmt_u32(out, g_metrics.phase_cycles[i], 1);
+    }
+    return out;
+}
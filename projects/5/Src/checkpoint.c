@@ -0,0 +1,191 @@
+#include "stm32f10x.h"
+#include "stm32f10x_bkp.h"
+#include "stm32f10x_rtc.h"
+#include "checkpoint.h"
+#include "fmt.h"
+
+#define kCheckpointMagic 0xC4B7  // check 的初值：全 0 (備份區重置後) 不會通過
+#define kRtcPrescaler 32767      // LSE 32.768 kHz → 1 Hz
+#define kBankCount 2
+
+typedef enum
+{
+    BANK_SEQ = 0,
+    BANK_COUNTS,     // occupied | capacity << 8
+    BANK_TIME_LOW,
+    BANK_TIME_HIGH,
+    BANK_CHECK,
+    BANK_WORDS
+} bank_word_t;
+
+typedef enum
+{
+    RTC_STATE_OFF = 0,
+    RTC_STATE_STARTING,  // 等待 LSE 起振
+    RTC_STATE_RUNNING
+} rtc_state_t;
+
+static const uint16_t kBanks[kBankCount][BANK_WORDS] =
+{
+    { BKP_DR1, BKP_DR2, BKP_DR3, BKP_DR4, BKP_DR5 },
+    { BKP_DR6, BKP_DR7, BKP_DR8, BKP_DR9, BKP_DR10 }
+};
+static const char *const kRtcNames[] = { "OFF", "START", "RUN" };
+
+static rtc_state_t g_rtc = RTC_STATE_OFF;
+static checkpoint_t g_current;
+static bool g_valid = false;   // g_current 已寫入 (或開機時讀到) 備份區
+static uint8_t g_bank = 0;     // 最後寫入的一組
+static uint16_t g_seq = 0;
+static uint32_t g_saves = 0;
+
+static uint16_t bank_check(const uint16_t *words)
+{
+    return kCheckpointMagic ^ words[BANK_SEQ] ^ words[BANK_COUNTS]
+            ^ words[BANK_TIME_LOW] ^ words[BANK_TIME_HIGH];
+}
+
+static bool read_bank(uint8_t bank, uint16_t *words)
+{
+    for (uint8_t i = 0; i < BANK_WORDS; i++)
+    {
+        words[i] = BKP_ReadBackupRegister(kBanks[bank][i]);
+    }
+    return words[BANK_CHECK] == bank_check(words);
+}
+
+static uint32_t rtc_seconds(void)
+{
+    return g_rtc == RTC_STATE_RUNNING ? RTC_GetCounter() : 0;
+}
+
+// 寫入另一組，check 最後寫
+static void write_bank(void)
+{
+    uint16_t words[BANK_WORDS];
+
+    words[BANK_SEQ] = ++g_seq;
+    words[BANK_COUNTS] = g_current.occupied
+            | (uint16_t) (g_current.capacity << 8);
+    words[BANK_TIME_LOW] = g_current.event_s & 0xFFFF;
+    words[BANK_TIME_HIGH] = g_current.event_s >> 16;
+    words[BANK_CHECK] = bank_check(words);
+
+    g_bank ^= 1;
+    for (uint8_t i = 0; i < BANK_WORDS; i++)
+    {
+        BKP_WriteBackupRegister(kBanks[g_bank][i], words[i]);
+    }
+}
+
+// VBAT 保留的 RTC 只需等待 APB 同步；否則打開 LSE，起振後由 checkpoint_poll() 設定。
+// RTCSEL 只能設定一次：已選了 LSE 以外的時脈時重置備份區，再把讀到的快照寫回
+void checkpoint_init(void)
+{
+    uint16_t words[kBankCount][BANK_WORDS];
+    bool valid[kBankCount];
+    const uint32_t kRtcMask = RCC_BDCR_LSERDY | RCC_BDCR_RTCEN
+            | RCC_BDCR_RTCSEL;
+    const uint32_t kRtcRunning = RCC_BDCR_LSERDY | RCC_BDCR_RTCEN
+            | RCC_BDCR_RTCSEL_LSE;
+
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;
+    PWR->CR |= PWR_CR_DBP; // 解除 BDCR、RTC、BKP 的寫入保護
+
+    for (uint8_t bank = 0; bank < kBankCount; bank++)
+    {
+        valid[bank] = read_bank(bank, words[bank]);
+    }
+    if (valid[0] || valid[1])
+    {
+        // 兩組都有效時取 seq 較新的一組 (回繞後仍可比較)
+        g_bank = !valid[0] || (valid[1] && (int16_t) (words[1][BANK_SEQ]
+                - words[0][BANK_SEQ]) > 0) ? 1 : 0;
+        const uint16_t *w = words[g_bank];
+        g_seq = w[BANK_SEQ];
+        g_current.occupied = w[BANK_COUNTS] & 0xFF;
+        g_current.capacity = w[BANK_COUNTS] >> 8;
+        g_current.event_s = ((uint32_t) w[BANK_TIME_HIGH] << 16)
+                | w[BANK_TIME_LOW];
+        g_valid = true;
+    }
+
+    uint32_t rtcsel = RCC->BDCR & RCC_BDCR_RTCSEL;
+    if (rtcsel != RCC_BDCR_RTCSEL_NOCLOCK && rtcsel != RCC_BDCR_RTCSEL_LSE)
+    {
+        RCC->BDCR |= RCC_BDCR_BDRST;
+        RCC->BDCR &= ~RCC_BDCR_BDRST;
+        if (g_valid)
+        {
+            write_bank();
+        }
+    }
+
+    if ((RCC->BDCR & kRtcMask) == kRtcRunning)
+    {
+        RTC_WaitForSynchro();
+        g_rtc = RTC_STATE_RUNNING;
+    }
+    else
+    {
+        RCC->BDCR |= RCC_BDCR_LSEON;
+        RCC->CIR |= RCC_CIR_LSERDYIE;
+        g_rtc = RTC_STATE_STARTING;
+    }
+}
+
+// 由 EVENT_CLOCK (LSE ready) 喚醒後呼叫；沒有事時直接返回
+void checkpoint_poll(void)
+{
+    if (g_rtc != RTC_STATE_STARTING || (RCC->BDCR & RCC_BDCR_LSERDY) == 0)
+    {
+        return;
+    }
+    // checkpoint_init() 之後 RTCSEL 只會是 0 或 LSE
+    RCC->BDCR = (RCC->BDCR & ~RCC_BDCR_RTCSEL) | RCC_BDCR_RTCSEL_LSE
+            | RCC_BDCR_RTCEN;
+    RTC_WaitForSynchro();
+    RTC_WaitForLastTask();
+    RTC_SetPrescaler(kRtcPrescaler);
+    RTC_WaitForLastTask();
+    g_rtc = RTC_STATE_RUNNING;
+}
+
+bool checkpoint_get(checkpoint_t *checkpoint)
+{
+    *checkpoint = g_current;
+    return g_valid;
+}
+
+// 值沒變時不寫入；LSE 就緒前 (RTC 尚未計數) 的變更時間記為 0
+void checkpoint_set(uint8_t occupied, uint8_t capacity)
+{
+    if (g_valid && occupied == g_current.occupied
+            && capacity == g_current.capacity)
+    {
+        return;
+    }
+    g_current = (checkpoint_t) { occupied, capacity, rtc_seconds() };
+    write_bank();
+    g_valid = true;
+    g_saves++;
+}
+
+// "CKPT rtc=OFF|START|RUN now=<s> last=<s> seq=<n> saves=<n>"
+// rtc=START 時 (LSE 尚未就緒) now=0，期間的變更 last=0
+char *checkpoint_format(char *out)
+{
+    static const char *const kLabels[] =
+    { " now=", " last=", " seq=", " saves=" };
+    const uint32_t values[] =
+    { rtc_seconds(), g_current.event_s, g_seq, g_saves };
+
+    out = fmt_str(out, "CKPT rtc=");
+    out = fmt_str(out, kRtcNames[g_rtc]);
+    for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        out = fmt_str(out, kLabels[i]);
+        out = fmt_u32(out, values[i], 1);
+    }
+    return out;
+}
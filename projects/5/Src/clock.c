@@ -0,0 +1,195 @@
+#include "stm32f10x.h"
+#include "stm32f10x_rcc.h"
+#include "clock.h"
+#include "events.h"
+
+#define kClockReadyTimeout 0x10000 // HSE 起振 / PLL 鎖定的輪詢上限 (8 MHz 下約 10 ms)
+
+static clock_freqs_t g_freqs;
+static clock_profile_t g_profile = CLOCK_PROFILE_RUN;
+static clock_listener_t g_listeners[kClockMaxListeners];
+static uint8_t g_listener_count = 0;
+
+// 由 RCC 暫存器重新計算各時脈，並同步 CMSIS 的 SystemCoreClock
+static void update_freqs(void)
+{
+    RCC_ClocksTypeDef clocks;
+
+    RCC_GetClocksFreq(&clocks);
+    g_freqs.sysclk_hz = clocks.SYSCLK_Frequency;
+    g_freqs.hclk_hz = clocks.HCLK_Frequency;
+    g_freqs.pclk1_hz = clocks.PCLK1_Frequency;
+    g_freqs.pclk2_hz = clocks.PCLK2_Frequency;
+    // APB 預除頻不是 1 時，計時器時脈為 PCLK x2 (RM0008 7.2)
+    g_freqs.tim_apb1_hz = clocks.PCLK1_Frequency
+            * ((RCC->CFGR & RCC_CFGR_PPRE1_2) != 0 ? 2 : 1);
+    g_freqs.tim_apb2_hz = clocks.PCLK2_Frequency
+            * ((RCC->CFGR & RCC_CFGR_PPRE2_2) != 0 ? 2 : 1);
+    SystemCoreClock = clocks.HCLK_Frequency;
+}
+
+static bool wait_ready(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+{
+    for (uint32_t i = 0; i < kClockReadyTimeout; i++)
+    {
+        if ((*reg & mask) == value)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// HSE x9；PLL 開啟後不能再改倍頻設定，已開啟 (clock_start_pll) 時不動
+static void enable_pll(void)
+{
+    if ((RCC->CR & RCC_CR_PLLON) != 0)
+    {
+        return;
+    }
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_PLLSRC | RCC_CFGR_PLLXTPRE
+            | RCC_CFGR_PLLMULL)) | RCC_CFGR_PLLSRC_HSE | RCC_CFGR_PLLMULL9;
+    RCC->CR |= RCC_CR_PLLON;
+}
+
+// 72 MHz：先提高 flash wait state 再切換；HSE 或 PLL 失敗時維持 HSI
+static bool switch_to_run(void)
+{
+    RCC->CR |= RCC_CR_HSEON;
+    if (!wait_ready(&RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY))
+    {
+        RCC->CR &= ~RCC_CR_HSEON;
+        return false;
+    }
+
+    FLASH->ACR = FLASH_ACR_PRFTBE | FLASH_ACR_LATENCY_2;
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2))
+            | RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_PPRE2_DIV1;
+    enable_pll();
+    if (!wait_ready(&RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY))
+    {
+        RCC->CR &= ~(RCC_CR_PLLON | RCC_CR_HSEON);
+        FLASH->ACR = FLASH_ACR_PRFTBE | FLASH_ACR_LATENCY_0;
+        return false;
+    }
+
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+    return wait_ready(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_PLL);
+}
+
+// 8 MHz HSI：先切換再降低 wait state，最後關掉 PLL 與 HSE
+static bool switch_to_idle(void)
+{
+    RCC->CR |= RCC_CR_HSION;
+    if (!wait_ready(&RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY))
+    {
+        return false;
+    }
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSI;
+    if (!wait_ready(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_HSI))
+    {
+        return false;
+    }
+
+    RCC->CFGR &= ~(RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2);
+    FLASH->ACR = FLASH_ACR_PRFTBE | FLASH_ACR_LATENCY_0;
+    RCC->CR &= ~(RCC_CR_PLLON | RCC_CR_HSEON);
+    return true;
+}
+
+void clock_init(void)
+{
+    update_freqs();
+    g_profile = (RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL
+            ? CLOCK_PROFILE_RUN : CLOCK_PROFILE_IDLE;
+}
+
+const clock_freqs_t *clock_freqs(void)
+{
+    return &g_freqs;
+}
+
+clock_profile_t clock_profile(void)
+{
+    return g_profile;
+}
+
+bool clock_add_listener(clock_listener_t listener)
+{
+    if (g_listener_count == kClockMaxListeners)
+    {
+        return false;
+    }
+    g_listeners[g_listener_count++] = listener;
+    return true;
+}
+
+bool clock_set_profile(clock_profile_t profile)
+{
+    if (profile == g_profile)
+    {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < g_listener_count; i++)
+    {
+        g_listeners[i](CLOCK_EVENT_PRE_CHANGE, &g_freqs);
+    }
+
+    bool ok = profile == CLOCK_PROFILE_RUN ? switch_to_run() : switch_to_idle();
+    update_freqs();
+    if (ok)
+    {
+        g_profile = profile;
+    }
+
+    // 失敗時時脈可能未變，仍要讓驅動程式恢復
+    for (uint8_t i = g_listener_count; i > 0; i--)
+    {
+        g_listeners[i - 1](CLOCK_EVENT_POST_CHANGE, &g_freqs);
+    }
+    return ok;
+}
+
+void clock_start_hse(void)
+{
+    RCC->CIR |= RCC_CIR_HSERDYIE;
+    RCC->CR |= RCC_CR_HSEON;
+    NVIC_EnableIRQ(RCC_IRQn);
+}
+
+void clock_start_pll(void)
+{
+    RCC->CIR |= RCC_CIR_PLLRDYIE;
+    enable_pll();
+}
+
+bool clock_hse_ready(void)
+{
+    return (RCC->CR & RCC_CR_HSERDY) != 0;
+}
+
+bool clock_pll_ready(void)
+{
+    return (RCC->CR & RCC_CR_PLLRDY) != 0;
+}
+
+// 仍在 HSI 時才關掉 HSE / PLL；已切到 PLL (CLOCK RUN) 就只關中斷
+void clock_cancel_start(void)
+{
+    RCC->CIR &= ~(RCC_CIR_HSERDYIE | RCC_CIR_PLLRDYIE);
+    if ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+    {
+        RCC->CR &= ~(RCC_CR_PLLON | RCC_CR_HSEON);
+    }
+}
+
+// ready 旗標只會出現一次：清除旗標並關掉對應的中斷，交給主迴圈處理
+void RCC_IRQHandler(void)
+{
+    uint32_t flags = RCC->CIR
+            & (RCC_CIR_HSERDYF | RCC_CIR_PLLRDYF | RCC_CIR_LSERDYF);
+
+    RCC->CIR = (RCC->CIR & ~(flags << 8)) | (flags << 16);
+    events_post(EVENT_CLOCK);
+}
@@ -0,0 +1,251 @@
+#include "command.h"
+#include "usart_tx.h"
+#include "fmt.h"
+#include "telemetry.h"
+#include "presence.h"
+#include "clock.h"
+#include "boot.h"
+#include "store.h"
+#include "checkpoint.h"
+#include "display.h"
+#include "echo_capture.h"
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#define kMaxCapacity 99
+#define kMinTelemetryPeriod 100
+#define kMaxTelemetryPeriod 60000
+
+// 比對指令關鍵字 (不分大小寫)，成功時回傳關鍵字之後的位置
+static const char *match_word(const char *line, const char *word)
+{
+    while (*word)
+    {
+        if (toupper((unsigned char) *line) != *word)
+        {
+            return NULL;
+        }
+        line++;
+        word++;
+    }
+    if (*line != '\0' && *line != ' ')
+    {
+        return NULL;
+    }
+    while (*line == ' ')
+    {
+        line++;
+    }
+    return line;
+}
+
+static bool parse_uint(const char *str, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    if (*str == '\0')
+    {
+        return false;
+    }
+    while (*str >= '0' && *str <= '9')
+    {
+        result = result * 10 + (*str++ - '0');
+        if (result > 1000000)
+        {
+            return false;
+        }
+    }
+    while (*str == ' ')
+    {
+        str++;
+    }
+    *value = result;
+    return *str == '\0';
+}
+
+static bool parse_int(const char *str, int32_t *value)
+{
+    uint32_t magnitude;
+    bool negative = *str == '-';
+
+    if (!parse_uint(negative ? str + 1 : str, &magnitude))
+    {
+        return false;
+    }
+    *value = negative ? -(int32_t) magnitude : (int32_t) magnitude;
+    return true;
+}
+
+static void reply(const char *str)
+{
+    usart_tx_write(str, strlen(str));
+}
+
+static bool set_capacity(const command_context_t *ctx, uint32_t capacity)
+{
+    int occupied = *ctx->capacity - *ctx->remaining_spaces;
+
+    if (capacity < 1 || capacity > kMaxCapacity || (int) capacity < occupied)
+    {
+        return false;
+    }
+    *ctx->capacity = capacity;
+    *ctx->remaining_spaces = capacity - occupied;
+    return true;
+}
+
+void command_execute(const command_context_t *ctx, const char *line,
+        uint32_t now_us)
+{
+    const char *arg;
+    uint32_t value;
+    bool ok = false;
+
+    while (*line == ' ')
+    {
+        line++;
+    }
+
+    if ((arg = match_word(line, "Q")) != NULL && *arg == '\0')
+    {
+        char buffer[4 + 2 * FMT_I32_MAX + 4];
+        char *end = fmt_str(buffer, "OCC ");
+        end = fmt_write(end, FMT_DEC(2),
+                *ctx->capacity - *ctx->remaining_spaces);
+        *end++ = '/';
+        end = fmt_write(end, FMT_DEC(2), *ctx->capacity);
+        end = fmt_str(end, "\r\n");
+        usart_tx_write(buffer, end - buffer);
+        return;
+    }
+    else if ((arg = match_word(line, "LOAD")) != NULL && *arg == '\0')
+    {
+        char buffer[5 + FMT_I32_MAX + 4];
+        char *end = fmt_str(buffer, "LOAD ");
+        end = fmt_write(end, FMT_FIXED(1, 1), *ctx->cpu_load_permille);
+        end = fmt_str(end, "%\r\n");
+        usart_tx_write(buffer, end - buffer);
+        return;
+    }
+    else if ((arg = match_word(line, "ECHO")) != NULL && *arg == '\0')
+    {
+        char buffer[11 + 5 + 6 + 5 + 6 + FMT_U32_MAX + 2];
+        char *end = fmt_str(buffer, "ECHO entry=");
+        end = fmt_u32(end, units_echo_to_mm(ctx->last_echo_us[ECHO_ENTRY],
+                *ctx->temperature_c), 0);
+        end = fmt_str(end, " exit=");
+        end = fmt_u32(end, units_echo_to_mm(ctx->last_echo_us[ECHO_EXIT],
+                *ctx->temperature_c), 0);
+        end = fmt_str(end, " drop=");
+        end = fmt_u32(end, echo_capture_dropped(), 0);
+        end = fmt_str(end, "\r\n");
+        usart_tx_write(buffer, end - buffer);
+        return;
+    }
+    else if ((arg = match_word(line, "BOOT")) != NULL && *arg == '\0')
+    {
+        // 直接格式化到 TX 緩衝區，不佔用 stack
+        char *start = usart_tx_reserve(kBootTextMax + 2);
+        if (start != NULL)
+        {
+            char *end = fmt_str(boot_format(start), "\r\n");
+            usart_tx_commit(end - start);
+        }
+        return;
+    }
+    else if ((arg = match_word(line, "STORE")) != NULL && *arg == '\0')
+    {
+        char *start = usart_tx_reserve(kStoreTextMax + 2);
+        if (start != NULL)
+        {
+            char *end = fmt_str(store_format(start), "\r\n");
+            usart_tx_commit(end - start);
+        }
+        return;
+    }
+    else if ((arg = match_word(line, "CKPT")) != NULL && *arg == '\0')
+    {
+        char *start = usart_tx_reserve(kCheckpointTextMax + 2);
+        if (start != NULL)
+        {
+            char *end = fmt_str(checkpoint_format(start), "\r\n");
+            usart_tx_commit(end - start);
+        }
+        return;
+    }
+    else if ((arg = match_word(line, "CAP")) != NULL)
+    {
+        ok = parse_uint(arg, &value) && set_capacity(ctx, value);
+    }
+    else if ((arg = match_word(line, "OPEN")) != NULL)
+    {
+        const char *rest;
+        if ((rest = match_word(arg, "ENTRY")) != NULL && *rest == '\0')
+        {
+            gate_request(ctx->entry_gate, now_us);
+            ok = true;
+        }
+        else if ((rest = match_word(arg, "EXIT")) != NULL && *rest == '\0')
+        {
+            gate_request(ctx->exit_gate, now_us);
+            ok = true;
+        }
+    }
+    else if ((arg = match_word(line, "RATE")) != NULL)
+    {
+        if (parse_uint(arg, &value) && value >= kMinTelemetryPeriod
+                && value <= kMaxTelemetryPeriod)
+        {
+            *ctx->telemetry_period_us = value * 1000;
+            ok = true;
+        }
+    }
+    else if ((arg = match_word(line, "BRIGHT")) != NULL)
+    {
+        if (parse_uint(arg, &value) && value <= kDisplayDimSteps)
+        {
+            display_set_brightness(value);
+            ok = true;
+        }
+    }
+    else if ((arg = match_word(line, "TEMP")) != NULL)
+    {
+        int32_t celsius;
+        if (parse_int(arg, &celsius) && celsius >= kMinTemperature
+                && celsius <= kMaxTemperature)
+        {
+            *ctx->temperature_c = celsius;
+            ok = true;
+        }
+    }
+    else if ((arg = match_word(line, "MODE")) != NULL)
+    {
+        const char *rest;
+        if ((rest = match_word(arg, "TEXT")) != NULL && *rest == '\0')
+        {
+            *ctx->telemetry_mode = TELEMETRY_TEXT;
+            ok = true;
+        }
+        else if ((rest = match_word(arg, "BIN")) != NULL && *rest == '\0')
+        {
+            *ctx->telemetry_mode = TELEMETRY_BINARY;
+            ok = true;
+        }
+    }
+    else if ((arg = match_word(line, "CLOCK")) != NULL)
+    {
+        // 回覆在切換之後送出，使用新的 BRR
+        const char *rest;
+        if ((rest = match_word(arg, "RUN")) != NULL && *rest == '\0')
+        {
+            ok = clock_set_profile(CLOCK_PROFILE_RUN);
+        }
+        else if ((rest = match_word(arg, "IDLE")) != NULL && *rest == '\0')
+        {
+            ok = clock_set_profile(CLOCK_PROFILE_IDLE);
+        }
+    }
+
+    reply(ok ? "OK\r\n" : "ERR\r\n");
+}
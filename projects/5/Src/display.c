@@ -0,0 +1,195 @@
+#include "stm32f10x.h"
+#include "display.h"
+#include "clock.h"
+
+// 0 ~ 9 的 a-g 段
+static const uint8_t kSegments[10] =
+{ 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x27, 0x7F, 0x6F };
+
+static const display_panel_t *g_panel;
+static uint16_t g_pins = 0;             // 顯示器使用到的所有腳位
+
+// 以下由 SysTick_Handler 讀取
+static volatile uint32_t g_on_word[kDisplayMaxDigits]; // 各位數點亮時的 BSRR
+static volatile uint32_t g_off_word = 0;               // 全部熄滅的 BSRR
+static volatile uint8_t g_brightness = kDisplayDimSteps;
+static volatile bool g_blink = false;
+static uint8_t g_slot = 0;
+static uint32_t g_blink_slots = 0;      // 閃爍半週期的 slot 數
+static uint32_t g_blink_count = 0;
+static volatile bool g_blink_off = false;
+static bool g_pwm = false;              // SysTick 目前以軟體 PWM 的頻率運作
+
+static uint8_t slot_count(void)
+{
+    return (g_panel->multiplexed ? g_panel->digits : 1) * kDisplayDimSteps;
+}
+
+// 多工或調光時以軟體 PWM 刷新，每個 slot 一次中斷；只閃爍時每半週期一次
+static bool needs_pwm(void)
+{
+    return g_panel->multiplexed || g_brightness < kDisplayDimSteps;
+}
+
+// 以 HCLK 設定 SysTick：軟體 PWM 用 HCLK 計數，只閃爍時用 HCLK / 8
+// (72 MHz 下 500 ms 超出 24-bit 的 LOAD)
+static void systick_start(uint32_t hclk_hz)
+{
+    SysTick->CTRL = 0;
+    if (g_pwm)
+    {
+        SysTick->LOAD = hclk_hz / (kDisplayRefreshHz * slot_count()) - 1;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+    }
+    else
+    {
+        SysTick->LOAD = hclk_hz / 8 / 1000 * kDisplayBlinkHalfMs - 1;
+    }
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+// 依目前設定決定 SysTick 是否需要運作、以哪一種頻率運作
+static void update_refresh(void)
+{
+    bool pwm = needs_pwm();
+    bool running = (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) != 0;
+
+    if (!pwm && !g_blink)
+    {
+        SysTick->CTRL = 0;
+        GPIOB->BSRR = g_on_word[0];
+        return;
+    }
+    if (!running || pwm != g_pwm)
+    {
+        g_pwm = pwm;
+        g_blink_slots = pwm ? kDisplayRefreshHz * slot_count()
+                * kDisplayBlinkHalfMs / 1000 : 1;
+        g_blink_count = 0;
+        systick_start(clock_freqs()->hclk_hz);
+    }
+    if (!pwm)
+    {
+        // 只在亮暗交替時才有中斷，新的數值要在這裡寫出
+        uint32_t primask = __get_PRIMASK();
+
+        __disable_irq();
+        GPIOB->BSRR = g_blink_off ? g_off_word : g_on_word[0];
+        __set_PRIMASK(primask);
+    }
+}
+
+// 時脈切換後以新的 HCLK 重算刷新週期 (SysTick 以 HCLK 計數)
+static void on_clock_change(clock_event_t event, const clock_freqs_t *freqs)
+{
+    if (event == CLOCK_EVENT_POST_CHANGE
+            && (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) != 0)
+    {
+        systick_start(freqs->hclk_hz);
+    }
+}
+
+void display_init(const display_panel_t *panel)
+{
+    g_panel = panel;
+    g_pins = 0;
+    for (uint8_t i = 0; i < panel->digits; i++)
+    {
+        if (panel->multiplexed)
+        {
+            g_pins |= (0x7F << panel->segment_shift[0])
+                    | panel->select_mask[i];
+        }
+        else
+        {
+            g_pins |= 0x7F << panel->segment_shift[i];
+        }
+    }
+    g_off_word = (uint32_t) g_pins << 16;
+
+    // 刷新中斷優先權設為最低，不影響 Echo 捕捉與 DMA
+    NVIC_SetPriority(SysTick_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+    clock_add_listener(on_clock_change);
+    display_set_number(0);
+}
+
+void display_set_number(int value)
+{
+    uint32_t words[kDisplayMaxDigits];
+    uint16_t all_on = 0;
+
+    if (value < 0)
+    {
+        value = 0;
+    }
+    for (uint8_t i = 0; i < g_panel->digits; i++)
+    {
+        uint8_t segments = kSegments[value % 10];
+        value /= 10;
+
+        if (g_panel->multiplexed)
+        {
+            uint16_t set = (segments << g_panel->segment_shift[0])
+                    | g_panel->select_mask[i];
+            words[i] = set | ((uint32_t) (g_pins & ~set) << 16);
+        }
+        else
+        {
+            all_on |= segments << g_panel->segment_shift[i];
+        }
+    }
+    if (!g_panel->multiplexed)
+    {
+        words[0] = all_on | ((uint32_t) (g_pins & ~all_on) << 16);
+    }
+
+    // 靜態顯示只用到 words[0]
+    uint8_t count = g_panel->multiplexed ? g_panel->digits : 1;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        g_on_word[i] = words[i];
+    }
+    __set_PRIMASK(primask);
+    update_refresh();
+}
+
+void display_set_blink(bool enable)
+{
+    if (enable == g_blink)
+    {
+        return;
+    }
+    g_blink = enable;
+    g_blink_off = false;
+    g_blink_count = 0;
+    update_refresh();
+}
+
+void display_set_brightness(uint8_t level)
+{
+    g_brightness = level > kDisplayDimSteps ? kDisplayDimSteps : level;
+    update_refresh();
+}
+
+void SysTick_Handler(void)
+{
+    uint8_t digit = g_slot / kDisplayDimSteps;
+    uint8_t step = g_slot % kDisplayDimSteps;
+
+    if (g_blink && ++g_blink_count >= g_blink_slots)
+    {
+        g_blink_count = 0;
+        g_blink_off = !g_blink_off;
+    }
+    bool lit = step < g_brightness && !(g_blink && g_blink_off);
+    GPIOB->BSRR = lit ? g_on_word[digit] : g_off_word;
+
+    if (++g_slot >= slot_count())
+    {
+        g_slot = 0;
+    }
+}
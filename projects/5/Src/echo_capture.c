@@ -0,0 +1,133 @@
+#include "stm32f10x.h"
+#include "echo_capture.h"
+#include "events.h"
+#include "timebase.h"
+
+// 佇列：head 只由 ISR 寫入，tail 只由主迴圈寫入
+static volatile echo_sample_t g_queue[kEchoQueueSize];
+static volatile uint8_t g_queue_head = 0;
+static volatile uint8_t g_queue_tail = 0;
+static volatile uint32_t g_dropped = 0;
+
+static uint32_t g_period = 0;              // TIM2 一個週期的 tick 數 (ARR + 1)
+static uint16_t g_rise_ccr[ECHO_SENSOR_COUNT];
+static uint32_t g_rise_us[ECHO_SENSOR_COUNT]; // 上升沿 ISR 時的 timebase
+
+static void queue_push(uint8_t sensor, uint32_t width_us)
+{
+    uint8_t head = g_queue_head;
+
+    if ((uint8_t) (head - g_queue_tail) >= kEchoQueueSize)
+    {
+        g_dropped++;
+        return;
+    }
+    g_queue[head % kEchoQueueSize].sensor = sensor;
+    g_queue[head % kEchoQueueSize].width_us = width_us;
+    g_queue_head = head + 1;
+    events_post(EVENT_ECHO);
+}
+
+void echo_capture_init(void)
+{
+    g_period = TIM2->ARR + 1;
+
+    // CH2 -> TI2, CH3 -> TI3，輸入濾波 fDTS/2 N=6 去除雜訊毛刺
+    TIM2->CCMR1 = (TIM2->CCMR1 & 0x00FF) | TIM_CCMR1_CC2S_0
+            | TIM_CCMR1_IC2F_2;
+    TIM2->CCMR2 = (TIM2->CCMR2 & 0xFF00) | TIM_CCMR2_CC3S_0
+            | TIM_CCMR2_IC3F_2;
+    // 從上升沿開始捕捉
+    TIM2->CCER = (TIM2->CCER & ~(TIM_CCER_CC2P | TIM_CCER_CC3P))
+            | TIM_CCER_CC2E | TIM_CCER_CC3E;
+
+    TIM2->SR = 0;
+    TIM2->DIER |= TIM_DIER_CC2IE | TIM_DIER_CC3IE;
+    NVIC->ISER[0] |= (1U << TIM2_IRQn);
+}
+
+bool echo_capture_pop(echo_sample_t *sample)
+{
+    uint8_t tail = g_queue_tail;
+
+    if (tail == g_queue_head)
+    {
+        return false;
+    }
+    sample->sensor = g_queue[tail % kEchoQueueSize].sensor;
+    sample->width_us = g_queue[tail % kEchoQueueSize].width_us;
+    g_queue_tail = tail + 1;
+    return true;
+}
+
+uint32_t echo_capture_dropped(void)
+{
+    return g_dropped;
+}
+
+void echo_capture_suspend(void)
+{
+    TIM2->DIER &= ~(TIM_DIER_CC2IE | TIM_DIER_CC3IE);
+}
+
+void echo_capture_resume(void)
+{
+    uint16_t falling = TIM2->CCER & (TIM_CCER_CC2P | TIM_CCER_CC3P);
+
+    // 等待下降沿的通道：上升沿是以切換前的速度鎖存的，丟棄
+    g_dropped += ((falling & TIM_CCER_CC2P) != 0)
+            + ((falling & TIM_CCER_CC3P) != 0);
+    TIM2->CCER &= ~(TIM_CCER_CC2P | TIM_CCER_CC3P);
+    TIM2->SR = ~(TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC2OF | TIM_SR_CC3OF);
+    TIM2->DIER |= TIM_DIER_CC2IE | TIM_DIER_CC3IE;
+}
+
+static void handle_edge(uint8_t sensor, uint16_t ccr, uint16_t polarity_bit,
+        uint32_t now_us)
+{
+    if ((TIM2->CCER & polarity_bit) == 0)
+    {
+        g_rise_ccr[sensor] = ccr;
+        g_rise_us[sensor] = now_us;
+        TIM2->CCER |= polarity_bit; // 改捕捉下降沿
+    }
+    else
+    {
+        queue_push(sensor, echo_capture_width(g_rise_ccr[sensor], ccr,
+                timebase_elapsed(now_us, g_rise_us[sensor]), g_period));
+        TIM2->CCER &= ~polarity_bit; // 改回上升沿
+    }
+}
+
+static void handle_channel(uint8_t sensor, uint16_t sr, uint16_t flag,
+        uint16_t overcapture_flag, volatile uint16_t *ccr,
+        uint16_t polarity_bit, uint32_t now_us)
+{
+    if ((sr & flag) == 0)
+    {
+        return;
+    }
+    // 讀取 CCRx 會自動清除 CCxIF
+    uint16_t value = *ccr;
+
+    if ((sr & overcapture_flag) != 0)
+    {
+        // 漏掉邊緣：極性已不可信，丟棄這次並從上升沿重來
+        TIM2->SR = ~overcapture_flag;
+        TIM2->CCER &= ~polarity_bit;
+        g_dropped++;
+        return;
+    }
+    handle_edge(sensor, value, polarity_bit, now_us);
+}
+
+void TIM2_IRQHandler(void)
+{
+    uint16_t sr = TIM2->SR;
+    uint32_t now_us = timebase_now_us();
+
+    handle_channel(ECHO_EXIT, sr, TIM_SR_CC2IF, TIM_SR_CC2OF, &TIM2->CCR2,
+            TIM_CCER_CC2P, now_us);
+    handle_channel(ECHO_ENTRY, sr, TIM_SR_CC3IF, TIM_SR_CC3OF, &TIM2->CCR3,
+            TIM_CCER_CC3P, now_us);
+}
@@ -0,0 +1,48 @@
+#include "stm32f10x.h"
+#include "events.h"
+#include "timebase.h"
+
+static volatile uint32_t g_pending = 0;
+static uint32_t g_idle_us = 0;
+static uint32_t g_wakeups = 0;
+
+void events_post(uint32_t events)
+{
+    // ISR 之間可能互相搶佔，需以 PRIMASK 保護 read-modify-write
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_pending |= events;
+    __set_PRIMASK(primask);
+}
+
+uint32_t events_wait(void)
+{
+    __disable_irq();
+    while (g_pending == 0)
+    {
+        // PRIMASK 設定時 WFI 仍會被待處理的中斷喚醒，
+        // 因此檢查 g_pending 與進入睡眠之間不會漏掉事件
+        uint32_t start_us = timebase_now_us();
+        __WFI();
+        g_idle_us += timebase_elapsed(timebase_now_us(), start_us);
+        g_wakeups++;
+
+        __enable_irq(); // 讓喚醒的中斷執行
+        __disable_irq();
+    }
+    uint32_t events = g_pending;
+    g_pending = 0;
+    __enable_irq();
+
+    return events;
+}
+
+uint32_t events_idle_us(void)
+{
+    return g_idle_us;
+}
+
+uint32_t events_wakeups(void)
+{
+    return g_wakeups;
+}
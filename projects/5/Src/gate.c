@@ -0,0 +1,80 @@
+#include "gate.h"
+#include "timebase.h"
+
+static void enter_state(gate_t *gate, gate_state_t state, uint32_t now_us,
+        uint32_t duration_us)
+{
+    gate->state = state;
+    gate->deadline_us = now_us + duration_us;
+}
+
+void gate_init(gate_t *gate, volatile uint16_t *ccr, uint16_t open_pulse,
+        uint16_t closed_pulse, uint32_t travel_us, uint32_t hold_us)
+{
+    gate->ccr = ccr;
+    gate->open_pulse = open_pulse;
+    gate->closed_pulse = closed_pulse;
+    gate->travel_us = travel_us;
+    gate->hold_us = hold_us;
+    gate->state = GATE_CLOSED;
+    gate->deadline_us = 0;
+    gate->pending = 0;
+    gate->requested = 0;
+    gate->served = 0;
+
+    *gate->ccr = closed_pulse;
+}
+
+void gate_request(gate_t *gate, uint32_t now_us)
+{
+    gate->pending++;
+    gate->requested++;
+
+    switch (gate->state)
+    {
+    case GATE_CLOSED:
+    case GATE_CLOSING:
+        // 關閉中也直接反轉回開啟
+        *gate->ccr = gate->open_pulse;
+        enter_state(gate, GATE_OPENING, now_us, gate->travel_us);
+        break;
+    case GATE_OPENING:
+    case GATE_OPEN:
+        // 已在開啟流程中，到 OPEN 結束時再逐台放行
+        break;
+    }
+}
+
+void gate_update(gate_t *gate, uint32_t now_us)
+{
+    if (gate->state == GATE_CLOSED || !timebase_reached(now_us,
+            gate->deadline_us))
+    {
+        return;
+    }
+
+    switch (gate->state)
+    {
+    case GATE_OPENING:
+        enter_state(gate, GATE_OPEN, now_us, gate->hold_us);
+        break;
+    case GATE_OPEN:
+        gate->pending--;
+        gate->served++;
+        if (gate->pending > 0)
+        {
+            enter_state(gate, GATE_OPEN, now_us, gate->hold_us);
+        }
+        else
+        {
+            *gate->ccr = gate->closed_pulse;
+            enter_state(gate, GATE_CLOSING, now_us, gate->travel_us);
+        }
+        break;
+    case GATE_CLOSING:
+        gate->state = GATE_CLOSED;
+        break;
+    case GATE_CLOSED:
+        break;
+    }
+}
@@ -1,16 +1,32 @@
 #include "stm32f10x.h"
-#include <stdio.h>
+#include "echo_capture.h"
+#include "timebase.h"
+#include "gate.h"
+#include "parking.h"
+#include "usart_tx.h"
+#include "usart_rx.h"
+#include "command.h"
+#include "telemetry.h"
+#include "display.h"
+#include "events.h"
+#include "trigger.h"
+#include "fmt.h"
+#include "units.h"
+#include "clock.h"
+#include "boot.h"
+#include "store.h"
+#include "checkpoint.h"
 #include <string.h>
 #include <stdbool.h>
 
 /*
  * - 入口超音波感測器 (Entry Sensor):
  * - Trig (觸發腳): PC13
- * - Echo (回波腳): PA2 (對應 EXTI2 中斷)
+ * - Echo (回波腳): PA2 (TIM2_CH3 Input Capture)
  *
  * - 出口超音波感測器 (Exit Sensor):
  * - Trig (觸發腳): PC14
- * - Echo (回波腳): PA1 (對應 EXTI1 中斷)
+ * - Echo (回波腳): PA1 (TIM2_CH2 Input Capture)
  *
  * - 入口閘門伺服馬達 (Entry Gate Servo):
  * - PWM 信號線: PA8 (使用 TIM1 Channel 1)
@@ -30,46 +46,75 @@
  * - a-g 段: PB8 - PB14
  */
 
-// Constants
-#define kTriggerGap 5 * 1000 * 1000 // 觸發間隔 (5 秒)
-#define kServoDelay 450            // Servo 閘門開啟後延遲多久關閉
-#define kServoOpen 1500
-#define kServoEntryClosed 2500
-#define kServoExitClosed 500
-#define kTxBufferSize 128           // USART 發送緩衝區 Buffer 大小
-
-#define kSysClockFreq 27000000
-#define kTim1ClockFreq 144000000
-#define kTim2ClockFreq 72000000
-#define kUsart1ClockFreq 72000000
+// Constants (量測間隔、Servo 時間與預設容量見 parking.h)
+#define kServoTickHz 1000000        // TIM1 / TIM2 計數頻率
+#define kServoPeriod UNITS_US_TO_TICKS(20000, kServoTickHz) // 50 Hz PWM
+#define kServoMinPulse 500          // 0° 的脈寬 (µs)
+#define kServoMaxPulse 2500         // 180° 的脈寬 (µs)
+#define kServoTicks(deg) UNITS_US_TO_TICKS(UNITS_SERVO_US((deg), kServoMinPulse, \
+        kServoMaxPulse), kServoTickHz)
+#define kServoOpen kServoTicks(90)
+#define kServoEntryClosed kServoTicks(180)
+#define kServoExitClosed kServoTicks(0)
+#define kTelemetryPeriod 500000    // 預設遙測回報週期 (500 ms)
+#define kUsartBaud 9600
+#define kRetainedMagic 0x43415253u // "SRAC"：.noinit 中的計數有效
+#define kFlashSnapshotPeriod 60000000 // 車輛數寫入 flash 紀錄區的週期 (µs)
 
 // Global variables
-// --- 超音波感測器
-volatile uint32_t g_entry_echo_duration_us = 0;
-volatile uint32_t g_exit_echo_duration_us = 0;
-static volatile uint32_t g_entry_echo_start_us = 0;
-static volatile uint32_t g_exit_echo_start_us = 0;
-volatile bool g_is_entry_detected = false;
-volatile bool g_is_exit_detected = false;
-
-// --- 計時與計數
-volatile uint32_t g_us_ticks = 0; // us 計時器
-volatile int g_remaining_spaces = 20;
-
-// USART
-char g_tx_buffer[kTxBufferSize];
-volatile uint16_t g_tx_head = 0;
-volatile uint16_t g_tx_tail = 0;
+// --- 計數
+volatile int g_remaining_spaces = kDefaultCapacity;
+int g_capacity = kDefaultCapacity;
+uint32_t g_telemetry_period_us = kTelemetryPeriod;
+uint8_t g_telemetry_mode = TELEMETRY_TEXT;
+int8_t g_temperature_c = kDefaultTemperature; // 音速補償用的氣溫 (TEMP 指令)
+
+// --- 軟體重置 / watchdog 重置後保留的車輛數 (.noinit，上電後內容隨機)
+typedef struct
+{
+    uint32_t magic;
+    int32_t occupied;
+    int32_t capacity;
+    uint32_t check;  // 前三個欄位 XOR 後取反
+} retained_counts_t;
+static NOINIT retained_counts_t g_retained;
+
+// --- CPU 負載 (每個遙測週期更新一次)
+uint16_t g_cpu_load_permille = 0;
+uint16_t g_wakeups_per_report = 0;
+
+// --- 七段顯示器 (靜態接線: 個位 PB0-6、十位 PB8-14)
+static const display_panel_t kDisplayPanel =
+{ .digits = 2, .multiplexed = false, .segment_shift = { 0, 8 } };
+
+// --- 閘門
+gate_t g_entry_gate;
+gate_t g_exit_gate;
+
+// --- 進出判斷與感測器排程
+parking_t g_parking =
+{ .remaining_spaces = &g_remaining_spaces, .capacity = &g_capacity,
+        .entry_gate = &g_entry_gate, .exit_gate = &g_exit_gate,
+        .idle_gap_us = kIdleGap, .active_gap_us = kActiveGap,
+        .temperature_c = &g_temperature_c };
 
 // 函式宣告
-void delay_us(uint32_t us); // 延遲 us
-void delay_ms(uint32_t ms); // 延遲 ms
-void usart1_send_str(char *str);
-void update_display(int count);
+bool usart1_send_str(const char *str);
+bool send_cars_report(int cars);
+bool send_binary_report(uint32_t now_us);
+void update_cpu_load(uint32_t now_us);
+void restore_state(void);
+void retain_counts(void);
+uint32_t earliest_deadline(uint32_t a, uint32_t b);
+void set_clock_dividers(const clock_freqs_t *freqs);
+void on_clock_change(clock_event_t event, const clock_freqs_t *freqs);
 
 int main(void)
 {
     // --- Clock 初始化 ---
+    // 各匯流排的時脈由 RCC 讀出，不寫死在程式裡；開機時為 HSI 8 MHz，
+    // HSE / PLL 由 boot_init() 在背景啟動，就緒後切換到 72 MHz
+    clock_init();
     // 啟用外設時脈
     RCC->APB2ENR |= RCC_APB2ENR_AFIOEN | RCC_APB2ENR_IOPAEN | RCC_APB2ENR_IOPBEN
             | RCC_APB2ENR_IOPCEN | RCC_APB2ENR_TIM1EN | RCC_APB2ENR_USART1EN;
@@ -87,24 +132,22 @@ int main(void)
     GPIOA->CRH = (GPIOA->CRH & ~0x00000FFF) | (0x4 << 8) | (0xB << 4)
             | (0xB << 0);
 
-    // --- SysTick 初始化 (10µs tick, 每 tick 將全域的 g_us_ticks += 10) ---
-    SysTick->LOAD = (kSysClockFreq / 100000) - 1;
-    SysTick->VAL = 0;
-    // SysTick 啟用計數器、啟用中斷
-    SysTick->CTRL = SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk;
+    // --- 時基初始化 (TIM3 -> TIM4 串接, TIM3/TIM4 與 TIM2 同在 APB1) ---
+    timebase_init();
+    boot_init();
 
-    // --- TIM1 & TIM2 PWM 初始化 ---
-    TIM1->PSC = (kTim1ClockFreq / 1000000) - 1;
-    TIM1->ARR = 20000 - 1;
+    // --- TIM1 & TIM2 PWM 初始化 (PSC 與 USART1 的 BRR 見 set_clock_dividers) ---
+    set_clock_dividers(clock_freqs());
+    TIM1->ARR = kServoPeriod - 1;
     TIM1->CCR1 = kServoEntryClosed;
 
     TIM1->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;
     TIM1->CCER = TIM_CCER_CC1E;
     TIM1->BDTR = TIM_BDTR_MOE;
     TIM1->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+    trigger_init(); // Trig 脈衝 (TIM1 CH2/CH3 + DMA)
 
-    TIM2->PSC = (kTim2ClockFreq / 1000000) - 1;
-    TIM2->ARR = 20000 - 1;
+    TIM2->ARR = kServoPeriod - 1;
     TIM2->CCR1 = kServoExitClosed;
 
     TIM2->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;
@@ -112,211 +155,302 @@ int main(void)
     TIM2->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
 
     // --- USART1 初始化 ---
-    USART1->BRR = kUsart1ClockFreq / 9600;
-    // 啟用 USART、傳送器、接收器及接收中斷
-    USART1->CR1 = USART_CR1_UE | USART_CR1_RE | USART_CR1_TE | USART_CR1_RXNEIE;
-
-    // --- EXTI & NVIC 初始化 ---
-    AFIO->EXTICR[0] = (AFIO->EXTICR[0] & ~0x0FF0) | (0x0 << 8) | (0x0 << 4);
-    // 設定中斷遮罩
-    EXTI->IMR |= EXTI_IMR_MR1 | EXTI_IMR_MR2;
-    // 設定上升沿觸發
-    EXTI->RTSR |= EXTI_RTSR_TR1 | EXTI_RTSR_TR2;
-    // 設定下降沿觸發
-    EXTI->FTSR |= EXTI_FTSR_TR1 | EXTI_FTSR_TR2;
-    // 使用 IRQn 編號來啟用中斷
-    NVIC->ISER[0] |= (1U << EXTI1_IRQn) | (1U << EXTI2_IRQn);
-    NVIC->ISER[1] |= (1U << (USART1_IRQn - 32));
+    // 啟用 USART、傳送器、接收器
+    USART1->CR1 = USART_CR1_UE | USART_CR1_RE | USART_CR1_TE;
+    // 傳送交給 DMA1 Channel 4，接收交給 DMA1 Channel 5 + IDLE 中斷
+    usart_tx_init();
+    usart_rx_init();
+    telemetry_init();
+    clock_add_listener(on_clock_change);
+
+    // --- 閘門狀態機 ---
+    gate_init(&g_entry_gate, &TIM1->CCR1, kServoOpen, kServoEntryClosed,
+            kServoTravel * 1000, (kServoDelay - kServoTravel) * 1000);
+    gate_init(&g_exit_gate, &TIM2->CCR1, kServoOpen, kServoExitClosed,
+            kServoTravel * 1000, (kServoDelay - kServoTravel) * 1000);
+
+    // --- Echo Input Capture (TIM2 CH2/CH3) ---
+    echo_capture_init();
+
+    // --- Flash 紀錄區 (斷電後保留的車輛數與設定) 與備份區快照 ---
+    store_init();
+    checkpoint_init();
+
+    // --- 遠端指令 ---
+    const command_context_t command_ctx =
+    { &g_remaining_spaces, &g_capacity, &g_telemetry_period_us,
+            &g_telemetry_mode, &g_cpu_load_permille, &g_entry_gate,
+            &g_exit_gate, &g_temperature_c, g_parking.last_echo_us };
 
     // --- 主迴圈 ---
-    uint32_t last_bt_send_time_us = 0;
-    uint32_t last_entry_trig_time_us = 0;
-    uint32_t last_exit_trig_time_us = 0;
-    bool exit_trig_started = false; // 用於標記出口觸發是否已開始
-
-    update_display(g_remaining_spaces);
-
+    uint32_t boot_time_us = timebase_now_us();
+    uint32_t last_bt_send_time_us = boot_time_us;
+    uint32_t last_snapshot_us = boot_time_us - kFlashSnapshotPeriod; // 開機後先寫一次
+    restore_state();
+    parking_init(&g_parking, boot_time_us);
+
+    int shown_spaces = g_remaining_spaces;
+    display_init(&kDisplayPanel);
+    display_set_number(shown_spaces);
+    display_set_blink(shown_spaces == 0); // 重置前已滿：開機即閃爍
+
+    uint32_t events = EVENT_ALL;
     while (1)
     {
-        float distance_m;
-        char buffer[30];
+        echo_sample_t echo;
+        char frame[kUsartRxFrameSize];
+        uint32_t now_us = timebase_now_us();
 
-        // --- 主迴圈中的週期性 Trig ---
-        if (g_us_ticks - last_entry_trig_time_us >= kTriggerGap)
+        // --- HSE / PLL 就緒或逾時、LSE 就緒 ---
+        boot_poll(now_us);
+        checkpoint_poll();
+
+        // --- Trig (由 parking 排程，一次只有一顆感測器發波) ---
+        uint8_t due = parking_poll_due(&g_parking, now_us);
+        for (uint8_t sensor = 0; sensor < ECHO_SENSOR_COUNT; sensor++)
         {
-            // 5 秒
-            last_entry_trig_time_us = g_us_ticks;
-            GPIOC->BSRR = GPIO_BSRR_BS13;
-            delay_us(10);
-            GPIOC->BRR = GPIO_BRR_BR13;
+            if ((due & (1U << sensor)) != 0)
+            {
+                trigger_fire(sensor);
+                boot_mark_ping(now_us);
+            }
         }
 
-        // 延遲 2.5 秒後才開始出口的 Trig
-        if (!exit_trig_started && g_us_ticks >= kTriggerGap / 2)
+        // --- 處理感測器 detect ---
+        while ((events & EVENT_ECHO) != 0 && echo_capture_pop(&echo))
         {
-            exit_trig_started = true;
-            last_exit_trig_time_us = g_us_ticks;
+            parking_on_echo(&g_parking, echo.sensor, echo.width_us, now_us);
         }
 
-        if (exit_trig_started
-                && (g_us_ticks - last_exit_trig_time_us >= kTriggerGap))
+        // --- 遠端指令 ---
+        while ((events & EVENT_RX) != 0
+                && usart_rx_get_frame(frame, sizeof(frame)) > 0)
         {
-            // 5 秒
-            last_exit_trig_time_us = g_us_ticks;
-            GPIOC->BSRR = GPIO_BSRR_BS14;
-            delay_us(10);
-            GPIOC->BRR = GPIO_BRR_BR14;
+            command_execute(&command_ctx, frame, now_us);
         }
 
-        // --- 處理感測器 detect ---
-        if (g_is_entry_detected)
-        {
-            g_is_entry_detected = false;
+        // --- 閘門狀態機 ---
+        gate_update(&g_entry_gate, now_us);
+        gate_update(&g_exit_gate, now_us);
 
-            distance_m = (g_entry_echo_duration_us * 343.0 / 2.0) / 1000000.0;
-            if (distance_m < 1.0 && g_remaining_spaces > 0)
-            {
-                g_remaining_spaces--;
-                TIM1->CCR1 = kServoOpen;
-                delay_ms(kServoDelay);
-                TIM1->CCR1 = kServoEntryClosed;
-            }
+        // --- 顯示器只在數值改變時更新，刷新與閃爍由 SysTick 負責 ---
+        if (g_remaining_spaces != shown_spaces)
+        {
+            shown_spaces = g_remaining_spaces;
+            display_set_number(shown_spaces);
+            display_set_blink(shown_spaces == 0);
+            retain_counts();
         }
 
-        if (g_is_exit_detected)
+        // --- 車輛數每次變更都寫入備份區；flash 紀錄區的車輛數只定期更新，
+        //     設定值有變才寫 (變更會合併) ---
+        checkpoint_set(g_capacity - g_remaining_spaces, g_capacity);
+        if (timebase_elapsed(now_us, last_snapshot_us) >= kFlashSnapshotPeriod)
         {
-            g_is_exit_detected = false;
-
-            distance_m = (g_exit_echo_duration_us * 343.0 / 2.0) / 1000000.0;
-
-            if (distance_m < 1.0 && g_remaining_spaces < 20)
-            {
-                g_remaining_spaces++;
-                TIM2->CCR1 = kServoOpen;
-                delay_ms(kServoDelay);
-                TIM2->CCR1 = kServoExitClosed;
-            }
+            store_set(STORE_KEY_OCCUPIED, g_capacity - g_remaining_spaces,
+                    now_us);
+            last_snapshot_us = now_us;
         }
+        store_set(STORE_KEY_CAPACITY, g_capacity, now_us);
+        store_set(STORE_KEY_TELEMETRY_PERIOD, g_telemetry_period_us, now_us);
+        store_poll(now_us);
 
-        if (g_remaining_spaces == 0)
+        if (timebase_elapsed(now_us, last_bt_send_time_us)
+                >= g_telemetry_period_us)
         {
-            if ((g_us_ticks / 500000) % 2)
+            update_cpu_load(now_us);
+            last_bt_send_time_us = now_us;
+            if (g_telemetry_mode == TELEMETRY_BINARY)
             {
-                GPIOB->ODR = 0x0000;
+                send_binary_report(now_us);
             }
             else
             {
-                update_display(0);
+                send_cars_report(g_capacity - g_remaining_spaces);
             }
         }
-        else
+
+        // --- 找出下一個定時工作的時間點，設定 alarm 後睡眠等待事件 ---
+        uint32_t next_us = parking_next_trigger(&g_parking);
+        uint32_t deadline_us;
+
+        next_us = earliest_deadline(next_us,
+                last_bt_send_time_us + g_telemetry_period_us);
+        next_us = earliest_deadline(next_us,
+                last_snapshot_us + kFlashSnapshotPeriod);
+        if (gate_next_deadline(&g_entry_gate, &deadline_us))
+        {
+            next_us = earliest_deadline(next_us, deadline_us);
+        }
+        if (gate_next_deadline(&g_exit_gate, &deadline_us))
         {
-            update_display(g_remaining_spaces);
+            next_us = earliest_deadline(next_us, deadline_us);
         }
-
-        if (g_us_ticks - last_bt_send_time_us >= 500000)
+        if (boot_next_deadline(&deadline_us))
         {
-            last_bt_send_time_us = g_us_ticks;
-            sprintf(buffer, "Current Cars: %02d\r\n", 20 - g_remaining_spaces);
-            usart1_send_str(buffer);
+            next_us = earliest_deadline(next_us, deadline_us);
         }
+        if (store_next_deadline(&deadline_us))
+        {
+            next_us = earliest_deadline(next_us, deadline_us);
+        }
+        timebase_set_alarm(next_us);
+        events = events_wait();
     }
 }
 
-void delay_us(uint32_t us)
+uint32_t earliest_deadline(uint32_t a, uint32_t b)
 {
-    uint32_t start = g_us_ticks;
-    while ((g_us_ticks - start) < us)
-        ;
+    return timebase_after(a, b) ? b : a;
 }
 
-void delay_ms(uint32_t ms)
+// PSC 平時要到下一次 update 才生效 (TIM2 在 8 MHz 下最多 180 ms)，以 UG
+// 立即載入並還原 CNT，PWM 週期與捕捉的相位不變
+static void load_timer_psc(TIM_TypeDef *tim, uint16_t psc)
 {
-    for (uint32_t i = 0; i < ms; i++)
-    {
-        delay_us(1000);
-    }
+    uint16_t count = tim->CNT;
+
+    tim->PSC = psc;
+    tim->EGR = TIM_EGR_UG;
+    tim->CNT = count;
+    tim->SR = ~TIM_SR_UIF;
 }
 
-// ISRs (中斷)
-// SysTick 中斷：只負責累加 g_us_ticks
-void SysTick_Handler(void)
+// Servo / Echo 計時器維持 1 MHz 計數，USART1 維持 kUsartBaud
+void set_clock_dividers(const clock_freqs_t *freqs)
 {
-    g_us_ticks += 10; // 每 10us 一次 += 10
+    load_timer_psc(TIM1, units_timer_psc(freqs->tim_apb2_hz, kServoTickHz));
+    load_timer_psc(TIM2, units_timer_psc(freqs->tim_apb1_hz, kServoTickHz));
+    USART1->BRR = units_usart_brr(freqs->pclk2_hz, kUsartBaud);
 }
 
-void USART1_IRQHandler(void)
+// 時脈切換：移位中的字元送完才改 BRR；切換期間的 Echo 量測丟棄
+void on_clock_change(clock_event_t event, const clock_freqs_t *freqs)
 {
-    // 檢查是否為 TXE (發送緩存區空) 中斷
-    if ((USART1->SR & USART_SR_TXE) != 0)
+    if (event == CLOCK_EVENT_PRE_CHANGE)
     {
-        if (g_tx_head != g_tx_tail)
-        {
-            // 如果緩衝區還有資料，發送下一個字元
-            USART1->DR = g_tx_buffer[g_tx_tail];
-            g_tx_tail = (g_tx_tail + 1) % kTxBufferSize;
-        }
-        else
-        {
-            // 如果緩衝區已空，關閉 TXE 中斷
-            USART1->CR1 &= ~USART_CR1_TXEIE;
-        }
+        usart_tx_suspend();
+        echo_capture_suspend();
+        return;
     }
+    set_clock_dividers(freqs);
+    echo_capture_resume();
+    usart_tx_resume();
+}
+
+static uint32_t retained_check(const retained_counts_t *counts)
+{
+    return ~(counts->magic ^ (uint32_t) counts->occupied
+            ^ (uint32_t) counts->capacity);
 }
 
-// EXTI 中斷
-void EXTI1_IRQHandler(void)
-{ // 出口 Echo (PA1)
-    if ((EXTI->PR & EXTI_PR_PR1) != 0)
+// 車輛數：軟體重置後 .noinit 的最新；上電時 (magic / check 不符) 改用備份區
+// (接 VBAT 時斷電後仍保留)，備份區也無效時用 flash 紀錄區 (最多少了
+// kFlashSnapshotPeriod 內的變更)；數值不合理時維持預設
+void restore_state(void)
+{
+    uint32_t occupied, capacity, period;
+    checkpoint_t checkpoint;
+
+    if (store_get(STORE_KEY_TELEMETRY_PERIOD, &period) && period != 0)
     {
-        if ((GPIOA->IDR & GPIO_IDR_IDR1) != 0)
-        {
-            g_exit_echo_start_us = g_us_ticks;
-        }
-        else
-        {
-            g_exit_echo_duration_us = g_us_ticks - g_exit_echo_start_us;
-            g_is_exit_detected = true;
-        }
-        EXTI->PR = EXTI_PR_PR1; // 清除中斷
+        g_telemetry_period_us = period;
     }
-}
 
-void EXTI2_IRQHandler(void)
-{ // 入口 Echo (PA2)
-    if ((EXTI->PR & EXTI_PR_PR2) != 0)
+    if (g_retained.magic == kRetainedMagic
+            && g_retained.check == retained_check(&g_retained)
+            && g_retained.capacity >= 1 && g_retained.occupied >= 0
+            && g_retained.occupied <= g_retained.capacity)
     {
-        if ((GPIOA->IDR & GPIO_IDR_IDR2) != 0)
-        {
-            g_entry_echo_start_us = g_us_ticks;
-        }
-        else
-        {
-            g_entry_echo_duration_us = g_us_ticks - g_entry_echo_start_us;
-            g_is_entry_detected = true;
-        }
-        EXTI->PR = EXTI_PR_PR2; // 清除中斷
+        g_capacity = g_retained.capacity;
+        g_remaining_spaces = g_retained.capacity - g_retained.occupied;
+        return;
     }
+    if (checkpoint_get(&checkpoint) && checkpoint.capacity >= 1
+            && checkpoint.occupied <= checkpoint.capacity)
+    {
+        g_capacity = checkpoint.capacity;
+        g_remaining_spaces = checkpoint.capacity - checkpoint.occupied;
+    }
+    else if (store_get(STORE_KEY_OCCUPIED, &occupied)
+            && store_get(STORE_KEY_CAPACITY, &capacity) && capacity >= 1
+            && occupied <= capacity)
+    {
+        g_capacity = capacity;
+        g_remaining_spaces = capacity - occupied;
+    }
+    retain_counts();
+}
+
+void retain_counts(void)
+{
+    g_retained.magic = kRetainedMagic;
+    g_retained.occupied = g_capacity - g_remaining_spaces;
+    g_retained.capacity = g_capacity;
+    g_retained.check = retained_check(&g_retained);
 }
 
-void usart1_send_str(char *str)
+// 以 events_wait() 累計的睡眠時間計算上一個遙測週期的 CPU 負載
+void update_cpu_load(uint32_t now_us)
 {
-    while (*str)
+    static uint32_t last_time_us = 0;
+    static uint32_t last_idle_us = 0;
+    static uint32_t last_wakeups = 0;
+    uint32_t idle_us = events_idle_us();
+    uint32_t wakeups = events_wakeups();
+    uint32_t window_ms = timebase_elapsed(now_us, last_time_us) / 1000;
+
+    if (window_ms > 0)
     {
-        // 將字元放入緩衝區
-        g_tx_buffer[g_tx_head] = *str++;
-        g_tx_head = (g_tx_head + 1) % kTxBufferSize;
+        uint32_t idle_permille = (idle_us - last_idle_us) / window_ms;
+        g_cpu_load_permille = idle_permille < 1000 ? 1000 - idle_permille : 0;
     }
-    // 啟用 TXE 中斷，開始發送過程
-    USART1->CR1 |= USART_CR1_TXEIE;
+    g_wakeups_per_report = wakeups - last_wakeups;
+    last_time_us = now_us;
+    last_idle_us = idle_us;
+    last_wakeups = wakeups;
 }
 
-void update_display(int count)
+// 空間不足時整串丟棄 (計入 usart_tx 統計)，不會覆蓋尚未送出的資料
+bool usart1_send_str(const char *str)
 {
-    uint16_t arr[10] =
-    { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x27, 0x7F, 0x6F };
-    if (count >= 0 && count <= 99)
+    return usart_tx_write(str, strlen(str));
+}
+
+// 直接格式化到 TX 緩衝區: "Current Cars: %02d\r\n"
+bool send_cars_report(int cars)
+{
+    static const char kPrefix[] = "Current Cars: ";
+    char *start = usart_tx_reserve(sizeof(kPrefix) - 1 + FMT_I32_MAX + 2);
+
+    if (start == NULL)
     {
-        GPIOB->ODR = (arr[count / 10] << 8) | arr[count % 10];
+        return false;
     }
+    char *end = fmt_str(start, kPrefix);
+    end = fmt_write(end, FMT_DEC(2), cars);
+    end = fmt_str(end, "\r\n");
+    usart_tx_commit(end - start);
+    return true;
+}
+
+bool send_binary_report(uint32_t now_us)
+{
+    usart_tx_stats_t tx_stats;
+    telemetry_record_t record;
+
+    usart_tx_get_stats(&tx_stats);
+    record.timestamp_us = now_us;
+    record.occupied = g_capacity - g_remaining_spaces;
+    record.capacity = g_capacity;
+    record.entry_echo_us = g_parking.last_echo_us[ECHO_ENTRY];
+    record.exit_echo_us = g_parking.last_echo_us[ECHO_EXIT];
+    record.entry_gate = g_entry_gate.state;
+    record.exit_gate = g_exit_gate.state;
+    record.echo_dropped = echo_capture_dropped();
+    record.tx_rejected = tx_stats.rejected;
+    record.rx_truncated = usart_rx_truncated();
+    record.cpu_load_permille = g_cpu_load_permille;
+    record.wakeups = g_wakeups_per_report;
+    return telemetry_send(&record);
 }
@@ -0,0 +1,122 @@
+#include "parking.h"
+#include "timebase.h"
+
+// 呼叫前需先設定 remaining_spaces、capacity、閘門、量測間隔與氣溫
+void parking_init(parking_t *lot, uint32_t now_us)
+{
+    for (uint8_t sensor = 0; sensor < ECHO_SENSOR_COUNT; sensor++)
+    {
+        lot->next_trigger_us[sensor] = now_us;
+        lot->gap_us[sensor] = lot->idle_gap_us;
+        presence_init(&lot->presence[sensor]);
+        lot->waiting[sensor] = false;
+        lot->last_echo_us[sensor] = 0;
+    }
+    lot->channel_free_us = now_us;
+    lot->last_sensor = ECHO_EXIT; // 開機後先量入口
+}
+
+// 回傳這次需要送出 Trig 的感測器 (bit = echo_sensor_t)，一次最多一顆
+uint8_t parking_poll_due(parking_t *lot, uint32_t now_us)
+{
+    uint8_t pick = ECHO_SENSOR_COUNT;
+
+    if (!timebase_reached(now_us, lot->channel_free_us))
+    {
+        return 0;
+    }
+    // 兩顆都到期時輪流，避免其中一顆一直搶走發波時段
+    for (uint8_t sensor = 0; sensor < ECHO_SENSOR_COUNT; sensor++)
+    {
+        if (timebase_reached(now_us, lot->next_trigger_us[sensor])
+                && (pick == ECHO_SENSOR_COUNT || pick == lot->last_sensor))
+        {
+            pick = sensor;
+        }
+    }
+    if (pick == ECHO_SENSOR_COUNT)
+    {
+        return 0;
+    }
+    lot->last_sensor = pick;
+    lot->channel_free_us = now_us + kPingCycle;
+    // 回波遺失時的保險，正常情況由 parking_on_echo() 重新排定
+    lot->next_trigger_us[pick] = now_us + lot->idle_gap_us;
+    return 1U << pick;
+}
+
+uint32_t parking_next_trigger(const parking_t *lot)
+{
+    uint32_t entry = lot->next_trigger_us[ECHO_ENTRY];
+    uint32_t exit = lot->next_trigger_us[ECHO_EXIT];
+    uint32_t next = timebase_after(entry, exit) ? exit : entry;
+
+    return timebase_after(lot->channel_free_us, next) ? lot->channel_free_us : next;
+}
+
+// 車位足夠時計數並開門
+static bool parking_count_car(parking_t *lot, uint8_t sensor, uint32_t now_us)
+{
+    if (sensor == ECHO_ENTRY)
+    {
+        if (*lot->remaining_spaces <= 0)
+        {
+            return false;
+        }
+        (*lot->remaining_spaces)--;
+        gate_request(lot->entry_gate, now_us);
+    }
+    else
+    {
+        if (*lot->remaining_spaces >= *lot->capacity)
+        {
+            return false;
+        }
+        (*lot->remaining_spaces)++;
+        gate_request(lot->exit_gate, now_us);
+    }
+    return true;
+}
+
+// 處理一筆回波；判定有新的車進出時更新車位並開啟閘門，回傳 true
+bool parking_on_echo(parking_t *lot, uint8_t sensor, uint32_t width_us,
+        uint32_t now_us)
+{
+    presence_t *presence = &lot->presence[sensor];
+    uint16_t distance_mm = units_echo_to_mm(width_us, *lot->temperature_c);
+    bool counted = false;
+
+    lot->last_echo_us[sensor] = width_us;
+    switch (presence_update(presence, distance_mm))
+    {
+    case PRESENCE_ARRIVED:
+        lot->waiting[sensor] = true;
+        break;
+    case PRESENCE_DEPARTED:
+        lot->waiting[sensor] = false;
+        break;
+    default:
+        break;
+    }
+    if (lot->waiting[sensor] && parking_count_car(lot, sensor, now_us))
+    {
+        lot->waiting[sensor] = false;
+        counted = true;
+    }
+
+    // 有車時全速量測 (單筆讀值接近也加快，讓中位數盡快確認)，淨空後逐次放慢
+    if (presence->state != PRESENCE_CLEAR || distance_mm < kApproachMm)
+    {
+        lot->gap_us[sensor] = lot->active_gap_us;
+    }
+    else if (lot->gap_us[sensor] < lot->idle_gap_us / 2)
+    {
+        lot->gap_us[sensor] *= 2;
+    }
+    else
+    {
+        lot->gap_us[sensor] = lot->idle_gap_us;
+    }
+    lot->next_trigger_us[sensor] = now_us + lot->gap_us[sensor];
+    return counted;
+}
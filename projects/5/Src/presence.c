@@ -0,0 +1,60 @@
+#include "presence.h"
+
+void presence_init(presence_t *presence)
+{
+    for (uint8_t i = 0; i < kPresenceWindow; i++)
+    {
+        presence->window_mm[i] = UINT16_MAX; // 開機時視為淨空
+    }
+    presence->next = 0;
+    presence->median_mm = UINT16_MAX;
+    presence->state = PRESENCE_CLEAR;
+}
+
+// 視窗很小，直接插入排序一份副本
+static uint16_t median(const uint16_t *values)
+{
+    uint16_t sorted[kPresenceWindow];
+
+    for (uint8_t i = 0; i < kPresenceWindow; i++)
+    {
+        uint16_t value = values[i];
+        uint8_t j = i;
+
+        while (j > 0 && sorted[j - 1] > value)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    return sorted[kPresenceWindow / 2];
+}
+
+presence_event_t presence_update(presence_t *presence, uint16_t distance_mm)
+{
+    presence_state_t old_state = presence->state;
+    uint16_t m;
+
+    presence->window_mm[presence->next] = distance_mm;
+    presence->next = (presence->next + 1) % kPresenceWindow;
+    m = median(presence->window_mm);
+    presence->median_mm = m;
+
+    if (old_state == PRESENCE_OCCUPIED)
+    {
+        if (m <= kDepartMm)
+        {
+            return PRESENCE_NONE;
+        }
+        presence->state = m < kApproachMm ? PRESENCE_APPROACH : PRESENCE_CLEAR;
+        return PRESENCE_DEPARTED;
+    }
+    if (m < kArriveMm)
+    {
+        presence->state = PRESENCE_OCCUPIED;
+        return PRESENCE_ARRIVED;
+    }
+    presence->state = m < kApproachMm ? PRESENCE_APPROACH : PRESENCE_CLEAR;
+    return PRESENCE_NONE;
+}
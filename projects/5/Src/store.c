@@ -0,0 +1,323 @@
+#include "stm32f10x.h"
+#include "stm32f10x_crc.h"
+#include "stm32f10x_flash.h"
+#include "store.h"
+#include "timebase.h"
+#include "fmt.h"
+#include <stddef.h>
+
+#define kStoreMagic 0x5453564Bu // "KVST"
+#define kNoPage 0xFF
+#define kSlotsPerPage (kStorePageSize / sizeof(slot_t))
+#define kSlotHalfWords (sizeof(slot_t) / 2)
+
+// 一格：頁首或紀錄
+typedef struct
+{
+    uint32_t tag;    // 頁首為 kStoreMagic，紀錄為 key
+    uint32_t value;  // 頁首為 generation
+    uint32_t crc;
+} slot_t;
+
+typedef struct
+{
+    uint16_t key;     // 0：未使用
+    bool in_flash;    // stored 有效
+    uint32_t value;   // 目前的值
+    uint32_t stored;  // flash 上最後一筆紀錄的值
+} entry_t;
+
+typedef struct
+{
+    uint16_t bad;     // 開機時略過的損壞紀錄
+    uint32_t writes;  // 開機後寫入的紀錄
+    uint32_t errors;  // 寫入失敗 (程式化錯誤或讀回不符)
+} store_stats_t;
+
+static entry_t g_entries[kStoreMaxKeys];
+static uint8_t g_entry_count = 0;
+static uint8_t g_page = kNoPage;   // 有效的頁
+static uint16_t g_next = 0;        // 下一個可寫入的格
+static uint32_t g_generation = 0;   // 換頁次數 (0：尚未寫入)
+static bool g_pending = false;
+static uint32_t g_deadline_us = 0;
+static store_stats_t g_stats;
+
+static uint32_t slot_address(uint8_t page, uint16_t index)
+{
+    return kStoreBase + page * kStorePageSize + index * sizeof(slot_t);
+}
+
+static const slot_t *slot_at(uint8_t page, uint16_t index)
+{
+    return (const slot_t *) (uintptr_t) slot_address(page, index);
+}
+
+static uint32_t slot_crc(uint32_t tag, uint32_t value)
+{
+    uint32_t words[2] = { tag, value };
+
+    CRC_ResetDR();
+    return CRC_CalcBlockCRC(words, 2);
+}
+
+static bool slot_erased(const slot_t *slot)
+{
+    return slot->tag == 0xFFFFFFFF && slot->value == 0xFFFFFFFF
+            && slot->crc == 0xFFFFFFFF;
+}
+
+static bool slot_valid(const slot_t *slot)
+{
+    return slot->crc == slot_crc(slot->tag, slot->value);
+}
+
+static bool page_blank(uint8_t page)
+{
+    for (uint16_t i = 0; i < kSlotsPerPage; i++)
+    {
+        if (!slot_erased(slot_at(page, i)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void flash_done(void)
+{
+    FLASH_Lock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+}
+
+// 依位址順序寫入 6 個 half-word，寫完後讀回確認
+static bool program_slot(uint8_t page, uint16_t index, uint32_t tag,
+        uint32_t value)
+{
+    const uint32_t words[3] = { tag, value, slot_crc(tag, value) };
+    uint32_t address = slot_address(page, index);
+    FLASH_Status status = FLASH_COMPLETE;
+
+    FLASH_Unlock();
+    for (uint8_t i = 0; i < kSlotHalfWords && status == FLASH_COMPLETE; i++)
+    {
+        status = FLASH_ProgramHalfWord(address + 2 * i,
+                (uint16_t) (words[i / 2] >> (16 * (i % 2))));
+    }
+    flash_done();
+
+    const slot_t *slot = slot_at(page, index);
+    if (status != FLASH_COMPLETE || slot->tag != words[0]
+            || slot->value != words[1] || slot->crc != words[2])
+    {
+        g_stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+static bool erase_page(uint8_t page)
+{
+    FLASH_Unlock();
+    FLASH_Status status = FLASH_ErasePage(slot_address(page, 0));
+    flash_done();
+
+    if (status != FLASH_COMPLETE || !page_blank(page))
+    {
+        g_stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+static entry_t *find_entry(uint16_t key, bool create)
+{
+    for (uint8_t i = 0; i < g_entry_count; i++)
+    {
+        if (g_entries[i].key == key)
+        {
+            return &g_entries[i];
+        }
+    }
+    if (!create || g_entry_count == kStoreMaxKeys)
+    {
+        return NULL;
+    }
+    entry_t *entry = &g_entries[g_entry_count++];
+    *entry = (entry_t) { key, false, 0, 0 };
+    return entry;
+}
+
+// 把每個 key 的目前值複製到另一頁，最後才寫頁首；失敗時原本的頁仍然有效
+static bool compact(void)
+{
+    uint8_t target = g_page == 0 ? 1 : 0;
+    uint16_t next = 1;
+
+    if (!page_blank(target) && !erase_page(target))
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < g_entry_count; i++)
+    {
+        // 寫入失敗的格留著，換下一格
+        while (!program_slot(target, next, g_entries[i].key,
+                g_entries[i].value))
+        {
+            if (++next == kSlotsPerPage)
+            {
+                return false;
+            }
+        }
+        next++;
+    }
+    if (!program_slot(target, 0, kStoreMagic, g_generation + 1))
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < g_entry_count; i++)
+    {
+        g_entries[i].stored = g_entries[i].value;
+        g_entries[i].in_flash = true;
+    }
+    g_stats.writes += g_entry_count;
+    g_page = target;
+    g_next = next;
+    g_generation++;
+    return true;
+}
+
+static bool append(entry_t *entry)
+{
+    while (g_page != kNoPage && g_next < kSlotsPerPage)
+    {
+        if (program_slot(g_page, g_next++, entry->key, entry->value))
+        {
+            entry->stored = entry->value;
+            entry->in_flash = true;
+            g_stats.writes++;
+            return true;
+        }
+    }
+    // 頁已滿 (或還沒有有效的頁)：換頁時會一併寫入所有 key
+    return compact();
+}
+
+static bool commit(void)
+{
+    for (uint8_t i = 0; i < g_entry_count; i++)
+    {
+        entry_t *entry = &g_entries[i];
+        if ((!entry->in_flash || entry->value != entry->stored)
+                && !append(entry))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void store_init(void)
+{
+    RCC->AHBENR |= RCC_AHBENR_CRCEN;
+
+    for (uint8_t page = 0; page < kStorePageCount; page++)
+    {
+        const slot_t *header = slot_at(page, 0);
+        if (header->tag == kStoreMagic && slot_valid(header)
+                && (g_page == kNoPage
+                        || (int32_t) (header->value - g_generation) > 0))
+        {
+            g_page = page;
+            g_generation = header->value;
+        }
+    }
+    if (g_page == kNoPage)
+    {
+        return; // 第一次寫入時建立
+    }
+
+    // 後面的紀錄覆蓋前面的；寫到一半 (CRC 不符) 的格略過，但之後不能再寫
+    g_next = 1;
+    for (uint16_t i = 1; i < kSlotsPerPage; i++)
+    {
+        const slot_t *slot = slot_at(g_page, i);
+        if (slot_erased(slot))
+        {
+            continue;
+        }
+        g_next = i + 1;
+        entry_t *entry;
+        if (!slot_valid(slot) || slot->tag == 0 || slot->tag > 0xFFFF)
+        {
+            g_stats.bad++;
+        }
+        else if ((entry = find_entry(slot->tag, true)) != NULL)
+        {
+            entry->value = entry->stored = slot->value;
+            entry->in_flash = true;
+        }
+    }
+}
+
+bool store_get(uint16_t key, uint32_t *value)
+{
+    entry_t *entry = find_entry(key, false);
+
+    if (entry == NULL)
+    {
+        return false;
+    }
+    *value = entry->value;
+    return true;
+}
+
+void store_set(uint16_t key, uint32_t value, uint32_t now_us)
+{
+    entry_t *entry = find_entry(key, true);
+
+    if (entry == NULL)
+    {
+        return;
+    }
+    entry->value = value;
+    if (!g_pending && (!entry->in_flash || value != entry->stored))
+    {
+        g_pending = true;
+        g_deadline_us = now_us + kStoreCommitDelay;
+    }
+}
+
+// 寫入失敗時保留變更，kStoreCommitDelay 後重試
+void store_poll(uint32_t now_us)
+{
+    if (g_pending && timebase_reached(now_us, g_deadline_us))
+    {
+        g_pending = !commit();
+        g_deadline_us = now_us + kStoreCommitDelay;
+    }
+}
+
+bool store_next_deadline(uint32_t *deadline_us)
+{
+    *deadline_us = g_deadline_us;
+    return g_pending;
+}
+
+// "STORE gen=<換頁次數> used=<已使用的格> bad=<損壞紀錄> writes=<寫入> err=<失敗>"
+char *store_format(char *out)
+{
+    static const char *const kLabels[] =
+    { "STORE gen=", " used=", " bad=", " writes=", " err=" };
+    const uint32_t values[] =
+    { g_generation, g_page == kNoPage ? 0 : g_next, g_stats.bad,
+            g_stats.writes, g_stats.errors };
+
+    for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        out = fmt_str(out, kLabels[i]);
+        out = fmt_u32(out, values[i], 1);
+    }
+    return out;
+}
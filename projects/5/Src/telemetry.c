@@ -0,0 +1,71 @@
+#include "stm32f10x.h"
+#include "stm32f10x_crc.h"
+#include "telemetry.h"
+#include "usart_tx.h"
+#include "cobs.h"
+
+static uint16_t g_seq = 0;
+
+static void put_u16(uint8_t *dst, uint32_t value)
+{
+    if (value > 0xFFFF)
+    {
+        value = 0xFFFF;
+    }
+    dst[0] = value & 0xFF;
+    dst[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = value & 0xFF;
+    dst[1] = (value >> 8) & 0xFF;
+    dst[2] = (value >> 16) & 0xFF;
+    dst[3] = value >> 24;
+}
+
+void telemetry_init(void)
+{
+    RCC->AHBENR |= RCC_AHBENR_CRCEN;
+}
+
+bool telemetry_send(const telemetry_record_t *record)
+{
+    // 以 word 陣列存放，CRC_CalcBlockCRC 可以直接讀取
+    uint32_t words[kTelemetryFrameSize / 4];
+    uint8_t *frame = (uint8_t *) words;
+
+    frame[kTelemetryOffVersion] = kTelemetryVersion;
+    put_u16(&frame[kTelemetryOffSeq], g_seq);
+    put_u32(&frame[kTelemetryOffTimestamp], record->timestamp_us);
+    frame[kTelemetryOffOccupied] = record->occupied;
+    frame[kTelemetryOffCapacity] = record->capacity;
+    put_u16(&frame[kTelemetryOffEntryEcho], record->entry_echo_us);
+    put_u16(&frame[kTelemetryOffExitEcho], record->exit_echo_us);
+    frame[kTelemetryOffGates] = (record->entry_gate & 0x0F)
+            | (record->exit_gate << 4);
+    put_u16(&frame[kTelemetryOffEchoDropped], record->echo_dropped);
+    put_u16(&frame[kTelemetryOffTxRejected], record->tx_rejected);
+    put_u16(&frame[kTelemetryOffRxTruncated], record->rx_truncated);
+    put_u16(&frame[kTelemetryOffCpuLoad], record->cpu_load_permille);
+    put_u16(&frame[kTelemetryOffWakeups], record->wakeups);
+
+    CRC_ResetDR();
+    put_u32(&frame[kTelemetryPayloadSize],
+            CRC_CalcBlockCRC(words, kTelemetryPayloadSize / 4));
+
+    // 直接編碼進 TX 緩衝區
+    uint8_t *out = (uint8_t *) usart_tx_reserve(
+            COBS_ENCODED_MAX(kTelemetryFrameSize) + 2);
+    if (out == NULL)
+    {
+        return false;
+    }
+    out[0] = 0;
+    uint16_t len = cobs_encode(frame, kTelemetryFrameSize, &out[1]);
+    out[len + 1] = 0;
+    usart_tx_commit(len + 2);
+
+    g_seq++;
+    return true;
+}
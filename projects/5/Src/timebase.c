@@ -0,0 +1,144 @@
+#include "stm32f10x.h"
+#include "timebase.h"
+#include "events.h"
+#include "clock.h"
+#include "units.h"
+
+#define kAlarmMaxAhead 0x7000     // 單次 alarm 最遠距離 (需小於半個 TIM3 週期，見下方的 int16_t 比較)
+#define kAlarmMinAhead 20         // 太近的 alarm 直接視為到期
+#define kTickHz 1000000           // TIM3 計數頻率 (1 µs)
+
+static volatile uint32_t g_wraps = 0; // 32-bit 計數器的回繞次數
+
+// 時脈切換後重新載入 TIM3 的 PSC。PSC 平時要到下一次 update 才生效，
+// 在那之前 TIM3 會以錯誤的速度計數，因此以 UG 立即載入並還原 CNT；
+// UG 產生的 TRGO 不能推動 TIM4，期間先停止 TIM4 (每次切換最多少算 1 µs)
+static void on_clock_change(clock_event_t event, const clock_freqs_t *freqs)
+{
+    if (event != CLOCK_EVENT_POST_CHANGE)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t count = TIM3->CNT;
+    TIM4->CR1 = 0;
+    TIM3->PSC = units_timer_psc(freqs->tim_apb1_hz, kTickHz);
+    TIM3->EGR = TIM_EGR_UG;
+    TIM3->CNT = count;
+    TIM3->SR = ~TIM_SR_UIF;
+    TIM4->CR1 = TIM_CR1_CEN;
+
+    __set_PRIMASK(primask);
+}
+
+void timebase_init(void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN | RCC_APB1ENR_TIM4EN;
+
+    // TIM3: 1 MHz 計數，update 事件輸出為 TRGO
+    TIM3->CR1 = 0;
+    TIM3->PSC = units_timer_psc(clock_freqs()->tim_apb1_hz, kTickHz);
+    TIM3->ARR = 0xFFFF;
+    TIM3->CR2 = TIM_CR2_MMS_1;
+    TIM3->EGR = TIM_EGR_UG; // 立即載入 PSC (TIM4 尚未啟用，不會被計入)
+    TIM3->SR = 0;
+    TIM3->CNT = 0;
+
+    // TIM4: 以 ITR2 (= TIM3 TRGO) 作為 external clock mode 1 的時脈
+    TIM4->CR1 = 0;
+    TIM4->PSC = 0;
+    TIM4->ARR = 0xFFFF;
+    TIM4->SMCR = TIM_SMCR_TS_1 | TIM_SMCR_SMS;
+    TIM4->CNT = 0;
+    TIM4->SR = 0;
+    TIM4->DIER = TIM_DIER_UIE; // 每 71.6 分鐘一次，累計回繞次數
+    TIM4->CR1 = TIM_CR1_CEN;
+
+    TIM3->CR1 = TIM_CR1_CEN;
+    NVIC->ISER[0] |= (1U << TIM3_IRQn) | (1U << TIM4_IRQn);
+    clock_add_listener(on_clock_change);
+}
+
+uint32_t timebase_now_us(void)
+{
+    uint16_t high;
+    uint16_t low;
+
+    // TIM4 在 TIM3 回繞後需要數個時脈週期才會同步進位，
+    // 因此 low == 0 的那 1 µs 內重讀，並確認前後讀到的高位一致
+    do
+    {
+        high = TIM4->CNT;
+        low = TIM3->CNT;
+    } while (low == 0 || high != TIM4->CNT);
+
+    return ((uint32_t) high << 16) | low;
+}
+
+uint64_t timebase_now_us64(void)
+{
+    uint32_t wraps;
+    uint32_t now;
+    bool pending;
+
+    // 讀值期間 TIM4 中斷更新了 g_wraps 就重讀；中斷被遮罩 (或優先權較低)
+    // 時以尚未處理的 UIF 判斷回繞
+    do
+    {
+        wraps = g_wraps;
+        now = timebase_now_us();
+        pending = (TIM4->SR & TIM_SR_UIF) != 0;
+    } while (wraps != g_wraps);
+
+    return timebase_join(wraps, now, pending);
+}
+
+void timebase_set_alarm(uint32_t deadline_us)
+{
+    uint32_t now = timebase_now_us();
+    int32_t ahead = (int32_t) (deadline_us - now);
+
+    if (ahead < kAlarmMinAhead)
+    {
+        TIM3->DIER &= ~TIM_DIER_CC1IE;
+        events_post(EVENT_TIMER);
+        return;
+    }
+    if (ahead > kAlarmMaxAhead)
+    {
+        ahead = kAlarmMaxAhead;
+    }
+
+    uint16_t compare = (uint16_t) (now + ahead);
+    TIM3->CCR1 = compare;
+    TIM3->SR = ~TIM_SR_CC1IF;
+    TIM3->DIER |= TIM_DIER_CC1IE;
+
+    // 設定期間若已錯過比較點，不會再產生中斷
+    if ((int16_t) (TIM3->CNT - compare) >= 0 && (TIM3->SR & TIM_SR_CC1IF) == 0)
+    {
+        events_post(EVENT_TIMER);
+    }
+}
+
+void TIM3_IRQHandler(void)
+{
+    if ((TIM3->SR & TIM_SR_CC1IF) != 0)
+    {
+        TIM3->SR = ~TIM_SR_CC1IF;
+        TIM3->DIER &= ~TIM_DIER_CC1IE;
+        events_post(EVENT_TIMER);
+    }
+}
+
+void TIM4_IRQHandler(void)
+{
+    if ((TIM4->SR & TIM_SR_UIF) != 0)
+    {
+        TIM4->SR = ~TIM_SR_UIF;
+        g_wraps++;
+    }
+}
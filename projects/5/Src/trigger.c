@@ -0,0 +1,51 @@
+#include "stm32f10x.h"
+#include "trigger.h"
+#include "echo_capture.h"
+
+static const uint32_t kTrigSet[ECHO_SENSOR_COUNT] =
+{ GPIO_BSRR_BS13, GPIO_BSRR_BS14 };
+static const uint32_t kTrigReset = GPIO_BSRR_BR13 | GPIO_BSRR_BR14;
+
+// TIM1 需先設定好 PSC / ARR 並啟動
+void trigger_init(void)
+{
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    GPIOC->BRR = GPIO_BRR_BR13 | GPIO_BRR_BR14;
+
+    // 記憶體 -> 周邊，32-bit，位址不遞增；拉高的通道每次由 trigger_fire() 啟動
+    DMA1_Channel3->CCR = 0;
+    DMA1_Channel3->CPAR = (uint32_t) (uintptr_t) &GPIOC->BSRR;
+    DMA1_Channel3->CCR = DMA_CCR3_DIR | DMA_CCR3_MSIZE_1 | DMA_CCR3_PSIZE_1;
+
+    // 拉低的通道一直循環，每個 TIM1 週期都寫一次 (平常沒有作用)
+    DMA1_Channel6->CCR = 0;
+    DMA1_Channel6->CPAR = (uint32_t) (uintptr_t) &GPIOC->BSRR;
+    DMA1_Channel6->CMAR = (uint32_t) (uintptr_t) &kTrigReset;
+    DMA1_Channel6->CNDTR = 1;
+    DMA1_Channel6->CCR = DMA_CCR6_DIR | DMA_CCR6_MSIZE_1 | DMA_CCR6_PSIZE_1
+            | DMA_CCR6_CIRC | DMA_CCR6_EN;
+
+    // CH2/CH3 為 frozen 比較模式 (只產生事件)，關閉 preload 讓新的 CCR 立即生效
+    TIM1->CCMR1 &= ~(TIM_CCMR1_CC2S | TIM_CCMR1_OC2M | TIM_CCMR1_OC2PE);
+    TIM1->CCMR2 &= ~(TIM_CCMR2_CC3S | TIM_CCMR2_OC3M | TIM_CCMR2_OC3PE);
+    TIM1->DIER |= TIM_DIER_CC3DE;
+}
+
+// 在 kTrigLeadTicks 後送出一個 Trig 脈衝，不等待脈衝結束
+void trigger_fire(uint8_t sensor)
+{
+    uint32_t period = TIM1->ARR + 1;
+
+    // 關閉 CC2DE 清掉上一輪留下的 DMA request，避免一啟動就立刻拉高
+    TIM1->DIER &= ~TIM_DIER_CC2DE;
+    DMA1_Channel3->CCR &= ~DMA_CCR3_EN;
+    DMA1_Channel3->CMAR = (uint32_t) (uintptr_t) &kTrigSet[sensor];
+    DMA1_Channel3->CNDTR = 1;
+    DMA1_Channel3->CCR |= DMA_CCR3_EN;
+
+    // 若被中斷拖過了比較點，脈衝會延到下一個週期，但脈寬不變
+    uint32_t start = (TIM1->CNT + kTrigLeadTicks) % period;
+    TIM1->CCR2 = start;
+    TIM1->CCR3 = (start + kTrigPulseTicks) % period;
+    TIM1->DIER |= TIM_DIER_CC2DE;
+}
@@ -0,0 +1,107 @@
+#include "stm32f10x.h"
+#include "usart_rx.h"
+#include "events.h"
+#include <string.h>
+
+static volatile char g_buf[kUsartRxBufferSize];
+static volatile uint32_t g_idle_count = 0; // 由 ISR 累加
+
+// 以下只由主迴圈存取
+static uint16_t g_read_pos = 0;
+static uint32_t g_seen_idle_count = 0;
+static char g_line[kUsartRxFrameSize];
+static uint16_t g_line_len = 0;
+static uint32_t g_truncated = 0;
+
+void usart_rx_init(void)
+{
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    // 周邊 -> 記憶體，記憶體位址遞增，循環模式
+    DMA1_Channel5->CCR = 0;
+    DMA1_Channel5->CPAR = (uint32_t) (uintptr_t) &USART1->DR;
+    DMA1_Channel5->CMAR = (uint32_t) (uintptr_t) g_buf;
+    DMA1_Channel5->CNDTR = kUsartRxBufferSize;
+    DMA1_Channel5->CCR = DMA_CCR5_MINC | DMA_CCR5_CIRC | DMA_CCR5_EN;
+
+    USART1->CR3 |= USART_CR3_DMAR;
+    // 不使用 RXNE 中斷，只在線路閒置時中斷一次
+    USART1->CR1 = (USART1->CR1 & ~USART_CR1_RXNEIE) | USART_CR1_IDLEIE;
+    NVIC->ISER[1] |= (1U << (USART1_IRQn - 32));
+}
+
+static uint16_t finish_frame(char *frame, uint16_t size)
+{
+    uint16_t len = g_line_len < size - 1 ? g_line_len : size - 1;
+
+    memcpy(frame, g_line, len);
+    frame[len] = '\0';
+    g_line_len = 0;
+    return len;
+}
+
+uint16_t usart_rx_get_frame(char *frame, uint16_t size)
+{
+    uint32_t idle_count = g_idle_count;
+    uint16_t dma_pos = kUsartRxBufferSize - DMA1_Channel5->CNDTR;
+
+    if (dma_pos >= kUsartRxBufferSize)
+    {
+        dma_pos = 0;
+    }
+
+    while (g_read_pos != dma_pos)
+    {
+        char c = g_buf[g_read_pos];
+        g_read_pos = (g_read_pos + 1) % kUsartRxBufferSize;
+
+        if (c == '\r' || c == '\n')
+        {
+            if (g_line_len > 0)
+            {
+                return finish_frame(frame, size);
+            }
+            continue;
+        }
+        if (g_line_len < kUsartRxFrameSize - 1)
+        {
+            g_line[g_line_len++] = c;
+        }
+        else
+        {
+            g_truncated++;
+        }
+    }
+
+    // 目前收到的資料都處理完，且期間線路閒置過：視為一個完整 frame
+    if (idle_count != g_seen_idle_count)
+    {
+        g_seen_idle_count = idle_count;
+        if (g_line_len > 0)
+        {
+            return finish_frame(frame, size);
+        }
+    }
+    return 0;
+}
+
+uint32_t usart_rx_truncated(void)
+{
+    return g_truncated;
+}
+
+void USART1_IRQHandler(void)
+{
+    uint16_t sr = USART1->SR;
+
+    // IDLE / ORE 旗標需以「讀 SR 再讀 DR」的順序清除
+    if ((sr & (USART_SR_IDLE | USART_SR_ORE)) != 0)
+    {
+        (void) USART1->DR;
+        if ((sr & USART_SR_IDLE) != 0)
+        {
+            g_idle_count++;
+            events_post(EVENT_RX);
+        }
+    }
+}
@@ -0,0 +1,190 @@
+#include "stm32f10x.h"
+#include "usart_tx.h"
+#include <string.h>
+
+// 資料區間：未回繞時為 [tail, head)；回繞時為 [tail, end) + [0, head)
+static char g_buf[kUsartTxBufferSize];
+static volatile uint16_t g_head = 0;
+static volatile uint16_t g_tail = 0;
+static volatile uint16_t g_end = 0;
+static volatile bool g_wrapped = false;
+static volatile uint16_t g_dma_len = 0; // 進行中的 DMA 長度，0 代表閒置
+static uint16_t g_reserve_pos = 0;
+static usart_tx_stats_t g_stats;
+
+static void start_next_transfer(void)
+{
+    if (g_dma_len != 0)
+    {
+        return;
+    }
+    if (g_wrapped && g_tail == g_end)
+    {
+        g_tail = 0;
+        g_wrapped = false;
+    }
+
+    uint16_t len = (g_wrapped ? g_end : g_head) - g_tail;
+    if (len == 0)
+    {
+        return;
+    }
+    DMA1_Channel4->CCR &= ~DMA_CCR4_EN;
+    // DMA 寫入 DR 不會清除 TC，先清掉才能在 usart_tx_suspend() 判斷是否送完
+    USART1->SR = (uint16_t) ~USART_SR_TC;
+    DMA1_Channel4->CMAR = (uint32_t) (uintptr_t) &g_buf[g_tail];
+    DMA1_Channel4->CNDTR = len;
+    g_dma_len = len;
+    DMA1_Channel4->CCR |= DMA_CCR4_EN;
+}
+
+static uint16_t used_bytes(void)
+{
+    return g_wrapped ? (g_end - g_tail) + g_head : g_head - g_tail;
+}
+
+void usart_tx_init(void)
+{
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    DMA1_Channel4->CCR = 0;
+    DMA1_Channel4->CPAR = (uint32_t) (uintptr_t) &USART1->DR;
+    // 記憶體 -> 周邊，記憶體位址遞增，8-bit 傳輸
+    DMA1_Channel4->CCR = DMA_CCR4_MINC | DMA_CCR4_DIR | DMA_CCR4_TCIE
+            | DMA_CCR4_TEIE;
+
+    USART1->CR3 |= USART_CR3_DMAT;
+    NVIC->ISER[0] |= (1U << DMA1_Channel4_IRQn);
+}
+
+char *usart_tx_reserve(uint16_t len)
+{
+    char *result = NULL;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!g_wrapped && g_head == g_tail && g_dma_len == 0)
+    {
+        // 已清空，從頭開始可得到最大的連續空間
+        g_head = 0;
+        g_tail = 0;
+    }
+
+    if (len == 0 || len >= kUsartTxBufferSize)
+    {
+        // 不可能放得下
+    }
+    else if (g_wrapped)
+    {
+        if (g_tail - g_head > len)
+        {
+            result = &g_buf[g_head];
+        }
+    }
+    else if (kUsartTxBufferSize - g_head >= len)
+    {
+        result = &g_buf[g_head];
+    }
+    else if (g_tail > len)
+    {
+        // 尾端放不下，回繞到緩衝區開頭 (head 不可追上 tail)
+        result = &g_buf[0];
+    }
+
+    if (result != NULL)
+    {
+        g_reserve_pos = result - g_buf;
+    }
+    else
+    {
+        g_stats.rejected++;
+        g_stats.dropped_bytes += len;
+    }
+
+    __set_PRIMASK(primask);
+    return result;
+}
+
+void usart_tx_commit(uint16_t len)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_reserve_pos == 0 && !g_wrapped && g_head != 0)
+    {
+        g_end = g_head;
+        g_wrapped = true;
+    }
+    g_head = g_reserve_pos + len;
+
+    uint16_t used = used_bytes();
+    if (used > g_stats.high_water)
+    {
+        g_stats.high_water = used;
+    }
+    start_next_transfer();
+
+    __set_PRIMASK(primask);
+}
+
+bool usart_tx_write(const void *data, uint16_t len)
+{
+    char *dst = usart_tx_reserve(len);
+
+    if (dst == NULL)
+    {
+        return false;
+    }
+    memcpy(dst, data, len);
+    usart_tx_commit(len);
+    return true;
+}
+
+uint16_t usart_tx_pending(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint16_t used = used_bytes();
+    __set_PRIMASK(primask);
+    return used;
+}
+
+void usart_tx_suspend(void)
+{
+    USART1->CR3 &= ~USART_CR3_DMAT;
+    while ((USART1->SR & USART_SR_TC) == 0)
+        ;
+}
+
+void usart_tx_resume(void)
+{
+    USART1->CR3 |= USART_CR3_DMAT;
+}
+
+void usart_tx_get_stats(usart_tx_stats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_stats;
+    __set_PRIMASK(primask);
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+    uint32_t isr = DMA1->ISR;
+
+    if ((isr & (DMA_ISR_TCIF4 | DMA_ISR_TEIF4)) != 0)
+    {
+        DMA1->IFCR = DMA_IFCR_CGIF4;
+        DMA1_Channel4->CCR &= ~DMA_CCR4_EN;
+
+        // 傳輸錯誤時同樣丟棄該段，避免卡住整個佇列
+        if ((isr & DMA_ISR_TCIF4) != 0)
+        {
+            g_stats.sent_bytes += g_dma_len;
+        }
+        g_tail += g_dma_len;
+        g_dma_len = 0;
+        start_next_transfer();
+    }
+}
@@ -42,6 +42,21 @@ defined in linker script */
 /* end address for the .bss section. defined in linker script */
 .word _ebss
 
+/* DWT cycle counter at the end of each startup phase, stored in
+   g_startup_cycles (.noinit, boot.c); indices match boot_phase_t */
+.equ  DWT_CYCCNT, 0xE0001004
+.equ  BOOT_PHASE_SYSTEM_INIT, 0
+.equ  BOOT_PHASE_DATA, 1
+.equ  BOOT_PHASE_BSS, 2
+.equ  BOOT_PHASE_CTORS, 3
+
+.macro STAMP phase
+  ldr   r0, =DWT_CYCCNT
+  ldr   r0, [r0]
+  ldr   r1, =g_startup_cycles
+  str   r0, [r1, #(\phase * 4)]
+.endm
+
 /**
  * @brief  This is the code that gets called when the processor first
  *          starts execution following a reset event. Only the absolutely
@@ -57,42 +72,69 @@ defined in linker script */
 Reset_Handler:
   ldr   r0, =_estack
   mov   sp, r0          /* set stack pointer */
+/* Start the DWT cycle counter for the boot metrics (boot.c).*/
+  bl  boot_start_cycle_counter
 /* Call the clock system initialization function.*/
   bl  SystemInit
 
-/* Copy the data segment initializers from flash to SRAM */
-  ldr r0, =_sdata
-  ldr r1, =_edata
-  ldr r2, =_sidata
-  movs r3, #0
-  b LoopCopyDataInit
-
-CopyDataInit:
-  ldr r4, [r2, r3]
-  str r4, [r0, r3]
-  adds r3, r3, #4
-
-LoopCopyDataInit:
-  adds r4, r0, r3
-  cmp r4, r1
-  bcc CopyDataInit
-
-/* Zero fill the bss segment. */
-  ldr r2, =_sbss
-  ldr r4, =_ebss
-  movs r3, #0
-  b LoopFillZerobss
-
-FillZerobss:
-  str  r3, [r2]
-  adds r2, r2, #4
-
-LoopFillZerobss:
-  cmp r2, r4
-  bcc FillZerobss
+  STAMP BOOT_PHASE_SYSTEM_INIT
+
+/* Copy the data segment initializers from flash to SRAM, one entry of
+   __copy_table (load address, start, words) at a time, 4 words per LDM/STM */
+  ldr   r4, =__copy_table_start__
+  ldr   r5, =__copy_table_end__
+CopyTableLoop:
+  cmp   r4, r5
+  bhs   CopyTableDone
+  ldmia r4!, {r0, r1, r2}
+CopyBlock:
+  subs  r2, r2, #4
+  blo   CopyTail
+  ldmia r0!, {r3, r6, r7, r8}
+  stmia r1!, {r3, r6, r7, r8}
+  b     CopyBlock
+CopyTail:
+  adds  r2, r2, #4
+  beq   CopyTableLoop
+CopyWord:
+  ldr   r3, [r0], #4
+  str   r3, [r1], #4
+  subs  r2, r2, #1
+  bne   CopyWord
+  b     CopyTableLoop
+CopyTableDone:
+  STAMP BOOT_PHASE_DATA
+
+/* Zero fill the regions of __zero_table (start, words); .noinit is left alone */
+  ldr   r4, =__zero_table_start__
+  ldr   r5, =__zero_table_end__
+  movs  r3, #0
+  movs  r6, #0
+  movs  r7, #0
+  mov   r8, #0
+ZeroTableLoop:
+  cmp   r4, r5
+  bhs   ZeroTableDone
+  ldmia r4!, {r1, r2}
+ZeroBlock:
+  subs  r2, r2, #4
+  blo   ZeroTail
+  stmia r1!, {r3, r6, r7, r8}
+  b     ZeroBlock
+ZeroTail:
+  adds  r2, r2, #4
+  beq   ZeroTableLoop
+ZeroWord:
+  str   r3, [r1], #4
+  subs  r2, r2, #1
+  bne   ZeroWord
+  b     ZeroTableLoop
+ZeroTableDone:
+  STAMP BOOT_PHASE_BSS
 
 /* Call static constructors */
   bl __libc_init_array
+  STAMP BOOT_PHASE_CTORS
 /* Call the application's entry point.*/
   bl main
 
@@ -0,0 +1,21 @@
+#ifndef COBS_H
+#define COBS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Consistent Overhead Byte Stuffing
+ *
+ * 編碼後的資料不含 0x00，因此可以用 0x00 當作 frame 分隔符號。
+ * 編碼最多增加 len / 254 + 1 個位元組 (不含分隔符號)。
+ */
+
+#define COBS_ENCODED_MAX(len) ((len) + (len) / 254 + 1)
+
+size_t cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+// 解碼失敗 (格式錯誤或超出 dst_size) 時回傳 0
+size_t cobs_decode(const uint8_t *src, size_t len, uint8_t *dst,
+        size_t dst_size);
+
+#endif /* COBS_H */
@@ -0,0 +1,31 @@
+#ifndef DELAY_H
+#define DELAY_H
+
+#include <stdint.h>
+
+/*
+ * 以 DWT cycle counter 計時的忙等延遲
+ *
+ * 每 µs 的 cycle 數在 delay_init() 時由 SystemCoreClock 計算，
+ * 因此與 SYSCLK 設定及編譯最佳化等級無關。變更系統時脈後需再呼叫
+ * delay_init()。CYCCNT 為 32-bit，單次 delay_cycles() 在 72 MHz 下
+ * 最長約 59 秒；delay_us() / delay_ms() 會分段等待，沒有長度限制。
+ *
+ * delay_sleep_ms() 用於較長的等待：SysTick 每 1 ms 中斷一次，期間以 WFI
+ * 睡眠，其他中斷照常處理。SysTick_Handler 可以是空的 (stm32f10x_it.c)，
+ * 但 SysTick 不能同時另作他用 (例如專案 5 的顯示器掃描)。
+ */
+
+void delay_init(void);
+void delay_cycles(uint32_t cycles);
+void delay_us(uint32_t us);
+void delay_ms(uint32_t ms);
+void delay_sleep_ms(uint32_t ms);
+
+// 每 µs 的 cycle 數，無條件進位 (寧可多等也不提早結束)
+static inline uint32_t delay_cycles_per_us(uint32_t core_clock_hz)
+{
+    return (core_clock_hz + 999999) / 1000000;
+}
+
+#endif /* DELAY_H */
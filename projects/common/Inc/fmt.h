@@ -0,0 +1,54 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+/*
+ * 不配置記憶體的數字格式化 (取代 sprintf)
+ *
+ * 所有函式都直接寫入 out，回傳寫入結尾的下一個位置，不補 '\0'，
+ * 因此可以串接使用，也可以直接寫進 usart_tx_reserve() 取得的緩衝區。
+ *
+ * 固定格式請使用 FMT_DEC / FMT_HEX / FMT_FIXED 描述子搭配 fmt_write()，
+ * 寬度不合法時會在編譯期報錯；FMT_*_MAX 為各格式最多輸出的字元數。
+ */
+
+#define FMT_U32_MAX 10 // "4294967295"
+#define FMT_I32_MAX 11 // "-2147483648"
+#define FMT_HEX_MAX 8
+
+typedef enum
+{
+    FMT_KIND_DEC = 0,
+    FMT_KIND_HEX,
+    FMT_KIND_FIXED
+} fmt_kind_t;
+
+typedef struct
+{
+    uint8_t kind;  // fmt_kind_t
+    uint8_t width; // 最少字元數 (補零，FMT_DEC 的負號計入)；FMT_FIXED 為整數部分的位數
+    uint8_t frac;  // FMT_FIXED 的小數位數
+} fmt_spec_t;
+
+// 條件不成立時 bit-field 寬度為負數，造成編譯錯誤
+#define FMT_CHECK(cond) (0 * sizeof(struct { int fmt_check : (cond) ? 1 : -1; }))
+
+#define FMT_DEC(width) \
+    ((fmt_spec_t) { FMT_KIND_DEC, (width) + FMT_CHECK((width) <= FMT_U32_MAX), 0 })
+#define FMT_HEX(width) \
+    ((fmt_spec_t) { FMT_KIND_HEX, \
+        (width) + FMT_CHECK((width) >= 1 && (width) <= FMT_HEX_MAX), 0 })
+// value 為放大 10^frac 倍的整數，例如 FMT_FIXED(1, 3) 把 1234 輸出成 "1.234"
+#define FMT_FIXED(width, frac) \
+    ((fmt_spec_t) { FMT_KIND_FIXED, (width) + FMT_CHECK((width) >= 1 \
+        && (frac) >= 1 && (width) + (frac) <= FMT_U32_MAX), (frac) })
+
+char *fmt_u32(char *out, uint32_t value, uint8_t width);
+char *fmt_i32(char *out, int32_t value);
+char *fmt_hex(char *out, uint32_t value, uint8_t digits);
+char *fmt_fixed(char *out, int32_t value, uint8_t width, uint8_t frac);
+char *fmt_str(char *out, const char *str);
+char *fmt_write(char *out, fmt_spec_t spec, int32_t value);
+
+#endif /* FMT_H */
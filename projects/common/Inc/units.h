@@ -0,0 +1,82 @@
+#ifndef UNITS_H
+#define UNITS_H
+
+#include <stdint.h>
+
+/*
+ * 物理量換算 (全部以整數完成)
+ *
+ * Cortex-M3 沒有 FPU，專案以 -mfloat-abi=soft 編譯，任何 float / double
+ * 運算都會變成數百 cycle 的 libgcc 呼叫，也會把軟體浮點函式庫連結進 flash。
+ *
+ * - UNITS_* 巨集用於常數 (時脈、鮑率、Servo 角度...)，在編譯期算完；
+ *   參數必須是常數，否則 64-bit 除法會在執行期呼叫 __aeabi_uldivmod
+ * - 執行期的換算 (Echo 脈寬、時脈切換後的 PSC / BRR) 使用 static inline 函式，
+ *   只用 32-bit 整數乘除
+ *
+ * 單位寫在名稱裡：_hz、_us、_mm、_deg、_ticks、_cm_s。
+ */
+
+// 條件不成立時 bit-field 寬度為負數，造成編譯錯誤
+#define UNITS_CHECK(cond) (0 * sizeof(struct { int units_check : (cond) ? 1 : -1; }))
+
+// 整數除法四捨五入 (a、b 皆為正數)
+#define UNITS_DIV_ROUND(a, b) (((a) + (b) / 2) / (b))
+
+// 計時器時脈 clock_hz 要以 tick_hz 計數時的 PSC；無法整除時編譯失敗
+#define UNITS_TIMER_PSC(clock_hz, tick_hz) \
+    ((clock_hz) / (tick_hz) - 1 + UNITS_CHECK((clock_hz) % (tick_hz) == 0 \
+        && (clock_hz) / (tick_hz) <= 0x10000))
+
+// 以 tick_hz 計數時，us 微秒對應的 tick 數 (四捨五入)
+#define UNITS_US_TO_TICKS(us, tick_hz) \
+    ((uint32_t) UNITS_DIV_ROUND((uint64_t) (us) * (tick_hz), 1000000))
+
+// USART BRR (12.4 定點的 USARTDIV = clock / (16 × baud))，四捨五入
+#define UNITS_USART_BRR(clock_hz, baud) \
+    (UNITS_DIV_ROUND((clock_hz), (baud)) + UNITS_CHECK((clock_hz) / (baud) >= 16 \
+        && (clock_hz) / (baud) <= 0xFFFF))
+
+// 執行期版本 (時脈由 RCC 讀出時)：無法整除時取最接近的值，超出範圍時取極值
+static inline uint16_t units_timer_psc(uint32_t clock_hz, uint32_t tick_hz)
+{
+    uint32_t div = UNITS_DIV_ROUND(clock_hz, tick_hz);
+
+    return (uint16_t) ((div == 0 ? 1 : div > 0x10000 ? 0x10000 : div) - 1);
+}
+
+static inline uint16_t units_usart_brr(uint32_t clock_hz, uint32_t baud)
+{
+    uint32_t brr = UNITS_DIV_ROUND(clock_hz, baud);
+
+    return (uint16_t) (brr < 16 ? 16 : brr > 0xFFFF ? 0xFFFF : brr);
+}
+
+// Servo 角度 -> 脈寬：0° 為 min_us、180° 為 max_us，線性內插
+#define UNITS_SERVO_US(deg, min_us, max_us) \
+    ((min_us) + UNITS_DIV_ROUND((deg) * ((max_us) - (min_us)), 180) \
+        + UNITS_CHECK((deg) >= 0 && (deg) <= 180 && (max_us) > (min_us)))
+
+// --- 超音波 ---
+
+#define UNITS_SOUND_SPEED_0C 33130 // 0 °C 的音速 (cm/s)
+#define UNITS_SOUND_SPEED_SLOPE 606 // 每 °C 增加 0.606 m/s (0.001 m/s)
+#define UNITS_MAX_ECHO_US 65535     // 超過此值的脈寬視為同一個最遠距離
+
+// c = 331.3 + 0.606 × T (m/s)，以 cm/s 表示
+static inline uint32_t units_sound_speed_cm_s(int8_t temperature_c)
+{
+    return UNITS_SOUND_SPEED_0C + (UNITS_SOUND_SPEED_SLOPE * temperature_c) / 10;
+}
+
+// Echo 來回脈寬 (µs) -> 距離 (mm，四捨五入)；乘積最大約 2.5e9，不超過 32-bit
+static inline uint16_t units_echo_to_mm(uint32_t width_us, int8_t temperature_c)
+{
+    if (width_us > UNITS_MAX_ECHO_US)
+    {
+        width_us = UNITS_MAX_ECHO_US;
+    }
+    return (width_us * units_sound_speed_cm_s(temperature_c) + 100000) / 200000;
+}
+
+#endif /* UNITS_H */
@@ -0,0 +1,63 @@
+#include "cobs.h"
+
+size_t cobs_encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    uint8_t *code = dst;  // 目前區塊的長度碼位置
+    uint8_t *out = dst + 1;
+    uint8_t run = 1;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (src[i] == 0)
+        {
+            *code = run;
+            code = out++;
+            run = 1;
+            continue;
+        }
+        *out++ = src[i];
+        if (++run == 0xFF)
+        {
+            *code = run;
+            code = out++;
+            run = 1;
+        }
+    }
+    *code = run;
+    return out - dst;
+}
+
+size_t cobs_decode(const uint8_t *src, size_t len, uint8_t *dst,
+        size_t dst_size)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len)
+    {
+        uint8_t run = src[in++];
+
+        if (run == 0 || in + run - 1 > len)
+        {
+            return 0;
+        }
+        for (uint8_t i = 1; i < run; i++)
+        {
+            if (src[in] == 0 || out >= dst_size)
+            {
+                return 0;
+            }
+            dst[out++] = src[in++];
+        }
+        // 長度碼 0xFF 代表區塊沒有隱含的 0x00；最後一個區塊也沒有
+        if (run != 0xFF && in < len)
+        {
+            if (out >= dst_size)
+            {
+                return 0;
+            }
+            dst[out++] = 0;
+        }
+    }
+    return out;
+}
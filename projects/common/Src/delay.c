@@ -0,0 +1,66 @@
+#include "stm32f10x.h"
+#include "delay.h"
+
+// CMSIS 1.30 的 core_cm3.h 沒有定義 DWT
+#define DWT_CTRL   (*(volatile uint32_t *) 0xE0001000UL)
+#define DWT_CYCCNT (*(volatile uint32_t *) 0xE0001004UL)
+#define DWT_CTRL_CYCCNTENA (1UL << 0)
+
+#define kDelayMaxChunkUs 1000000 // 分段等待，避免 cycle 數超出 32-bit
+
+static uint32_t g_cycles_per_us = 1;
+
+void delay_init(void)
+{
+    SystemCoreClockUpdate();
+    g_cycles_per_us = delay_cycles_per_us(SystemCoreClock);
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+void delay_cycles(uint32_t cycles)
+{
+    uint32_t start = DWT_CYCCNT;
+
+    // 以差值比較，CYCCNT 回繞也正確
+    while (DWT_CYCCNT - start < cycles)
+        ;
+}
+
+void delay_us(uint32_t us)
+{
+    while (us > kDelayMaxChunkUs)
+    {
+        delay_cycles(kDelayMaxChunkUs * g_cycles_per_us);
+        us -= kDelayMaxChunkUs;
+    }
+    delay_cycles(us * g_cycles_per_us);
+}
+
+void delay_ms(uint32_t ms)
+{
+    while (ms > 0)
+    {
+        delay_cycles(1000 * g_cycles_per_us);
+        ms--;
+    }
+}
+
+// 每個 SysTick 週期 (1 ms) 設定一次 COUNTFLAG；其他中斷喚醒時繼續睡
+void delay_sleep_ms(uint32_t ms)
+{
+    SysTick->LOAD = 1000 * g_cycles_per_us - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk
+            | SysTick_CTRL_ENABLE_Msk;
+    while (ms > 0)
+    {
+        __WFI();
+        if ((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0)
+        {
+            ms--;
+        }
+    }
+    SysTick->CTRL = 0;
+}
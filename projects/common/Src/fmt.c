@@ -0,0 +1,95 @@
+#include "fmt.h"
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+char *fmt_u32(char *out, uint32_t value, uint8_t width)
+{
+    char digits[FMT_U32_MAX];
+    uint8_t count = 0;
+
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    for (; width > count; width--)
+    {
+        *out++ = '0';
+    }
+    while (count > 0)
+    {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+char *fmt_i32(char *out, int32_t value)
+{
+    uint32_t magnitude = (uint32_t) value;
+
+    if (value < 0)
+    {
+        *out++ = '-';
+        magnitude = 0u - magnitude;
+    }
+    return fmt_u32(out, magnitude, 0);
+}
+
+char *fmt_hex(char *out, uint32_t value, uint8_t digits)
+{
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+    {
+        *out++ = kHexDigits[(value >> shift) & 0xF];
+    }
+    return out;
+}
+
+char *fmt_fixed(char *out, int32_t value, uint8_t width, uint8_t frac)
+{
+    uint32_t magnitude = (uint32_t) value;
+    uint32_t scale = 1;
+
+    if (value < 0)
+    {
+        *out++ = '-';
+        magnitude = 0u - magnitude;
+    }
+    for (uint8_t i = 0; i < frac; i++)
+    {
+        scale *= 10;
+    }
+    out = fmt_u32(out, magnitude / scale, width);
+    *out++ = '.';
+    return fmt_u32(out, magnitude % scale, frac);
+}
+
+char *fmt_str(char *out, const char *str)
+{
+    while (*str)
+    {
+        *out++ = *str++;
+    }
+    return out;
+}
+
+char *fmt_write(char *out, fmt_spec_t spec, int32_t value)
+{
+    switch (spec.kind)
+    {
+    case FMT_KIND_HEX:
+        return fmt_hex(out, (uint32_t) value, spec.width);
+    case FMT_KIND_FIXED:
+        return fmt_fixed(out, value, spec.width, spec.frac);
+    case FMT_KIND_DEC:
+    default:
+        if (value < 0)
+        {
+            // 與 %0Nd 相同，負號計入寬度
+            *out++ = '-';
+            return fmt_u32(out, 0u - (uint32_t) value,
+                    spec.width > 0 ? spec.width - 1 : 0);
+        }
+        return fmt_u32(out, (uint32_t) value, spec.width);
+    }
+}
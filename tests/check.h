@@ -0,0 +1,69 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * 主機端測試的檢查巨集
+ *
+ * tests/ 的每個 .c 是一個獨立的執行檔 (host.cmake 以 add_test 註冊)。
+ * 檢查失敗時印出位置與數值並繼續執行，main() 最後 return check_result()，
+ * 有任何失敗時 ctest 即判定失敗。
+ */
+
+static int g_check_failures = 0;
+
+static inline void check_report(bool ok, const char *expr, const char *file,
+        int line)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+        g_check_failures++;
+    }
+}
+
+static inline void check_report_eq(long long actual, long long expected,
+        const char *expr, const char *file, int line)
+{
+    if (actual != expected)
+    {
+        fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", file, line,
+                expr, actual, expected);
+        g_check_failures++;
+    }
+}
+
+static inline void check_report_near(long long actual, long long expected,
+        long long tolerance, const char *expr, const char *file, int line)
+{
+    long long diff = actual > expected ? actual - expected : expected - actual;
+
+    if (diff > tolerance)
+    {
+        fprintf(stderr, "%s:%d: %s is %lld, expected %lld ± %lld\n", file,
+                line, expr, actual, expected, tolerance);
+        g_check_failures++;
+    }
+}
+
+#define CHECK(cond) check_report((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) \
+    check_report_eq((long long) (actual), (long long) (expected), #actual, \
+            __FILE__, __LINE__)
+#define CHECK_NEAR(actual, expected, tolerance) \
+    check_report_near((long long) (actual), (long long) (expected), \
+            (long long) (tolerance), #actual, __FILE__, __LINE__)
+
+static inline int check_result(void)
+{
+    if (g_check_failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", g_check_failures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* CHECK_H */
@@ -0,0 +1,54 @@
+#include <stdlib.h>
+
+#include "sim.h"
+#include "delay.h"
+#include "check.h"
+
+/*
+ * DWT 延遲的 cycle 數 (在暫存器模擬器上執行)
+ *
+ * host.cmake 以每個 SYSCLK_FREQ_* 設定各編一次，EXPECTED_SYSCLK_HZ 為該設定
+ * 的頻率。SystemInit() 在模擬的 RCC 上切換時脈後，檢查 delay_init() 算出的
+ * 每 µs cycle 數，以及實際等待的虛擬時間。
+ *
+ * 韌體忙碌時虛擬時間跟著實際時間前進，被主機排程搶走的時間也算在內，
+ * 只會讓等待變長：每種等待重複數次，全部都不能短於要求，最短的一次
+ * 不能超出太多 (cycle 數算錯時會差好幾倍)。
+ */
+
+#define kRepeat 8
+#define kSlackUs 200 // 存取暫存器的額外時間
+
+typedef void (*delay_fn_t)(uint32_t value);
+
+static void check_delay(delay_fn_t fn, uint32_t value, uint32_t us)
+{
+    uint64_t shortest = UINT64_MAX;
+
+    for (int i = 0; i < kRepeat; i++)
+    {
+        uint64_t start = sim_now();
+
+        fn(value);
+        uint64_t elapsed_us = (sim_now() - start) / SIM_NS_PER_US;
+        CHECK(elapsed_us >= us);
+        shortest = elapsed_us < shortest ? elapsed_us : shortest;
+    }
+    CHECK(shortest <= us + us / 10 + kSlackUs);
+}
+
+int main(void)
+{
+    delay_init();
+    CHECK_EQ(SystemCoreClock, EXPECTED_SYSCLK_HZ);
+    CHECK_EQ(delay_cycles_per_us(SystemCoreClock),
+            (EXPECTED_SYSCLK_HZ + 999999) / 1000000);
+
+    // 不整除時無條件進位：1 µs 絕不少於 1 µs
+    CHECK(delay_cycles_per_us(SystemCoreClock) * 1000000ULL >= SystemCoreClock);
+
+    check_delay(delay_us, 10, 10); // HC-SR04 的 Trig 脈衝
+    check_delay(delay_us, 2000, 2000);
+    check_delay(delay_ms, 2, 2000);
+    exit(check_result());
+}
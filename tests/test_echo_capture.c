@@ -0,0 +1,244 @@
+#include <signal.h>
+#include <stdlib.h>
+
+#include "sim.h"
+#include "echo_capture.h"
+#include "events.h"
+#include "timebase.h"
+#include "units.h"
+#include "check.h"
+
+/*
+ * Echo 脈寬量測 (在暫存器模擬器上執行)
+ *
+ * - echo_capture_width()：CCR 差值在 TIM2 週期內回繞，整數個週期由 ISR 之間的
+ *   timebase 補上
+ * - 捕捉路徑：以模擬器的事件在 PA1 / PA2 產生 Echo 脈衝，經 TIM2 輸入捕捉與
+ *   TIM2_IRQHandler 進入佇列：極性切換、overcapture、佇列已滿時的丟棄、
+ *   echo_capture_pop() 的順序
+ *
+ * timebase 與 events 以模擬器的虛擬時間代替，不需要 TIM3/TIM4 與時脈管理。
+ * ctest 以 -s 0.001 執行 (見 host.cmake)，忙碌時的虛擬時間幾乎不前進。
+ */
+
+#define kPeriod 20000 // Servo PWM 週期 (1 MHz 計數)
+#define kEntryPin 2   // PA2 = TIM2_CH3
+#define kExitPin 1    // PA1 = TIM2_CH2
+
+static uint32_t g_posted = 0;
+
+uint32_t timebase_now_us(void)
+{
+    return (uint32_t) (sim_now() / SIM_NS_PER_US);
+}
+
+void events_post(uint32_t events)
+{
+    g_posted |= events;
+}
+
+static void test_within_one_period(void)
+{
+    CHECK_EQ(echo_capture_width(1000, 3912, 2912, kPeriod), 2912);
+    // CCR 在上升沿與下降沿之間回繞
+    CHECK_EQ(echo_capture_width(19000, 1912, 2912, kPeriod), 2912);
+    CHECK_EQ(echo_capture_width(500, 500, 0, kPeriod), 0);
+}
+
+static void test_longer_than_period(void)
+{
+    // 4 m 約 23.3 ms：CCR 只剩 3323 µs 的餘數
+    CHECK_EQ(echo_capture_width(100, 3423, 23323, kPeriod), 23323);
+    CHECK_EQ(echo_capture_width(19990, 3313, 23323, kPeriod), 23323);
+    // HC-SR04 逾時的 38 ms 脈寬
+    CHECK_EQ(echo_capture_width(0, 18000, 38000, kPeriod), 38000);
+    CHECK_EQ(echo_capture_width(2, 2, 40000, kPeriod), 40000);
+}
+
+static void test_isr_latency(void)
+{
+    // 上升沿的 ISR 晚到：經過時間比實際脈寬短
+    CHECK_EQ(echo_capture_width(100, 3423, 23323 - 9000, kPeriod), 23323);
+    CHECK_EQ(echo_capture_width(100, 3012, 0, kPeriod), 2912);
+    // 下降沿的 ISR 晚到
+    CHECK_EQ(echo_capture_width(100, 3423, 23323 + 9000, kPeriod), 23323);
+    CHECK_EQ(echo_capture_width(100, 3012, 2912 + 9999, kPeriod), 2912);
+}
+
+static void test_timebase_wraps(void)
+{
+    uint32_t rise_us = 0xFFFFF000;
+    uint32_t fall_us = rise_us + 23323;
+
+    CHECK_EQ(echo_capture_width(100, 3423, fall_us - rise_us, kPeriod), 23323);
+}
+
+// ------------------------------------------------------------
+// 捕捉路徑
+// ------------------------------------------------------------
+
+static void echo_high(uintptr_t pin)
+{
+    sim_gpio_drive(0, (uint8_t) pin, true);
+}
+
+static void echo_low(uintptr_t pin)
+{
+    sim_gpio_drive(0, (uint8_t) pin, false);
+}
+
+// 目前的虛擬時間 (sim_now() 只在存取暫存器與 tick 時更新)
+static uint64_t now_ns(void)
+{
+    (void) TIM2->CNT;
+    return sim_now();
+}
+
+// base 起 start_us 後在 pin 上產生 width_us 的高電位
+static void schedule_pulse(uint64_t base, uint8_t pin, uint32_t start_us,
+        uint32_t width_us)
+{
+    sigset_t tick, old;
+
+    // 模擬器的 SIGALRM tick 也會操作事件佇列
+    sigemptyset(&tick);
+    sigaddset(&tick, SIGALRM);
+    sigprocmask(SIG_BLOCK, &tick, &old);
+    sim_schedule(base + start_us * SIM_NS_PER_US, echo_high, pin);
+    sim_schedule(base + (start_us + width_us) * SIM_NS_PER_US, echo_low, pin);
+    sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+static volatile bool g_woke = false;
+
+void SysTick_Handler(void)
+{
+    SysTick->CTRL = 0;
+    g_woke = true;
+}
+
+// 以 SysTick 單次計時在 WFI 中等待 us：虛擬時間直接跳到下一個中斷，
+// 期間 TIM2 的捕捉中斷照常執行
+static void wait_us(uint32_t us)
+{
+    g_woke = false;
+    SysTick->LOAD = us * (SystemCoreClock / 1000000) - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk
+            | SysTick_CTRL_ENABLE_Msk;
+    while (!g_woke)
+    {
+        __WFI();
+    }
+}
+
+static void test_polarity(void)
+{
+    echo_sample_t sample;
+
+    CHECK_EQ(TIM2->CCER & (TIM_CCER_CC2P | TIM_CCER_CC3P), 0);
+    schedule_pulse(now_ns(), kEntryPin, 100, 2912);
+    wait_us(1000);
+    // 上升沿之後改捕捉下降沿，出口不受影響
+    CHECK(TIM2->CCER & TIM_CCER_CC3P);
+    CHECK_EQ(TIM2->CCER & TIM_CCER_CC2P, 0);
+    CHECK(!echo_capture_pop(&sample));
+
+    g_posted = 0;
+    wait_us(3000);
+    CHECK_EQ(TIM2->CCER & TIM_CCER_CC3P, 0);
+    CHECK(g_posted & EVENT_ECHO);
+    CHECK(echo_capture_pop(&sample));
+    CHECK_EQ(sample.sensor, ECHO_ENTRY);
+    CHECK_NEAR(sample.width_us, 2912, 1);
+    CHECK(!echo_capture_pop(&sample));
+
+    // 超過一個 TIM2 週期的脈寬 (4 m)
+    schedule_pulse(now_ns(), kExitPin, 100, 23323);
+    wait_us(24000);
+    CHECK(echo_capture_pop(&sample));
+    CHECK_EQ(sample.sensor, ECHO_EXIT);
+    CHECK_NEAR(sample.width_us, 23323, 1);
+}
+
+static void test_overcapture(void)
+{
+    echo_sample_t sample;
+    uint32_t dropped = echo_capture_dropped();
+    uint64_t base = now_ns();
+
+    // ISR 來不及執行時又到了一個上升沿：CC3IF 仍設定，硬體設 CC3OF
+    NVIC->ICER[0] = 1U << TIM2_IRQn;
+    schedule_pulse(base, kEntryPin, 100, 200);
+    schedule_pulse(base, kEntryPin, 500, 1000);
+    wait_us(800);
+    CHECK(TIM2->SR & TIM_SR_CC3OF);
+    NVIC->ISER[0] = 1U << TIM2_IRQn; // 存取暫存器之後即執行 ISR
+
+    // 丟棄這次並從上升沿重來：Echo 仍在高電位，下降沿不會被捕捉
+    CHECK_EQ(echo_capture_dropped(), dropped + 1);
+    CHECK_EQ(TIM2->SR & TIM_SR_CC3OF, 0);
+    CHECK_EQ(TIM2->CCER & TIM_CCER_CC3P, 0);
+    wait_us(1000);
+    CHECK(!echo_capture_pop(&sample));
+
+    // 下一個完整的脈衝正常量測
+    schedule_pulse(now_ns(), kEntryPin, 100, 1500);
+    wait_us(2000);
+    CHECK(echo_capture_pop(&sample));
+    CHECK_EQ(sample.sensor, ECHO_ENTRY);
+    CHECK_NEAR(sample.width_us, 1500, 1);
+    CHECK_EQ(echo_capture_dropped(), dropped + 1);
+}
+
+static void test_queue_full(void)
+{
+    echo_sample_t sample;
+    uint32_t dropped = echo_capture_dropped();
+    uint64_t base = now_ns();
+
+    // 兩顆感測器輪流，主迴圈沒有取出：超過 kEchoQueueSize 的樣本被丟棄
+    for (uint32_t i = 0; i < kEchoQueueSize + 2; i++)
+    {
+        schedule_pulse(base, i % 2 == 0 ? kEntryPin : kExitPin, 100 + i * 2000,
+                500 + i * 100);
+    }
+    wait_us((kEchoQueueSize + 2) * 2000 + 500);
+    CHECK_EQ(echo_capture_dropped(), dropped + 2);
+
+    // 依完成的順序取出
+    for (uint32_t i = 0; i < kEchoQueueSize; i++)
+    {
+        CHECK(echo_capture_pop(&sample));
+        CHECK_EQ(sample.sensor, i % 2 == 0 ? ECHO_ENTRY : ECHO_EXIT);
+        CHECK_NEAR(sample.width_us, 500 + i * 100, 1);
+    }
+    CHECK(!echo_capture_pop(&sample));
+
+    // 取出後又有空間
+    schedule_pulse(now_ns(), kExitPin, 100, 700);
+    wait_us(1000);
+    CHECK(echo_capture_pop(&sample));
+    CHECK_NEAR(sample.width_us, 700, 1);
+}
+
+int main(void)
+{
+    test_within_one_period();
+    test_longer_than_period();
+    test_isr_latency();
+    test_timebase_wraps();
+
+    // TIM2 與韌體相同：1 MHz 計數、20 ms 週期 (CH1 的 Servo PWM 不影響捕捉)
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+    TIM2->PSC = units_timer_psc(SystemCoreClock, 1000000);
+    TIM2->ARR = kPeriod - 1;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CR1 = TIM_CR1_CEN;
+    echo_capture_init();
+
+    test_polarity();
+    test_overcapture();
+    test_queue_full();
+    exit(check_result());
+}
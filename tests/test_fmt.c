@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "check.h"
+
+/*
+ * fmt_write() 與原本 sprintf 寫法的輸出比較
+ *
+ * FMT_DEC(n) 對應 %0nd (負號計入寬度)、FMT_HEX(n) 對應 %0nX、
+ * FMT_FIXED(1, 3) 對應 %.3f。
+ */
+
+static const int32_t kValues[] =
+{
+    0, 1, -1, 5, -5, 9, -9, 10, -10, 42, -42, 99, -99, 100, -100, 12345,
+    -12345, INT32_MAX, INT32_MIN
+};
+
+#define kValueCount (sizeof(kValues) / sizeof(kValues[0]))
+
+// fmt 的輸出 (補上 '\0') 與 expected 相同
+static void check_output(const char *expected, fmt_spec_t spec, int32_t value)
+{
+    char text[FMT_I32_MAX + 2];
+    char *end = fmt_write(text, spec, value);
+
+    *end = '\0';
+    if (strcmp(text, expected) != 0)
+    {
+        fprintf(stderr, "fmt gives \"%s\", sprintf gives \"%s\"\n", text,
+                expected);
+    }
+    CHECK(strcmp(text, expected) == 0);
+}
+
+static void test_dec(void)
+{
+    char expected[32];
+
+    for (size_t i = 0; i < kValueCount; i++)
+    {
+        int32_t v = kValues[i];
+
+        snprintf(expected, sizeof(expected), "%d", (int) v);
+        check_output(expected, FMT_DEC(0), v);
+        snprintf(expected, sizeof(expected), "%01d", (int) v);
+        check_output(expected, FMT_DEC(1), v);
+        snprintf(expected, sizeof(expected), "%02d", (int) v);
+        check_output(expected, FMT_DEC(2), v);
+        snprintf(expected, sizeof(expected), "%05d", (int) v);
+        check_output(expected, FMT_DEC(5), v);
+        snprintf(expected, sizeof(expected), "%010d", (int) v);
+        check_output(expected, FMT_DEC(10), v);
+    }
+}
+
+static void test_dec_negative_width(void)
+{
+    // main.c 的 "Current Cars: %02d"：負號佔一格，不另外補零
+    check_output("-5", FMT_DEC(2), -5);
+    check_output("-05", FMT_DEC(3), -5);
+    check_output("-42", FMT_DEC(2), -42);
+    check_output("05", FMT_DEC(2), 5);
+}
+
+static void test_hex(void)
+{
+    char expected[32];
+
+    for (size_t i = 0; i < kValueCount; i++)
+    {
+        uint32_t v = (uint32_t) kValues[i];
+
+        snprintf(expected, sizeof(expected), "%08X", (unsigned) v);
+        check_output(expected, FMT_HEX(8), (int32_t) v);
+        snprintf(expected, sizeof(expected), "%02X", (unsigned) (v & 0xFF));
+        check_output(expected, FMT_HEX(2), (int32_t) v);
+    }
+}
+
+static void test_fixed(void)
+{
+    char expected[32];
+
+    for (int32_t v = -2500; v <= 2500; v += 7)
+    {
+        snprintf(expected, sizeof(expected), "%.3f", v / 1000.0);
+        check_output(expected, FMT_FIXED(1, 3), v);
+    }
+}
+
+int main(void)
+{
+    test_dec();
+    test_dec_negative_width();
+    test_hex();
+    test_fixed();
+    return check_result();
+}
@@ -0,0 +1,107 @@
+#include "gate.h"
+#include "check.h"
+
+/*
+ * 閘門 Servo 狀態機：CLOSED -> OPENING -> OPEN -> CLOSING -> CLOSED，
+ * 開啟期間到達的車延長開啟時間，關閉中到達的車讓閘門反轉
+ */
+
+#define kOpen 2000
+#define kClosed 1000
+#define kTravel 150000
+#define kHold 300000
+
+static uint16_t g_ccr;
+
+static void test_single_car(void)
+{
+    gate_t gate;
+    uint32_t deadline = 0;
+
+    gate_init(&gate, &g_ccr, kOpen, kClosed, kTravel, kHold);
+    CHECK_EQ(g_ccr, kClosed);
+    CHECK(gate_is_idle(&gate));
+    CHECK(!gate_next_deadline(&gate, &deadline));
+
+    gate_request(&gate, 1000);
+    CHECK_EQ(gate.state, GATE_OPENING);
+    CHECK_EQ(g_ccr, kOpen);
+    CHECK(gate_next_deadline(&gate, &deadline));
+    CHECK_EQ(deadline, 1000 + kTravel);
+
+    gate_update(&gate, 1000 + kTravel - 1);
+    CHECK_EQ(gate.state, GATE_OPENING);
+    gate_update(&gate, 1000 + kTravel);
+    CHECK_EQ(gate.state, GATE_OPEN);
+    gate_update(&gate, 1000 + kTravel + kHold);
+    CHECK_EQ(gate.state, GATE_CLOSING);
+    CHECK_EQ(g_ccr, kClosed);
+    CHECK_EQ(gate.served, 1);
+    gate_update(&gate, 1000 + 2 * kTravel + kHold);
+    CHECK_EQ(gate.state, GATE_CLOSED);
+    CHECK(gate_is_idle(&gate));
+}
+
+static void test_cars_while_open(void)
+{
+    gate_t gate;
+    uint32_t now = 0;
+
+    gate_init(&gate, &g_ccr, kOpen, kClosed, kTravel, kHold);
+    gate_request(&gate, now);
+    gate_request(&gate, now + 10);   // OPENING 中到達
+    gate_update(&gate, now += kTravel);
+    gate_request(&gate, now + 10);   // OPEN 中到達
+    CHECK_EQ(gate.pending, 3);
+
+    // 每台車各保持 kHold，最後一台通過後才關閉
+    gate_update(&gate, now += kHold);
+    CHECK_EQ(gate.state, GATE_OPEN);
+    gate_update(&gate, now += kHold);
+    CHECK_EQ(gate.state, GATE_OPEN);
+    CHECK_EQ(g_ccr, kOpen);
+    gate_update(&gate, now += kHold);
+    CHECK_EQ(gate.state, GATE_CLOSING);
+    CHECK_EQ(gate.requested, 3);
+    CHECK_EQ(gate.served, 3);
+}
+
+static void test_reopen_while_closing(void)
+{
+    gate_t gate;
+    uint32_t now = 0;
+
+    gate_init(&gate, &g_ccr, kOpen, kClosed, kTravel, kHold);
+    gate_request(&gate, now);
+    gate_update(&gate, now += kTravel);
+    gate_update(&gate, now += kHold);
+    CHECK_EQ(gate.state, GATE_CLOSING);
+
+    gate_request(&gate, now += kTravel / 2);
+    CHECK_EQ(gate.state, GATE_OPENING);
+    CHECK_EQ(g_ccr, kOpen);
+    gate_update(&gate, now += kTravel);
+    CHECK_EQ(gate.state, GATE_OPEN);
+}
+
+static void test_deadline_across_wrap(void)
+{
+    gate_t gate;
+    uint32_t now = 0xFFFFFFFF - kTravel / 2;
+
+    gate_init(&gate, &g_ccr, kOpen, kClosed, kTravel, kHold);
+    gate_request(&gate, now);
+    gate_update(&gate, now + kTravel / 4);
+    CHECK_EQ(gate.state, GATE_OPENING);
+    gate_update(&gate, now + kTravel);
+    CHECK_EQ(gate.state, GATE_OPEN);
+}
+
+int main(void)
+{
+    test_single_car();
+    test_cars_while_open();
+    test_reopen_while_closing();
+    test_deadline_across_wrap();
+    return check_result();
+}
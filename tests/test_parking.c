@@ -0,0 +1,191 @@
+#include "parking.h"
+#include "check.h"
+
+/*
+ * 停車場邏輯 (parking_logic)：每台車只計數一次、車位已滿時保留到有空位、
+ * 兩顆感測器輪流使用發波時段、兩個閘門同時有車潮時不漏掉任何一台
+ */
+
+#define kTemperature 20
+#define kBurstPresent 4     // 車潮中每台車停在感測器前的量測次數
+#define kBurstPeriod 8      // 車潮中前後兩台車的間隔 (量測次數)
+
+static volatile int g_remaining;
+static int g_capacity;
+static int8_t g_temperature = kTemperature;
+static uint16_t g_entry_ccr;
+static uint16_t g_exit_ccr;
+static gate_t g_entry_gate;
+static gate_t g_exit_gate;
+static uint32_t g_now_us = 0;
+
+static void lot_init(parking_t *lot, int capacity)
+{
+    g_capacity = capacity;
+    g_remaining = capacity;
+    gate_init(&g_entry_gate, &g_entry_ccr, 2000, 1000, 150000, 300000);
+    gate_init(&g_exit_gate, &g_exit_ccr, 2000, 1000, 150000, 300000);
+    lot->remaining_spaces = &g_remaining;
+    lot->capacity = &g_capacity;
+    lot->entry_gate = &g_entry_gate;
+    lot->exit_gate = &g_exit_gate;
+    lot->idle_gap_us = kIdleGap;
+    lot->active_gap_us = kActiveGap;
+    lot->temperature_c = &g_temperature;
+    parking_init(lot, g_now_us);
+}
+
+// 距離 (mm) 對應的 Echo 脈寬
+static uint32_t echo_width_us(uint32_t distance_mm)
+{
+    return distance_mm * 200000 / units_sound_speed_cm_s(kTemperature);
+}
+
+// 同一個距離連續量測 count 次，回傳計數的次數
+static int feed(parking_t *lot, uint8_t sensor, uint32_t distance_mm,
+        int count)
+{
+    int counted = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        g_now_us += kActiveGap;
+        counted += parking_on_echo(lot, sensor, echo_width_us(distance_mm),
+                g_now_us);
+    }
+    return counted;
+}
+
+static void test_counts_each_car_once(void)
+{
+    parking_t lot;
+
+    lot_init(&lot, 2);
+    CHECK_EQ(feed(&lot, ECHO_ENTRY, 500, 20), 1);
+    CHECK_EQ(g_remaining, 1);
+    CHECK_EQ(g_entry_gate.requested, 1);
+    CHECK_EQ(feed(&lot, ECHO_ENTRY, 3000, 10), 0);
+    CHECK_EQ(feed(&lot, ECHO_EXIT, 500, 20), 1);
+    CHECK_EQ(g_remaining, 2);
+    CHECK_EQ(g_exit_gate.requested, 1);
+}
+
+static void test_waits_while_full(void)
+{
+    parking_t lot;
+
+    lot_init(&lot, 1);
+    CHECK_EQ(feed(&lot, ECHO_ENTRY, 500, 10), 1);
+    CHECK_EQ(feed(&lot, ECHO_ENTRY, 3000, 10), 0);
+    CHECK_EQ(g_remaining, 0);
+
+    // 第二台車停在入口：車位已滿不計數，出場後才放行
+    CHECK_EQ(feed(&lot, ECHO_ENTRY, 500, 10), 0);
+    CHECK(lot.waiting[ECHO_ENTRY]);
+    CHECK_EQ(feed(&lot, ECHO_EXIT, 500, 10), 1);
+    CHECK_EQ(g_remaining, 1);
+    CHECK_EQ(feed(&lot, ECHO_ENTRY, 500, 1), 1);
+    CHECK_EQ(g_remaining, 0);
+    CHECK_EQ(g_entry_gate.requested, 2);
+
+    // 沒有車在場內時出口的車不計數
+    g_remaining = g_capacity;
+    CHECK_EQ(feed(&lot, ECHO_EXIT, 3000, 10), 0);
+    CHECK_EQ(feed(&lot, ECHO_EXIT, 500, 10), 0);
+    CHECK_EQ(g_remaining, g_capacity);
+}
+
+// 第 sample 次量測時車潮中是否有車停在感測器前
+static uint32_t burst_distance_mm(int sample, int offset, int cars)
+{
+    int slot = sample - offset;
+
+    if (slot < 0 || slot >= cars * kBurstPeriod)
+    {
+        return 3000;
+    }
+    return slot % kBurstPeriod < kBurstPresent ? 500 : 3000;
+}
+
+static void test_interleaved_bursts(void)
+{
+    parking_t lot;
+    const int entry_cars = 6;
+    const int exit_cars = 4;
+    int samples[ECHO_SENSOR_COUNT] = { 0 };
+    int counted = 0;
+
+    lot_init(&lot, 20);
+    g_remaining = g_capacity - exit_cars;
+    // 每台車保持 1 s，下一台車到達時閘門還開著，請求必須排隊
+    gate_init(&g_entry_gate, &g_entry_ccr, 2000, 1000, 150000, 1000000);
+    gate_init(&g_exit_gate, &g_exit_ccr, 2000, 1000, 150000, 1000000);
+
+    // 兩顆感測器輪流發波，出口的車潮晚兩次量測開始，兩個閘門同時開啟
+    for (int step = 0; step < 2 * (entry_cars + 2) * kBurstPeriod; step++)
+    {
+        uint8_t sensor = step % 2 ? ECHO_EXIT : ECHO_ENTRY;
+        int cars = sensor == ECHO_ENTRY ? entry_cars : exit_cars;
+        int offset = sensor == ECHO_ENTRY ? 0 : 2;
+        uint32_t distance_mm = burst_distance_mm(samples[sensor]++, offset, cars);
+
+        g_now_us += kPingCycle;
+        counted += parking_on_echo(&lot, sensor, echo_width_us(distance_mm),
+                g_now_us);
+        gate_update(&g_entry_gate, g_now_us);
+        gate_update(&g_exit_gate, g_now_us);
+        CHECK_EQ(g_entry_gate.requested - g_entry_gate.served,
+                g_entry_gate.pending);
+        CHECK_EQ(g_exit_gate.requested - g_exit_gate.served,
+                g_exit_gate.pending);
+    }
+    while (!gate_is_idle(&g_entry_gate) || !gate_is_idle(&g_exit_gate))
+    {
+        g_now_us += kPingCycle;
+        gate_update(&g_entry_gate, g_now_us);
+        gate_update(&g_exit_gate, g_now_us);
+    }
+
+    CHECK_EQ(counted, entry_cars + exit_cars);
+    CHECK_EQ(g_entry_gate.requested, entry_cars);
+    CHECK_EQ(g_entry_gate.served, entry_cars);
+    CHECK_EQ(g_exit_gate.requested, exit_cars);
+    CHECK_EQ(g_exit_gate.served, exit_cars);
+    CHECK_EQ(g_remaining, g_capacity - entry_cars);
+    CHECK(!lot.waiting[ECHO_ENTRY]);
+    CHECK(!lot.waiting[ECHO_EXIT]);
+}
+
+static void test_sensors_share_ping_slot(void)
+{
+    parking_t lot;
+
+    lot_init(&lot, 2);
+    CHECK_EQ(parking_poll_due(&lot, g_now_us), 1U << ECHO_ENTRY);
+    CHECK_EQ(parking_poll_due(&lot, g_now_us), 0);
+    CHECK_EQ(parking_next_trigger(&lot), g_now_us + kPingCycle);
+    CHECK_EQ(parking_poll_due(&lot, g_now_us + kPingCycle - 1), 0);
+    CHECK_EQ(parking_poll_due(&lot, g_now_us + kPingCycle), 1U << ECHO_EXIT);
+}
+
+static void test_gap_follows_presence(void)
+{
+    parking_t lot;
+
+    lot_init(&lot, 2);
+    feed(&lot, ECHO_ENTRY, 500, 1);
+    CHECK_EQ(lot.gap_us[ECHO_ENTRY], kActiveGap);
+    feed(&lot, ECHO_ENTRY, 3000, 10);
+    CHECK_EQ(lot.gap_us[ECHO_ENTRY], kIdleGap);
+    CHECK_EQ(lot.next_trigger_us[ECHO_ENTRY], g_now_us + kIdleGap);
+}
+
+int main(void)
+{
+    test_counts_each_car_once();
+    test_waits_while_full();
+    test_interleaved_bursts();
+    test_sensors_share_ping_slot();
+    test_gap_follows_presence();
+    return check_result();
+}
@@ -0,0 +1,164 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "gate.h"
+#include "telemetry.h"
+#include "usart_tx.h"
+#include "units.h"
+#include "check.h"
+
+/*
+ * 遙測編碼與解碼的來回測試 (在暫存器模擬器上執行)
+ *
+ * telemetry_send() 以 CRC 周邊模型計算 CRC、COBS 編碼後經 USART1 DMA 送出，
+ * 夾雜指令回覆的文字；收集 USART1 的輸出交給 tools/telemetry_decode
+ * (路徑由 ctest 以環境變數 TELEMETRY_DECODE 傳入)，比對解碼後的每一行。
+ */
+
+#define kBaud 115200
+#define kLongText 300 // 超過解碼器的緩衝區 (256)
+
+static int g_output[2];
+static uint8_t g_bytes[4096];
+static size_t g_byte_count = 0;
+
+static void collect(void)
+{
+    ssize_t n;
+
+    while (usart_tx_pending() > 0)
+    {
+        __WFI();
+    }
+    while ((USART1->SR & USART_SR_TC) == 0)
+        ;
+    while ((n = read(g_output[0], g_bytes + g_byte_count,
+            sizeof(g_bytes) - g_byte_count)) > 0)
+    {
+        g_byte_count += n;
+    }
+}
+
+static void send_text(const char *text, size_t len)
+{
+    // 每次最多寫入半個緩衝區，等送完再寫下一段
+    while (len > 0)
+    {
+        uint16_t piece = len > kUsartTxBufferSize / 2 ? kUsartTxBufferSize / 2 : len;
+        CHECK(usart_tx_write(text, piece));
+        collect();
+        text += piece;
+        len -= piece;
+    }
+}
+
+static void send_record(const telemetry_record_t *record)
+{
+    CHECK(telemetry_send(record));
+    collect();
+}
+
+// 複製第一個 frame 並改掉其中一個位元組，接在最後
+static void append_corrupted_frame(void)
+{
+    uint8_t *start = memchr(g_bytes, 0, g_byte_count);
+    uint8_t *end = memchr(start + 1, 0, g_bytes + g_byte_count - start - 1);
+    size_t len = end - start + 1;
+
+    memcpy(g_bytes + g_byte_count, start, len);
+    g_bytes[g_byte_count + 10] ^= 0x80;
+    g_byte_count += len;
+}
+
+static char *decode(void)
+{
+    static char output[8192];
+    char path[] = "/tmp/test_telemetry_XXXXXX";
+    char command[512];
+    const char *decoder = getenv("TELEMETRY_DECODE");
+    int fd = mkstemp(path);
+    size_t len;
+    FILE *pipe;
+
+    if (decoder == NULL || fd < 0 || write(fd, g_bytes, g_byte_count)
+            != (ssize_t) g_byte_count)
+    {
+        fprintf(stderr, "cannot run the decoder (TELEMETRY_DECODE not set?)\n");
+        exit(1);
+    }
+    close(fd);
+    snprintf(command, sizeof(command), "'%s' '%s'", decoder, path);
+    pipe = popen(command, "r");
+    len = pipe != NULL ? fread(output, 1, sizeof(output) - 1, pipe) : 0;
+    output[len] = '\0';
+    CHECK(pipe != NULL && pclose(pipe) == 0);
+    unlink(path);
+    return output;
+}
+
+int main(void)
+{
+    static char long_text[kLongText + 1];
+    static char expected[8192];
+    const telemetry_record_t busy =
+    {
+        123456789, 3, 20, 17492, 70000, GATE_OPEN, GATE_CLOSING,
+        1, 2, 70000, 123, 23
+    };
+    // 每個欄位都含 0x0A、0x0D：frame 內的換行不能被當成文字行
+    const telemetry_record_t newlines =
+    {
+        0x0A0D0A0D, 10, 13, 0x0A0D, 0x0D0A, 1, 0, 10, 13, 10, 13, 10
+    };
+    const telemetry_record_t idle = { 0 };
+
+    if (pipe(g_output) != 0 || fcntl(g_output[0], F_SETFL, O_NONBLOCK) != 0)
+    {
+        return 1;
+    }
+    sim_usart_set_output(g_output[1]);
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+    USART1->BRR = units_usart_brr(SystemCoreClock, kBaud);
+    USART1->CR1 = USART_CR1_UE | USART_CR1_TE;
+    usart_tx_init();
+    telemetry_init();
+
+    memset(long_text, 'x', kLongText);
+    memcpy(long_text, "LONG ", 5);
+    memcpy(long_text + kLongText - 2, "\r\n", 2);
+
+    send_record(&busy);
+    send_text("OK\r\n", 4);
+    send_text(long_text, kLongText);
+    send_record(&newlines);
+    send_text("LOAD 12.3%\r\n", 12);
+    send_record(&idle);
+    append_corrupted_frame();
+
+    snprintf(expected, sizeof(expected),
+            "seq=0 t=123.456789 occ=3/20 echo_in=17492us echo_out=65535us "
+            "gate_in=open gate_out=closing echo_drop=1 tx_rej=2 rx_trunc=65535 "
+            "load=12.3%% wakeups=23\n"
+            "OK\r\n"
+            "%s"
+            "seq=1 t=168.626701 occ=10/13 echo_in=2573us echo_out=3338us "
+            "gate_in=opening gate_out=closed echo_drop=10 tx_rej=13 rx_trunc=10 "
+            "load=1.3%% wakeups=10\n"
+            "LOAD 12.3%%\r\n"
+            "seq=2 t=0.000000 occ=0/0 echo_in=0us echo_out=0us "
+            "gate_in=closed gate_out=closed echo_drop=0 tx_rej=0 rx_trunc=0 "
+            "load=0.0%% wakeups=0\n"
+            "# CRC error (1)\n", long_text);
+
+    const char *output = decode();
+    CHECK(strcmp(output, expected) == 0);
+    if (strcmp(output, expected) != 0)
+    {
+        fprintf(stderr, "decoded:\n%s\nexpected:\n%s\n", output, expected);
+    }
+    exit(check_result());
+}
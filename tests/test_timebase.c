@@ -0,0 +1,60 @@
+#include "timebase.h"
+#include "check.h"
+
+/*
+ * 32-bit µs 時基約 71.6 分鐘回繞一次：比較與經過時間必須跨越回繞仍正確，
+ * 以回繞次數組成的 64-bit 時間在回繞前後必須單調遞增
+ * (TIM3 -> TIM4 的實際回繞見 test_timebase_chain.c)
+ */
+
+static void test_compare_across_wrap(void)
+{
+    uint32_t before = 0xFFFFFF00;
+    uint32_t after = 0x00000100;
+
+    CHECK(timebase_after(after, before));
+    CHECK(!timebase_after(before, after));
+    CHECK(!timebase_after(before, before));
+    CHECK(timebase_reached(after, before));
+    CHECK(timebase_reached(before, before));
+    CHECK(!timebase_reached(before, after));
+    CHECK_EQ(timebase_elapsed(after, before), 0x200);
+
+    // 相差 2^31 - 1 µs (約 35.8 分鐘) 內仍可比較
+    CHECK(timebase_after(before + 0x7FFFFFFF, before));
+    CHECK(!timebase_reached(before, before + 0x7FFFFFFF));
+}
+
+static void test_deadline_across_wrap(void)
+{
+    uint32_t now = 0xFFFF0000;
+    uint32_t deadline = now + 500000; // 回繞後才到期
+
+    CHECK(deadline < now);
+    CHECK(!timebase_reached(now, deadline));
+    CHECK(!timebase_reached(now + 499999, deadline));
+    CHECK(timebase_reached(now + 500000, deadline));
+    CHECK_EQ(timebase_elapsed(deadline, now), 500000);
+}
+
+static void test_join(void)
+{
+    CHECK_EQ(timebase_join(0, 0xFFFFFFFF, false), 0xFFFFFFFFULL);
+    CHECK_EQ(timebase_join(1, 0, false), 0x100000000ULL);
+    CHECK_EQ(timebase_join(2, 5, false), 0x200000005ULL);
+
+    // 回繞後 TIM4 中斷還沒執行：讀值在前半圈，回繞次數要補 1
+    CHECK_EQ(timebase_join(0, 3, true), 0x100000003ULL);
+    CHECK_EQ(timebase_join(0, 0x7FFFFFFF, true), 0x17FFFFFFFULL);
+    // 旗標是讀值之後才設定的：讀值仍屬於回繞前
+    CHECK_EQ(timebase_join(0, 0xFFFFFFF0, true), 0xFFFFFFF0ULL);
+    CHECK(timebase_join(0, 0xFFFFFFF0, true) < timebase_join(0, 3, true));
+}
+
+int main(void)
+{
+    test_compare_across_wrap();
+    test_deadline_across_wrap();
+    test_join();
+    return check_result();
+}
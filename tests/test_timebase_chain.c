@@ -0,0 +1,120 @@
+#include <stdlib.h>
+
+#include "sim.h"
+#include "timebase.h"
+#include "clock.h"
+#include "events.h"
+#include "check.h"
+
+/*
+ * TIM3 -> TIM4 串接的 µs 時基 (在暫存器模擬器上執行)
+ *
+ * - 低 16 位元 (TIM3) 回繞：連續讀值不能倒退，回繞後高位只加 1；
+ *   模擬器每次存取暫存器都會推進虛擬時間，回繞常會落在
+ *   timebase_now_us() 讀 TIM4 -> TIM3 -> TIM4 之間，走到重讀的路徑
+ * - 32-bit 回繞：TIM4 update 中斷累計回繞次數，timebase_now_us64() 跨越
+ *   回繞仍遞增；中斷被遮罩時以尚未處理的 UIF 補上
+ *
+ * 為了不等 65 ms / 71.6 分鐘，直接把 CNT 往前設到回繞前幾 µs (只會往前跳，
+ * 時間仍是單調的)。時脈管理與 events 以簡單的替身代替。
+ * ctest 以 -s 0.01 執行 (見 host.cmake)。
+ */
+
+#define kLowRollovers 200
+#define kBeforeRollover 0xFFF0 // 回繞前 16 µs
+
+static clock_freqs_t g_freqs;
+
+const clock_freqs_t *clock_freqs(void)
+{
+    return &g_freqs;
+}
+
+bool clock_add_listener(clock_listener_t listener)
+{
+    (void) listener;
+    return true;
+}
+
+void events_post(uint32_t events)
+{
+    (void) events;
+}
+
+// 讀到高 16 位元改變為止，每筆都不能比前一筆小；回傳讀值期間遇到回繞的次數
+static uint32_t read_through_rollover(uint64_t *last)
+{
+    uint16_t start_high = TIM4->CNT;
+    uint32_t straddled = 0;
+
+    for (;;)
+    {
+        uint16_t before = TIM4->CNT;
+        uint64_t now = timebase_now_us64();
+
+        CHECK(now >= *last);
+        *last = now;
+        if ((uint16_t) (now >> 16) != before)
+        {
+            straddled++;
+        }
+        if ((uint16_t) (now >> 16) != start_high)
+        {
+            return straddled;
+        }
+    }
+}
+
+static void test_low_rollover(void)
+{
+    uint64_t last = timebase_now_us64();
+    uint32_t straddled = 0;
+
+    for (int i = 0; i < kLowRollovers; i++)
+    {
+        uint16_t high = TIM4->CNT;
+
+        TIM3->CNT = kBeforeRollover;
+        straddled += read_through_rollover(&last);
+        CHECK_EQ((uint16_t) (last >> 16), (uint16_t) (high + 1));
+        CHECK((uint16_t) last < 0x8000);
+    }
+    CHECK_EQ(last >> 32, 0);
+    // 至少有一部分讀值在執行中遇到回繞 (重讀的路徑)
+    CHECK(straddled > 0);
+}
+
+static void test_wrap(void)
+{
+    uint64_t last = timebase_now_us64();
+
+    TIM4->CNT = 0xFFFF;
+    TIM3->CNT = kBeforeRollover;
+    read_through_rollover(&last);
+    CHECK_EQ(last >> 32, 1);
+    CHECK((uint32_t) last < 0x8000);
+
+    // 中斷遮罩期間回繞：TIM4 中斷還沒執行，由 UIF 補上
+    __disable_irq();
+    TIM4->CNT = 0xFFFF;
+    TIM3->CNT = kBeforeRollover;
+    read_through_rollover(&last);
+    CHECK((TIM4->SR & TIM_SR_UIF) != 0);
+    CHECK_EQ(last >> 32, 2);
+    __enable_irq();
+
+    uint64_t now = timebase_now_us64();
+    CHECK((TIM4->SR & TIM_SR_UIF) == 0);
+    CHECK(now >= last);
+    CHECK_EQ(now >> 32, 2);
+}
+
+int main(void)
+{
+    g_freqs.tim_apb1_hz = sim_rcc_timclk(1);
+    timebase_init();
+
+    test_low_rollover();
+    test_wrap();
+    exit(check_result());
+}
@@ -0,0 +1,150 @@
+#include <math.h>
+#include <stdint.h>
+
+#include "units.h"
+#include "check.h"
+
+/*
+ * units.h 的整數換算與 double 計算的結果比較
+ *
+ * 比較以千分之一為單位 (CHECK_NEAR 只接受整數)。四捨五入的換算誤差
+ * 不超過 0.5 個單位；Echo 距離另外有音速截斷到整數 cm/s 造成的誤差。
+ */
+
+#define kMilli 1000.0
+
+// 韌體實際使用的時脈 (HSI 8 MHz、PLL 24 ~ 72 MHz 與 APB1 除頻)
+static const uint32_t kClocks[] =
+{
+    8000000, 16000000, 24000000, 32000000, 36000000, 48000000, 56000000,
+    64000000, 72000000
+};
+
+#define kClockCount (sizeof(kClocks) / sizeof(kClocks[0]))
+
+// c = 331.3 + 0.606 × T (m/s)；來回距離的一半，單位 mm
+static double exact_echo_mm(uint32_t width_us, int temperature_c)
+{
+    double speed_m_s = 331.3 + 0.606 * temperature_c;
+
+    return width_us * 1e-6 * speed_m_s * 1000.0 / 2.0;
+}
+
+// 四捨五入 0.5 mm，加上音速少算 1 cm/s 以內 (每 200 µs 脈寬 0.001 mm)
+static long long echo_tolerance(uint32_t width_us)
+{
+    return 500 + width_us / 200;
+}
+
+static void test_echo_to_mm(void)
+{
+    for (int t = -40; t <= 85; t++)
+    {
+        for (uint32_t w = 0; w <= 38000; w += 7)
+        {
+            CHECK_NEAR(units_echo_to_mm(w, (int8_t) t) * kMilli,
+                    llround(exact_echo_mm(w, t) * kMilli), echo_tolerance(w));
+        }
+        // 超過最大脈寬時固定為最遠距離
+        CHECK_EQ(units_echo_to_mm(UNITS_MAX_ECHO_US + 1000, (int8_t) t),
+                units_echo_to_mm(UNITS_MAX_ECHO_US, (int8_t) t));
+        CHECK_NEAR(units_echo_to_mm(UNITS_MAX_ECHO_US, (int8_t) t) * kMilli,
+                llround(exact_echo_mm(UNITS_MAX_ECHO_US, t) * kMilli),
+                echo_tolerance(UNITS_MAX_ECHO_US));
+    }
+}
+
+static void test_timer_psc(void)
+{
+    static const uint32_t kTicks[] = { 1000, 10000, 100000, 1000000 };
+
+    for (size_t c = 0; c < kClockCount; c++)
+    {
+        for (size_t i = 0; i < sizeof(kTicks) / sizeof(kTicks[0]); i++)
+        {
+            double exact = (double) kClocks[c] / kTicks[i] - 1.0;
+
+            if (exact > 0xFFFF)
+            {
+                CHECK_EQ(units_timer_psc(kClocks[c], kTicks[i]), 0xFFFF);
+                continue;
+            }
+            CHECK_NEAR(units_timer_psc(kClocks[c], kTicks[i]) * kMilli,
+                    llround(exact * kMilli), 500);
+        }
+    }
+    // 無法整除時取最接近的值
+    CHECK_EQ(units_timer_psc(8000000, 3000000), 2);
+    CHECK_EQ(units_timer_psc(1000, 1000000), 0);
+    CHECK_EQ(UNITS_TIMER_PSC(72000000, 1000000), 71);
+    CHECK_EQ(UNITS_TIMER_PSC(8000000, 10000), 799);
+}
+
+static void test_usart_brr(void)
+{
+    static const uint32_t kBauds[] = { 9600, 19200, 57600, 115200 };
+
+    for (size_t c = 0; c < kClockCount; c++)
+    {
+        for (size_t i = 0; i < sizeof(kBauds) / sizeof(kBauds[0]); i++)
+        {
+            uint16_t brr = units_usart_brr(kClocks[c], kBauds[i]);
+            double actual_baud = (double) kClocks[c] / brr;
+
+            CHECK_NEAR(brr * kMilli, llround((double) kClocks[c] / kBauds[i]
+                    * kMilli), 500);
+            // 實際鮑率誤差在 USART 容許的 2% 以內 (以千分之一計)
+            CHECK_NEAR(actual_baud * kMilli / kBauds[i], 1000, 20);
+        }
+    }
+    CHECK_EQ(UNITS_USART_BRR(72000000, 9600), 7500);
+    CHECK_EQ(UNITS_USART_BRR(8000000, 115200), 69);
+    CHECK_EQ(units_usart_brr(100, 9600), 16);
+    CHECK_EQ(units_usart_brr(72000000, 300), 0xFFFF);
+}
+
+// UNITS_SERVO_US 的參數必須是常數 (UNITS_CHECK)，逐一展開
+#define CHECK_SERVO(deg, min_us, max_us) \
+    CHECK_NEAR(UNITS_SERVO_US(deg, min_us, max_us) * kMilli, \
+            llround(((min_us) + (deg) * ((max_us) - (min_us)) / 180.0) * kMilli), 500)
+
+static void test_servo_us(void)
+{
+    CHECK_SERVO(0, 500, 2500);
+    CHECK_SERVO(1, 500, 2500);
+    CHECK_SERVO(45, 500, 2500);
+    CHECK_SERVO(89, 500, 2500);
+    CHECK_SERVO(90, 500, 2500);
+    CHECK_SERVO(91, 500, 2500);
+    CHECK_SERVO(135, 500, 2500);
+    CHECK_SERVO(179, 500, 2500);
+    CHECK_SERVO(180, 500, 2500);
+    CHECK_SERVO(7, 1000, 2000);
+    CHECK_SERVO(121, 1000, 2000);
+    CHECK_SERVO(180, 1000, 2000);
+}
+
+static void test_us_to_ticks(void)
+{
+    static const uint32_t kTicks[] = { 32768, 1000000, 8000000, 72000000 };
+
+    for (size_t i = 0; i < sizeof(kTicks) / sizeof(kTicks[0]); i++)
+    {
+        for (uint32_t us = 0; us <= 60000; us += 13)
+        {
+            CHECK_NEAR(UNITS_US_TO_TICKS(us, kTicks[i]) * kMilli,
+                    llround(us * 1e-6 * kTicks[i] * kMilli), 500);
+        }
+    }
+    CHECK_EQ(UNITS_US_TO_TICKS(20000, 1000000), 20000);
+}
+
+int main(void)
+{
+    test_echo_to_mm();
+    test_timer_psc();
+    test_usart_brr();
+    test_servo_us();
+    test_us_to_ticks();
+    return check_result();
+}
@@ -0,0 +1,308 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "usart_rx.h"
+#include "usart_tx.h"
+#include "command.h"
+#include "telemetry.h"
+#include "events.h"
+#include "clock.h"
+#include "boot.h"
+#include "store.h"
+#include "checkpoint.h"
+#include "display.h"
+#include "echo_capture.h"
+#include "fmt.h"
+#include "units.h"
+#include "check.h"
+
+/*
+ * USART1 DMA 接收與遠端指令 (在暫存器模擬器上執行)
+ *
+ * 以模擬器從 RX 送入位元組，經 DMA1 Channel 5 (circular) 與 IDLE 中斷切成
+ * frame：'\r' / '\n' / 線路閒置結尾、空行略過、過長的 frame 截斷並計數、
+ * 環狀緩衝區回繞。指令的回覆經 usart_tx 送到 pipe 後比對：大小寫、
+ * 前後空白、參數範圍與未知指令。
+ *
+ * 時脈、開機紀錄、flash 紀錄區、備份區與顯示器以簡單的替身代替。
+ */
+
+#define kBaud 115200
+
+static int g_output[2]; // USART1 的輸出 pipe
+static volatile bool g_rx_event = false;
+
+static int g_remaining = 17;
+static int g_capacity = 20;
+static uint32_t g_telemetry_period_us = 500000;
+static uint8_t g_telemetry_mode = TELEMETRY_TEXT;
+static const uint16_t g_cpu_load = 123;
+static gate_t g_entry_gate;
+static gate_t g_exit_gate;
+static uint16_t g_entry_ccr;
+static uint16_t g_exit_ccr;
+static int8_t g_temperature = 20;
+static const uint32_t g_last_echo_us[ECHO_SENSOR_COUNT] = { 8746, 17492 };
+static uint8_t g_brightness = kDisplayDimSteps;
+static clock_profile_t g_profile = CLOCK_PROFILE_RUN;
+
+static const command_context_t kContext =
+{ &g_remaining, &g_capacity, &g_telemetry_period_us, &g_telemetry_mode,
+        &g_cpu_load, &g_entry_gate, &g_exit_gate, &g_temperature,
+        g_last_echo_us };
+
+void events_post(uint32_t events)
+{
+    if ((events & EVENT_RX) != 0)
+    {
+        g_rx_event = true;
+    }
+}
+
+bool clock_set_profile(clock_profile_t profile)
+{
+    g_profile = profile;
+    return true;
+}
+
+char *boot_format(char *out)
+{
+    return fmt_str(out, "BOOT stub");
+}
+
+char *store_format(char *out)
+{
+    return fmt_str(out, "STORE stub");
+}
+
+char *checkpoint_format(char *out)
+{
+    return fmt_str(out, "CKPT stub");
+}
+
+void display_set_brightness(uint8_t level)
+{
+    g_brightness = level;
+}
+
+uint32_t echo_capture_dropped(void)
+{
+    return 2;
+}
+
+// 從 RX 送入 text，等到線路閒置的中斷
+static void receive(const char *text)
+{
+    g_rx_event = false;
+    sim_usart_inject((const uint8_t *) text, strlen(text));
+    while (!g_rx_event)
+    {
+        __WFI();
+    }
+}
+
+// 取出下一個 frame 並比對內容 (expected == NULL 表示沒有 frame)
+static void check_frame(const char *expected)
+{
+    char frame[kUsartRxFrameSize];
+    uint16_t len = usart_rx_get_frame(frame, sizeof(frame));
+
+    if (expected == NULL)
+    {
+        CHECK_EQ(len, 0);
+        return;
+    }
+    CHECK_EQ(len, strlen(expected));
+    CHECK(strcmp(frame, expected) == 0);
+}
+
+// 讀回 USART1 已送出的位元組，與 expected 比對
+static void check_output(const char *expected)
+{
+    static char received[kUsartTxBufferSize];
+    size_t len = strlen(expected);
+    ssize_t n;
+
+    while (usart_tx_pending() > 0)
+    {
+        __WFI();
+    }
+    while ((USART1->SR & USART_SR_TC) == 0) // 最後一個字元移出
+        ;
+    n = read(g_output[0], received, sizeof(received));
+    CHECK_EQ(n, len);
+    CHECK(n == (ssize_t) len && memcmp(received, expected, len) == 0);
+}
+
+// 從 RX 送入一行指令，執行後比對回覆
+static void check_command(const char *line, const char *reply)
+{
+    char frame[kUsartRxFrameSize];
+
+    receive(line);
+    CHECK(usart_rx_get_frame(frame, sizeof(frame)) > 0);
+    command_execute(&kContext, frame, 0);
+    check_output(reply);
+}
+
+// ------------------------------------------------------------
+// 切分 frame
+// ------------------------------------------------------------
+
+static void test_idle_ends_frame(void)
+{
+    // 沒有換行：線路閒置後才成為 frame，之前取不到
+    g_rx_event = false;
+    sim_usart_inject((const uint8_t *) "Q", 1);
+    check_frame(NULL);
+    while (!g_rx_event)
+    {
+        __WFI();
+    }
+    check_frame("Q");
+    check_frame(NULL);
+}
+
+static void test_line_endings(void)
+{
+    // CR、LF、CRLF 都結束一個 frame，空行略過
+    receive("CAP 5\r\nQ\n\r\n\rRATE 200\r");
+    check_frame("CAP 5");
+    check_frame("Q");
+    check_frame("RATE 200");
+    check_frame(NULL);
+
+    // 同一段傳輸中最後一行沒有換行：由 IDLE 結尾
+    receive("OPEN ENTRY\r\nLOAD");
+    check_frame("OPEN ENTRY");
+    check_frame("LOAD");
+    check_frame(NULL);
+}
+
+static void test_truncation(void)
+{
+    char line[kUsartRxFrameSize + 12];
+    char expected[kUsartRxFrameSize];
+    char frame[8];
+    uint32_t before = usart_rx_truncated();
+
+    // 超過 kUsartRxFrameSize - 1 的部分丟棄並計數，下一個 frame 不受影響
+    memset(line, 'A', kUsartRxFrameSize + 9);
+    strcpy(line + kUsartRxFrameSize + 9, "\r\n");
+    memset(expected, 'A', kUsartRxFrameSize - 1);
+    expected[kUsartRxFrameSize - 1] = '\0';
+    receive(line);
+    check_frame(expected);
+    CHECK_EQ(usart_rx_truncated() - before, 10);
+
+    // 呼叫端的緩衝區較小時只複製到放得下的長度
+    receive("TEMP -12\r\n");
+    CHECK_EQ(usart_rx_get_frame(frame, sizeof(frame)), sizeof(frame) - 1);
+    CHECK(strcmp(frame, "TEMP -1") == 0);
+    check_frame(NULL);
+}
+
+static void test_buffer_wraps(void)
+{
+    // 每次 11 byte，累計超過 kUsartRxBufferSize 數圈
+    for (int i = 0; i < 3 * kUsartRxBufferSize / 11; i++)
+    {
+        receive("CAP 10\r\nQ\r\n");
+        check_frame("CAP 10");
+        check_frame("Q");
+        check_frame(NULL);
+    }
+}
+
+// ------------------------------------------------------------
+// 指令
+// ------------------------------------------------------------
+
+static void test_queries(void)
+{
+    check_command("Q\r\n", "OCC 03/20\r\n");
+    check_command("  q  \r\n", "OCC 03/20\r\n"); // 前後的空白略過
+    check_command("Q 1\r\n", "ERR\r\n");
+    check_command("LOAD\r\n", "LOAD 12.3%\r\n");
+    check_command("ECHO\r\n", "ECHO entry=1502 exit=3004 drop=2\r\n");
+    check_command("BOOT\r\n", "BOOT stub\r\n");
+    check_command("store\r\n", "STORE stub\r\n");
+}
+
+static void test_settings(void)
+{
+    check_command("CAP 30\r\n", "OK\r\n");
+    CHECK_EQ(g_capacity, 30);
+    CHECK_EQ(g_remaining, 27);
+    check_command("CAP 2\r\n", "ERR\r\n"); // 少於場內的車
+    check_command("CAP 100\r\n", "ERR\r\n");
+    check_command("CAP\r\n", "ERR\r\n");
+    CHECK_EQ(g_capacity, 30);
+
+    check_command("rate 250\r\n", "OK\r\n");
+    CHECK_EQ(g_telemetry_period_us, 250000);
+    check_command("RATE 99\r\n", "ERR\r\n");
+    check_command("RATE 2x\r\n", "ERR\r\n");
+
+    check_command("TEMP -5\r\n", "OK\r\n");
+    CHECK_EQ(g_temperature, -5);
+    check_command("TEMP 86\r\n", "ERR\r\n");
+
+    check_command("BRIGHT 3\r\n", "OK\r\n");
+    CHECK_EQ(g_brightness, 3);
+    check_command("BRIGHT 9\r\n", "ERR\r\n");
+
+    check_command("MODE BIN\r\n", "OK\r\n");
+    CHECK_EQ(g_telemetry_mode, TELEMETRY_BINARY);
+    check_command("MODE HEX\r\n", "ERR\r\n");
+    check_command("mode text\r\n", "OK\r\n");
+    CHECK_EQ(g_telemetry_mode, TELEMETRY_TEXT);
+
+    check_command("CLOCK IDLE\r\n", "OK\r\n");
+    CHECK_EQ(g_profile, CLOCK_PROFILE_IDLE);
+    check_command("CLOCK\r\n", "ERR\r\n");
+}
+
+static void test_gates_and_unknown(void)
+{
+    check_command("OPEN EXIT\r\n", "OK\r\n");
+    CHECK_EQ(g_exit_gate.requested, 1);
+    check_command("OPEN\r\n", "ERR\r\n");
+    check_command("OPEN ENTRYWAY\r\n", "ERR\r\n");
+    CHECK_EQ(g_entry_gate.requested, 0);
+
+    // 未知指令與只比對到開頭的關鍵字
+    check_command("HELLO\r\n", "ERR\r\n");
+    check_command("QQ\r\n", "ERR\r\n");
+    check_command("CAPACITY 5\r\n", "ERR\r\n");
+    CHECK_EQ(g_capacity, 30);
+}
+
+int main(void)
+{
+    if (pipe(g_output) != 0 || fcntl(g_output[0], F_SETFL, O_NONBLOCK) != 0)
+    {
+        return 1;
+    }
+    sim_usart_set_output(g_output[1]);
+
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+    USART1->BRR = units_usart_brr(SystemCoreClock, kBaud);
+    USART1->CR1 = USART_CR1_UE | USART_CR1_RE | USART_CR1_TE;
+    usart_tx_init();
+    usart_rx_init();
+    gate_init(&g_entry_gate, &g_entry_ccr, 2000, 1000, 150000, 300000);
+    gate_init(&g_exit_gate, &g_exit_ccr, 2000, 1000, 150000, 300000);
+
+    test_idle_ends_frame();
+    test_line_endings();
+    test_truncation();
+    test_buffer_wraps();
+    test_queries();
+    test_settings();
+    test_gates_and_unknown();
+    exit(check_result());
+}
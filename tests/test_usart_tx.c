@@ -0,0 +1,129 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "usart_tx.h"
+#include "units.h"
+#include "check.h"
+
+/*
+ * USART1 DMA 傳送的 bip-buffer (在暫存器模擬器上執行)
+ *
+ * 寫入的資料經 DMA1 Channel 4 與 USART1 模型送到 pipe，讀回後比對內容與順序：
+ * 尾端放不下時回繞到開頭、空間不足時整筆拒收、已送出的資料不會被覆蓋。
+ */
+
+#define kBaud 115200
+
+static int g_output[2]; // USART1 的輸出 pipe
+
+static void wait_pending(uint16_t at_most)
+{
+    while (usart_tx_pending() > at_most)
+    {
+        __WFI();
+    }
+}
+
+// 讀回 USART1 已送出的位元組，與 expected 比對
+static void check_output(const char *expected, size_t len)
+{
+    static char received[kUsartTxBufferSize * 2];
+    ssize_t n;
+
+    wait_pending(0);
+    while ((USART1->SR & USART_SR_TC) == 0) // 最後一個字元移出
+        ;
+    n = read(g_output[0], received, sizeof(received));
+    CHECK_EQ(n, len);
+    CHECK(n == (ssize_t) len && memcmp(received, expected, len) == 0);
+}
+
+static void fill(char *data, char value, uint16_t len)
+{
+    memset(data, value, len);
+}
+
+static void test_write(void)
+{
+    CHECK(usart_tx_write("hello\r\n", 7));
+    CHECK_EQ(usart_tx_pending(), 7);
+    check_output("hello\r\n", 7);
+    CHECK_EQ(usart_tx_pending(), 0);
+}
+
+static void test_wrap_and_reject(void)
+{
+    static char expected[kUsartTxBufferSize * 2];
+    usart_tx_stats_t before;
+    usart_tx_stats_t after;
+    char *a;
+    char *b;
+    char *c;
+    char *e;
+
+    usart_tx_get_stats(&before);
+
+    // A 送出中、B 排隊；A 送完後 B 之後只剩 56 byte，C 回繞到開頭
+    a = usart_tx_reserve(100);
+    fill(a, 'A', 100);
+    usart_tx_commit(100);
+    b = usart_tx_reserve(100);
+    CHECK(b == a + 100);
+    fill(b, 'B', 100);
+    usart_tx_commit(100);
+    wait_pending(100);
+
+    c = usart_tx_reserve(80);
+    CHECK(c == a);
+    fill(c, 'C', 80);
+    usart_tx_commit(80);
+
+    // B 還沒送完：C 與 B 之間只有 20 byte
+    CHECK(usart_tx_reserve(30) == NULL);
+    e = usart_tx_reserve(10);
+    CHECK(e == c + 80);
+    fill(e, 'E', 10);
+    usart_tx_commit(10);
+
+    fill(expected, 'A', 100);
+    fill(expected + 100, 'B', 100);
+    fill(expected + 200, 'C', 80);
+    fill(expected + 280, 'E', 10);
+    check_output(expected, 290);
+
+    usart_tx_get_stats(&after);
+    CHECK_EQ(after.rejected - before.rejected, 1);
+    CHECK_EQ(after.dropped_bytes - before.dropped_bytes, 30);
+    CHECK_EQ(after.sent_bytes - before.sent_bytes, 290);
+    CHECK(after.high_water >= 200);
+}
+
+static void test_oversized(void)
+{
+    CHECK(usart_tx_reserve(0) == NULL);
+    CHECK(usart_tx_reserve(kUsartTxBufferSize) == NULL);
+    // 清空後從頭開始，可取得最大的連續空間
+    CHECK(usart_tx_reserve(kUsartTxBufferSize - 1) != NULL);
+}
+
+int main(void)
+{
+    if (pipe(g_output) != 0 || fcntl(g_output[0], F_SETFL, O_NONBLOCK) != 0)
+    {
+        return 1;
+    }
+    sim_usart_set_output(g_output[1]);
+
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+    USART1->BRR = units_usart_brr(SystemCoreClock, kBaud);
+    USART1->CR1 = USART_CR1_UE | USART_CR1_TE;
+    usart_tx_init();
+
+    test_write();
+    test_wrap_and_reject();
+    test_oversized();
+    exit(check_result());
+}
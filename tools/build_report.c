@@ -0,0 +1,544 @@
+/*
+ * 韌體大小 / stack / 複雜度報告 (Linux / MSYS)
+ *
+ * 把一次建置的每個符號整理成一份快照，並與上一次建置的快照比較：
+ *   - 大小：arm-none-eabi-nm -S 的輸出 (函式、常數、.data、.bss)
+ *   - stack：gcc -fstack-usage 產生的 .su
+ *   - 循環複雜度：gcc -fcyclomatic-complexity 產生的 .cyclo
+ *
+ * 用法:
+ *   build_report [-p 上次快照] [-o 本次快照] 符號檔 [*.su *.cyclo ...]
+ *
+ * 有上次快照時只列出有變化的符號 (依大小變化排序) 與總計差異；
+ * 沒有時列出最大的函式與 stack 用量最多的函式。
+ * 專案的 makefile.targets 以 `make report` 呼叫本工具。
+ *
+ * 限制：
+ *   - 以名稱對應符號，不同檔案裡同名的 static 函式會合併 (大小相加、stack 取最大)
+ *   - LTO 時編譯階段不會產生 .su；連結時加上 -fstack-usage 會輸出
+ *     <elf>.ltrans*.su，是跨檔 inline 之後的實際 stack 用量
+ *
+ * 編譯:
+ *   cc -O2 -o build_report build_report.c
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kMaxSymbols 4096
+#define kMaxName 96
+#define kTopCount 15
+#define kUnknown (-1)
+
+typedef enum
+{
+    KIND_CODE = 'F',   // .text (flash)
+    KIND_CONST = 'R',  // .rodata (flash)
+    KIND_DATA = 'D',   // .data (flash 與 RAM 各一份)
+    KIND_BSS = 'B'     // .bss (RAM)
+} kind_t;
+
+typedef struct
+{
+    char name[kMaxName];
+    char kind;
+    long size;
+    long stack;        // kUnknown: 沒有 .su 資料
+    bool dynamic;      // stack 含 alloca / VLA，數值只是下限
+    long cyclo;
+} symbol_t;
+
+typedef struct
+{
+    symbol_t symbols[kMaxSymbols];
+    int count;
+} snapshot_t;
+
+static snapshot_t g_current;
+static snapshot_t g_previous;
+
+static symbol_t *find(snapshot_t *snap, const char *name, bool create)
+{
+    for (int i = 0; i < snap->count; i++)
+    {
+        if (strcmp(snap->symbols[i].name, name) == 0)
+        {
+            return &snap->symbols[i];
+        }
+    }
+    if (!create || snap->count == kMaxSymbols)
+    {
+        return NULL;
+    }
+
+    symbol_t *sym = &snap->symbols[snap->count++];
+    snprintf(sym->name, sizeof(sym->name), "%s", name);
+    sym->kind = KIND_CODE;
+    sym->size = 0;
+    sym->stack = kUnknown;
+    sym->dynamic = false;
+    sym->cyclo = kUnknown;
+    return sym;
+}
+
+static int nm_kind(char type)
+{
+    switch (type)
+    {
+    case 'T': case 't': case 'W': case 'w':
+        return KIND_CODE;
+    case 'R': case 'r':
+        return KIND_CONST;
+    case 'D': case 'd':
+        return KIND_DATA;
+    case 'B': case 'b':
+        return KIND_BSS;
+    default:
+        return 0;
+    }
+}
+
+// nm -S 的一行： "08000124 00000050 T main"
+static void load_symbols(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+
+    if (file == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned long addr;
+        unsigned long size;
+        char type;
+        char name[kMaxName];
+
+        if (sscanf(line, "%lx %lx %c %95s", &addr, &size, &type, name) != 4)
+        {
+            continue; // 沒有大小的符號 (標籤、連結器符號)
+        }
+        int kind = nm_kind(type);
+        if (kind == 0)
+        {
+            continue;
+        }
+        symbol_t *sym = find(&g_current, name, true);
+        if (sym != NULL)
+        {
+            sym->kind = kind;
+            sym->size += size;
+        }
+    }
+    fclose(file);
+}
+
+// .su： "../Src/main.c:70:5:main\t64\tstatic"
+// .cyclo： "../Src/main.c:70:5:main\t15"
+static void load_metrics(const char *path, bool is_stack)
+{
+    FILE *file = fopen(path, "r");
+    char line[512];
+
+    if (file == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *tab = strchr(line, '\t');
+        if (tab == NULL)
+        {
+            continue;
+        }
+        *tab = '\0';
+
+        char *name = strrchr(line, ':');
+        name = name != NULL ? name + 1 : line;
+        long value = strtol(tab + 1, &tab, 10);
+
+        // 只在連結後仍存在的函式上記錄 (gc-sections 移除的不算)
+        symbol_t *sym = find(&g_current, name, false);
+        if (sym == NULL)
+        {
+            continue;
+        }
+        if (is_stack)
+        {
+            sym->stack = value > sym->stack ? value : sym->stack;
+            sym->dynamic = sym->dynamic || strstr(tab, "dynamic") != NULL;
+        }
+        else
+        {
+            sym->cyclo = value > sym->cyclo ? value : sym->cyclo;
+        }
+    }
+    fclose(file);
+}
+
+static bool ends_with(const char *str, const char *suffix)
+{
+    size_t len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+// 快照格式 (TSV)：kind name size stack cyclo，未知值寫成 -
+static void save_snapshot(const snapshot_t *snap, const char *path)
+{
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    for (int i = 0; i < snap->count; i++)
+    {
+        const symbol_t *sym = &snap->symbols[i];
+        fprintf(file, "%c\t%s\t%ld\t", sym->kind, sym->name, sym->size);
+        if (sym->stack == kUnknown)
+        {
+            fprintf(file, "-\t");
+        }
+        else
+        {
+            fprintf(file, "%ld%s\t", sym->stack, sym->dynamic ? "+" : "");
+        }
+        if (sym->cyclo == kUnknown)
+        {
+            fprintf(file, "-\n");
+        }
+        else
+        {
+            fprintf(file, "%ld\n", sym->cyclo);
+        }
+    }
+    fclose(file);
+}
+
+static bool load_snapshot(snapshot_t *snap, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+
+    if (file == NULL)
+    {
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char kind;
+        char name[kMaxName];
+        long size;
+        char stack[16];
+        char cyclo[16];
+
+        if (sscanf(line, "%c %95s %ld %15s %15s", &kind, name, &size, stack,
+                cyclo) != 5)
+        {
+            continue;
+        }
+        symbol_t *sym = find(snap, name, true);
+        if (sym != NULL)
+        {
+            sym->kind = kind;
+            sym->size = size;
+            sym->stack = stack[0] == '-' ? kUnknown : strtol(stack, NULL, 10);
+            sym->dynamic = strchr(stack, '+') != NULL;
+            sym->cyclo = cyclo[0] == '-' ? kUnknown : strtol(cyclo, NULL, 10);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+typedef struct
+{
+    long flash;
+    long ram;
+    long code;
+    long max_stack;
+    const char *max_stack_name;
+} totals_t;
+
+static totals_t sum(const snapshot_t *snap)
+{
+    totals_t totals = { 0 };
+
+    for (int i = 0; i < snap->count; i++)
+    {
+        const symbol_t *sym = &snap->symbols[i];
+        switch (sym->kind)
+        {
+        case KIND_CODE:
+            totals.code += sym->size;
+            totals.flash += sym->size;
+            break;
+        case KIND_CONST:
+            totals.flash += sym->size;
+            break;
+        case KIND_DATA:
+            totals.flash += sym->size;
+            totals.ram += sym->size;
+            break;
+        case KIND_BSS:
+            totals.ram += sym->size;
+            break;
+        }
+        if (sym->stack > totals.max_stack)
+        {
+            totals.max_stack = sym->stack;
+            totals.max_stack_name = sym->name;
+        }
+    }
+    return totals;
+}
+
+static void print_delta(const char *label, long now, long before, bool has_before)
+{
+    printf("  %-10s %7ld", label, now);
+    if (has_before && now != before)
+    {
+        printf(" (%+ld)", now - before);
+    }
+    printf("\n");
+}
+
+static void print_totals(const snapshot_t *snap, const snapshot_t *prev)
+{
+    totals_t now = sum(snap);
+    totals_t before = prev != NULL ? sum(prev) : now;
+    bool has_before = prev != NULL;
+
+    printf("totals (bytes, symbols only):\n");
+    print_delta("flash", now.flash, before.flash, has_before);
+    print_delta("  code", now.code, before.code, has_before);
+    print_delta("ram", now.ram, before.ram, has_before);
+    print_delta("max frame", now.max_stack, before.max_stack, has_before);
+    if (now.max_stack_name != NULL)
+    {
+        printf("  (largest frame: %s)\n", now.max_stack_name);
+    }
+}
+
+static void format_metric(char *buffer, size_t size, long value, bool dynamic)
+{
+    if (value == kUnknown)
+    {
+        snprintf(buffer, size, "-");
+    }
+    else
+    {
+        snprintf(buffer, size, "%ld%s", value, dynamic ? "+" : "");
+    }
+}
+
+typedef struct
+{
+    const symbol_t *now;     // NULL: 已移除
+    const symbol_t *before;  // NULL: 新增
+    long size_delta;
+} change_t;
+
+static long magnitude(long value)
+{
+    return value < 0 ? -value : value;
+}
+
+static int by_size_delta(const void *a, const void *b)
+{
+    const change_t *lhs = a;
+    const change_t *rhs = b;
+    long diff = magnitude(rhs->size_delta) - magnitude(lhs->size_delta);
+
+    return diff > 0 ? 1 : diff < 0 ? -1 : 0;
+}
+
+static void print_change(const change_t *change)
+{
+    const symbol_t *sym = change->now != NULL ? change->now : change->before;
+    char stack_before[24] = "-";
+    char stack_now[24] = "-";
+    char cyclo_before[24] = "-";
+    char cyclo_now[24] = "-";
+
+    if (change->before != NULL)
+    {
+        format_metric(stack_before, sizeof(stack_before), change->before->stack,
+                change->before->dynamic);
+        format_metric(cyclo_before, sizeof(cyclo_before), change->before->cyclo,
+                false);
+    }
+    if (change->now != NULL)
+    {
+        format_metric(stack_now, sizeof(stack_now), change->now->stack,
+                change->now->dynamic);
+        format_metric(cyclo_now, sizeof(cyclo_now), change->now->cyclo, false);
+    }
+
+    const char *status = change->before == NULL ? "new"
+            : change->now == NULL ? "removed" : "";
+    printf("  %c %-32s %+6ld   stack %5s -> %-5s  cyclo %3s -> %-3s %s\n",
+            sym->kind, sym->name, change->size_delta, stack_before, stack_now,
+            cyclo_before, cyclo_now, status);
+}
+
+static void print_changes(const snapshot_t *snap, const snapshot_t *prev)
+{
+    static change_t changes[2 * kMaxSymbols];
+    int count = 0;
+
+    for (int i = 0; i < snap->count; i++)
+    {
+        const symbol_t *now = &snap->symbols[i];
+        const symbol_t *before = find((snapshot_t *) prev, now->name, false);
+
+        if (before == NULL || before->size != now->size
+                || before->stack != now->stack || before->cyclo != now->cyclo)
+        {
+            changes[count].now = now;
+            changes[count].before = before;
+            changes[count].size_delta = now->size - (before ? before->size : 0);
+            count++;
+        }
+    }
+    for (int i = 0; i < prev->count; i++)
+    {
+        const symbol_t *before = &prev->symbols[i];
+        if (find((snapshot_t *) snap, before->name, false) == NULL)
+        {
+            changes[count].now = NULL;
+            changes[count].before = before;
+            changes[count].size_delta = -before->size;
+            count++;
+        }
+    }
+
+    qsort(changes, count, sizeof(changes[0]), by_size_delta);
+    printf("\n%d changed symbols (size delta, stack, cyclomatic):\n", count);
+    for (int i = 0; i < count; i++)
+    {
+        print_change(&changes[i]);
+    }
+}
+
+static int by_size(const void *a, const void *b)
+{
+    const symbol_t *lhs = *(const symbol_t *const *) a;
+    const symbol_t *rhs = *(const symbol_t *const *) b;
+
+    return (rhs->size > lhs->size) - (rhs->size < lhs->size);
+}
+
+static int by_stack(const void *a, const void *b)
+{
+    const symbol_t *lhs = *(const symbol_t *const *) a;
+    const symbol_t *rhs = *(const symbol_t *const *) b;
+
+    return (rhs->stack > lhs->stack) - (rhs->stack < lhs->stack);
+}
+
+static void print_top(const snapshot_t *snap)
+{
+    static const symbol_t *sorted[kMaxSymbols];
+    int count = 0;
+
+    for (int i = 0; i < snap->count; i++)
+    {
+        if (snap->symbols[i].kind == KIND_CODE)
+        {
+            sorted[count++] = &snap->symbols[i];
+        }
+    }
+
+    qsort(sorted, count, sizeof(sorted[0]), by_size);
+    printf("\nlargest functions:\n");
+    for (int i = 0; i < count && i < kTopCount; i++)
+    {
+        printf("  %-32s %6ld\n", sorted[i]->name, sorted[i]->size);
+    }
+
+    qsort(sorted, count, sizeof(sorted[0]), by_stack);
+    printf("\nlargest stack frames:\n");
+    for (int i = 0; i < count && i < kTopCount && sorted[i]->stack > 0; i++)
+    {
+        char stack[24];
+        char cyclo[24];
+        format_metric(stack, sizeof(stack), sorted[i]->stack, sorted[i]->dynamic);
+        format_metric(cyclo, sizeof(cyclo), sorted[i]->cyclo, false);
+        printf("  %-32s %7s  cyclo %s\n", sorted[i]->name, stack, cyclo);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *previous_path = NULL;
+    const char *output_path = NULL;
+    int arg = 1;
+
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+    {
+        if (strcmp(argv[arg], "-p") == 0)
+        {
+            previous_path = argv[arg + 1];
+        }
+        else if (strcmp(argv[arg], "-o") == 0)
+        {
+            output_path = argv[arg + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (arg >= argc)
+    {
+        fprintf(stderr, "usage: %s [-p previous.tsv] [-o snapshot.tsv] "
+                "symbols.txt [*.su *.cyclo ...]\n", argv[0]);
+        return 2;
+    }
+
+    load_symbols(argv[arg++]);
+    for (; arg < argc; arg++)
+    {
+        if (ends_with(argv[arg], ".su"))
+        {
+            load_metrics(argv[arg], true);
+        }
+        else if (ends_with(argv[arg], ".cyclo"))
+        {
+            load_metrics(argv[arg], false);
+        }
+        else
+        {
+            fprintf(stderr, "%s: unknown input (expected .su or .cyclo)\n",
+                    argv[arg]);
+            return 2;
+        }
+    }
+
+    bool has_previous = previous_path != NULL
+            && load_snapshot(&g_previous, previous_path);
+    print_totals(&g_current, has_previous ? &g_previous : NULL);
+    if (has_previous)
+    {
+        print_changes(&g_current, &g_previous);
+    }
+    else
+    {
+        print_top(&g_current);
+    }
+
+    if (output_path != NULL)
+    {
+        save_snapshot(&g_current, output_path);
+    }
+    return 0;
+}
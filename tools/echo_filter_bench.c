@@ -0,0 +1,264 @@
+/*
+ * Echo 距離換算 / 濾波的基準測試 (Linux x86-64)
+ *
+ * 比較原本的浮點路徑 (每筆 width * 343.0 / 2.0 / 1000000.0，單筆 < 1 m
+ * 就算有車) 與 presence.c 的整數路徑 (溫度補償換算 mm、中位數、遲滯)：
+ *
+ * 1. 換算精度：整數 mm 與 double 精確值在 -40 ~ 85 °C、0 ~ 38 ms 的最大誤差
+ * 2. 判斷品質：模擬的回波串流 (雜訊、漏波、鬼影) 中，兩種做法的
+ *    誤判到達 (沒有車卻判定有車) 與漏掉的車數
+ * 3. 每筆耗時：ns 與 TSC cycle，只代表主機
+ *
+ * 第 3 項不能拿來比較兩種做法在韌體上的成本：主機有硬體 FPU，浮點路徑
+ * 在這裡只要幾個 cycle；Cortex-M3 以 -mfloat-abi=soft 編譯時每個 double
+ * 乘除都是數百 cycle 的 libgcc 呼叫。韌體上的實際 cycle 數要在板子上以
+ * DWT CYCCNT 量測，輸出也如此標示。
+ *
+ * 用法:
+ *   echo_filter_bench [樣本數]      預設 1000000
+ *
+ * 編譯:
+ *   cc -O2 -I../projects/common/Inc -I../projects/5/Inc -o echo_filter_bench echo_filter_bench.c \
+ *      ../projects/5/Src/presence.c -lm
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "presence.h"
+
+#define kNoEchoUs 38000
+#define kCarMinUs 1750     // 約 0.3 m
+#define kCarMaxUs 5250     // 約 0.9 m
+#define kBackgroundUs 17500 // 約 3 m
+#define kDropoutPercent 2
+#define kGhostPercent 1
+#define kNoiseUs 60        // 約 1 cm
+
+typedef struct
+{
+    uint32_t width_us;
+    bool car;             // 這筆量測時感測器前真的有車
+} reading_t;
+
+static uint64_t g_rng = 0x2545F4914F6CDD1DULL;
+
+static uint32_t rng_next(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t) (g_rng >> 32);
+}
+
+static uint32_t rng_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rng_next() % (hi - lo + 1);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 車子停留 10 ~ 40 筆量測，中間淨空 20 ~ 200 筆
+static uint32_t make_stream(reading_t *stream, uint32_t count)
+{
+    uint32_t cars = 0;
+    uint32_t i = 0;
+
+    while (i < count)
+    {
+        uint32_t gap = rng_range(20, 200);
+        uint32_t stay = rng_range(10, 40);
+        uint32_t car_us = rng_range(kCarMinUs, kCarMaxUs);
+
+        for (uint32_t n = 0; n < gap + stay && i < count; n++, i++)
+        {
+            bool car = n >= gap;
+            uint32_t width = car ? car_us : kBackgroundUs;
+
+            width += rng_range(0, 2 * kNoiseUs) - kNoiseUs;
+            if (rng_next() % 100 < kDropoutPercent)
+            {
+                width = kNoEchoUs;
+            }
+            else if (rng_next() % 100 < kGhostPercent)
+            {
+                width = rng_range(600, 23000);
+            }
+            stream[i].width_us = width;
+            stream[i].car = car;
+            cars += car && n == gap;
+        }
+    }
+    return cars;
+}
+
+// 原本 main.c 的寫法
+__attribute__((noinline)) static bool float_is_car(uint32_t width_us)
+{
+    float distance_m = (width_us * 343.0 / 2.0) / 1000000.0;
+
+    return distance_m < 1.0;
+}
+
+__attribute__((noinline)) static presence_event_t int_update(presence_t *presence,
+        uint32_t width_us)
+{
+    return presence_update(presence, units_echo_to_mm(width_us,
+            kDefaultTemperature));
+}
+
+static void check_conversion(void)
+{
+    double worst = 0;
+    int worst_t = 0;
+    uint32_t worst_w = 0;
+
+    for (int t = kMinTemperature; t <= kMaxTemperature; t++)
+    {
+        for (uint32_t w = 0; w <= kNoEchoUs; w++)
+        {
+            double exact = w * (331.3 + 0.606 * t) / 2.0 / 1000.0;
+            double error = fabs(units_echo_to_mm(w, t) - exact);
+            if (error > worst)
+            {
+                worst = error;
+                worst_t = t;
+                worst_w = w;
+            }
+        }
+    }
+    printf("conversion: max error %.2f mm (%d C, %u us)\n", worst, worst_t,
+            worst_w);
+}
+
+typedef struct
+{
+    uint32_t arrivals;
+    uint32_t false_arrivals; // 沒有車，或同一台車再算一次
+    bool counted;            // 目前這台車已被計數
+} tally_t;
+
+// real：到達時感測器前確實有車 (含濾波延遲的那幾筆)
+static void tally(tally_t *t, bool real)
+{
+    t->arrivals++;
+    if (!real || t->counted)
+    {
+        t->false_arrivals++;
+    }
+    t->counted = t->counted || real;
+}
+
+static void print_tally(const char *name, const tally_t *t, uint32_t cars)
+{
+    uint32_t correct = t->arrivals - t->false_arrivals;
+
+    printf("  %-22s %7u arrivals, %6u false, %6u missed\n", name, t->arrivals,
+            t->false_arrivals, cars - correct);
+}
+
+static void check_detection(const reading_t *stream, uint32_t count, uint32_t cars)
+{
+    presence_t presence;
+    tally_t by_float = { 0 };
+    tally_t by_int = { 0 };
+    bool float_last = false;
+
+    presence_init(&presence);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // 中位數最多落後 kPresenceWindow / 2 筆
+        bool recent_car = stream[i].car;
+        for (uint32_t lag = 1; lag <= kPresenceWindow / 2 && lag <= i; lag++)
+        {
+            recent_car = recent_car || stream[i - lag].car;
+        }
+        if (i > 0 && stream[i].car && !stream[i - 1].car)
+        {
+            by_float.counted = false;
+            by_int.counted = false;
+        }
+
+        // 浮點路徑：每個「從沒車變有車」的讀值都算一次到達
+        bool is_car = float_is_car(stream[i].width_us);
+        if (is_car && !float_last)
+        {
+            tally(&by_float, stream[i].car);
+        }
+        float_last = is_car;
+
+        if (int_update(&presence, stream[i].width_us) == PRESENCE_ARRIVED)
+        {
+            tally(&by_int, recent_car);
+        }
+    }
+    printf("detection: %u cars in %u readings\n", cars, count);
+    print_tally("float single reading:", &by_float, cars);
+    print_tally("int median/hysteresis:", &by_int, cars);
+}
+
+static void benchmark(const reading_t *stream, uint32_t count)
+{
+    presence_t presence;
+    volatile uint32_t sink = 0;
+    uint64_t t0, c0;
+
+    t0 = now_ns();
+    c0 = __rdtsc();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sink += float_is_car(stream[i].width_us);
+    }
+    double float_cycles = (double) (__rdtsc() - c0) / count;
+    double float_ns = (double) (now_ns() - t0) / count;
+
+    presence_init(&presence);
+    t0 = now_ns();
+    c0 = __rdtsc();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sink += int_update(&presence, stream[i].width_us);
+    }
+    double int_cycles = (double) (__rdtsc() - c0) / count;
+    double int_ns = (double) (now_ns() - t0) / count;
+
+    printf("cost per reading (HOST ONLY: x86-64 with hardware FPU, not "
+            "representative of Cortex-M3 soft-float):\n");
+    printf("  float single reading:  %6.2f ns  %6.1f TSC cycles\n", float_ns,
+            float_cycles);
+    printf("  int median/hysteresis: %6.2f ns  %6.1f TSC cycles\n", int_ns,
+            int_cycles);
+    printf("  (on the target every double multiply/divide of the float path is "
+            "a libgcc call; measure with DWT CYCCNT)\n");
+    (void) sink;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+    reading_t *stream = malloc(count * sizeof(*stream));
+
+    if (count == 0 || stream == NULL)
+    {
+        fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+        return 2;
+    }
+    uint32_t cars = make_stream(stream, count);
+
+    check_conversion();
+    check_detection(stream, count, cars);
+    benchmark(stream, count);
+    free(stream);
+    return 0;
+}
@@ -0,0 +1,344 @@
+/*
+ * fmt 與 sprintf 的基準測試 (Linux x86-64)
+ *
+ * 以韌體實際輸出的格式比較 projects/common/fmt 與原本的 sprintf 寫法：
+ *
+ * 1. 輸出一致：每個樣本兩邊的字串必須完全相同，不同時結束碼為 1
+ * 2. 每次呼叫的耗時：ns 與 TSC cycle
+ * 3. stack 用量：在塗滿固定值的獨立 stack (ucontext) 上執行一次，
+ *    扣除空函式的用量後，最深被寫到的位置
+ * 4. 程式大小：讀取本執行檔的 symbol table，加總 fmt_* 函式的大小
+ *
+ * 數字都來自主機 (glibc、x86-64 -O2)，只能看相對差距。Cortex-M3 上
+ * newlib-nano 的 sprintf 另外需要 -u _printf_float 與 _sbrk，韌體的
+ * 程式大小與 stack 以 report-5 (build_report、stack_depth) 為準。
+ *
+ * 用法:
+ *   fmt_bench [次數]      預設 1000000
+ *
+ * 編譯:
+ *   cc -O2 -I../projects/common/Inc -o fmt_bench fmt_bench.c ../projects/common/Src/fmt.c
+ */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <x86intrin.h>
+
+#include "fmt.h"
+
+#define kBufferSize 64
+#define kStackSize 16384
+#define kStackPaint 0xA5
+
+typedef char *(*format_fn_t)(char *out, int32_t value);
+
+typedef struct
+{
+    const char *name;
+    format_fn_t by_fmt;
+    format_fn_t by_printf;
+    int32_t min;
+    int32_t max;
+} format_case_t;
+
+// --- 韌體的格式 ---
+
+// main.c 的文字遙測 (原本 sprintf(buffer, "Current Cars: %02d\r\n", ...))
+static char *cars_fmt(char *out, int32_t value)
+{
+    out = fmt_str(out, "Current Cars: ");
+    out = fmt_write(out, FMT_DEC(2), value);
+    return fmt_str(out, "\r\n");
+}
+
+static char *cars_printf(char *out, int32_t value)
+{
+    return out + sprintf(out, "Current Cars: %02d\r\n", (int) value);
+}
+
+// 4-ii 的計數 (原本 sprintf(tx_buffer, "%d\r\n", i))
+static char *count_fmt(char *out, int32_t value)
+{
+    return fmt_str(fmt_i32(out, value), "\r\n");
+}
+
+static char *count_printf(char *out, int32_t value)
+{
+    return out + sprintf(out, "%d\r\n", (int) value);
+}
+
+// 定點數：原本只能以 float printf 輸出
+static char *fixed_fmt(char *out, int32_t value)
+{
+    return fmt_write(out, FMT_FIXED(1, 3), value);
+}
+
+static char *fixed_printf(char *out, int32_t value)
+{
+    return out + sprintf(out, "%.3f", value / 1000.0);
+}
+
+static char *hex_fmt(char *out, int32_t value)
+{
+    return fmt_write(out, FMT_HEX(8), value);
+}
+
+static char *hex_printf(char *out, int32_t value)
+{
+    return out + sprintf(out, "%08X", (unsigned) value);
+}
+
+static const format_case_t kCases[] =
+{
+    { "Current Cars: %02d", cars_fmt, cars_printf, 0, 99 },
+    { "%d", count_fmt, count_printf, INT32_MIN, INT32_MAX },
+    { "%.3f (fixed)", fixed_fmt, fixed_printf, -9999999, 9999999 },
+    { "%08X", hex_fmt, hex_printf, INT32_MIN, INT32_MAX },
+};
+
+static uint64_t g_rng = 0x2545F4914F6CDD1DULL;
+
+static uint32_t rng_next(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t) (g_rng >> 32);
+}
+
+static int32_t rng_range(int32_t lo, int32_t hi)
+{
+    uint32_t span = (uint32_t) hi - (uint32_t) lo;
+
+    return (int32_t) ((uint32_t) lo + (span == UINT32_MAX ? rng_next()
+            : rng_next() % (span + 1)));
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 兩邊的輸出必須相同 (含範圍兩端)
+static uint32_t check_output(const format_case_t *c, const int32_t *values,
+        uint32_t count)
+{
+    char a[kBufferSize];
+    char b[kBufferSize];
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < count + 2; i++)
+    {
+        int32_t value = i == count ? c->min : i == count + 1 ? c->max : values[i];
+        *c->by_fmt(a, value) = '\0';
+        *c->by_printf(b, value) = '\0';
+        if (strcmp(a, b) != 0 && mismatches++ < 5)
+        {
+            printf("  mismatch for %d: fmt \"%s\", printf \"%s\"\n", value, a, b);
+        }
+    }
+    return mismatches;
+}
+
+typedef struct
+{
+    double ns;
+    double cycles;
+} cost_t;
+
+static cost_t measure(format_fn_t fn, const int32_t *values, uint32_t count)
+{
+    char buffer[kBufferSize];
+    volatile char sink = 0;
+    uint64_t t0 = now_ns();
+    uint64_t c0 = __rdtsc();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sink ^= *fn(buffer, values[i]);
+    }
+    cost_t cost = { (double) (now_ns() - t0) / count,
+            (double) (__rdtsc() - c0) / count };
+    (void) sink;
+    return cost;
+}
+
+// --- stack 用量 ---
+
+static ucontext_t g_main_context;
+static ucontext_t g_probe_context;
+static format_fn_t g_probe_fn;
+static int32_t g_probe_value;
+static uint8_t g_stack[kStackSize] __attribute__((aligned(16)));
+
+static char *probe_nothing(char *out, int32_t value)
+{
+    (void) value;
+    return out;
+}
+
+static void probe_entry(void)
+{
+    char buffer[kBufferSize];
+
+    if (g_probe_fn != NULL)
+    {
+        g_probe_fn(buffer, g_probe_value);
+    }
+}
+
+static size_t stack_bytes(format_fn_t fn, int32_t value)
+{
+    size_t untouched = 0;
+
+    memset(g_stack, kStackPaint, sizeof(g_stack));
+    getcontext(&g_probe_context);
+    g_probe_context.uc_stack.ss_sp = g_stack;
+    g_probe_context.uc_stack.ss_size = sizeof(g_stack);
+    g_probe_context.uc_link = &g_main_context;
+    makecontext(&g_probe_context, probe_entry, 0);
+    g_probe_fn = fn;
+    g_probe_value = value;
+    swapcontext(&g_main_context, &g_probe_context);
+
+    while (untouched < sizeof(g_stack) && g_stack[untouched] == kStackPaint)
+    {
+        untouched++;
+    }
+    return sizeof(g_stack) - untouched;
+}
+
+// 範圍內最長的輸出 (最多位數) 通常用到最深的 stack
+static size_t stack_worst(format_fn_t fn, const format_case_t *c)
+{
+    size_t base = stack_bytes(probe_nothing, 0);
+    size_t worst = 0;
+    const int32_t probes[] = { c->min, c->max, 0, -1 };
+
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++)
+    {
+        if (probes[i] < c->min || probes[i] > c->max)
+        {
+            continue;
+        }
+        size_t used = stack_bytes(fn, probes[i]);
+        if (used > worst)
+        {
+            worst = used;
+        }
+    }
+    return worst > base ? worst - base : 0;
+}
+
+// --- 程式大小 ---
+
+// 讀取 /proc/self/exe 的 .symtab，加總名稱以 prefix 開頭的函式 (已 strip 時回傳 0)
+static size_t code_bytes(const char *prefix)
+{
+    FILE *file = fopen("/proc/self/exe", "rb");
+    Elf64_Ehdr header;
+    size_t total = 0;
+
+    if (file == NULL)
+    {
+        return 0;
+    }
+    if (fread(&header, sizeof(header), 1, file) == 1
+            && memcmp(header.e_ident, ELFMAG, SELFMAG) == 0
+            && header.e_ident[EI_CLASS] == ELFCLASS64)
+    {
+        Elf64_Shdr *sections = calloc(header.e_shnum, sizeof(Elf64_Shdr));
+
+        fseek(file, (long) header.e_shoff, SEEK_SET);
+        if (sections != NULL && fread(sections, sizeof(Elf64_Shdr),
+                header.e_shnum, file) == header.e_shnum)
+        {
+            for (uint16_t i = 0; i < header.e_shnum; i++)
+            {
+                if (sections[i].sh_type != SHT_SYMTAB)
+                {
+                    continue;
+                }
+                Elf64_Shdr *strtab = &sections[sections[i].sh_link];
+                char *names = malloc(strtab->sh_size);
+                Elf64_Sym symbol;
+
+                fseek(file, (long) strtab->sh_offset, SEEK_SET);
+                if (names == NULL || fread(names, 1, strtab->sh_size, file)
+                        != strtab->sh_size)
+                {
+                    free(names);
+                    continue;
+                }
+                for (uint64_t off = 0; off + sizeof(symbol) <= sections[i].sh_size;
+                        off += sizeof(symbol))
+                {
+                    fseek(file, (long) (sections[i].sh_offset + off), SEEK_SET);
+                    if (fread(&symbol, sizeof(symbol), 1, file) == 1
+                            && ELF64_ST_TYPE(symbol.st_info) == STT_FUNC
+                            && symbol.st_name < strtab->sh_size
+                            && strncmp(names + symbol.st_name, prefix,
+                                    strlen(prefix)) == 0)
+                    {
+                        total += symbol.st_size;
+                    }
+                }
+                free(names);
+            }
+        }
+        free(sections);
+    }
+    fclose(file);
+    return total;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+    int32_t *values = malloc(count * sizeof(*values));
+    uint32_t mismatches = 0;
+
+    if (count == 0 || values == NULL)
+    {
+        fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+        return 2;
+    }
+
+    printf("per call (host: glibc sprintf, x86-64 -O2, %u samples):\n", count);
+    printf("  %-20s %9s %10s %9s %10s %8s %10s\n", "format", "fmt ns", "printf ns",
+            "fmt cyc", "printf cyc", "fmt stk", "printf stk");
+    for (size_t i = 0; i < sizeof(kCases) / sizeof(kCases[0]); i++)
+    {
+        const format_case_t *c = &kCases[i];
+
+        for (uint32_t n = 0; n < count; n++)
+        {
+            values[n] = rng_range(c->min, c->max);
+        }
+        mismatches += check_output(c, values, count);
+
+        cost_t by_fmt = measure(c->by_fmt, values, count);
+        cost_t by_printf = measure(c->by_printf, values, count);
+        printf("  %-20s %9.1f %10.1f %9.1f %10.1f %8zu %10zu\n", c->name,
+                by_fmt.ns, by_printf.ns, by_fmt.cycles, by_printf.cycles,
+                stack_worst(c->by_fmt, c), stack_worst(c->by_printf, c));
+    }
+
+    size_t size = code_bytes("fmt_");
+    if (size != 0)
+    {
+        printf("code: fmt_* %zu bytes (host); sprintf is in the shared libc\n",
+                size);
+    }
+    printf("output: %s\n", mismatches == 0 ? "identical" : "MISMATCH");
+    free(values);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#ifndef SIM_CORE_CM3_H
+#define SIM_CORE_CM3_H
+
+/*
+ * 模擬器用的 core_cm3.h
+ *
+ * 沿用 CMSIS 原本的暫存器定義，但把以 ARM 組語實作的 intrinsic 改名
+ * 藏起來 (未使用的 static inline 不會被產生)，改由模擬器 (sim_core.c)
+ * 提供同名函式。
+ */
+
+#define __enable_irq cmsis_asm_enable_irq
+#define __disable_irq cmsis_asm_disable_irq
+#define __enable_fault_irq cmsis_asm_enable_fault_irq
+#define __disable_fault_irq cmsis_asm_disable_fault_irq
+#define __NOP cmsis_asm_NOP
+#define __WFI cmsis_asm_WFI
+#define __WFE cmsis_asm_WFE
+#define __SEV cmsis_asm_SEV
+#define __ISB cmsis_asm_ISB
+#define __DSB cmsis_asm_DSB
+#define __DMB cmsis_asm_DMB
+#define __CLREX cmsis_asm_CLREX
+#define NVIC_SystemReset cmsis_asm_NVIC_SystemReset
+
+#include_next "core_cm3.h"
+
+#undef __enable_irq
+#undef __disable_irq
+#undef __enable_fault_irq
+#undef __disable_fault_irq
+#undef __NOP
+#undef __WFI
+#undef __WFE
+#undef __SEV
+#undef __ISB
+#undef __DSB
+#undef __DMB
+#undef __CLREX
+#undef NVIC_SystemReset
+
+void __enable_irq(void);
+void __disable_irq(void);
+void __enable_fault_irq(void);
+void __disable_fault_irq(void);
+void __WFI(void);
+void __WFE(void);
+void __SEV(void);
+void NVIC_SystemReset(void);
+
+// 主機上的記憶體屏障只需阻止編譯器重排
+#define __NOP() __asm volatile ("nop")
+#define __ISB() __asm volatile ("" ::: "memory")
+#define __DSB() __asm volatile ("" ::: "memory")
+#define __DMB() __asm volatile ("" ::: "memory")
+#define __CLREX() ((void) 0)
+
+#endif /* SIM_CORE_CM3_H */
@@ -0,0 +1,205 @@
+#ifndef SIM_H
+#define SIM_H
+
+/*
+ * STM32F103 暫存器層級的主機端模擬器 (Linux x86-64)
+ *
+ * 韌體原始碼不需修改，直接以主機編譯器編譯後與模擬器連結成一般的
+ * Linux 程式：
+ *
+ * - 周邊位址 (0x40000000、0xE0000000) 以 mmap 固定映射到相同位址，
+ *   平時設為不可存取。韌體每次存取暫存器都會觸發 SIGSEGV，模擬器先把
+ *   虛擬時間推進到當下、更新該暫存器內容，再以單步 (TF) 執行該指令，
+ *   於 SIGTRAP 時套用寫入 / 讀取的副作用 (rc_w0、w1c、read-to-clear、
+ *   BSRR、CRC DR 等)。模型自己透過另一個可寫的別名映射操作暫存器。
+ * - __disable_irq / __WFI 等 CMSIS intrinsic 由模擬器實作 (include/core_cm3.h)，
+ *   中斷在存取暫存器後、週期性的 SIGALRM tick、開啟中斷及 WFI 時派送，
+ *   ISR 之間不會互相搶占。
+ * - 虛擬時間在韌體忙碌時跟著實際時間 (乘上 -s 倍率) 前進，模擬器處理
+ *   trap 的時間不計入，改為每次周邊存取固定計 4 個 HCLK 週期；
+ *   WFI 時直接跳到下一個會產生中斷的時間點，因此閒置的時間不需等待。
+ *
+ * 模型：RCC (時脈樹、ready 旗標)、GPIO/AFIO/EXTI、TIM1-4 (計數、
+ * 輸出比較、輸入捕捉、主從串接、one-pulse、DMA request)、DMA1、
+ * USART1 (依 BRR 的字元時間、IDLE、ORE)、SysTick、NVIC、DWT CYCCNT、CRC、
+ * FLASH (解鎖、half-word 程式化、頁清除、斷電；主記憶體只存放資料)、
+ * BKP / RTC (LSE 計數、DBP 寫入保護、VBAT 保留)。
+ * 未建模的周邊 (ADC、SPI、I2C...) 行為與一般記憶體相同，
+ * 周邊的時脈開關 (RCC_xxxENR) 不影響模型。
+ *
+ * 用法:
+ *   sim_5 [-s 倍率] [-t tick_us] [-o 輸出檔] [-b 開機次數] [情境檔]
+ *
+ *   USART1 送出的位元組寫到 stdout (或 -o 指定的檔案)，可直接接到
+ *   telemetry_decode；追蹤訊息與結束時的統計寫到 stderr。
+ *   情境檔格式見 sim_scenario.c，範例在 scenarios/。情境檔以 reboot
+ *   分成數次開機，模擬器每次開機重新執行自己並帶上 -b；-b n 也可直接
+ *   從第 n 次開機開始。expect 不符時結束碼為 1。
+ *
+ * 編譯 (以專案 5 為例，於 tools/ 下執行):
+ *   P=../projects/5
+ *   cc -O2 -g -no-pie -std=gnu11 -DSTM32F10X_MD -DUSE_STDPERIPH_DRIVER \
+ *      -Dmain=firmware_main \
+ *      -Isim/include -I$P/Inc -I../projects/common/Inc \
+ *      -I$P/Libraries/CMSIS/CM3/DeviceSupport/ST/STM32F10x \
+ *      -I$P/Libraries/CMSIS/CM3/CoreSupport \
+ *      -I$P/Libraries/STM32F10x_StdPeriph_Driver/inc \
+ *      -o sim_5 $(find sim $P/Src ../projects/common/Src -name '*.c' \
+ *                 ! -name syscalls.c ! -name sysmem.c) \
+ *      $P/Libraries/CMSIS/CM3/DeviceSupport/ST/STM32F10x/system_stm32f10x.c \
+ *      $P/Libraries/STM32F10x_StdPeriph_Driver/src/stm32f10x_bkp.c \
+ *      $P/Libraries/STM32F10x_StdPeriph_Driver/src/stm32f10x_crc.c \
+ *      $P/Libraries/STM32F10x_StdPeriph_Driver/src/stm32f10x_flash.c \
+ *      $P/Libraries/STM32F10x_StdPeriph_Driver/src/stm32f10x_rcc.c \
+ *      $P/Libraries/STM32F10x_StdPeriph_Driver/src/stm32f10x_rtc.c
+ *
+ * 或使用根目錄的 CMake：cmake -S . -B build && cmake --build build --target sim_5
+ *
+ * 必須以 -no-pie 連結：韌體以 32-bit 位址設定 DMA (CMAR)，
+ * 靜態變數必須位於 4 GB 以下。以 perf 分析時韌體函式名稱照常顯示；
+ * 以 gdb 除錯時需先 "handle SIGSEGV SIGTRAP nostop noprint pass"。
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stm32f10x.h"
+
+#define kSimNever UINT64_MAX
+#define kSimIrqCount 43          // STM32F10x medium density 的外部中斷數
+#define kSimIrqSysTick 63        // 在中斷遮罩中代表 SysTick 的 bit
+
+#define SIM_NS_PER_US 1000ULL
+#define SIM_NS_PER_MS 1000000ULL
+#define SIM_NS_PER_S 1000000000ULL
+
+// 取得周邊暫存器的別名 (模型專用，存取不會觸發 trap)
+#define SIM_REG(type, base) ((type *) sim_alias(base))
+
+// --- 追蹤訊息開關 (情境檔的 trace 指令) ---
+#define SIM_TRACE_IRQ (1U << 0)
+#define SIM_TRACE_PWM (1U << 1)
+#define SIM_TRACE_USART (1U << 2)
+#define SIM_TRACE_SENSOR (1U << 3)
+#define SIM_TRACE_GPIO(port) (1U << (8 + (port))) // 0 = GPIOA
+
+// 一段連續的暫存器區塊與其存取副作用，offset 以區塊開頭計算
+typedef struct
+{
+    const char *name;
+    uint32_t base;
+    uint32_t size;
+    uint8_t unit; // 同型周邊的編號 (例如 GPIOA = 0、GPIOB = 1)
+    void (*read)(uint8_t unit, uint32_t offset);       // CPU 讀取前更新內容
+    void (*after_read)(uint8_t unit, uint32_t offset); // 讀取的副作用
+    void (*write)(uint8_t unit, uint32_t offset, uint32_t old, uint32_t value);
+} sim_block_t;
+
+// 一種周邊的模型
+typedef struct
+{
+    const char *name;
+    const sim_block_t *blocks;
+    uint8_t block_count;
+    void (*reset)(void);
+    void (*advance)(uint64_t now_ns);         // 推進到 now_ns
+    uint64_t (*next_event)(uint64_t now_ns);  // 下一個會拉起中斷的時間點
+    uint64_t (*irq_levels)(void);             // 目前拉高的中斷 (bit = IRQn)
+    void (*dma_poll)(void);                   // DMA 通道開啟時重新送出 request
+} sim_device_t;
+
+extern const sim_device_t sim_rcc_device;
+extern const sim_device_t sim_scs_device;
+extern const sim_device_t sim_crc_device;
+extern const sim_device_t sim_gpio_device;
+extern const sim_device_t sim_timer_device;
+extern const sim_device_t sim_dma_device;
+extern const sim_device_t sim_usart_device;
+extern const sim_device_t sim_flash_device;
+extern const sim_device_t sim_backup_device;
+
+extern uint32_t g_sim_trace;
+
+// --- sim_core.c ---
+void *sim_alias(uint32_t addr);
+uint64_t sim_now(void);
+void sim_schedule(uint64_t time_ns, void (*fn)(uintptr_t arg), uintptr_t arg);
+void sim_set_end(uint64_t time_ns);
+void sim_set_reboot(void);
+uint32_t sim_bus_read(uint32_t addr, uint8_t size);
+void sim_bus_write(uint32_t addr, uint8_t size, uint32_t value);
+void sim_irq_pend(uint8_t irq);
+uint8_t sim_irq_priority(uint8_t irq);
+void sim_dma_poll_all(void);
+void sim_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void sim_fatal(const char *format, ...)
+        __attribute__((format(printf, 1, 2), noreturn));
+void sim_finish(const char *reason) __attribute__((noreturn));
+
+// dt_ns 內經過的時脈數，未滿一個時脈的部分累積在 remainder
+static inline uint64_t sim_clocks(uint64_t *remainder, uint64_t dt_ns,
+        uint32_t hz)
+{
+    uint64_t total = dt_ns * hz + *remainder;
+
+    *remainder = total % SIM_NS_PER_S;
+    return total / SIM_NS_PER_S;
+}
+
+// clocks 個時脈所需的時間 (無條件進位)
+static inline uint64_t sim_clocks_to_ns(uint64_t clocks, uint32_t hz)
+{
+    return hz == 0 ? kSimNever : (clocks * SIM_NS_PER_S + hz - 1) / hz;
+}
+
+// --- sim_system.c ---
+uint32_t sim_rcc_sysclk(void);
+uint32_t sim_rcc_hclk(void);
+uint32_t sim_rcc_pclk(uint8_t apb);
+uint32_t sim_rcc_timclk(uint8_t apb);
+void sim_rcc_set_hse(uint32_t hz);
+void sim_rcc_set_startup(uint32_t hse_us, uint32_t pll_us);
+void sim_rcc_set_lse(bool present, uint32_t startup_us);
+
+// --- sim_backup.c ---
+bool sim_backup_writable(void);
+void sim_backup_set_image(const char *path, bool load);
+void sim_backup_save(void);
+void sim_backup_domain_reset(void);
+
+// --- sim_flash.c ---
+void sim_flash_set_image(const char *path, bool load);
+void sim_flash_set_cut(uint32_t operation);
+void sim_flash_save(void);
+
+// --- sim_gpio.c ---
+typedef void (*sim_pin_watch_t)(uint8_t port, uint8_t pin, bool level,
+        uintptr_t arg);
+
+bool sim_gpio_parse(const char *name, uint8_t *port, uint8_t *pin);
+bool sim_gpio_level(uint8_t port, uint8_t pin);
+void sim_gpio_drive(uint8_t port, uint8_t pin, bool level);
+void sim_gpio_watch(uint8_t port, uint8_t pin, sim_pin_watch_t fn,
+        uintptr_t arg);
+
+// --- sim_dma.c ---
+void sim_dma_request(uint8_t channel);
+
+// --- sim_usart.c ---
+void sim_usart_inject(const uint8_t *data, size_t len);
+void sim_usart_set_output(int fd);
+uint32_t sim_usart_sent(void);
+bool sim_usart_expect(const char *text);
+
+// --- sim_scenario.c ---
+void sim_scenario_load(const char *path, uint16_t boot);
+
+// --- sim_vectors.c ---
+typedef void (*sim_handler_t)(void);
+
+void SysTick_Handler(void);
+extern const sim_handler_t kSimVectors[kSimIrqCount];
+extern const char *const kSimVectorNames[kSimIrqCount];
+
+#endif /* SIM_H */
@@ -0,0 +1,269 @@
+/*
+ * 備份區模型：BKP 資料暫存器、RTC 計數器與 PWR_CR.DBP 寫入保護
+ *
+ * - PWR->CR 的 DBP 為 0 時寫入 BKP、RTC (以及 RCC->BDCR，見 sim_system.c) 無效
+ * - BKP DR1 ~ DR10 各 16 bit (medium density)
+ * - RCC->BDCR.BDRST：RTC、BKP 與 BDCR 回到重置值；RTCSEL 設定後只能這樣清除
+ * - RTC：RCC->BDCR 選擇 LSE (32.768 kHz) 或 LSI (40 kHz) 且 RTCEN 時計數，
+ *   預除器 PRL + 1 個 RTCCLK 加一；PRL、CNT、ALR 只有 CNF 時能寫入。
+ *   RSF 由軟體清除後 2 個 RTCCLK 才設定 (RTC 沒有時脈時不會設定)；
+ *   寫入立即生效，RTOFF 一直是 1。SECF / ALRF / OWF 不產生中斷。
+ *
+ * 情境檔：
+ *   backup image <檔案> [new]
+ *                         有 VBAT 電池：載入上一次結束時的 BDCR、RTC 與 BKP
+ *                         (檔案不存在或加上 new 時為重置值)，結束時寫回；關機期間 RTC
+ *                         不前進。沒有這一行時每次都是上電重置後的狀態。
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define kLseHz 32768
+#define kLsiHz 40000
+#define kRtcCrlFlags 0x0F   // SECF、ALRF、OWF、RSF：寫 0 清除
+#define kBkpDataFirst 0x04  // DR1
+#define kBkpDataLast 0x28   // DR10
+
+// 映像檔：BDCR 與 RTC、BKP 的暫存器內容 (以 word 存放)
+typedef struct
+{
+    uint32_t bdcr;
+    uint32_t rtc[0x28 / 4];
+    uint32_t bkp[0x40 / 4];
+} backup_image_t;
+
+static const char *g_image_path = NULL;
+static uint64_t g_last_ns = 0;
+static uint64_t g_rtc_remainder = 0;
+static uint32_t g_rtc_generation = 0; // 重新清除 RSF 時作廢尚未到期的同步
+
+static RTC_TypeDef *rtc(void)
+{
+    return SIM_REG(RTC_TypeDef, RTC_BASE);
+}
+
+bool sim_backup_writable(void)
+{
+    return (SIM_REG(PWR_TypeDef, PWR_BASE)->CR & PWR_CR_DBP) != 0;
+}
+
+static uint32_t rtc_hz(void)
+{
+    RCC_TypeDef *r = SIM_REG(RCC_TypeDef, RCC_BASE);
+    uint32_t bdcr = r->BDCR;
+
+    if ((bdcr & RCC_BDCR_RTCEN) == 0)
+    {
+        return 0;
+    }
+    switch (bdcr & RCC_BDCR_RTCSEL)
+    {
+    case RCC_BDCR_RTCSEL_LSE:
+        return (bdcr & RCC_BDCR_LSERDY) != 0 ? kLseHz : 0;
+    case RCC_BDCR_RTCSEL_LSI:
+        return (r->CSR & RCC_CSR_LSIRDY) != 0 ? kLsiHz : 0;
+    default: // HSE / 128 未建模
+        return 0;
+    }
+}
+
+static uint32_t rtc_counter(void)
+{
+    return (rtc()->CNTH << 16) | (rtc()->CNTL & 0xFFFF);
+}
+
+static void set_counter(uint32_t value)
+{
+    rtc()->CNTH = value >> 16;
+    rtc()->CNTL = value & 0xFFFF;
+}
+
+// DIV 從 PRL 往下數，數到 0 後重新載入並讓 CNT 加一
+static void rtc_advance(uint64_t now_ns)
+{
+    RTC_TypeDef *t = rtc();
+    uint32_t hz = rtc_hz();
+    uint64_t ticks = sim_clocks(&g_rtc_remainder, now_ns - g_last_ns, hz);
+
+    g_last_ns = now_ns;
+    if (ticks == 0)
+    {
+        return;
+    }
+    uint32_t prl = ((t->PRLH & 0xF) << 16) | (t->PRLL & 0xFFFF);
+    uint32_t div = ((t->DIVH & 0xF) << 16) | (t->DIVL & 0xFFFF);
+    uint64_t elapsed = (prl - (div > prl ? prl : div)) + ticks;
+    uint64_t seconds = elapsed / (prl + 1ULL);
+
+    div = prl - (uint32_t) (elapsed % (prl + 1ULL));
+    t->DIVH = div >> 16;
+    t->DIVL = div & 0xFFFF;
+    if (seconds != 0)
+    {
+        set_counter(rtc_counter() + (uint32_t) seconds);
+        t->CRL |= RTC_CRL_SECF;
+    }
+}
+
+static void rtc_synchronized(uintptr_t generation)
+{
+    if (generation == g_rtc_generation)
+    {
+        rtc()->CRL |= RTC_CRL_RSF;
+    }
+}
+
+static void rtc_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    RTC_TypeDef *t = rtc();
+    volatile uint32_t *reg = sim_alias(RTC_BASE + offset);
+
+    (void) unit;
+    if (!sim_backup_writable())
+    {
+        *reg = old;
+        return;
+    }
+    switch (offset)
+    {
+    case 0x04: // CRL
+        t->CRL = (old & value & kRtcCrlFlags) | (value & RTC_CRL_CNF)
+                | RTC_CRL_RTOFF;
+        if ((value & RTC_CRL_RSF) == 0)
+        {
+            uint32_t hz = rtc_hz();
+            g_rtc_generation++;
+            if (hz != 0)
+            {
+                sim_schedule(sim_now() + sim_clocks_to_ns(2, hz),
+                        rtc_synchronized, g_rtc_generation);
+            }
+        }
+        break;
+    case 0x08: // PRLH
+    case 0x0C: // PRLL
+    case 0x18: // CNTH
+    case 0x1C: // CNTL
+    case 0x20: // ALRH
+    case 0x24: // ALRL
+        if ((t->CRL & RTC_CRL_CNF) == 0)
+        {
+            *reg = old;
+        }
+        else
+        {
+            *reg = value & (offset == 0x08 ? 0xF : 0xFFFF);
+        }
+        break;
+    case 0x10: // DIVH、DIVL：唯讀
+    case 0x14:
+        *reg = old;
+        break;
+    default: // CRH
+        *reg = value & 0x7;
+        break;
+    }
+}
+
+static void bkp_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    volatile uint32_t *reg = sim_alias(BKP_BASE + offset);
+
+    (void) unit;
+    if (!sim_backup_writable())
+    {
+        *reg = old;
+    }
+    else if (offset >= kBkpDataFirst && offset <= kBkpDataLast)
+    {
+        *reg = value & 0xFFFF;
+    }
+}
+
+void sim_backup_set_image(const char *path, bool load)
+{
+    backup_image_t image;
+    FILE *file = load ? fopen(path, "rb") : NULL;
+
+    g_image_path = path;
+    if (file == NULL)
+    {
+        return; // 第一次執行：重置值
+    }
+    if (fread(&image, sizeof(image), 1, file) != 1)
+    {
+        sim_fatal("backup: %s is not a backup image", path);
+    }
+    fclose(file);
+
+    // 重新上電：RSF 要等韌體重新同步
+    SIM_REG(RCC_TypeDef, RCC_BASE)->BDCR = image.bdcr;
+    memcpy(sim_alias(RTC_BASE), image.rtc, sizeof(image.rtc));
+    rtc()->CRL = (image.rtc[1] & ~RTC_CRL_RSF & ~RTC_CRL_CNF) | RTC_CRL_RTOFF;
+    memcpy(sim_alias(BKP_BASE), image.bkp, sizeof(image.bkp));
+    g_last_ns = sim_now();
+}
+
+void sim_backup_save(void)
+{
+    backup_image_t image;
+
+    if (g_image_path == NULL)
+    {
+        return;
+    }
+    rtc_advance(sim_now());
+    image.bdcr = SIM_REG(RCC_TypeDef, RCC_BASE)->BDCR;
+    memcpy(image.rtc, sim_alias(RTC_BASE), sizeof(image.rtc));
+    memcpy(image.bkp, sim_alias(BKP_BASE), sizeof(image.bkp));
+
+    FILE *file = fopen(g_image_path, "wb");
+    if (file == NULL || fwrite(&image, sizeof(image), 1, file) != 1)
+    {
+        sim_log("backup: cannot write %s: %s", g_image_path, strerror(errno));
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    sim_log("backup: RTC %u s, image %s", rtc_counter(), g_image_path);
+}
+
+static void backup_reset(void)
+{
+    RTC_TypeDef *t = rtc();
+
+    memset(sim_alias(RTC_BASE), 0, sizeof(RTC_TypeDef));
+    memset(sim_alias(BKP_BASE), 0, sizeof(BKP_TypeDef));
+    g_rtc_remainder = 0;
+    g_rtc_generation++;
+    t->CRL = RTC_CRL_RTOFF;
+    t->PRLL = 0x8000;
+    t->DIVL = 0x8000;
+    t->ALRH = 0xFFFF;
+    t->ALRL = 0xFFFF;
+}
+
+// RCC->BDCR.BDRST：RTC 與 BKP 回到重置值 (BDCR 本身由 sim_system.c 處理)
+void sim_backup_domain_reset(void)
+{
+    g_last_ns = sim_now();
+    backup_reset();
+}
+
+static const sim_block_t kBackupBlocks[] =
+{
+    { "RTC", RTC_BASE, 0x400, 0, NULL, NULL, rtc_write },
+    { "BKP", BKP_BASE, 0x400, 0, NULL, NULL, bkp_write },
+};
+
+const sim_device_t sim_backup_device =
+{
+    "BKP", kBackupBlocks, 2, backup_reset, rtc_advance, NULL, NULL, NULL
+};
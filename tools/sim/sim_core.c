@@ -0,0 +1,1066 @@
+/*
+ * 模擬器核心：周邊記憶體映射、存取 trap、虛擬時間、事件佇列、中斷派送、
+ * CMSIS intrinsic 與 main()。
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/ucontext.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "the register-level simulator needs Linux on x86-64"
+#endif
+
+// 韌體的 main() 以 -Dmain=firmware_main 改名
+#undef main
+int firmware_main(void);
+
+#define kPageSize 4096
+#define kTrapFlag 0x100             // EFLAGS.TF
+#define kMaxStepNs (100 * SIM_NS_PER_MS) // 單次推進上限 (避免時脈換算溢位)
+#define kQueueSize 1024
+#define kStormLimit 100000          // 單次派送中連續執行 ISR 的上限
+#define kDefaultTickUs 100
+#define kAccessCycles 4             // 每次周邊存取計入的 HCLK 週期 (trap 本身的時間不計)
+
+typedef struct
+{
+    const char *name;
+    uint32_t base;
+    uint32_t size;
+    int prot;        // 韌體視角的保護屬性 (PROT_NONE = 每次存取都 trap)
+    uint8_t *alias;  // 模型使用的可寫別名
+} sim_region_t;
+
+typedef struct
+{
+    uint64_t time_ns;
+    uint32_t seq;
+    void (*fn)(uintptr_t arg);
+    uintptr_t arg;
+} sim_event_t;
+
+typedef struct
+{
+    volatile bool active;
+    bool write;
+    bool alarm_blocked;
+    uintptr_t page;
+    uint32_t reg;
+    uint32_t old;
+    const sim_block_t *block;
+} sim_access_t;
+
+static sim_region_t g_regions[] =
+{
+    { "periph", PERIPH_BASE, 0x30000, PROT_NONE, NULL },  // APB1、APB2、AHB
+    { "ppb", 0xE0000000, 0x100000, PROT_NONE, NULL },     // DWT、SCS、DBGMCU
+    { "flash", 0x08000000, 0x10000, PROT_NONE, NULL },    // 主記憶體 (資料)
+    { "sysmem", 0x1FFFF000, 0x1000, PROT_READ, NULL },    // Flash 容量、UID
+};
+
+static const sim_device_t *const kDevices[] =
+{
+    &sim_rcc_device, &sim_scs_device, &sim_gpio_device, &sim_timer_device,
+    &sim_dma_device, &sim_usart_device, &sim_crc_device, &sim_flash_device,
+    &sim_backup_device
+};
+
+#define kDeviceCount (sizeof(kDevices) / sizeof(kDevices[0]))
+#define kRegionCount (sizeof(g_regions) / sizeof(g_regions[0]))
+
+uint32_t g_sim_trace = 0;
+
+static const sim_block_t *g_blocks[32];
+static uint8_t g_block_count = 0;
+
+static uint64_t g_now_ns = 0;
+static uint64_t g_end_ns = kSimNever;
+static uint64_t g_real_ref_ns = 0;
+static uint64_t g_real_start_ns = 0;
+static double g_scale = 1.0;
+static uint16_t g_boot = 1;     // 第幾次開機 (情境檔以 reboot 分段)
+static bool g_reboot = false;   // 結束時接著執行下一段
+static int g_argc;
+static char **g_argv;
+
+static sim_event_t g_queue[kQueueSize];
+static uint16_t g_queue_len = 0;
+static uint32_t g_queue_seq = 0;
+
+static sim_access_t g_access;
+static uint64_t g_soft_pending = 0;   // 以 __atomic 存取 (信號處理函式也會修改)
+static volatile uint32_t g_primask = 0;
+static volatile uint32_t g_faultmask = 0;
+static volatile uint32_t g_basepri = 0;
+static uint32_t g_control = 0;
+static volatile bool g_in_isr = false;
+static volatile bool g_running = false;
+
+static struct
+{
+    uint64_t accesses;
+    uint64_t ticks;
+    uint64_t wfi;
+    uint64_t idle_ns;
+    uint64_t irqs[kSimIrqCount + 1]; // 最後一格是 SysTick
+} g_stats;
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * SIM_NS_PER_S + ts.tv_nsec;
+}
+
+static sim_region_t *find_region(uintptr_t addr)
+{
+    for (size_t i = 0; i < kRegionCount; i++)
+    {
+        if (addr >= g_regions[i].base
+                && addr - g_regions[i].base < g_regions[i].size)
+        {
+            return &g_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static const sim_block_t *find_block(uint32_t addr)
+{
+    for (uint8_t i = 0; i < g_block_count; i++)
+    {
+        if (addr >= g_blocks[i]->base
+                && addr - g_blocks[i]->base < g_blocks[i]->size)
+        {
+            return g_blocks[i];
+        }
+    }
+    return NULL;
+}
+
+void *sim_alias(uint32_t addr)
+{
+    sim_region_t *region = find_region(addr);
+
+    if (region == NULL)
+    {
+        sim_fatal("no simulated memory at 0x%08X", addr);
+    }
+    return region->alias + (addr - region->base);
+}
+
+uint64_t sim_now(void)
+{
+    return g_now_ns;
+}
+
+// ============================================================
+// 訊息輸出 (信號處理函式中也會呼叫，只用 vsnprintf + write)
+// ============================================================
+
+static void log_va(const char *prefix, const char *format, va_list args)
+{
+    char line[256];
+    int len = snprintf(line, sizeof(line), "[%4llu.%06llu] %s",
+            (unsigned long long) (g_now_ns / SIM_NS_PER_S),
+            (unsigned long long) (g_now_ns % SIM_NS_PER_S / SIM_NS_PER_US),
+            prefix);
+
+    len += vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+    if (len > (int) sizeof(line) - 2)
+    {
+        len = sizeof(line) - 2;
+    }
+    line[len++] = '\n';
+    if (write(STDERR_FILENO, line, len) < 0)
+    {
+        // stderr 已關閉時無處可報
+    }
+}
+
+void sim_log(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    log_va("", format, args);
+    va_end(args);
+}
+
+static void print_stats(void)
+{
+    uint64_t real_ns = monotonic_ns() - g_real_start_ns;
+
+    sim_log("sim: %llu.%03llu s simulated in %llu.%03llu s, "
+            "%llu register accesses, %llu ticks, %llu WFI (%llu%% idle)",
+            (unsigned long long) (g_now_ns / SIM_NS_PER_S),
+            (unsigned long long) (g_now_ns % SIM_NS_PER_S / SIM_NS_PER_MS),
+            (unsigned long long) (real_ns / SIM_NS_PER_S),
+            (unsigned long long) (real_ns % SIM_NS_PER_S / SIM_NS_PER_MS),
+            (unsigned long long) g_stats.accesses,
+            (unsigned long long) g_stats.ticks,
+            (unsigned long long) g_stats.wfi,
+            (unsigned long long) (g_now_ns == 0 ? 0 :
+                    g_stats.idle_ns * 100 / g_now_ns));
+    sim_log("sim: USART1 sent %u bytes", sim_usart_sent());
+    for (int i = 0; i <= kSimIrqCount; i++)
+    {
+        if (g_stats.irqs[i] != 0)
+        {
+            sim_log("sim: %-14s %llu interrupts",
+                    i == kSimIrqCount ? "SysTick" : kSimVectorNames[i],
+                    (unsigned long long) g_stats.irqs[i]);
+        }
+    }
+}
+
+void sim_fatal(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    log_va("sim: fatal: ", format, args);
+    va_end(args);
+    print_stats();
+    _exit(1);
+}
+
+// 以同樣的參數重新執行模擬器，從下一段開機 (韌體的靜態變數、周邊全部回到重置值)
+static void reboot(void)
+{
+    char **argv = calloc(g_argc + 3, sizeof(*argv));
+    char boot[8];
+    int argc = 0;
+
+    if (argv == NULL)
+    {
+        _exit(1);
+    }
+    snprintf(boot, sizeof(boot), "%u", g_boot + 1);
+    argv[argc++] = g_argv[0];
+    argv[argc++] = "-b";
+    argv[argc++] = boot;
+    for (int i = 1; i < g_argc; i++)
+    {
+        if (strcmp(g_argv[i], "-b") == 0)
+        {
+            i++; // 取代原本的 -b
+        }
+        else if (strncmp(g_argv[i], "-b", 2) != 0)
+        {
+            argv[argc++] = g_argv[i];
+        }
+    }
+    argv[argc] = NULL;
+
+    // 忽略 SIGALRM 會丟掉尚未送達的 tick；ignore 在 exec 後仍有效，直到重新安裝處理函式
+    signal(SIGALRM, SIG_IGN);
+    sim_log("sim: reboot");
+    execv("/proc/self/exe", argv);
+    sim_log("sim: cannot reboot: %s", strerror(errno));
+    _exit(1);
+}
+
+void sim_finish(const char *reason)
+{
+    sim_log("sim: %s", reason);
+    sim_flash_save();
+    sim_backup_save();
+    print_stats();
+    if (g_reboot)
+    {
+        reboot();
+    }
+    _exit(0);
+}
+
+// ============================================================
+// 事件佇列與虛擬時間
+// ============================================================
+
+void sim_schedule(uint64_t time_ns, void (*fn)(uintptr_t arg), uintptr_t arg)
+{
+    uint16_t pos = g_queue_len;
+
+    if (g_queue_len >= kQueueSize)
+    {
+        sim_fatal("event queue full");
+    }
+    // 依時間排序，同一時間先排入的先執行
+    while (pos > 0 && g_queue[pos - 1].time_ns > time_ns)
+    {
+        g_queue[pos] = g_queue[pos - 1];
+        pos--;
+    }
+    g_queue[pos] = (sim_event_t) { time_ns, g_queue_seq++, fn, arg };
+    g_queue_len++;
+}
+
+void sim_set_end(uint64_t time_ns)
+{
+    g_end_ns = time_ns;
+}
+
+void sim_set_reboot(void)
+{
+    g_reboot = true;
+}
+
+static void advance_devices(uint64_t time_ns)
+{
+    // 先更新時間：推進中觸發的事件 (例如 DMA 寫 GPIO) 以 sim_now() 取得的是這一步的時間
+    g_now_ns = time_ns;
+    for (size_t i = 0; i < kDeviceCount; i++)
+    {
+        if (kDevices[i]->advance != NULL)
+        {
+            kDevices[i]->advance(time_ns);
+        }
+    }
+}
+
+static uint64_t next_event(void)
+{
+    uint64_t next = g_queue_len > 0 ? g_queue[0].time_ns : kSimNever;
+
+    for (size_t i = 0; i < kDeviceCount; i++)
+    {
+        if (kDevices[i]->next_event != NULL)
+        {
+            uint64_t t = kDevices[i]->next_event(g_now_ns);
+            if (t < next)
+            {
+                next = t;
+            }
+        }
+    }
+    return next;
+}
+
+static void run_until(uint64_t target_ns)
+{
+    if (target_ns > g_end_ns)
+    {
+        target_ns = g_end_ns;
+    }
+    for (;;)
+    {
+        // 停在每個周邊事件上 (例如計時器比較觸發的 DMA 寫 GPIO)，
+        // 韌體忙碌時這些事件的時間點才不會被併到下一次存取
+        uint64_t step = next_event();
+
+        if (step > target_ns || step <= g_now_ns)
+        {
+            step = target_ns;
+        }
+        if (step > g_now_ns + kMaxStepNs)
+        {
+            step = g_now_ns + kMaxStepNs;
+        }
+        if (step > g_now_ns)
+        {
+            advance_devices(step);
+        }
+        while (g_queue_len > 0 && g_queue[0].time_ns <= g_now_ns)
+        {
+            sim_event_t event = g_queue[0];
+
+            g_queue_len--;
+            memmove(&g_queue[0], &g_queue[1], g_queue_len * sizeof(g_queue[0]));
+            event.fn(event.arg);
+        }
+        if (g_now_ns >= target_ns)
+        {
+            break;
+        }
+    }
+    if (g_now_ns >= g_end_ns)
+    {
+        sim_finish("end of scenario");
+    }
+}
+
+// 把虛擬時間推進到「現在」(忙碌的實際時間乘上倍率，再加上 extra_ns)
+static void sync_time(uint64_t extra_ns)
+{
+    uint64_t real = monotonic_ns();
+    uint64_t dt = (uint64_t) ((real - g_real_ref_ns) * g_scale);
+
+    g_real_ref_ns = real;
+    run_until(g_now_ns + dt + extra_ns);
+}
+
+// 信號處理函式結束前呼叫：模擬器自己花掉的時間不算韌體忙碌
+static void restart_real_clock(void)
+{
+    g_real_ref_ns = monotonic_ns();
+}
+
+// ============================================================
+// 匯流排存取 (DMA 與模型之間)
+// ============================================================
+
+static uint32_t load(const void *p, uint8_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return *(const volatile uint8_t *) p;
+    case 2:
+        return *(const volatile uint16_t *) p;
+    default:
+        return *(const volatile uint32_t *) p;
+    }
+}
+
+static void store(void *p, uint8_t size, uint32_t value)
+{
+    switch (size)
+    {
+    case 1:
+        *(volatile uint8_t *) p = value;
+        break;
+    case 2:
+        *(volatile uint16_t *) p = value;
+        break;
+    default:
+        *(volatile uint32_t *) p = value;
+        break;
+    }
+}
+
+uint32_t sim_bus_read(uint32_t addr, uint8_t size)
+{
+    if (find_region(addr) == NULL)
+    {
+        return load((const void *) (uintptr_t) addr, size); // SRAM
+    }
+
+    const sim_block_t *block = find_block(addr & ~3U);
+    uint32_t offset = block != NULL ? (addr & ~3U) - block->base : 0;
+
+    if (block != NULL && block->read != NULL)
+    {
+        block->read(block->unit, offset);
+    }
+    uint32_t value = load(sim_alias(addr), size);
+    if (block != NULL && block->after_read != NULL)
+    {
+        block->after_read(block->unit, offset);
+    }
+    return value;
+}
+
+void sim_bus_write(uint32_t addr, uint8_t size, uint32_t value)
+{
+    if (find_region(addr) == NULL)
+    {
+        store((void *) (uintptr_t) addr, size, value);
+        return;
+    }
+
+    const sim_block_t *block = find_block(addr & ~3U);
+    volatile uint32_t *reg = sim_alias(addr & ~3U);
+    uint32_t old = *reg;
+
+    store(sim_alias(addr), size, value);
+    if (block != NULL && block->write != NULL)
+    {
+        block->write(block->unit, (addr & ~3U) - block->base, old, *reg);
+    }
+}
+
+void sim_dma_poll_all(void)
+{
+    for (size_t i = 0; i < kDeviceCount; i++)
+    {
+        if (kDevices[i]->dma_poll != NULL)
+        {
+            kDevices[i]->dma_poll();
+        }
+    }
+}
+
+// ============================================================
+// 中斷
+// ============================================================
+
+void sim_irq_pend(uint8_t irq)
+{
+    __atomic_fetch_or(&g_soft_pending, 1ULL << irq, __ATOMIC_RELAXED);
+}
+
+uint8_t sim_irq_priority(uint8_t irq)
+{
+    if (irq == kSimIrqSysTick)
+    {
+        return SIM_REG(SCB_Type, SCB_BASE)->SHP[11];
+    }
+    return SIM_REG(NVIC_Type, NVIC_BASE)->IP[irq];
+}
+
+static uint64_t pending_irqs(void)
+{
+    const NVIC_Type *nvic = SIM_REG(NVIC_Type, NVIC_BASE);
+    uint64_t enabled = nvic->ISER[0] | ((uint64_t) nvic->ISER[1] << 32);
+    uint64_t soft = __atomic_load_n(&g_soft_pending, __ATOMIC_RELAXED);
+    uint64_t levels = soft;
+
+    for (size_t i = 0; i < kDeviceCount; i++)
+    {
+        if (kDevices[i]->irq_levels != NULL)
+        {
+            levels |= kDevices[i]->irq_levels();
+        }
+    }
+    enabled &= (1ULL << kSimIrqCount) - 1;
+    return (levels & enabled) | (soft & (1ULL << kSimIrqSysTick));
+}
+
+// 優先權最高 (數值最小) 的 pending 中斷，同優先權時 SysTick 與較小的 IRQn 先
+static int highest_pending(uint64_t pending)
+{
+    int best = -1;
+    uint8_t best_priority = 0xFF;
+
+    if ((pending & (1ULL << kSimIrqSysTick)) != 0)
+    {
+        best = kSimIrqSysTick;
+        best_priority = sim_irq_priority(kSimIrqSysTick);
+    }
+    for (int irq = 0; irq < kSimIrqCount; irq++)
+    {
+        if ((pending & (1ULL << irq)) != 0
+                && (best < 0 || sim_irq_priority(irq) < best_priority))
+        {
+            best = irq;
+            best_priority = sim_irq_priority(irq);
+        }
+    }
+    if (best >= 0 && g_basepri != 0 && best_priority >= g_basepri)
+    {
+        return -1;
+    }
+    return best;
+}
+
+static void dispatch(void)
+{
+    uint32_t rounds = 0;
+
+    if (!g_running || g_in_isr)
+    {
+        return;
+    }
+    g_in_isr = true;
+    while (g_primask == 0 && g_faultmask == 0)
+    {
+        int irq = highest_pending(pending_irqs());
+        if (irq < 0)
+        {
+            break;
+        }
+
+        bool systick = irq == kSimIrqSysTick;
+        const char *name = systick ? "SysTick" : kSimVectorNames[irq];
+        if (++rounds > kStormLimit)
+        {
+            sim_fatal("interrupt storm: %s keeps firing", name);
+        }
+        __atomic_fetch_and(&g_soft_pending, ~(1ULL << irq), __ATOMIC_RELAXED);
+        g_stats.irqs[systick ? kSimIrqCount : irq]++;
+        if ((g_sim_trace & SIM_TRACE_IRQ) != 0)
+        {
+            sim_log("irq %s", name);
+        }
+        if (systick)
+        {
+            SysTick_Handler();
+        }
+        else if (kSimVectors[irq] != NULL)
+        {
+            kSimVectors[irq]();
+        }
+    }
+    g_in_isr = false;
+}
+
+// ============================================================
+// 存取 trap 與 tick
+// ============================================================
+
+static void on_segv(int sig, siginfo_t *info, void *context)
+{
+    ucontext_t *uc = context;
+    uintptr_t addr = (uintptr_t) info->si_addr;
+    sim_region_t *region = find_region(addr);
+    int saved_errno = errno;
+
+    if (region == NULL || region->prot != PROT_NONE || g_access.active)
+    {
+        // 不是周邊存取：恢復預設處理，重新執行時以 SIGSEGV 結束
+        signal(sig, SIG_DFL);
+        return;
+    }
+
+    g_access.write = (uc->uc_mcontext.gregs[REG_ERR] & 0x2) != 0;
+    g_access.reg = (uint32_t) addr & ~3U;
+    g_access.page = addr & ~(uintptr_t) (kPageSize - 1);
+    g_access.block = find_block(g_access.reg);
+    g_access.alarm_blocked = sigismember(&uc->uc_sigmask, SIGALRM);
+    g_access.active = true;
+    g_stats.accesses++;
+
+    sync_time(sim_clocks_to_ns(kAccessCycles, sim_rcc_hclk()));
+    if (g_access.write)
+    {
+        g_access.old = *(volatile uint32_t *) sim_alias(g_access.reg);
+    }
+    else if (g_access.block != NULL && g_access.block->read != NULL)
+    {
+        g_access.block->read(g_access.block->unit,
+                g_access.reg - g_access.block->base);
+    }
+
+    // 開放該頁並單步執行，指令完成後由 on_trap 收回
+    mprotect((void *) g_access.page, kPageSize, PROT_READ | PROT_WRITE);
+    uc->uc_mcontext.gregs[REG_EFL] |= kTrapFlag;
+    sigaddset(&uc->uc_sigmask, SIGALRM);
+    errno = saved_errno;
+}
+
+static void on_trap(int sig, siginfo_t *info, void *context)
+{
+    ucontext_t *uc = context;
+    const sim_block_t *block = g_access.block;
+    int saved_errno = errno;
+
+    (void) info;
+    if (!g_access.active)
+    {
+        signal(sig, SIG_DFL);
+        raise(sig);
+        return;
+    }
+    uc->uc_mcontext.gregs[REG_EFL] &= ~kTrapFlag;
+    mprotect((void *) g_access.page, kPageSize, PROT_NONE);
+    g_access.active = false;
+
+    if (block != NULL)
+    {
+        uint32_t offset = g_access.reg - block->base;
+
+        if (g_access.write && block->write != NULL)
+        {
+            block->write(block->unit, offset, g_access.old,
+                    *(volatile uint32_t *) sim_alias(g_access.reg));
+        }
+        else if (!g_access.write && block->after_read != NULL)
+        {
+            block->after_read(block->unit, offset);
+        }
+    }
+    if (!g_access.alarm_blocked)
+    {
+        sigdelset(&uc->uc_sigmask, SIGALRM);
+    }
+    dispatch();
+    restart_real_clock();
+    errno = saved_errno;
+}
+
+static void on_tick(int sig)
+{
+    int saved_errno = errno;
+
+    (void) sig;
+    g_stats.ticks++;
+    sync_time(0);
+    dispatch();
+    restart_real_clock();
+    errno = saved_errno;
+}
+
+static void block_tick(sigset_t *old)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(SIG_BLOCK, &set, old);
+}
+
+static void install_handlers(uint32_t tick_us)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    sigaddset(&action.sa_mask, SIGALRM);
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    action.sa_sigaction = on_segv;
+    sigaction(SIGSEGV, &action, NULL);
+    action.sa_sigaction = on_trap;
+    sigaction(SIGTRAP, &action, NULL);
+
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    action.sa_handler = on_tick;
+    sigaction(SIGALRM, &action, NULL);
+
+    timer_t timer;
+    struct sigevent event;
+    struct itimerspec spec;
+
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGALRM;
+    if (timer_create(CLOCK_MONOTONIC, &event, &timer) != 0)
+    {
+        sim_fatal("timer_create: %s", strerror(errno));
+    }
+    spec.it_interval.tv_sec = tick_us / 1000000;
+    spec.it_interval.tv_nsec = (tick_us % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    timer_settime(timer, 0, &spec, NULL);
+}
+
+static void map_regions(void)
+{
+    for (size_t i = 0; i < kRegionCount; i++)
+    {
+        sim_region_t *region = &g_regions[i];
+        int fd = memfd_create(region->name, 0);
+
+        if (fd < 0 || ftruncate(fd, region->size) != 0)
+        {
+            sim_fatal("memfd_create: %s", strerror(errno));
+        }
+        void *view = mmap((void *) (uintptr_t) region->base, region->size,
+                region->prot, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+        if (view != (void *) (uintptr_t) region->base)
+        {
+            sim_fatal("cannot map %s at 0x%08X (linked with -no-pie?)",
+                    region->name, region->base);
+        }
+        region->alias = mmap(NULL, region->size, PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+        if (region->alias == MAP_FAILED)
+        {
+            sim_fatal("mmap: %s", strerror(errno));
+        }
+        close(fd);
+    }
+
+    // 系統記憶體：Flash 容量 (KB) 與 96-bit unique ID
+    *(uint16_t *) sim_alias(0x1FFFF7E0) = 64;
+    memcpy(sim_alias(0x1FFFF7E8), "SIMULATED-F1", 12);
+
+    for (size_t i = 0; i < kDeviceCount; i++)
+    {
+        for (uint8_t b = 0; b < kDevices[i]->block_count; b++)
+        {
+            g_blocks[g_block_count++] = &kDevices[i]->blocks[b];
+        }
+        if (kDevices[i]->reset != NULL)
+        {
+            kDevices[i]->reset();
+        }
+    }
+}
+
+// ============================================================
+// CMSIS intrinsic
+// ============================================================
+
+static void check_pending(void)
+{
+    if (!g_in_isr && g_primask == 0 && g_faultmask == 0
+            && highest_pending(pending_irqs()) >= 0)
+    {
+        dispatch();
+    }
+}
+
+void __disable_irq(void)
+{
+    g_primask = 1;
+}
+
+void __enable_irq(void)
+{
+    g_primask = 0;
+    check_pending();
+}
+
+void __disable_fault_irq(void)
+{
+    g_faultmask = 1;
+}
+
+void __enable_fault_irq(void)
+{
+    g_faultmask = 0;
+    check_pending();
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return g_primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    g_primask = priMask & 1;
+    check_pending();
+}
+
+uint32_t __get_FAULTMASK(void)
+{
+    return g_faultmask;
+}
+
+void __set_FAULTMASK(uint32_t faultMask)
+{
+    g_faultmask = faultMask & 1;
+    check_pending();
+}
+
+uint32_t __get_BASEPRI(void)
+{
+    return g_basepri;
+}
+
+void __set_BASEPRI(uint32_t basePri)
+{
+    g_basepri = basePri & 0xFF;
+    check_pending();
+}
+
+uint32_t __get_CONTROL(void)
+{
+    return g_control;
+}
+
+void __set_CONTROL(uint32_t control)
+{
+    g_control = control;
+}
+
+// 主機的堆疊位於 4 GB 以上，只保留低 32 bit 供比較用
+uint32_t __get_MSP(void)
+{
+    return (uint32_t) (uintptr_t) __builtin_frame_address(0);
+}
+
+uint32_t __get_PSP(void)
+{
+    return __get_MSP();
+}
+
+void __set_MSP(uint32_t topOfMainStack)
+{
+    (void) topOfMainStack;
+}
+
+void __set_PSP(uint32_t topOfProcStack)
+{
+    (void) topOfProcStack;
+}
+
+uint32_t __REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+uint32_t __REV16(uint16_t value)
+{
+    return __builtin_bswap16(value);
+}
+
+int32_t __REVSH(int16_t value)
+{
+    return (int16_t) __builtin_bswap16(value);
+}
+
+uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (int i = 0; i < 32; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1);
+    }
+    return result;
+}
+
+// 單執行緒：exclusive store 一律成功
+uint8_t __LDREXB(uint8_t *addr)
+{
+    return *addr;
+}
+
+uint16_t __LDREXH(uint16_t *addr)
+{
+    return *addr;
+}
+
+uint32_t __LDREXW(uint32_t *addr)
+{
+    return *addr;
+}
+
+uint32_t __STREXB(uint8_t value, uint8_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+uint32_t __STREXH(uint16_t value, uint16_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+uint32_t __STREXW(uint32_t value, uint32_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+// 睡眠：直接把虛擬時間跳到下一個會拉起中斷的時間點
+void __WFI(void)
+{
+    sigset_t old;
+
+    block_tick(&old);
+    g_stats.wfi++;
+    sync_time(0);
+    while (pending_irqs() == 0)
+    {
+        uint64_t next = next_event();
+        uint64_t start = g_now_ns;
+
+        if (next == kSimNever && g_end_ns == kSimNever)
+        {
+            sim_finish("firmware sleeps with nothing left to wake it");
+        }
+        run_until(next > g_now_ns ? next : g_now_ns + 1);
+        g_stats.idle_ns += g_now_ns - start;
+    }
+    restart_real_clock();
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    check_pending();
+}
+
+void __WFE(void)
+{
+    __WFI();
+}
+
+void __SEV(void)
+{
+}
+
+void NVIC_SystemReset(void)
+{
+    sim_finish("NVIC_SystemReset()");
+}
+
+// ============================================================
+// main
+// ============================================================
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-s scale] [-t tick_us] [-o output] [-b boot] "
+            "[scenario]\n", name);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t tick_us = kDefaultTickUs;
+    const char *output = NULL;
+    sigset_t none;
+    int opt;
+
+    g_argc = argc;
+    g_argv = argv;
+    while ((opt = getopt(argc, argv, "s:t:o:b:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            g_scale = atof(optarg);
+            break;
+        case 't':
+            tick_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'b':
+            g_boot = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (g_scale <= 0 || tick_us == 0 || g_boot == 0 || optind + 1 < argc)
+    {
+        usage(argv[0]);
+    }
+    if (output != NULL)
+    {
+        // reboot 之後接在前一次開機的輸出後面
+        int fd = open(output, O_WRONLY | O_CREAT | (g_boot > 1 ? O_APPEND : O_TRUNC),
+                0644);
+        if (fd < 0)
+        {
+            perror(output);
+            return 1;
+        }
+        sim_usart_set_output(fd);
+    }
+    // reboot 時在信號處理函式中 exec，signal mask 會被繼承下來
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, NULL);
+
+    map_regions();
+    if (optind < argc)
+    {
+        sim_scenario_load(argv[optind], g_boot);
+    }
+    else if (g_boot > 1)
+    {
+        usage(argv[0]);
+    }
+    install_handlers(tick_us);
+
+    g_real_start_ns = monotonic_ns();
+    g_real_ref_ns = g_real_start_ns;
+    g_running = true;
+
+    SystemInit();
+    firmware_main();
+    sim_log("sim: firmware main() returned");
+    for (;;)
+    {
+        __WFI();
+    }
+}
@@ -0,0 +1,197 @@
+/*
+ * DMA1 模型
+ *
+ * 每個 request 立即完成一次傳輸 (不模擬匯流排仲裁與延遲)，
+ * 透過 sim_bus_read / sim_bus_write 存取，因此寫入周邊暫存器的副作用
+ * (GPIO BSRR、USART DR...) 與 CPU 寫入相同。MEM2MEM 在開啟通道時一次做完。
+ * 位址落在 0x1000 以下視為傳輸錯誤 (TEIF，通道關閉)。
+ */
+
+#include "sim.h"
+
+#define kDmaChannels 7
+
+typedef struct
+{
+    uint32_t peripheral; // 目前的位址 (暫存器 CPAR / CMAR 讀回的是設定值)
+    uint32_t memory;
+    uint16_t total;      // 開啟時的 CNDTR，循環模式重新載入用
+} dma_channel_t;
+
+static dma_channel_t g_channels[kDmaChannels];
+
+static DMA_TypeDef *dma1(void)
+{
+    return SIM_REG(DMA_TypeDef, DMA1_BASE);
+}
+
+static DMA_Channel_TypeDef *channel(uint8_t ch)
+{
+    return SIM_REG(DMA_Channel_TypeDef, DMA1_Channel1_BASE + 20 * (ch - 1));
+}
+
+static void set_flags(uint8_t ch, uint32_t flags)
+{
+    dma1()->ISR |= (flags | DMA_ISR_GIF1) << (4 * (ch - 1));
+}
+
+static void load(uint8_t ch)
+{
+    const DMA_Channel_TypeDef *c = channel(ch);
+
+    g_channels[ch - 1] = (dma_channel_t) { c->CPAR, c->CMAR, c->CNDTR };
+}
+
+// 傳輸一筆資料，回傳是否還有剩餘
+//
+// 先更新位址與 CNDTR 再存取匯流排：寫入周邊 (例如 USART DR) 可能
+// 立刻拉起下一個 request，在此函式內重入。
+static bool transfer(uint8_t ch)
+{
+    DMA_Channel_TypeDef *c = channel(ch);
+    dma_channel_t *state = &g_channels[ch - 1];
+    uint32_t ccr = c->CCR;
+    uint8_t psize = 1U << ((ccr & DMA_CCR1_PSIZE) >> 8);
+    uint8_t msize = 1U << ((ccr & DMA_CCR1_MSIZE) >> 10);
+    uint32_t peripheral = state->peripheral;
+    uint32_t memory = state->memory;
+    uint32_t flags = 0;
+
+    if (peripheral < 0x1000 || memory < 0x1000)
+    {
+        c->CCR &= ~DMA_CCR1_EN;
+        set_flags(ch, DMA_ISR_TEIF1);
+        return false;
+    }
+    state->peripheral += (ccr & DMA_CCR1_PINC) != 0 ? psize : 0;
+    state->memory += (ccr & DMA_CCR1_MINC) != 0 ? msize : 0;
+
+    uint16_t remaining = --c->CNDTR;
+    if (remaining == state->total / 2)
+    {
+        flags |= DMA_ISR_HTIF1;
+    }
+    if (remaining == 0)
+    {
+        flags |= DMA_ISR_TCIF1;
+        if ((ccr & DMA_CCR1_CIRC) != 0)
+        {
+            c->CNDTR = state->total;
+            load(ch);
+        }
+    }
+
+    if ((ccr & DMA_CCR1_DIR) != 0)
+    {
+        sim_bus_write(peripheral, psize, sim_bus_read(memory, msize));
+    }
+    else
+    {
+        sim_bus_write(memory, msize, sim_bus_read(peripheral, psize));
+    }
+    if (flags != 0)
+    {
+        set_flags(ch, flags);
+    }
+    return c->CNDTR != 0 && (c->CCR & DMA_CCR1_EN) != 0;
+}
+
+void sim_dma_request(uint8_t ch)
+{
+    const DMA_Channel_TypeDef *c = channel(ch);
+
+    if ((c->CCR & DMA_CCR1_EN) != 0 && (c->CCR & DMA_CCR1_MEM2MEM) == 0
+            && c->CNDTR != 0)
+    {
+        transfer(ch);
+    }
+}
+
+static void dma_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    DMA_TypeDef *d = dma1();
+
+    (void) unit;
+    if (offset == 0x00) // ISR 唯讀
+    {
+        d->ISR = old;
+        return;
+    }
+    if (offset == 0x04) // IFCR：寫 1 清除，CGIFx 清除該通道全部旗標
+    {
+        uint32_t clear = value;
+        for (uint8_t ch = 0; ch < kDmaChannels; ch++)
+        {
+            clear |= (value & (DMA_IFCR_CGIF1 << (4 * ch))) != 0 ? 0xFU << (4 * ch) : 0;
+        }
+        d->ISR &= ~clear;
+        d->IFCR = 0;
+        return;
+    }
+
+    uint8_t ch = (offset - 0x08) / 20 + 1;
+    uint32_t reg = (offset - 0x08) % 20;
+    DMA_Channel_TypeDef *c = channel(ch);
+
+    if (ch > kDmaChannels)
+    {
+        return;
+    }
+    if (reg != 0x00 && (c->CCR & DMA_CCR1_EN) != 0)
+    {
+        // 通道開啟時 CNDTR / CPAR / CMAR 不可寫
+        ((volatile uint32_t *) c)[reg / 4] = old;
+        return;
+    }
+    if (reg == 0x00 && (value & DMA_CCR1_EN) != 0 && (old & DMA_CCR1_EN) == 0)
+    {
+        load(ch);
+        if ((value & DMA_CCR1_MEM2MEM) != 0)
+        {
+            // MEM2MEM 不能搭配循環模式，最多做一輪
+            for (uint16_t n = g_channels[ch - 1].total; n > 0 && transfer(ch); n--)
+            {
+            }
+        }
+        else
+        {
+            sim_dma_poll_all(); // 周邊持續拉著的 request (例如 USART TXE)
+        }
+    }
+}
+
+static uint64_t dma_irq_levels(void)
+{
+    uint32_t isr = dma1()->ISR;
+    uint64_t levels = 0;
+
+    for (uint8_t ch = 1; ch <= kDmaChannels; ch++)
+    {
+        uint32_t flags = (isr >> (4 * (ch - 1))) & 0xE;
+
+        if ((flags & channel(ch)->CCR & 0xE) != 0)
+        {
+            levels |= 1ULL << (DMA1_Channel1_IRQn + ch - 1);
+        }
+    }
+    return levels;
+}
+
+static void dma_reset(void)
+{
+    for (uint8_t ch = 0; ch < kDmaChannels; ch++)
+    {
+        g_channels[ch] = (dma_channel_t) { 0 };
+    }
+}
+
+static const sim_block_t kDmaBlocks[] =
+{
+    { "DMA1", DMA1_BASE, 0x400, 0, NULL, NULL, dma_write },
+};
+
+const sim_device_t sim_dma_device =
+{
+    "DMA", kDmaBlocks, 1, dma_reset, NULL, NULL, dma_irq_levels, NULL
+};
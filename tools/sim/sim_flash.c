@@ -0,0 +1,236 @@
+/*
+ * Flash 模型：主記憶體 (0x08000000) 與 FLASH 介面 (KEYR、SR、CR、AR)
+ *
+ * 韌體編成主機程式，程式碼不在這裡；只有以位址存取的資料 (例如專案 5 的
+ * flash 紀錄區) 會經過模型，讀寫都會 trap。
+ *
+ * - KEYR 依序寫入 KEY1、KEY2 後清除 CR.LOCK，鎖定時 CR 不能修改
+ * - CR.PG：一次程式化一個 half-word，BSY 維持 kProgramUs；原值不是 0xFFFF
+ *   時 (寫入 0x0000 除外) 設定 PGERR 並保留原值
+ * - CR.PER + AR + STRT：BSY 維持 kPageEraseUs 後整頁變成 0xFF
+ * - 沒有 PG、鎖定或 BSY 時寫入主記憶體無效
+ *
+ * 情境檔：
+ *   flash image <檔案> [new]
+ *                        載入 flash 內容 (檔案不存在或加上 new 時為全 0xFF)，
+ *                        結束時寫回，下一次開機可從同一份 flash 開機
+ *   flash cut <n>        第 n 次程式化或頁清除進行到一半時斷電：half-word 只
+ *                        寫入低位元組、頁只清除前半，寫回映像檔後結束模擬
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define kFlashBase 0x08000000
+#define kFlashSize 0x10000      // 64 KB (與 sysmem 的 Flash 容量相同)
+#define kFlashPageSize 1024     // medium density
+#define kProgramUs 52           // tPROG (資料手冊 40 ~ 70 µs)
+#define kPageEraseUs 20000      // tERASE (資料手冊 20 ~ 40 ms)
+#define kFlashKey1 0x45670123
+#define kFlashKey2 0xCDEF89AB
+
+static const char *g_image_path = NULL;
+static uint32_t g_cut_at = 0;       // 0 = 不斷電
+static uint32_t g_operations = 0;   // 程式化與頁清除的次數
+static uint32_t g_erases = 0;
+static bool g_key1 = false;
+
+static FLASH_TypeDef *regs(void)
+{
+    return SIM_REG(FLASH_TypeDef, FLASH_R_BASE);
+}
+
+static uint8_t *memory(uint32_t offset)
+{
+    return sim_alias(kFlashBase + offset);
+}
+
+void sim_flash_save(void)
+{
+    if (g_image_path == NULL)
+    {
+        return;
+    }
+    FILE *file = fopen(g_image_path, "wb");
+    if (file == NULL || fwrite(memory(0), 1, kFlashSize, file) != kFlashSize)
+    {
+        sim_log("flash: cannot write %s: %s", g_image_path, strerror(errno));
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    sim_log("flash: %u operations (%u page erases), image %s", g_operations,
+            g_erases, g_image_path);
+}
+
+void sim_flash_set_image(const char *path, bool load)
+{
+    FILE *file = load ? fopen(path, "rb") : NULL;
+
+    g_image_path = path;
+    if (file == NULL)
+    {
+        return; // 第一次執行：維持全 0xFF
+    }
+    if (fread(memory(0), 1, kFlashSize, file) != kFlashSize)
+    {
+        sim_fatal("flash: %s is not a %u-byte image", path, kFlashSize);
+    }
+    fclose(file);
+}
+
+void sim_flash_set_cut(uint32_t operation)
+{
+    g_cut_at = operation;
+}
+
+// 斷電前的最後一次操作：套用一半的效果後結束
+static bool power_cut(void)
+{
+    return ++g_operations == g_cut_at;
+}
+
+static void finish_operation(uintptr_t arg)
+{
+    FLASH_TypeDef *f = regs();
+
+    if (arg != 0) // 頁清除
+    {
+        memset(memory(arg - 1), 0xFF, kFlashPageSize);
+        f->CR &= ~FLASH_CR_STRT;
+    }
+    f->SR = (f->SR & ~FLASH_SR_BSY) | FLASH_SR_EOP;
+}
+
+static void start_operation(uint64_t us, uintptr_t arg)
+{
+    regs()->SR |= FLASH_SR_BSY;
+    sim_schedule(sim_now() + us * SIM_NS_PER_US, finish_operation, arg);
+}
+
+static void start_erase(uint32_t address)
+{
+    uint32_t offset = (address - kFlashBase) & ~(kFlashPageSize - 1);
+
+    if (address - kFlashBase >= kFlashSize)
+    {
+        regs()->CR &= ~FLASH_CR_STRT;
+        return;
+    }
+    g_erases++;
+    if (power_cut())
+    {
+        memset(memory(offset), 0xFF, kFlashPageSize / 2);
+        sim_log("flash: power cut while erasing 0x%08X", address);
+        sim_finish("power cut");
+    }
+    start_operation(kPageEraseUs, offset + 1);
+}
+
+static void flash_reg_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    FLASH_TypeDef *f = regs();
+
+    (void) unit;
+    switch (offset)
+    {
+    case 0x04: // KEYR：唯寫
+        f->KEYR = 0;
+        if (value == kFlashKey2 && g_key1)
+        {
+            f->CR &= ~FLASH_CR_LOCK;
+        }
+        g_key1 = value == kFlashKey1;
+        break;
+    case 0x0C: // SR：EOP、WRPRTERR、PGERR 寫 1 清除，BSY 唯讀
+        f->SR = old & ~(value & (FLASH_SR_EOP | FLASH_SR_WRPRTERR
+                | FLASH_SR_PGERR));
+        break;
+    case 0x10: // CR：鎖定時只能維持原值；STRT 由硬體清除
+        if ((old & FLASH_CR_LOCK) != 0)
+        {
+            f->CR = old;
+            break;
+        }
+        f->CR = value | (old & FLASH_CR_STRT);
+        if ((value & FLASH_CR_STRT) != 0 && (old & FLASH_CR_STRT) == 0
+                && (value & FLASH_CR_PER) != 0 && (f->SR & FLASH_SR_BSY) == 0)
+        {
+            start_erase(f->AR);
+        }
+        else if ((f->SR & FLASH_SR_BSY) == 0)
+        {
+            f->CR &= ~FLASH_CR_STRT;
+        }
+        break;
+    default: // ACR、AR 等與一般記憶體相同
+        break;
+    }
+}
+
+static uint16_t program(uint32_t offset, uint16_t before, uint16_t after)
+{
+    FLASH_TypeDef *f = regs();
+
+    if ((f->CR & (FLASH_CR_PG | FLASH_CR_LOCK)) != FLASH_CR_PG
+            || (f->SR & FLASH_SR_BSY) != 0)
+    {
+        return before;
+    }
+    if (power_cut())
+    {
+        *(uint16_t *) memory(offset) = before & (after | 0xFF00);
+        sim_log("flash: power cut while programming 0x%08X",
+                kFlashBase + offset);
+        sim_finish("power cut");
+    }
+    if (before != 0xFFFF && after != 0x0000)
+    {
+        f->SR |= FLASH_SR_PGERR;
+        return before;
+    }
+    start_operation(kProgramUs, 0);
+    return after;
+}
+
+// CPU 已經把新值寫進記憶體：逐一檢查改變的 half-word 是否真的能寫入
+static void flash_array_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    uint32_t result = 0;
+
+    (void) unit;
+    for (uint8_t half = 0; half < 2; half++)
+    {
+        uint16_t before = old >> (16 * half);
+        uint16_t after = value >> (16 * half);
+        if (after != before)
+        {
+            after = program(offset + 2 * half, before, after);
+        }
+        result |= (uint32_t) after << (16 * half);
+    }
+    *(uint32_t *) memory(offset) = result;
+}
+
+static void flash_reset(void)
+{
+    memset(memory(0), 0xFF, kFlashSize);
+    regs()->CR = FLASH_CR_LOCK;
+}
+
+static const sim_block_t kFlashBlocks[] =
+{
+    { "FLASH", FLASH_R_BASE, 0x400, 0, NULL, NULL, flash_reg_write },
+    { "Flash memory", kFlashBase, kFlashSize, 0, NULL, NULL, flash_array_write },
+};
+
+const sim_device_t sim_flash_device =
+{
+    "FLASH", kFlashBlocks, 2, flash_reset, NULL, NULL, NULL, NULL
+};
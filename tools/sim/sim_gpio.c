@@ -0,0 +1,266 @@
+/*
+ * GPIO、AFIO、EXTI 模型
+ *
+ * 每支腳的電位：輸出模式取 ODR；輸入模式取外部驅動 (情境檔 / 感測器模型)，
+ * 沒有外部驅動時依上下拉 (ODR) 決定，浮接視為 0。
+ * 替代功能輸出 (計時器 PWM 等) 的波形不模擬，電位同樣取 ODR。
+ * 電位改變時通知 EXTI、計時器輸入捕捉與其他模型。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define kGpioPorts 5   // GPIOA ~ GPIOE
+#define kMaxWatchers 32
+
+typedef struct
+{
+    uint16_t driven;  // 有外部驅動的腳
+    uint16_t external;
+    uint16_t level;   // 目前的電位 (用來偵測邊緣)
+} gpio_port_t;
+
+typedef struct
+{
+    uint8_t port;
+    uint8_t pin;
+    sim_pin_watch_t fn;
+    uintptr_t arg;
+} gpio_watcher_t;
+
+static gpio_port_t g_ports[kGpioPorts];
+static gpio_watcher_t g_watchers[kMaxWatchers];
+static uint8_t g_watcher_count = 0;
+
+static GPIO_TypeDef *gpio(uint8_t port)
+{
+    return SIM_REG(GPIO_TypeDef, GPIOA_BASE + 0x400 * port);
+}
+
+bool sim_gpio_parse(const char *name, uint8_t *port, uint8_t *pin)
+{
+    char *end;
+
+    if (name[0] != 'P' || name[1] < 'A' || name[1] >= 'A' + kGpioPorts)
+    {
+        return false;
+    }
+    unsigned long n = strtoul(&name[2], &end, 10);
+    if (end == &name[2] || *end != '\0' || n > 15)
+    {
+        return false;
+    }
+    *port = name[1] - 'A';
+    *pin = n;
+    return true;
+}
+
+static uint16_t compute_levels(uint8_t port)
+{
+    const GPIO_TypeDef *g = gpio(port);
+    const gpio_port_t *state = &g_ports[port];
+    uint16_t levels = 0;
+
+    for (uint8_t pin = 0; pin < 16; pin++)
+    {
+        uint32_t config = (pin < 8 ? g->CRL >> (pin * 4) :
+                g->CRH >> ((pin - 8) * 4)) & 0xF;
+        uint16_t bit = 1U << pin;
+        bool level;
+
+        if ((config & 0x3) != 0)
+        {
+            level = (g->ODR & bit) != 0;                // 輸出
+        }
+        else if ((state->driven & bit) != 0)
+        {
+            level = (state->external & bit) != 0;
+        }
+        else
+        {
+            level = (config >> 2) == 2 && (g->ODR & bit) != 0; // 上拉
+        }
+        levels |= level ? bit : 0;
+    }
+    return levels;
+}
+
+static void exti_edge(uint8_t port, uint8_t pin, bool level)
+{
+    const AFIO_TypeDef *afio = SIM_REG(AFIO_TypeDef, AFIO_BASE);
+    EXTI_TypeDef *exti = SIM_REG(EXTI_TypeDef, EXTI_BASE);
+    uint32_t bit = 1U << pin;
+
+    if (((afio->EXTICR[pin / 4] >> ((pin % 4) * 4)) & 0xF) != port)
+    {
+        return;
+    }
+    if ((level && (exti->RTSR & bit) != 0) || (!level && (exti->FTSR & bit) != 0))
+    {
+        exti->PR |= bit;
+    }
+}
+
+// 重新計算電位，對改變的腳送出通知
+static void update_port(uint8_t port)
+{
+    uint16_t levels = compute_levels(port);
+    uint16_t changed = levels ^ g_ports[port].level;
+
+    g_ports[port].level = levels;
+    for (uint8_t pin = 0; changed != 0 && pin < 16; pin++)
+    {
+        if ((changed & (1U << pin)) == 0)
+        {
+            continue;
+        }
+        bool level = (levels & (1U << pin)) != 0;
+        exti_edge(port, pin, level);
+        for (uint8_t i = 0; i < g_watcher_count; i++)
+        {
+            if (g_watchers[i].port == port && g_watchers[i].pin == pin)
+            {
+                g_watchers[i].fn(port, pin, level, g_watchers[i].arg);
+            }
+        }
+    }
+}
+
+bool sim_gpio_level(uint8_t port, uint8_t pin)
+{
+    return (g_ports[port].level & (1U << pin)) != 0;
+}
+
+void sim_gpio_drive(uint8_t port, uint8_t pin, bool level)
+{
+    g_ports[port].driven |= 1U << pin;
+    if (level)
+    {
+        g_ports[port].external |= 1U << pin;
+    }
+    else
+    {
+        g_ports[port].external &= ~(1U << pin);
+    }
+    update_port(port);
+}
+
+void sim_gpio_watch(uint8_t port, uint8_t pin, sim_pin_watch_t fn,
+        uintptr_t arg)
+{
+    if (g_watcher_count >= kMaxWatchers)
+    {
+        sim_fatal("too many pin watchers");
+    }
+    g_watchers[g_watcher_count++] = (gpio_watcher_t) { port, pin, fn, arg };
+}
+
+static void gpio_read(uint8_t port, uint32_t offset)
+{
+    if (offset == 0x08) // IDR
+    {
+        gpio(port)->IDR = g_ports[port].level;
+    }
+}
+
+static void gpio_write(uint8_t port, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    GPIO_TypeDef *g = gpio(port);
+    uint32_t old_odr = g->ODR;
+
+    switch (offset)
+    {
+    case 0x08: // IDR 唯讀
+        g->IDR = old;
+        return;
+    case 0x0C: // ODR
+        g->ODR = value & 0xFFFF;
+        break;
+    case 0x10: // BSRR：同時設定與清除時以設定為準
+        g->ODR = (g->ODR & ~(value >> 16)) | (value & 0xFFFF);
+        g->BSRR = 0;
+        break;
+    case 0x14: // BRR
+        g->ODR &= ~(value & 0xFFFF);
+        g->BRR = 0;
+        break;
+    default:
+        break;
+    }
+    if ((g_sim_trace & SIM_TRACE_GPIO(port)) != 0 && g->ODR != old_odr)
+    {
+        sim_log("GPIO%c ODR %04X", 'A' + port, (unsigned) g->ODR);
+    }
+    update_port(port);
+}
+
+static void exti_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    EXTI_TypeDef *exti = SIM_REG(EXTI_TypeDef, EXTI_BASE);
+
+    (void) unit;
+    if (offset == 0x10) // SWIER：0 -> 1 時觸發
+    {
+        exti->PR |= value & ~old & exti->IMR;
+    }
+    else if (offset == 0x14) // PR：寫 1 清除
+    {
+        exti->PR = old & ~value;
+        exti->SWIER &= ~value;
+    }
+}
+
+static uint64_t exti_irq_levels(void)
+{
+    const EXTI_TypeDef *exti = SIM_REG(EXTI_TypeDef, EXTI_BASE);
+    uint32_t active = exti->PR & exti->IMR;
+    uint64_t levels = 0;
+
+    for (uint8_t line = 0; line < 5; line++)
+    {
+        if ((active & (1U << line)) != 0)
+        {
+            levels |= 1ULL << (EXTI0_IRQn + line);
+        }
+    }
+    if ((active & 0x03E0) != 0)
+    {
+        levels |= 1ULL << EXTI9_5_IRQn;
+    }
+    if ((active & 0xFC00) != 0)
+    {
+        levels |= 1ULL << EXTI15_10_IRQn;
+    }
+    return levels;
+}
+
+static void gpio_reset(void)
+{
+    for (uint8_t port = 0; port < kGpioPorts; port++)
+    {
+        // 重置後全部為浮接輸入
+        gpio(port)->CRL = 0x44444444;
+        gpio(port)->CRH = 0x44444444;
+    }
+    memset(g_ports, 0, sizeof(g_ports));
+}
+
+static const sim_block_t kGpioBlocks[] =
+{
+    { "GPIOA", GPIOA_BASE, 0x400, 0, gpio_read, NULL, gpio_write },
+    { "GPIOB", GPIOB_BASE, 0x400, 1, gpio_read, NULL, gpio_write },
+    { "GPIOC", GPIOC_BASE, 0x400, 2, gpio_read, NULL, gpio_write },
+    { "GPIOD", GPIOD_BASE, 0x400, 3, gpio_read, NULL, gpio_write },
+    { "GPIOE", GPIOE_BASE, 0x400, 4, gpio_read, NULL, gpio_write },
+    { "EXTI", EXTI_BASE, 0x400, 0, NULL, NULL, exti_write },
+};
+
+const sim_device_t sim_gpio_device =
+{
+    "GPIO", kGpioBlocks, sizeof(kGpioBlocks) / sizeof(kGpioBlocks[0]),
+    gpio_reset, NULL, NULL, exti_irq_levels, NULL
+};
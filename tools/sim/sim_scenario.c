@@ -0,0 +1,606 @@
+/*
+ * 情境檔與感測器模型
+ *
+ * 每行一個指令，# 之後為註解，時間為毫秒 (可帶小數)：
+ *
+ *   <ms> hcsr04 <名稱> <Trig 腳> <Echo 腳> [距離 m]  建立 HC-SR04
+ *   <ms> distance <名稱> <m>          改變量到的距離 (> 4 m 視為沒有回波)
+ *   <ms> pin <Pxn> 0|1                 從外部驅動輸入腳
+ *   <ms> rx "<文字>"                   從 USART1 RX 送入 (\n \r \t \\ \" \xHH)
+ *   <ms> trace irq|pwm|usart|sensor|GPIOx   開啟追蹤訊息
+ *   <ms> rcc hse <Hz>|off              HSE 頻率 (off = 晶振不起振)
+ *   <ms> rcc startup <HSE us> <PLL us> HSE 起振 / PLL 鎖定時間
+ *   <ms> rcc lse <us>|off              LSE 起振時間 (off = 晶振不起振)
+ *   <ms> flash image <檔案> [new]      flash 內容從檔案載入 (new = 全 0xFF)、
+ *                                      結束時寫回 (時間用 0)
+ *   <ms> flash cut <n>                 第 n 次程式化 / 頁清除時斷電 (見 sim_flash.c)
+ *   <ms> backup image <檔案> [new]     有 VBAT：備份區從檔案載入 (new = 重置值)、
+ *                                      結束時寫回 (時間用 0)
+ *   <ms> log <文字>                    印出訊息
+ *   <ms> expect "<文字>"               USART1 在上一個 expect 之後送出過這段文字，
+ *                                      否則以結束碼 1 結束 (跳脫字元同 rx)
+ *   <ms> expect pin <Pxn> 0|1          腳位此時的電位，不符時以結束碼 1 結束
+ *   <ms> reboot                        斷電後重新開機：寫回 image，之後的指令
+ *                                      屬於下一次開機，時間從 0 重新計算
+ *   <ms> end                           結束模擬
+ *
+ * 檔案在載入時全部檢查過，錯誤會指出行號。每次開機只執行自己那一段，
+ * 所以 hcsr04、flash image 等設定在 reboot 之後要再寫一次。
+ * 斷電 (flash cut)、NVIC_SystemReset() 與韌體停止時，也會提早進入下一段。
+ *
+ * HC-SR04：Trig 至少 10 us 的高電位結束後約 500 us 拉高 Echo，
+ * 寬度為來回時間 (音速 343 m/s)，超出量程時為 38 ms。
+ * 量測進行中的 Trig 會被忽略。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define kMaxCommands 512 // 事件佇列 (sim_core.c) 還要留位置給模型
+#define kMaxTokens 8
+#define kMaxLine 256
+#define kMaxSensors 4
+
+#define kSoundSpeedMps 343.0
+#define kSensorRangeM 4.0
+#define kNoEchoNs (38 * SIM_NS_PER_MS)
+#define kEchoDelayNs (500 * SIM_NS_PER_US)
+#define kMinTriggerNs (10 * SIM_NS_PER_US)
+
+typedef struct
+{
+    uint64_t time_ns;
+    uint16_t line;
+    uint8_t argc;
+    char *argv[kMaxTokens];
+    char text[kMaxLine]; // 各 token 的儲存空間
+} command_t;
+
+typedef struct
+{
+    char name[16];
+    uint8_t trig_port;
+    uint8_t trig_pin;
+    uint8_t echo_port;
+    uint8_t echo_pin;
+    double distance_m;
+    uint64_t trig_rise_ns;
+    bool measuring;
+} hcsr04_t;
+
+static command_t g_commands[kMaxCommands];
+static uint16_t g_command_count = 0;
+static hcsr04_t g_sensors[kMaxSensors];
+static uint8_t g_sensor_count = 0;
+static uint8_t g_declared_sensors = 0; // 載入檢查時這次開機已宣告的感測器
+
+// ------------------------------------------------------------
+// HC-SR04
+// ------------------------------------------------------------
+
+static void echo_fall(uintptr_t index)
+{
+    hcsr04_t *s = &g_sensors[index];
+
+    sim_gpio_drive(s->echo_port, s->echo_pin, false);
+    s->measuring = false;
+}
+
+static void echo_rise(uintptr_t index)
+{
+    hcsr04_t *s = &g_sensors[index];
+    uint64_t width_ns = kNoEchoNs;
+
+    if (s->distance_m <= kSensorRangeM)
+    {
+        width_ns = (uint64_t) (s->distance_m * 2 / kSoundSpeedMps * SIM_NS_PER_S);
+    }
+    if ((g_sim_trace & SIM_TRACE_SENSOR) != 0)
+    {
+        sim_log("%s echo %llu us (%.3f m)", s->name,
+                (unsigned long long) (width_ns / SIM_NS_PER_US), s->distance_m);
+    }
+    sim_gpio_drive(s->echo_port, s->echo_pin, true);
+    sim_schedule(sim_now() + width_ns, echo_fall, index);
+}
+
+static void on_trigger(uint8_t port, uint8_t pin, bool level, uintptr_t index)
+{
+    hcsr04_t *s = &g_sensors[index];
+    uint64_t now = sim_now();
+
+    (void) port;
+    (void) pin;
+    if (level)
+    {
+        s->trig_rise_ns = now;
+        return;
+    }
+    if (s->measuring)
+    {
+        return;
+    }
+    if (now - s->trig_rise_ns < kMinTriggerNs)
+    {
+        if ((g_sim_trace & SIM_TRACE_SENSOR) != 0)
+        {
+            sim_log("%s trigger too short (%llu ns)", s->name,
+                    (unsigned long long) (now - s->trig_rise_ns));
+        }
+        return;
+    }
+    s->measuring = true;
+    sim_schedule(now + kEchoDelayNs, echo_rise, index);
+}
+
+static hcsr04_t *find_sensor(const char *name)
+{
+    for (uint8_t i = 0; i < g_sensor_count; i++)
+    {
+        if (strcmp(g_sensors[i].name, name) == 0)
+        {
+            return &g_sensors[i];
+        }
+    }
+    return NULL;
+}
+
+// ------------------------------------------------------------
+// 指令
+// ------------------------------------------------------------
+
+static bool parse_number(const char *text, double *value)
+{
+    char *end;
+
+    *value = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+static bool parse_trace(const char *what, uint32_t *flag)
+{
+    static const struct
+    {
+        const char *name;
+        uint32_t flag;
+    } kTraces[] =
+    {
+        { "irq", SIM_TRACE_IRQ },
+        { "pwm", SIM_TRACE_PWM },
+        { "usart", SIM_TRACE_USART },
+        { "sensor", SIM_TRACE_SENSOR },
+    };
+
+    for (size_t i = 0; i < sizeof(kTraces) / sizeof(kTraces[0]); i++)
+    {
+        if (strcmp(what, kTraces[i].name) == 0)
+        {
+            *flag = kTraces[i].flag;
+            return true;
+        }
+    }
+    if (strncmp(what, "GPIO", 4) == 0 && what[4] >= 'A' && what[4] <= 'E'
+            && what[5] == '\0')
+    {
+        *flag = SIM_TRACE_GPIO(what[4] - 'A');
+        return true;
+    }
+    return false;
+}
+
+// 錯誤訊息中的文字：控制字元改回跳脫字元
+static const char *escape(const char *text, char *out, size_t size)
+{
+    size_t len = 0;
+
+    for (; *text != '\0' && len + 5 < size; text++)
+    {
+        if (*text == '\r' || *text == '\n')
+        {
+            out[len++] = '\\';
+            out[len++] = *text == '\r' ? 'r' : 'n';
+        }
+        else if ((unsigned char) *text < 0x20)
+        {
+            len += snprintf(&out[len], size - len, "\\x%02X", (unsigned char) *text);
+        }
+        else
+        {
+            out[len++] = *text;
+        }
+    }
+    out[len] = '\0';
+    return out;
+}
+
+// 檢查 (apply = false) 或執行一個指令，回傳錯誤訊息 (NULL = 成功)
+static const char *run_command(const command_t *cmd, bool apply)
+{
+    const char *verb = cmd->argv[0];
+    char *const *arg = &cmd->argv[1];
+    uint8_t argc = cmd->argc - 1;
+    uint8_t port, pin, port2, pin2;
+    double value;
+    uint32_t flag;
+
+    if (strcmp(verb, "hcsr04") == 0)
+    {
+        if ((argc != 3 && argc != 4) || strlen(arg[0]) >= sizeof(g_sensors[0].name)
+                || !sim_gpio_parse(arg[1], &port, &pin)
+                || !sim_gpio_parse(arg[2], &port2, &pin2)
+                || (argc == 4 && !parse_number(arg[3], &value)))
+        {
+            return "usage: hcsr04 <name> <trig pin> <echo pin> [distance m]";
+        }
+        if (!apply)
+        {
+            return ++g_declared_sensors > kMaxSensors ? "too many sensors" : NULL;
+        }
+        hcsr04_t *s = &g_sensors[g_sensor_count];
+        *s = (hcsr04_t) { "", port, pin, port2, pin2,
+                argc == 4 ? value : kSensorRangeM + 1, 0, false };
+        strcpy(s->name, arg[0]);
+        sim_gpio_watch(port, pin, on_trigger, g_sensor_count++);
+        sim_gpio_drive(port2, pin2, false);
+    }
+    else if (strcmp(verb, "distance") == 0)
+    {
+        if (argc != 2 || !parse_number(arg[1], &value) || value < 0)
+        {
+            return "usage: distance <name> <m>";
+        }
+        if (apply)
+        {
+            hcsr04_t *s = find_sensor(arg[0]);
+            if (s == NULL)
+            {
+                sim_fatal("line %u: unknown sensor %s", cmd->line, arg[0]);
+            }
+            s->distance_m = value;
+        }
+    }
+    else if (strcmp(verb, "pin") == 0)
+    {
+        if (argc != 2 || !sim_gpio_parse(arg[0], &port, &pin)
+                || (strcmp(arg[1], "0") != 0 && strcmp(arg[1], "1") != 0))
+        {
+            return "usage: pin <Pxn> 0|1";
+        }
+        if (apply)
+        {
+            sim_gpio_drive(port, pin, arg[1][0] == '1');
+        }
+    }
+    else if (strcmp(verb, "rx") == 0)
+    {
+        if (argc != 1)
+        {
+            return "usage: rx \"text\"";
+        }
+        if (apply)
+        {
+            sim_usart_inject((const uint8_t *) arg[0], strlen(arg[0]));
+        }
+    }
+    else if (strcmp(verb, "trace") == 0)
+    {
+        if (argc != 1 || !parse_trace(arg[0], &flag))
+        {
+            return "usage: trace irq|pwm|usart|sensor|GPIOA..GPIOE";
+        }
+        if (apply)
+        {
+            g_sim_trace |= flag;
+        }
+    }
+    else if (strcmp(verb, "rcc") == 0)
+    {
+        double value2;
+
+        if (argc == 2 && strcmp(arg[0], "hse") == 0
+                && (strcmp(arg[1], "off") == 0 || parse_number(arg[1], &value)))
+        {
+            if (apply)
+            {
+                sim_rcc_set_hse(strcmp(arg[1], "off") == 0 ? 0 : (uint32_t) value);
+            }
+        }
+        else if (argc == 3 && strcmp(arg[0], "startup") == 0
+                && parse_number(arg[1], &value) && parse_number(arg[2], &value2))
+        {
+            if (apply)
+            {
+                sim_rcc_set_startup(value, value2);
+            }
+        }
+        else if (argc == 2 && strcmp(arg[0], "lse") == 0
+                && (strcmp(arg[1], "off") == 0 || parse_number(arg[1], &value)))
+        {
+            if (apply)
+            {
+                bool off = strcmp(arg[1], "off") == 0;
+                sim_rcc_set_lse(!off, off ? 0 : (uint32_t) value);
+            }
+        }
+        else
+        {
+            return "usage: rcc hse <hz>|off, rcc startup <hse us> <pll us>, "
+                    "rcc lse <us>|off";
+        }
+    }
+    else if (strcmp(verb, "flash") == 0)
+    {
+        if ((argc == 2 || (argc == 3 && strcmp(arg[2], "new") == 0))
+                && strcmp(arg[0], "image") == 0)
+        {
+            if (apply)
+            {
+                sim_flash_set_image(arg[1], argc == 2);
+            }
+        }
+        else if (argc == 2 && strcmp(arg[0], "cut") == 0
+                && parse_number(arg[1], &value) && value >= 1)
+        {
+            if (apply)
+            {
+                sim_flash_set_cut((uint32_t) value);
+            }
+        }
+        else
+        {
+            return "usage: flash image <path> [new], flash cut <operation>";
+        }
+    }
+    else if (strcmp(verb, "backup") == 0)
+    {
+        if ((argc != 2 && (argc != 3 || strcmp(arg[2], "new") != 0))
+                || strcmp(arg[0], "image") != 0)
+        {
+            return "usage: backup image <path> [new]";
+        }
+        if (apply)
+        {
+            sim_backup_set_image(arg[1], argc == 2);
+        }
+    }
+    else if (strcmp(verb, "log") == 0)
+    {
+        if (apply)
+        {
+            char message[kMaxLine] = "";
+            for (uint8_t i = 0; i < argc; i++)
+            {
+                strcat(message, i == 0 ? "" : " ");
+                strcat(message, arg[i]);
+            }
+            sim_log("scenario: %s", message);
+        }
+    }
+    else if (strcmp(verb, "expect") == 0 && argc == 3
+            && strcmp(arg[0], "pin") == 0)
+    {
+        if (!sim_gpio_parse(arg[1], &port, &pin)
+                || (strcmp(arg[2], "0") != 0 && strcmp(arg[2], "1") != 0))
+        {
+            return "usage: expect pin <Pxn> 0|1";
+        }
+        if (apply && sim_gpio_level(port, pin) != (arg[2][0] == '1'))
+        {
+            sim_fatal("line %u: expected %s = %s", cmd->line, arg[1], arg[2]);
+        }
+    }
+    else if (strcmp(verb, "expect") == 0)
+    {
+        if (argc != 1 || arg[0][0] == '\0')
+        {
+            return "usage: expect \"text\" | expect pin <Pxn> 0|1";
+        }
+        if (apply && !sim_usart_expect(arg[0]))
+        {
+            char text[kMaxLine];
+            sim_fatal("line %u: expected \"%s\" from USART1", cmd->line,
+                    escape(arg[0], text, sizeof(text)));
+        }
+    }
+    else if (strcmp(verb, "reboot") == 0)
+    {
+        if (argc != 0)
+        {
+            return "usage: reboot";
+        }
+        g_declared_sensors = 0;
+    }
+    else if (strcmp(verb, "end") == 0)
+    {
+        if (argc != 0)
+        {
+            return "usage: end";
+        }
+    }
+    else
+    {
+        return "unknown command";
+    }
+    return NULL;
+}
+
+static void run_event(uintptr_t index)
+{
+    run_command(&g_commands[index], true);
+}
+
+// ------------------------------------------------------------
+// 讀檔
+// ------------------------------------------------------------
+
+// 把一行切成 token (雙引號內的空白保留並處理跳脫字元)，回傳錯誤訊息
+static const char *tokenize(const char *line, command_t *cmd)
+{
+    const char *p = line;
+    char *out = cmd->text;
+
+    cmd->argc = 0;
+    for (;;)
+    {
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#')
+        {
+            return NULL;
+        }
+        if (cmd->argc >= kMaxTokens)
+        {
+            return "too many arguments";
+        }
+        cmd->argv[cmd->argc++] = out;
+        if (*p != '"')
+        {
+            while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\n'
+                    && *p != '\r')
+            {
+                *out++ = *p++;
+            }
+            *out++ = '\0';
+            continue;
+        }
+        for (p++; *p != '"'; p++)
+        {
+            if (*p == '\0' || *p == '\n')
+            {
+                return "unterminated string";
+            }
+            if (*p != '\\')
+            {
+                *out++ = *p;
+                continue;
+            }
+            switch (*++p)
+            {
+            case 'n':
+                *out++ = '\n';
+                break;
+            case 'r':
+                *out++ = '\r';
+                break;
+            case 't':
+                *out++ = '\t';
+                break;
+            case 'x':
+            {
+                char hex[3] = { p[1], p[1] != '\0' ? p[2] : '\0', '\0' };
+                char *end;
+                *out++ = (char) strtoul(hex, &end, 16);
+                if (end != hex + 2)
+                {
+                    return "bad \\x escape";
+                }
+                p += 2;
+                break;
+            }
+            case '\0':
+                return "unterminated string";
+            default:
+                *out++ = *p;
+                break;
+            }
+        }
+        p++;
+        *out++ = '\0';
+    }
+}
+
+// 只保留第 boot 次開機的指令 (以 reboot 分段)
+void sim_scenario_load(const char *path, uint16_t boot)
+{
+    FILE *file = fopen(path, "r");
+    char line[kMaxLine];
+    uint16_t number = 0;
+    uint16_t section = 1;
+    bool empty_section = false;
+
+    if (file == NULL)
+    {
+        sim_fatal("cannot open scenario %s", path);
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        command_t *cmd = &g_commands[g_command_count];
+        const char *error;
+        double ms;
+
+        number++;
+        if (strchr(line, '\n') == NULL && !feof(file))
+        {
+            sim_fatal("%s:%u: line too long", path, number);
+        }
+        error = tokenize(line, cmd);
+        if (error == NULL && cmd->argc == 0)
+        {
+            continue;
+        }
+        if (error == NULL && (cmd->argc < 2 || !parse_number(cmd->argv[0], &ms)
+                || ms < 0))
+        {
+            error = "expected <time ms> <command> ...";
+        }
+        if (error == NULL)
+        {
+            // 去掉時間欄位
+            memmove(&cmd->argv[0], &cmd->argv[1],
+                    (cmd->argc - 1) * sizeof(cmd->argv[0]));
+            cmd->argc--;
+            cmd->time_ns = (uint64_t) (ms * SIM_NS_PER_MS);
+            cmd->line = number;
+            error = run_command(cmd, false);
+        }
+        if (error != NULL)
+        {
+            sim_fatal("%s:%u: %s", path, number, error);
+        }
+        empty_section = false;
+        if (section == boot && ++g_command_count >= kMaxCommands)
+        {
+            sim_fatal("%s: too many commands", path);
+        }
+        if (strcmp(cmd->argv[0], "reboot") == 0)
+        {
+            section++;
+            empty_section = true;
+        }
+    }
+    fclose(file);
+    if (empty_section)
+    {
+        sim_fatal("%s: nothing after the last reboot", path);
+    }
+    if (boot > section)
+    {
+        sim_fatal("%s: boot %u requested, scenario has %u", path, boot, section);
+    }
+    if (boot > 1)
+    {
+        sim_log("sim: boot %u of %u", boot, section);
+    }
+
+    for (uint16_t i = 0; i < g_command_count; i++)
+    {
+        if (strcmp(g_commands[i].argv[0], "end") == 0)
+        {
+            sim_set_end(g_commands[i].time_ns);
+        }
+        else if (strcmp(g_commands[i].argv[0], "reboot") == 0)
+        {
+            sim_set_end(g_commands[i].time_ns);
+            sim_set_reboot();
+        }
+        else
+        {
+            sim_schedule(g_commands[i].time_ns, run_event, i);
+        }
+    }
+}
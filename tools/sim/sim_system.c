@@ -0,0 +1,554 @@
+/*
+ * 系統周邊模型：RCC (時脈樹)、SCS (NVIC、SCB、SysTick、CoreDebug)、DWT、CRC
+ */
+
+#include "sim.h"
+
+#define kHsiHz 8000000
+#define kDefaultHseHz 8000000
+#define kDefaultHseStartupUs 200
+#define kDefaultPllLockUs 50
+#define kDefaultLseStartupUs 300000 // tSU(LSE) 資料手冊典型值 1 s，實測多在數百 ms
+
+// RCC->CIR 的 ready 旗標 (bit 0 ~ 4) 與中斷致能 (bit 8 ~ 12)
+#define kRccLsiRdyF (1U << 0)
+#define kRccLseRdyF (1U << 1)
+#define kRccHsiRdyF (1U << 2)
+#define kRccHseRdyF (1U << 3)
+#define kRccPllRdyF (1U << 4)
+#define kRccRdyFlags 0x1F
+
+static uint32_t g_hse_hz = kDefaultHseHz;
+static uint64_t g_hse_startup_ns = kDefaultHseStartupUs * SIM_NS_PER_US;
+static uint64_t g_pll_lock_ns = kDefaultPllLockUs * SIM_NS_PER_US;
+static uint32_t g_hse_generation = 0; // HSEON / PLLON 關閉後作廢尚未到期的 ready
+static uint32_t g_pll_generation = 0;
+static bool g_lse_present = true;
+static uint64_t g_lse_startup_ns = kDefaultLseStartupUs * SIM_NS_PER_US;
+static uint32_t g_lse_generation = 0;
+
+// ============================================================
+// RCC
+// ============================================================
+
+static RCC_TypeDef *rcc(void)
+{
+    return SIM_REG(RCC_TypeDef, RCC_BASE);
+}
+
+void sim_rcc_set_hse(uint32_t hz)
+{
+    g_hse_hz = hz;
+}
+
+void sim_rcc_set_startup(uint32_t hse_us, uint32_t pll_us)
+{
+    g_hse_startup_ns = hse_us * SIM_NS_PER_US;
+    g_pll_lock_ns = pll_us * SIM_NS_PER_US;
+}
+
+void sim_rcc_set_lse(bool present, uint32_t startup_us)
+{
+    g_lse_present = present;
+    g_lse_startup_ns = startup_us * SIM_NS_PER_US;
+}
+
+static uint32_t pll_hz(void)
+{
+    uint32_t cfgr = rcc()->CFGR;
+    uint32_t mul = ((cfgr & RCC_CFGR_PLLMULL) >> 18) + 2;
+    uint32_t input = kHsiHz / 2;
+
+    if ((cfgr & RCC_CFGR_PLLSRC) != 0)
+    {
+        input = g_hse_hz / ((cfgr & RCC_CFGR_PLLXTPRE) != 0 ? 2 : 1);
+    }
+    return input * (mul > 16 ? 16 : mul);
+}
+
+uint32_t sim_rcc_sysclk(void)
+{
+    switch (rcc()->CFGR & RCC_CFGR_SWS)
+    {
+    case RCC_CFGR_SWS_HSE:
+        return g_hse_hz;
+    case RCC_CFGR_SWS_PLL:
+        return pll_hz();
+    default:
+        return kHsiHz;
+    }
+}
+
+uint32_t sim_rcc_hclk(void)
+{
+    static const uint16_t kAhbDiv[8] = { 2, 4, 8, 16, 64, 128, 256, 512 };
+    uint32_t hpre = (rcc()->CFGR & RCC_CFGR_HPRE) >> 4;
+
+    return sim_rcc_sysclk() / (hpre < 8 ? 1 : kAhbDiv[hpre - 8]);
+}
+
+static uint32_t apb_div(uint8_t apb)
+{
+    uint32_t ppre = apb == 1 ? (rcc()->CFGR & RCC_CFGR_PPRE1) >> 8 :
+            (rcc()->CFGR & RCC_CFGR_PPRE2) >> 11;
+
+    return ppre < 4 ? 1 : 2U << (ppre - 4);
+}
+
+uint32_t sim_rcc_pclk(uint8_t apb)
+{
+    return sim_rcc_hclk() / apb_div(apb);
+}
+
+// APB 有除頻時，計時器時脈為 PCLK x2
+uint32_t sim_rcc_timclk(uint8_t apb)
+{
+    return sim_rcc_pclk(apb) * (apb_div(apb) == 1 ? 1 : 2);
+}
+
+static bool source_ready(uint32_t sw)
+{
+    switch (sw)
+    {
+    case RCC_CFGR_SW_HSE:
+        return (rcc()->CR & RCC_CR_HSERDY) != 0;
+    case RCC_CFGR_SW_PLL:
+        return (rcc()->CR & RCC_CR_PLLRDY) != 0;
+    default:
+        return (rcc()->CR & RCC_CR_HSIRDY) != 0;
+    }
+}
+
+// 目標時脈 ready 後才會切換 (RM0008 7.2.6)
+static void apply_switch(void)
+{
+    uint32_t sw = rcc()->CFGR & RCC_CFGR_SW;
+    uint32_t sws = sw << 2;
+
+    if ((rcc()->CFGR & RCC_CFGR_SWS) != sws && source_ready(sw))
+    {
+        rcc()->CFGR = (rcc()->CFGR & ~RCC_CFGR_SWS) | sws;
+    }
+}
+
+static void set_ready(uint32_t rdy_bit, uint32_t flag)
+{
+    rcc()->CR |= rdy_bit;
+    rcc()->CIR |= flag;
+    apply_switch();
+}
+
+static void pll_locked(uintptr_t generation);
+
+static void try_lock_pll(void)
+{
+    bool from_hse = (rcc()->CFGR & RCC_CFGR_PLLSRC) != 0;
+
+    if ((rcc()->CR & RCC_CR_PLLON) == 0 || (rcc()->CR & RCC_CR_PLLRDY) != 0)
+    {
+        return;
+    }
+    if (!from_hse || (rcc()->CR & RCC_CR_HSERDY) != 0)
+    {
+        sim_schedule(sim_now() + g_pll_lock_ns, pll_locked, g_pll_generation);
+    }
+}
+
+static void hse_ready(uintptr_t generation)
+{
+    if (generation == g_hse_generation && (rcc()->CR & RCC_CR_HSEON) != 0)
+    {
+        set_ready(RCC_CR_HSERDY, kRccHseRdyF);
+        try_lock_pll();
+    }
+}
+
+static void pll_locked(uintptr_t generation)
+{
+    if (generation == g_pll_generation && (rcc()->CR & RCC_CR_PLLON) != 0
+            && (rcc()->CR & RCC_CR_PLLRDY) == 0)
+    {
+        set_ready(RCC_CR_PLLRDY, kRccPllRdyF);
+    }
+}
+
+static void lse_ready(uintptr_t generation)
+{
+    if (generation == g_lse_generation
+            && (rcc()->BDCR & RCC_BDCR_LSEON) != 0)
+    {
+        rcc()->BDCR |= RCC_BDCR_LSERDY;
+        rcc()->CIR |= kRccLseRdyF;
+    }
+}
+
+static void rcc_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    const uint32_t kCrReady = RCC_CR_HSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY;
+    RCC_TypeDef *r = rcc();
+
+    (void) unit;
+    switch (offset)
+    {
+    case 0x00: // CR
+        r->CR = (value & ~kCrReady) | (old & kCrReady);
+        if ((value & RCC_CR_HSION) != 0 && (old & RCC_CR_HSIRDY) == 0)
+        {
+            set_ready(RCC_CR_HSIRDY, kRccHsiRdyF);
+        }
+        if ((value & RCC_CR_HSEON) != 0 && (old & RCC_CR_HSEON) == 0
+                && g_hse_hz != 0)
+        {
+            sim_schedule(sim_now() + g_hse_startup_ns, hse_ready,
+                    ++g_hse_generation);
+        }
+        if ((value & RCC_CR_HSEON) == 0)
+        {
+            r->CR &= ~RCC_CR_HSERDY;
+            g_hse_generation++;
+        }
+        if ((value & RCC_CR_PLLON) == 0)
+        {
+            r->CR &= ~RCC_CR_PLLRDY;
+            g_pll_generation++;
+        }
+        else if ((old & RCC_CR_PLLON) == 0)
+        {
+            try_lock_pll();
+        }
+        break;
+    case 0x04: // CFGR (SWS 唯讀)
+        r->CFGR = (value & ~RCC_CFGR_SWS) | (old & RCC_CFGR_SWS);
+        apply_switch();
+        break;
+    case 0x08: // CIR：bit 16 ~ 23 寫 1 清除對應旗標
+    {
+        uint32_t flags = old & (kRccRdyFlags | RCC_CIR_CSSF);
+        flags &= ~((value >> 16) & (kRccRdyFlags | RCC_CIR_CSSF));
+        r->CIR = flags | (value & 0x1F00);
+        break;
+    }
+    case 0x20: // BDCR：備份區，PWR_CR.DBP 為 0 時不能寫入
+        if (!sim_backup_writable())
+        {
+            r->BDCR = old;
+            break;
+        }
+        if ((value & RCC_BDCR_BDRST) != 0) // 重置期間其他位元維持重置值
+        {
+            r->BDCR = RCC_BDCR_BDRST;
+            g_lse_generation++;
+            sim_backup_domain_reset();
+            break;
+        }
+        // RTCSEL 設定後只能由 BDRST 清除
+        if ((old & RCC_BDCR_RTCSEL) != 0)
+        {
+            value = (value & ~RCC_BDCR_RTCSEL) | (old & RCC_BDCR_RTCSEL);
+        }
+        r->BDCR = (value & ~RCC_BDCR_LSERDY) | (old & RCC_BDCR_LSERDY);
+        if ((value & RCC_BDCR_LSEON) == 0)
+        {
+            r->BDCR &= ~RCC_BDCR_LSERDY;
+            g_lse_generation++;
+        }
+        else if ((old & RCC_BDCR_LSEON) == 0 && g_lse_present)
+        {
+            sim_schedule(sim_now() + g_lse_startup_ns, lse_ready,
+                    g_lse_generation);
+        }
+        break;
+    case 0x24: // CSR
+        r->CSR = (value & ~RCC_CSR_LSIRDY)
+                | ((value & RCC_CSR_LSION) != 0 ? RCC_CSR_LSIRDY : 0);
+        if ((value & RCC_CSR_LSION) != 0 && (old & RCC_CSR_LSIRDY) == 0)
+        {
+            r->CIR |= kRccLsiRdyF;
+        }
+        if ((value & RCC_CSR_RMVF) != 0)
+        {
+            r->CSR &= ~(RCC_CSR_RMVF | 0xFC000000);
+        }
+        else
+        {
+            r->CSR = (r->CSR & ~0xFC000000) | (old & 0xFC000000);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void rcc_reset(void)
+{
+    rcc()->CR = RCC_CR_HSION | RCC_CR_HSIRDY | 0x80;
+    rcc()->CSR = RCC_CSR_PINRSTF | RCC_CSR_PORRSTF;
+}
+
+static uint64_t rcc_irq_levels(void)
+{
+    uint32_t cir = rcc()->CIR;
+    bool active = (cir & (cir >> 8) & kRccRdyFlags) != 0;
+
+    return active ? 1ULL << RCC_IRQn : 0;
+}
+
+static const sim_block_t kRccBlocks[] =
+{
+    { "RCC", RCC_BASE, 0x400, 0, NULL, NULL, rcc_write },
+};
+
+const sim_device_t sim_rcc_device =
+{
+    "RCC", kRccBlocks, 1, rcc_reset, NULL, NULL, rcc_irq_levels, NULL
+};
+
+// ============================================================
+// SCS：SysTick、NVIC、SCB、CoreDebug，以及 DWT
+// ============================================================
+
+#define kDwtBase 0xE0001000
+#define kDwtCtrl 0x000
+#define kDwtCyccnt 0x004
+
+static uint64_t g_scs_last_ns = 0;
+static uint64_t g_systick_rem = 0;
+static uint64_t g_cyccnt_rem = 0;
+
+static SysTick_Type *systick(void)
+{
+    return SIM_REG(SysTick_Type, SysTick_BASE);
+}
+
+static uint32_t systick_hz(void)
+{
+    bool core = (systick()->CTRL & SysTick_CTRL_CLKSOURCE_Msk) != 0;
+
+    return core ? sim_rcc_hclk() : sim_rcc_hclk() / 8;
+}
+
+static void systick_count(uint64_t clocks)
+{
+    SysTick_Type *st = systick();
+    uint32_t load = st->LOAD & SysTick_LOAD_RELOAD_Msk;
+    uint32_t val = st->VAL & SysTick_VAL_CURRENT_Msk;
+
+    while (clocks > 0)
+    {
+        if (val == 0)
+        {
+            // 0 之後的下一個時脈重新載入
+            if (load == 0)
+            {
+                break;
+            }
+            val = load;
+            clocks--;
+            if (clocks > 2 * (uint64_t) (load + 1))
+            {
+                clocks %= load + 1; // 中間數圈只留下旗標
+            }
+            continue;
+        }
+        if (clocks < val)
+        {
+            val -= clocks;
+            break;
+        }
+        clocks -= val;
+        val = 0;
+        st->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if ((st->CTRL & SysTick_CTRL_TICKINT_Msk) != 0)
+        {
+            sim_irq_pend(kSimIrqSysTick);
+        }
+    }
+    st->VAL = val;
+}
+
+static void scs_advance(uint64_t now_ns)
+{
+    uint64_t dt = now_ns - g_scs_last_ns;
+    const CoreDebug_Type *debug = SIM_REG(CoreDebug_Type, CoreDebug_BASE);
+    volatile uint32_t *dwt = sim_alias(kDwtBase);
+
+    g_scs_last_ns = now_ns;
+    if ((systick()->CTRL & SysTick_CTRL_ENABLE_Msk) != 0)
+    {
+        systick_count(sim_clocks(&g_systick_rem, dt, systick_hz()));
+    }
+    if ((debug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0
+            && (dwt[kDwtCtrl / 4] & 1) != 0)
+    {
+        dwt[kDwtCyccnt / 4] += sim_clocks(&g_cyccnt_rem, dt, sim_rcc_hclk());
+    }
+}
+
+static uint64_t scs_next_event(uint64_t now_ns)
+{
+    const SysTick_Type *st = systick();
+    const uint32_t kMask = SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk;
+
+    if ((st->CTRL & kMask) != kMask)
+    {
+        return kSimNever;
+    }
+    uint32_t val = st->VAL & SysTick_VAL_CURRENT_Msk;
+    uint64_t clocks = val != 0 ? val : (uint64_t) (st->LOAD & SysTick_LOAD_RELOAD_Msk) + 1;
+    return now_ns + sim_clocks_to_ns(clocks, systick_hz());
+}
+
+static void scs_after_read(uint8_t unit, uint32_t offset)
+{
+    (void) unit;
+    if (offset == 0x010) // SysTick CTRL：COUNTFLAG 讀取後清除
+    {
+        systick()->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+    }
+}
+
+static void scs_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    NVIC_Type *nvic = SIM_REG(NVIC_Type, NVIC_BASE);
+    SCB_Type *scb = SIM_REG(SCB_Type, SCB_BASE);
+
+    (void) unit;
+    if (offset == 0x010) // SysTick CTRL (COUNTFLAG 唯讀)
+    {
+        systick()->CTRL = (value & ~SysTick_CTRL_COUNTFLAG_Msk)
+                | (old & SysTick_CTRL_COUNTFLAG_Msk);
+    }
+    else if (offset == 0x018) // SysTick VAL：寫入任何值都清為 0
+    {
+        systick()->VAL = 0;
+        systick()->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+    }
+    else if (offset >= 0x100 && offset < 0x120) // ISER：寫 1 致能
+    {
+        uint8_t n = (offset - 0x100) / 4;
+        nvic->ISER[n] = old | value;
+        nvic->ICER[n] = nvic->ISER[n];
+    }
+    else if (offset >= 0x180 && offset < 0x1A0) // ICER：寫 1 關閉
+    {
+        uint8_t n = (offset - 0x180) / 4;
+        nvic->ISER[n] &= ~value;
+        nvic->ICER[n] = nvic->ISER[n];
+    }
+    else if (offset >= 0x200 && offset < 0x220) // ISPR：軟體觸發
+    {
+        uint8_t n = (offset - 0x200) / 4;
+        for (uint8_t bit = 0; bit < 32; bit++)
+        {
+            if ((value & (1U << bit)) != 0 && n * 32 + bit < kSimIrqCount)
+            {
+                sim_irq_pend(n * 32 + bit);
+            }
+        }
+        nvic->ISPR[n] = 0;
+    }
+    else if (offset == 0xD04) // ICSR
+    {
+        if ((value & SCB_ICSR_PENDSTSET_Msk) != 0)
+        {
+            sim_irq_pend(kSimIrqSysTick);
+        }
+        scb->ICSR = 0;
+    }
+    else if (offset == 0xD0C) // AIRCR
+    {
+        if ((value >> SCB_AIRCR_VECTKEY_Pos) == 0x05FA
+                && (value & SCB_AIRCR_SYSRESETREQ_Msk) != 0)
+        {
+            sim_finish("system reset requested through AIRCR");
+        }
+        scb->AIRCR = (0xFA05U << SCB_AIRCR_VECTKEY_Pos)
+                | (value & SCB_AIRCR_PRIGROUP_Msk);
+    }
+    else if (offset == 0xF00) // STIR
+    {
+        if ((value & 0x1FF) < kSimIrqCount)
+        {
+            sim_irq_pend(value & 0x1FF);
+        }
+    }
+}
+
+static void dwt_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    volatile uint32_t *dwt = sim_alias(kDwtBase);
+
+    (void) unit;
+    if (offset == kDwtCtrl) // NUMCOMP 唯讀
+    {
+        dwt[0] = (value & 0x0FFFFFFF) | (old & 0xF0000000);
+    }
+}
+
+static void scs_reset(void)
+{
+    SCB_Type *scb = SIM_REG(SCB_Type, SCB_BASE);
+
+    *(volatile uint32_t *) &scb->CPUID = 0x411FC231; // Cortex-M3 r1p1
+    scb->AIRCR = 0xFA05U << SCB_AIRCR_VECTKEY_Pos;
+    ((volatile uint32_t *) sim_alias(kDwtBase))[kDwtCtrl / 4] = 0x40000000;
+}
+
+static const sim_block_t kScsBlocks[] =
+{
+    { "SCS", SCS_BASE, 0x1000, 0, NULL, scs_after_read, scs_write },
+    { "DWT", kDwtBase, 0x1000, 0, NULL, NULL, dwt_write },
+};
+
+const sim_device_t sim_scs_device =
+{
+    "SCS", kScsBlocks, 2, scs_reset, scs_advance, scs_next_event, NULL, NULL
+};
+
+// ============================================================
+// CRC：與硬體相同，逐 32-bit word、MSB first，多項式 0x04C11DB7
+// ============================================================
+
+static void crc_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    CRC_TypeDef *crc = SIM_REG(CRC_TypeDef, CRC_BASE);
+
+    (void) unit;
+    if (offset == 0x00) // DR：寫入資料，讀回目前的 CRC
+    {
+        uint32_t result = old ^ value;
+        for (int bit = 0; bit < 32; bit++)
+        {
+            result = (result & 0x80000000) ? (result << 1) ^ 0x04C11DB7 :
+                    result << 1;
+        }
+        crc->DR = result;
+    }
+    else if (offset == 0x08) // CR：RESET 自動清除
+    {
+        if ((value & CRC_CR_RESET) != 0)
+        {
+            crc->DR = 0xFFFFFFFF;
+        }
+        crc->CR = 0;
+    }
+}
+
+static void crc_reset(void)
+{
+    SIM_REG(CRC_TypeDef, CRC_BASE)->DR = 0xFFFFFFFF;
+}
+
+static const sim_block_t kCrcBlocks[] =
+{
+    { "CRC", CRC_BASE, 0x400, 0, NULL, NULL, crc_write },
+};
+
+const sim_device_t sim_crc_device =
+{
+    "CRC", kCrcBlocks, 1, crc_reset, NULL, NULL, NULL, NULL
+};
@@ -0,0 +1,450 @@
+/*
+ * TIM1 ~ TIM4 模型 (只支援向上計數)
+ *
+ * - 預分頻 / 自動重載、更新事件 (UIF、UDIS、URS、OPM、UG)
+ * - 輸出比較：CNT 等於 CCRx 時設定 CCxIF、送出 DMA request
+ * - 輸入捕捉：TIx 腳位的邊緣 (CCxS = 01 / 10、CCxP)，含 overcapture
+ * - 主從串接：MMS = 010 (update 當 TRGO) 搭配外部時脈模式 1 (SMS = 111)
+ *
+ * 輸出腳的 PWM 波形不模擬 (見 sim_gpio.c)，trace pwm 時改為在 CCRx 改變時
+ * 印出脈寬。
+ */
+
+#include "sim.h"
+
+#define kTimerCount 4
+#define kChannels 4
+
+#define kOffCr1 0x00
+#define kOffSmcr 0x08
+#define kOffSr 0x10
+#define kOffEgr 0x14
+#define kOffCcr1 0x34
+#define kOffCcr4 0x40
+
+// DMA request 來源在對照表中的位置
+#define kDmaUp 4
+#define kDmaTrig 5
+
+typedef struct
+{
+    const char *name;
+    uint32_t base;
+    uint8_t apb;
+    int8_t itr[4];           // ITR0 ~ 3 對應的主計時器 (timer 編號，-1 = 不存在)
+    uint8_t dma[6];          // CH1 ~ 4、UP、TRIG 的 DMA1 通道 (0 = 無)
+    uint8_t pins[kChannels]; // TI1 ~ 4 的腳位 (port << 4 | pin)
+} timer_info_t;
+
+typedef struct
+{
+    uint16_t psc;            // 預分頻的 shadow register
+    uint32_t psc_count;
+    uint64_t clock_rem;
+    uint32_t trgo;           // 本次推進中送出的 TRGO 次數
+    uint16_t traced_ccr[kChannels];
+} timer_state_t;
+
+// 編號 0 ~ 3 = TIM1 ~ TIM4 (RM0008 表 86、78、79)
+static const timer_info_t kTimers[kTimerCount] =
+{
+    { "TIM1", TIM1_BASE, 2, { -1, 1, 2, 3 }, { 2, 3, 6, 4, 5, 4 },
+            { 0x08, 0x09, 0x0A, 0x0B } },
+    { "TIM2", TIM2_BASE, 1, { 0, -1, 2, 3 }, { 5, 7, 1, 7, 2, 0 },
+            { 0x00, 0x01, 0x02, 0x03 } },
+    { "TIM3", TIM3_BASE, 1, { 0, 1, -1, 3 }, { 6, 0, 2, 3, 3, 6 },
+            { 0x06, 0x07, 0x10, 0x11 } },
+    { "TIM4", TIM4_BASE, 1, { 0, 1, 2, -1 }, { 1, 4, 5, 0, 7, 0 },
+            { 0x16, 0x17, 0x18, 0x19 } },
+};
+
+static timer_state_t g_timers[kTimerCount];
+static uint64_t g_timer_last_ns = 0;
+
+static TIM_TypeDef *tim(uint8_t n)
+{
+    return SIM_REG(TIM_TypeDef, kTimers[n].base);
+}
+
+static volatile uint16_t *ccr(uint8_t n, uint8_t ch)
+{
+    return &(&tim(n)->CCR1)[ch * 2];
+}
+
+static uint32_t ccmr(uint8_t n, uint8_t ch)
+{
+    const TIM_TypeDef *t = tim(n);
+
+    return ((ch < 2 ? t->CCMR1 : t->CCMR2) >> ((ch % 2) * 8)) & 0xFF;
+}
+
+static uint32_t slave_mode(uint8_t n)
+{
+    return tim(n)->SMCR & TIM_SMCR_SMS;
+}
+
+static void dma(uint8_t n, uint8_t source)
+{
+    if (kTimers[n].dma[source] != 0)
+    {
+        sim_dma_request(kTimers[n].dma[source]);
+    }
+}
+
+static void update_event(uint8_t n, bool from_ug)
+{
+    TIM_TypeDef *t = tim(n);
+
+    if ((t->CR1 & TIM_CR1_UDIS) != 0 && !from_ug)
+    {
+        return;
+    }
+    g_timers[n].psc = t->PSC;
+    if ((t->CR2 & TIM_CR2_MMS) == TIM_CR2_MMS_1)
+    {
+        g_timers[n].trgo++;
+    }
+    if (from_ug && (t->CR1 & TIM_CR1_URS) != 0)
+    {
+        return;
+    }
+    t->SR |= TIM_SR_UIF;
+    if ((t->DIER & TIM_DIER_UDE) != 0)
+    {
+        dma(n, kDmaUp);
+    }
+    if ((t->CR1 & TIM_CR1_OPM) != 0 && !from_ug)
+    {
+        t->CR1 &= ~TIM_CR1_CEN;
+    }
+}
+
+// 捕捉 / 比較事件：設定旗標、必要時送出 DMA request
+static void cc_event(uint8_t n, uint8_t ch)
+{
+    TIM_TypeDef *t = tim(n);
+    uint16_t flag = TIM_SR_CC1IF << ch;
+
+    if ((ccmr(n, ch) & TIM_CCMR1_CC1S) != 0)
+    {
+        if ((t->SR & flag) != 0)
+        {
+            t->SR |= TIM_SR_CC1OF << ch;
+        }
+        *ccr(n, ch) = t->CNT;
+    }
+    t->SR |= flag;
+    if ((t->DIER & (TIM_DIER_CC1DE << ch)) != 0)
+    {
+        dma(n, ch);
+    }
+}
+
+// 計數器經過 (from, to] 時的比較事件
+static void compare_range(uint8_t n, uint32_t from, uint32_t to)
+{
+    for (uint8_t ch = 0; ch < kChannels; ch++)
+    {
+        uint32_t value = *ccr(n, ch);
+
+        if ((ccmr(n, ch) & TIM_CCMR1_CC1S) == 0 && value > from && value <= to)
+        {
+            cc_event(n, ch);
+        }
+    }
+}
+
+// 計數 clocks 個計數時脈 (預分頻之前)
+static void count(uint8_t n, uint64_t clocks)
+{
+    TIM_TypeDef *t = tim(n);
+    timer_state_t *state = &g_timers[n];
+
+    while (clocks > 0 && (t->CR1 & TIM_CR1_CEN) != 0)
+    {
+        uint32_t period = state->psc + 1U;
+        uint32_t arr = t->ARR;
+        uint32_t cnt = t->CNT;
+
+        if (arr == 0)
+        {
+            return; // ARR = 0 時計數器停住
+        }
+        // CNT 超過 ARR 時會一路數到 0xFFFF 後歸零
+        uint32_t steps = cnt <= arr ? arr - cnt + 1 : 0x10000 - cnt;
+        uint64_t needed = (uint64_t) steps * period - state->psc_count;
+
+        if (clocks < needed)
+        {
+            uint64_t total = state->psc_count + clocks;
+            uint32_t next = cnt + (uint32_t) (total / period);
+
+            state->psc_count = total % period;
+            compare_range(n, cnt, next);
+            t->CNT = next;
+            return;
+        }
+        clocks -= needed;
+        state->psc_count = 0;
+        compare_range(n, cnt, cnt <= arr ? arr : 0xFFFF);
+        t->CNT = 0;
+        update_event(n, false);
+        for (uint8_t ch = 0; ch < kChannels; ch++)
+        {
+            if ((ccmr(n, ch) & TIM_CCMR1_CC1S) == 0 && *ccr(n, ch) == 0)
+            {
+                cc_event(n, ch);
+            }
+        }
+        if (clocks > 4 * (uint64_t) (arr + 1) * period
+                && (t->DIER & 0x7F00) == 0)
+        {
+            // 沒有 DMA 時中間數圈只留下旗標
+            clocks %= (uint64_t) (arr + 1) * period;
+        }
+    }
+}
+
+static void timer_advance(uint64_t now_ns)
+{
+    uint64_t dt = now_ns - g_timer_last_ns;
+
+    g_timer_last_ns = now_ns;
+    for (uint8_t n = 0; n < kTimerCount; n++)
+    {
+        g_timers[n].trgo = 0;
+    }
+    // 先推進以內部時脈計數的計時器，再把 TRGO 交給從計時器
+    for (uint8_t n = 0; n < kTimerCount; n++)
+    {
+        uint64_t clocks = sim_clocks(&g_timers[n].clock_rem, dt,
+                sim_rcc_timclk(kTimers[n].apb));
+
+        if (slave_mode(n) != TIM_SMCR_SMS)
+        {
+            count(n, clocks);
+        }
+    }
+    for (uint8_t n = 0; n < kTimerCount; n++)
+    {
+        if (slave_mode(n) == TIM_SMCR_SMS)
+        {
+            int8_t master = kTimers[n].itr[(tim(n)->SMCR & TIM_SMCR_TS) >> 4];
+
+            if (master >= 0 && g_timers[master].trgo > 0)
+            {
+                count(n, g_timers[master].trgo);
+            }
+        }
+    }
+}
+
+// 從 CNT 數到 value 需要的計數時脈
+static uint64_t clocks_to(uint8_t n, uint32_t value)
+{
+    const TIM_TypeDef *t = tim(n);
+    uint32_t cnt = t->CNT;
+    uint32_t arr = t->ARR;
+    uint32_t steps;
+
+    if (value > cnt && value <= arr)
+    {
+        steps = value - cnt;
+    }
+    else
+    {
+        steps = (cnt <= arr ? arr - cnt + 1 : 0x10000 - cnt) + value;
+    }
+    return (uint64_t) steps * (g_timers[n].psc + 1U) - g_timers[n].psc_count;
+}
+
+static uint64_t timer_next_event(uint64_t now_ns)
+{
+    uint64_t next = kSimNever;
+
+    for (uint8_t n = 0; n < kTimerCount; n++)
+    {
+        const TIM_TypeDef *t = tim(n);
+        uint64_t clocks = UINT64_MAX;
+
+        if ((t->CR1 & TIM_CR1_CEN) == 0 || t->ARR == 0
+                || slave_mode(n) == TIM_SMCR_SMS)
+        {
+            continue;
+        }
+        if ((t->DIER & (TIM_DIER_UIE | TIM_DIER_UDE)) != 0)
+        {
+            clocks = clocks_to(n, 0);
+        }
+        for (uint8_t ch = 0; ch < kChannels; ch++)
+        {
+            uint16_t enable = (TIM_DIER_CC1IE | TIM_DIER_CC1DE) << ch;
+
+            if ((t->DIER & enable) != 0 && (ccmr(n, ch) & TIM_CCMR1_CC1S) == 0)
+            {
+                uint64_t c = clocks_to(n, *ccr(n, ch));
+                clocks = c < clocks ? c : clocks;
+            }
+        }
+        if (clocks != UINT64_MAX)
+        {
+            uint64_t t_ns = now_ns + sim_clocks_to_ns(clocks,
+                    sim_rcc_timclk(kTimers[n].apb));
+            next = t_ns < next ? t_ns : next;
+        }
+    }
+    return next;
+}
+
+static void on_input(uint8_t port, uint8_t pin, bool level, uintptr_t arg)
+{
+    uint8_t n = arg >> 2;
+    uint8_t input = arg & 3;
+    const TIM_TypeDef *t = tim(n);
+
+    (void) port;
+    (void) pin;
+    for (uint8_t ch = 0; ch < kChannels; ch++)
+    {
+        uint32_t select = ccmr(n, ch) & TIM_CCMR1_CC1S;
+        bool falling = (t->CCER & (TIM_CCER_CC1P << (ch * 4))) != 0;
+
+        // CCxS = 01 接 TIx，10 接同組的另一個輸入 (TI1 <-> TI2、TI3 <-> TI4)
+        if ((t->CCER & (TIM_CCER_CC1E << (ch * 4))) == 0
+                || (select == 1 && input != ch)
+                || (select == 2 && input != (ch ^ 1))
+                || (select != 1 && select != 2) || level == falling)
+        {
+            continue;
+        }
+        cc_event(n, ch);
+    }
+}
+
+static void trace_pulse(uint8_t n, uint8_t ch)
+{
+    const TIM_TypeDef *t = tim(n);
+    uint32_t mode = (ccmr(n, ch) & TIM_CCMR1_OC1M) >> 4;
+    uint16_t value = *ccr(n, ch);
+    uint32_t hz = sim_rcc_timclk(kTimers[n].apb);
+
+    if ((mode != 6 && mode != 7) || value == g_timers[n].traced_ccr[ch])
+    {
+        return;
+    }
+    g_timers[n].traced_ccr[ch] = value;
+    sim_log("%s CH%u pulse %u/%u (%llu us)", kTimers[n].name, ch + 1U,
+            (unsigned) value, t->ARR + 1U,
+            (unsigned long long) value * (t->PSC + 1U) * 1000000ULL / hz);
+}
+
+static void timer_after_read(uint8_t n, uint32_t offset)
+{
+    if (offset >= kOffCcr1 && offset <= kOffCcr4)
+    {
+        uint8_t ch = (offset - kOffCcr1) / 4;
+
+        // 輸入捕捉時讀取 CCRx 會清除 CCxIF
+        if ((ccmr(n, ch) & TIM_CCMR1_CC1S) != 0)
+        {
+            tim(n)->SR &= ~(TIM_SR_CC1IF << ch);
+        }
+    }
+}
+
+static void timer_write(uint8_t n, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    TIM_TypeDef *t = tim(n);
+
+    switch (offset)
+    {
+    case kOffSr: // rc_w0
+        t->SR = old & value;
+        break;
+    case kOffEgr:
+        t->EGR = 0;
+        if ((value & TIM_EGR_UG) != 0)
+        {
+            t->CNT = 0;
+            g_timers[n].psc_count = 0;
+            update_event(n, true);
+        }
+        for (uint8_t ch = 0; ch < kChannels; ch++)
+        {
+            if ((value & (TIM_EGR_CC1G << ch)) != 0)
+            {
+                cc_event(n, ch);
+            }
+        }
+        if ((value & TIM_EGR_TG) != 0)
+        {
+            t->SR |= TIM_SR_TIF;
+            if ((t->DIER & TIM_DIER_TDE) != 0)
+            {
+                dma(n, kDmaTrig);
+            }
+        }
+        break;
+    default:
+        if (offset >= kOffCcr1 && offset <= kOffCcr4
+                && (g_sim_trace & SIM_TRACE_PWM) != 0)
+        {
+            trace_pulse(n, (offset - kOffCcr1) / 4);
+        }
+        break;
+    }
+}
+
+static uint64_t timer_irq_levels(void)
+{
+    uint64_t levels = 0;
+
+    for (uint8_t n = 0; n < kTimerCount; n++)
+    {
+        const TIM_TypeDef *t = tim(n);
+        uint32_t active = t->SR & t->DIER & 0xFF;
+
+        if (n == 0)
+        {
+            levels |= (active & TIM_SR_BIF) != 0 ? 1ULL << TIM1_BRK_IRQn : 0;
+            levels |= (active & TIM_SR_UIF) != 0 ? 1ULL << TIM1_UP_IRQn : 0;
+            levels |= (active & (TIM_SR_TIF | TIM_SR_COMIF)) != 0 ?
+                    1ULL << TIM1_TRG_COM_IRQn : 0;
+            levels |= (active & 0x1E) != 0 ? 1ULL << TIM1_CC_IRQn : 0;
+        }
+        else if (active != 0)
+        {
+            levels |= 1ULL << (TIM2_IRQn + n - 1);
+        }
+    }
+    return levels;
+}
+
+static void timer_reset(void)
+{
+    for (uint8_t n = 0; n < kTimerCount; n++)
+    {
+        tim(n)->ARR = 0xFFFF;
+        g_timers[n] = (timer_state_t) { 0 };
+        for (uint8_t ch = 0; ch < kChannels; ch++)
+        {
+            uint8_t pin = kTimers[n].pins[ch];
+            sim_gpio_watch(pin >> 4, pin & 0xF, on_input, (n << 2) | ch);
+        }
+    }
+}
+
+static const sim_block_t kTimerBlocks[] =
+{
+    { "TIM1", TIM1_BASE, 0x400, 0, NULL, timer_after_read, timer_write },
+    { "TIM2", TIM2_BASE, 0x400, 1, NULL, timer_after_read, timer_write },
+    { "TIM3", TIM3_BASE, 0x400, 2, NULL, timer_after_read, timer_write },
+    { "TIM4", TIM4_BASE, 0x400, 3, NULL, timer_after_read, timer_write },
+};
+
+const sim_device_t sim_timer_device =
+{
+    "TIM", kTimerBlocks, kTimerCount, timer_reset, timer_advance,
+    timer_next_event, timer_irq_levels, NULL
+};
@@ -0,0 +1,327 @@
+/*
+ * USART1 模型
+ *
+ * 字元時間 = 位元數 x BRR / PCLK2。傳送端有 TDR 與移位暫存器兩級，
+ * 移出的位元組寫到輸出檔；接收端從情境檔注入的佇列逐字元收進 DR，
+ * 前一筆未讀時設定 ORE 並丟棄新資料，佇列收完後再過一個字元時間設定 IDLE。
+ * 讀 SR 再讀 DR 的順序會清除 IDLE / ORE，與硬體相同。
+ * 送出的位元組另外保留一份，給情境檔的 expect 比對。
+ */
+
+#define _GNU_SOURCE // memmem
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define kRxQueueSize 4096
+#define kCaptureSize 65536
+
+#define kSrOre (1U << 3)
+#define kSrIdle (1U << 4)
+#define kSrRxne (1U << 5)
+#define kSrTc (1U << 6)
+#define kSrTxe (1U << 7)
+
+static int g_output_fd = STDOUT_FILENO;
+static uint32_t g_sent = 0;
+static uint8_t g_capture[kCaptureSize]; // 上次 expect 符合之後送出的位元組
+static size_t g_capture_len = 0;
+
+static bool g_tx_busy = false;  // 移位暫存器傳送中
+static bool g_tdr_full = false;
+static uint8_t g_tx_shift = 0;
+static uint8_t g_tdr = 0;
+
+static uint8_t g_rx_queue[kRxQueueSize];
+static uint16_t g_rx_head = 0;
+static uint16_t g_rx_tail = 0;
+static bool g_rx_busy = false;
+static uint8_t g_rdr = 0;
+static uint32_t g_rx_generation = 0; // 有新字元時作廢尚未到期的 IDLE
+static bool g_sr_read = false;       // 清除 IDLE / ORE 的讀取順序
+
+static USART_TypeDef *usart(void)
+{
+    return SIM_REG(USART_TypeDef, USART1_BASE);
+}
+
+void sim_usart_set_output(int fd)
+{
+    g_output_fd = fd;
+}
+
+uint32_t sim_usart_sent(void)
+{
+    return g_sent;
+}
+
+bool sim_usart_expect(const char *text)
+{
+    size_t len = strlen(text);
+    const uint8_t *found = memmem(g_capture, g_capture_len, text, len);
+
+    if (found == NULL)
+    {
+        return false;
+    }
+    // 符合的部分與之前的輸出不再參與比對，下一個 expect 只看之後的輸出
+    size_t used = (size_t) (found - g_capture) + len;
+    g_capture_len -= used;
+    memmove(g_capture, g_capture + used, g_capture_len);
+    return true;
+}
+
+static void capture(uint8_t data)
+{
+    if (g_capture_len == kCaptureSize)
+    {
+        // 太久沒有 expect：丟掉較舊的一半
+        g_capture_len = kCaptureSize / 2;
+        memmove(g_capture, g_capture + kCaptureSize / 2, g_capture_len);
+    }
+    g_capture[g_capture_len++] = data;
+}
+
+static uint64_t char_ns(void)
+{
+    const USART_TypeDef *u = usart();
+    uint32_t bits = 1 + ((u->CR1 & USART_CR1_M) != 0 ? 9 : 8)
+            + ((u->CR2 & USART_CR2_STOP) == USART_CR2_STOP_1 ? 2 : 1);
+
+    return sim_clocks_to_ns((uint64_t) bits * (u->BRR & 0xFFFF), sim_rcc_pclk(2));
+}
+
+static bool enabled(uint32_t direction)
+{
+    uint32_t mask = USART_CR1_UE | direction;
+
+    return (usart()->CR1 & mask) == mask;
+}
+
+static void usart_dma_poll(void)
+{
+    const USART_TypeDef *u = usart();
+
+    if ((u->CR3 & USART_CR3_DMAT) != 0 && (u->SR & kSrTxe) != 0
+            && enabled(USART_CR1_TE))
+    {
+        sim_dma_request(4);
+    }
+    if ((u->CR3 & USART_CR3_DMAR) != 0 && (u->SR & kSrRxne) != 0)
+    {
+        sim_dma_request(5);
+    }
+}
+
+// ------------------------------------------------------------
+// 傳送
+// ------------------------------------------------------------
+
+static void tx_done(uintptr_t arg);
+
+static void tx_start(uint8_t data)
+{
+    g_tx_busy = true;
+    g_tx_shift = data;
+    usart()->SR &= ~kSrTc;
+    sim_schedule(sim_now() + char_ns(), tx_done, 0);
+}
+
+static void tx_done(uintptr_t arg)
+{
+    uint8_t data = g_tx_shift;
+
+    (void) arg;
+    while (write(g_output_fd, &data, 1) < 0 && errno == EINTR)
+    {
+    }
+    g_sent++;
+    capture(data);
+    if ((g_sim_trace & SIM_TRACE_USART) != 0)
+    {
+        sim_log("USART1 tx %02X", data);
+    }
+    g_tx_busy = false;
+    if (g_tdr_full)
+    {
+        g_tdr_full = false;
+        usart()->SR |= kSrTxe;
+        tx_start(g_tdr);
+        usart_dma_poll();
+    }
+    else
+    {
+        usart()->SR |= kSrTc;
+    }
+}
+
+static void tx_write(uint8_t data)
+{
+    if (!enabled(USART_CR1_TE))
+    {
+        return;
+    }
+    if (!g_tx_busy)
+    {
+        tx_start(data);
+        usart_dma_poll(); // TDR 仍是空的
+    }
+    else if (!g_tdr_full)
+    {
+        g_tdr_full = true;
+        g_tdr = data;
+        usart()->SR &= ~kSrTxe;
+    }
+}
+
+// ------------------------------------------------------------
+// 接收
+// ------------------------------------------------------------
+
+static void rx_idle(uintptr_t generation)
+{
+    if (generation == g_rx_generation && enabled(USART_CR1_RE))
+    {
+        usart()->SR |= kSrIdle;
+    }
+}
+
+static void rx_done(uintptr_t arg)
+{
+    USART_TypeDef *u = usart();
+    uint8_t data = g_rx_queue[g_rx_head];
+
+    (void) arg;
+    g_rx_head = (g_rx_head + 1) % kRxQueueSize;
+    if (enabled(USART_CR1_RE))
+    {
+        if ((g_sim_trace & SIM_TRACE_USART) != 0)
+        {
+            sim_log("USART1 rx %02X", data);
+        }
+        if ((u->SR & kSrRxne) != 0)
+        {
+            u->SR |= kSrOre;
+        }
+        else
+        {
+            g_rdr = data;
+            u->SR |= kSrRxne;
+            usart_dma_poll();
+        }
+    }
+    g_rx_generation++;
+    if (g_rx_head != g_rx_tail)
+    {
+        sim_schedule(sim_now() + char_ns(), rx_done, 0);
+    }
+    else
+    {
+        g_rx_busy = false;
+        sim_schedule(sim_now() + char_ns(), rx_idle, g_rx_generation);
+    }
+}
+
+void sim_usart_inject(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        uint16_t next = (g_rx_tail + 1) % kRxQueueSize;
+        if (next == g_rx_head)
+        {
+            sim_fatal("USART1 receive queue full");
+        }
+        g_rx_queue[g_rx_tail] = data[i];
+        g_rx_tail = next;
+    }
+    if (!g_rx_busy && g_rx_head != g_rx_tail)
+    {
+        g_rx_busy = true;
+        g_rx_generation++;
+        sim_schedule(sim_now() + char_ns(), rx_done, 0);
+    }
+}
+
+// ------------------------------------------------------------
+// 暫存器
+// ------------------------------------------------------------
+
+static void usart_read(uint8_t unit, uint32_t offset)
+{
+    (void) unit;
+    if (offset == 0x04) // DR 讀到的是接收資料
+    {
+        usart()->DR = g_rdr;
+    }
+}
+
+static void usart_after_read(uint8_t unit, uint32_t offset)
+{
+    USART_TypeDef *u = usart();
+
+    (void) unit;
+    if (offset == 0x00)
+    {
+        g_sr_read = true;
+    }
+    else if (offset == 0x04)
+    {
+        u->SR &= ~(kSrRxne | (g_sr_read ? kSrIdle | kSrOre : 0));
+        g_sr_read = false;
+    }
+}
+
+static void usart_write(uint8_t unit, uint32_t offset, uint32_t old,
+        uint32_t value)
+{
+    USART_TypeDef *u = usart();
+
+    (void) unit;
+    switch (offset)
+    {
+    case 0x00: // SR：只有 RXNE、TC 可寫 0 清除
+        u->SR = old & (value | ~(kSrRxne | kSrTc));
+        break;
+    case 0x04: // DR
+        u->DR = g_rdr;
+        tx_write(value & 0xFF);
+        break;
+    case 0x14: // CR3
+        usart_dma_poll();
+        break;
+    default:
+        break;
+    }
+    g_sr_read = false;
+}
+
+static uint64_t usart_irq_levels(void)
+{
+    const USART_TypeDef *u = usart();
+    uint32_t active = u->SR & u->CR1 & (kSrTxe | kSrTc | kSrRxne | kSrIdle);
+
+    if ((u->SR & kSrOre) != 0 && (u->CR1 & USART_CR1_RXNEIE) != 0)
+    {
+        active |= kSrOre;
+    }
+    return active != 0 ? 1ULL << USART1_IRQn : 0;
+}
+
+static void usart_reset(void)
+{
+    usart()->SR = kSrTxe | kSrTc;
+}
+
+static const sim_block_t kUsartBlocks[] =
+{
+    { "USART1", USART1_BASE, 0x400, 0, usart_read, usart_after_read,
+            usart_write },
+};
+
+const sim_device_t sim_usart_device =
+{
+    "USART1", kUsartBlocks, 1, usart_reset, NULL, NULL, usart_irq_levels,
+    usart_dma_poll
+};
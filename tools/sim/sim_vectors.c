@@ -0,0 +1,156 @@
+/*
+ * 中斷向量表
+ *
+ * 與 startup_stm32f103c8tx.s 相同，所有 handler 預設為 weak，
+ * 韌體有定義的會取代預設值。觸發了沒有 handler 的中斷視為錯誤。
+ */
+
+#include "sim.h"
+
+static void default_handler(void);
+
+#define WEAK_HANDLER(name) \
+    void name(void) __attribute__((weak, alias("default_handler")))
+
+WEAK_HANDLER(SysTick_Handler);
+WEAK_HANDLER(WWDG_IRQHandler);
+WEAK_HANDLER(PVD_IRQHandler);
+WEAK_HANDLER(TAMPER_IRQHandler);
+WEAK_HANDLER(RTC_IRQHandler);
+WEAK_HANDLER(FLASH_IRQHandler);
+WEAK_HANDLER(RCC_IRQHandler);
+WEAK_HANDLER(EXTI0_IRQHandler);
+WEAK_HANDLER(EXTI1_IRQHandler);
+WEAK_HANDLER(EXTI2_IRQHandler);
+WEAK_HANDLER(EXTI3_IRQHandler);
+WEAK_HANDLER(EXTI4_IRQHandler);
+WEAK_HANDLER(DMA1_Channel1_IRQHandler);
+WEAK_HANDLER(DMA1_Channel2_IRQHandler);
+WEAK_HANDLER(DMA1_Channel3_IRQHandler);
+WEAK_HANDLER(DMA1_Channel4_IRQHandler);
+WEAK_HANDLER(DMA1_Channel5_IRQHandler);
+WEAK_HANDLER(DMA1_Channel6_IRQHandler);
+WEAK_HANDLER(DMA1_Channel7_IRQHandler);
+WEAK_HANDLER(ADC1_2_IRQHandler);
+WEAK_HANDLER(USB_HP_CAN_TX_IRQHandler);
+WEAK_HANDLER(USB_LP_CAN_RX0_IRQHandler);
+WEAK_HANDLER(CAN_RX1_IRQHandler);
+WEAK_HANDLER(CAN_SCE_IRQHandler);
+WEAK_HANDLER(EXTI9_5_IRQHandler);
+WEAK_HANDLER(TIM1_BRK_IRQHandler);
+WEAK_HANDLER(TIM1_UP_IRQHandler);
+WEAK_HANDLER(TIM1_TRG_COM_IRQHandler);
+WEAK_HANDLER(TIM1_CC_IRQHandler);
+WEAK_HANDLER(TIM2_IRQHandler);
+WEAK_HANDLER(TIM3_IRQHandler);
+WEAK_HANDLER(TIM4_IRQHandler);
+WEAK_HANDLER(I2C1_EV_IRQHandler);
+WEAK_HANDLER(I2C1_ER_IRQHandler);
+WEAK_HANDLER(I2C2_EV_IRQHandler);
+WEAK_HANDLER(I2C2_ER_IRQHandler);
+WEAK_HANDLER(SPI1_IRQHandler);
+WEAK_HANDLER(SPI2_IRQHandler);
+WEAK_HANDLER(USART1_IRQHandler);
+WEAK_HANDLER(USART2_IRQHandler);
+WEAK_HANDLER(USART3_IRQHandler);
+WEAK_HANDLER(EXTI15_10_IRQHandler);
+WEAK_HANDLER(RTCAlarm_IRQHandler);
+
+const sim_handler_t kSimVectors[kSimIrqCount] =
+{
+    WWDG_IRQHandler,
+    PVD_IRQHandler,
+    TAMPER_IRQHandler,
+    RTC_IRQHandler,
+    FLASH_IRQHandler,
+    RCC_IRQHandler,
+    EXTI0_IRQHandler,
+    EXTI1_IRQHandler,
+    EXTI2_IRQHandler,
+    EXTI3_IRQHandler,
+    EXTI4_IRQHandler,
+    DMA1_Channel1_IRQHandler,
+    DMA1_Channel2_IRQHandler,
+    DMA1_Channel3_IRQHandler,
+    DMA1_Channel4_IRQHandler,
+    DMA1_Channel5_IRQHandler,
+    DMA1_Channel6_IRQHandler,
+    DMA1_Channel7_IRQHandler,
+    ADC1_2_IRQHandler,
+    USB_HP_CAN_TX_IRQHandler,
+    USB_LP_CAN_RX0_IRQHandler,
+    CAN_RX1_IRQHandler,
+    CAN_SCE_IRQHandler,
+    EXTI9_5_IRQHandler,
+    TIM1_BRK_IRQHandler,
+    TIM1_UP_IRQHandler,
+    TIM1_TRG_COM_IRQHandler,
+    TIM1_CC_IRQHandler,
+    TIM2_IRQHandler,
+    TIM3_IRQHandler,
+    TIM4_IRQHandler,
+    I2C1_EV_IRQHandler,
+    I2C1_ER_IRQHandler,
+    I2C2_EV_IRQHandler,
+    I2C2_ER_IRQHandler,
+    SPI1_IRQHandler,
+    SPI2_IRQHandler,
+    USART1_IRQHandler,
+    USART2_IRQHandler,
+    USART3_IRQHandler,
+    EXTI15_10_IRQHandler,
+    RTCAlarm_IRQHandler,
+    NULL, // 42: 保留
+};
+
+const char *const kSimVectorNames[kSimIrqCount] =
+{
+    "WWDG",
+    "PVD",
+    "TAMPER",
+    "RTC",
+    "FLASH",
+    "RCC",
+    "EXTI0",
+    "EXTI1",
+    "EXTI2",
+    "EXTI3",
+    "EXTI4",
+    "DMA1_Channel1",
+    "DMA1_Channel2",
+    "DMA1_Channel3",
+    "DMA1_Channel4",
+    "DMA1_Channel5",
+    "DMA1_Channel6",
+    "DMA1_Channel7",
+    "ADC1_2",
+    "USB_HP_CAN_TX",
+    "USB_LP_CAN_RX0",
+    "CAN_RX1",
+    "CAN_SCE",
+    "EXTI9_5",
+    "TIM1_BRK",
+    "TIM1_UP",
+    "TIM1_TRG_COM",
+    "TIM1_CC",
+    "TIM2",
+    "TIM3",
+    "TIM4",
+    "I2C1_EV",
+    "I2C1_ER",
+    "I2C2_EV",
+    "I2C2_ER",
+    "SPI1",
+    "SPI2",
+    "USART1",
+    "USART2",
+    "USART3",
+    "EXTI15_10",
+    "RTCAlarm",
+    "reserved",
+};
+
+static void default_handler(void)
+{
+    sim_fatal("interrupt without a handler");
+}
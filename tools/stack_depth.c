@@ -0,0 +1,686 @@
+/*
+ * 最壞情況 stack 深度分析 (Linux / MSYS)
+ *
+ * 以反組譯建立呼叫圖，配合 gcc -fstack-usage 的 .su 算出每個進入點
+ * 最深的呼叫鏈，再依 NVIC 優先權加上中斷巢狀的深度：
+ *   - 呼叫圖：arm-none-eabi-objdump -d 的 bl / blx 與跳到其他函式開頭的 b (tail call)
+ *   - stack frame：.su 的數值；沒有 .su 的函式 (組合語言、newlib) 由開頭的
+ *     push / sub sp 推算
+ *   - 進入點：Reset_Handler (thread mode) 與所有 *_Handler / *_IRQHandler
+ *   - 巢狀：只有優先權數值較小的中斷能搶占，同一優先權的中斷不會互相巢狀；
+ *     每一層加上硬體推入的 exception frame
+ *
+ * 用法:
+ *   objdump -d 5.elf | stack_depth [-s stack 預留] [-p 中斷=優先權 ...]
+ *                                  [-t 進入點] - [*.su ...]
+ *   stack_depth ... 反組譯檔 [*.su ...]
+ *
+ * -p 必須與程式裡的 NVIC_SetPriority 一致；沒列出的中斷是重置值 0，
+ * NMI_Handler、HardFault_Handler 固定為 -2、-1。
+ * 有 -s 時，最壞情況超過 stack 預留或呼叫圖有遞迴時回傳 3，作為建置檢查。
+ *
+ * 限制：
+ *   - 函式指標 (blx rN) 無法追蹤，只在報告中列出
+ *   - 含 alloca / VLA 的函式 (.su 的 dynamic) 只算 .su 的數值
+ *   - 在主機上測試時也接受 x86-64 objdump 的 call / jmp
+ *
+ * 編譯:
+ *   cc -O2 -o stack_depth stack_depth.c
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kMaxFunctions 4096
+#define kMaxCalls 16384
+#define kMaxPriorities 64
+#define kMaxName 96
+#define kMaxPath 12
+#define kPrologueLength 6     // 只看函式開頭幾個指令推算 frame
+#define kExceptionFrame 32    // r0-r3, r12, lr, pc, xPSR
+#define kExceptionAlign 4     // STKALIGN：推入前可能多保留 4 bytes 對齊
+#define kUnknown (-1)
+#define kExitOverBudget 3
+
+typedef enum
+{
+    VISIT_NONE = 0,
+    VISIT_ACTIVE,
+    VISIT_DONE
+} visit_t;
+
+typedef struct
+{
+    char name[kMaxName];
+    unsigned long addr;
+    long su_frame;        // kUnknown: 沒有 .su 資料
+    bool dynamic;
+    long prologue_frame;  // 由 push / sub sp 推算
+    int prologue_count;   // 已檢查的開頭指令數
+    bool prologue_done;
+    bool indirect;        // 有無法追蹤的函式指標呼叫
+    int first_call;       // g_calls 中的起點 (排序後)
+    int call_count;
+
+    visit_t visit;
+    long depth;           // 含自己的最深呼叫鏈
+    int next;             // 最深呼叫鏈的下一個函式，-1: 無
+    int cycle;            // 呼叫鏈上重複進入的函式，-1: 無遞迴
+    bool reaches_indirect;
+} function_t;
+
+typedef struct
+{
+    unsigned long caller_addr;
+    unsigned long target;
+    int caller;
+    int callee;           // 解析後的函式，-1: 不在反組譯中
+    bool tail;            // b / jmp：跳回自己的開頭是迴圈，不是遞迴
+} call_t;
+
+typedef struct
+{
+    char name[kMaxName];
+    int priority;
+    bool used;
+} priority_t;
+
+static function_t g_functions[kMaxFunctions];
+static int g_function_count;
+static call_t g_calls[kMaxCalls];
+static int g_call_count;
+static priority_t g_priorities[kMaxPriorities];
+static int g_priority_count;
+
+static bool ends_with(const char *str, const char *suffix)
+{
+    size_t len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+static int find_function(const char *name)
+{
+    for (int i = 0; i < g_function_count; i++)
+    {
+        if (strcmp(g_functions[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 包含 addr 的函式 (g_functions 依位址排序)
+static int function_at(unsigned long addr)
+{
+    int low = 0;
+    int high = g_function_count - 1;
+    int found = -1;
+
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        if (g_functions[mid].addr <= addr)
+        {
+            found = mid;
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    return found;
+}
+
+static void add_function(unsigned long addr, const char *name)
+{
+    if (g_function_count == kMaxFunctions)
+    {
+        fprintf(stderr, "too many functions (max %d)\n", kMaxFunctions);
+        exit(1);
+    }
+    function_t *fn = &g_functions[g_function_count++];
+    memset(fn, 0, sizeof(*fn));
+    snprintf(fn->name, sizeof(fn->name), "%s", name);
+    fn->addr = addr;
+    fn->su_frame = kUnknown;
+    fn->next = -1;
+    fn->cycle = -1;
+}
+
+static void add_call(const function_t *caller, unsigned long target, bool tail)
+{
+    if (g_call_count == kMaxCalls)
+    {
+        fprintf(stderr, "too many calls (max %d)\n", kMaxCalls);
+        exit(1);
+    }
+    g_calls[g_call_count].caller_addr = caller->addr;
+    g_calls[g_call_count].target = target;
+    g_calls[g_call_count].caller = -1;
+    g_calls[g_call_count].callee = -1;
+    g_calls[g_call_count].tail = tail;
+    g_call_count++;
+}
+
+// b, b.n, b.w, beq, bne.n ... (不含 bl / bx / bic 等)
+static bool is_arm_branch(const char *mnemonic)
+{
+    static const char *const kConditions[] = {
+        "", "eq", "ne", "cs", "cc", "hs", "lo", "mi", "pl", "vs", "vc",
+        "hi", "ls", "ge", "lt", "gt", "le", "al"
+    };
+    char cond[8];
+
+    if (mnemonic[0] != 'b' || strlen(mnemonic) >= sizeof(cond) + 1)
+    {
+        return false;
+    }
+    snprintf(cond, sizeof(cond), "%s", mnemonic + 1);
+    char *width = strchr(cond, '.');
+    if (width != NULL)
+    {
+        if (strcmp(width, ".n") != 0 && strcmp(width, ".w") != 0)
+        {
+            return false;
+        }
+        *width = '\0';
+    }
+    for (size_t i = 0; i < sizeof(kConditions) / sizeof(kConditions[0]); i++)
+    {
+        if (strcmp(cond, kConditions[i]) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_call(const char *mnemonic)
+{
+    return strcmp(mnemonic, "bl") == 0 || strcmp(mnemonic, "blx") == 0
+            || strcmp(mnemonic, "call") == 0 || strcmp(mnemonic, "callq") == 0;
+}
+
+static bool is_branch(const char *mnemonic)
+{
+    return is_arm_branch(mnemonic) || strcmp(mnemonic, "cbz") == 0
+            || strcmp(mnemonic, "cbnz") == 0 || mnemonic[0] == 'j';
+}
+
+// "{r4, r5, r6, lr}" 的暫存器數
+static int count_registers(const char *operands)
+{
+    const char *brace = strchr(operands, '{');
+    int count = 1;
+
+    if (brace == NULL)
+    {
+        return 0;
+    }
+    for (const char *p = brace; *p != '\0' && *p != '}'; p++)
+    {
+        count += *p == ',';
+    }
+    return count;
+}
+
+// 函式開頭的 push / sub sp 累加成 frame，遇到第一個跳躍或呼叫就停止
+static void scan_prologue(function_t *fn, const char *mnemonic,
+        const char *operands)
+{
+    if (fn->prologue_done)
+    {
+        return;
+    }
+    if (strcmp(mnemonic, "push") == 0 || strcmp(mnemonic, "push.w") == 0
+            || (strcmp(mnemonic, "stmdb") == 0 && strncmp(operands, "sp!", 3) == 0))
+    {
+        fn->prologue_frame += 4 * count_registers(operands);
+    }
+    else if ((strncmp(mnemonic, "sub", 3) == 0 || strcmp(mnemonic, "subw") == 0)
+            && strncmp(operands, "sp,", 3) == 0 && strchr(operands, '#') != NULL)
+    {
+        fn->prologue_frame += strtol(strchr(operands, '#') + 1, NULL, 0);
+    }
+    else if (strncmp(mnemonic, "push", 4) == 0 && operands[0] == '%')
+    {
+        fn->prologue_frame += 8; // x86-64
+    }
+    else if (strncmp(mnemonic, "sub", 3) == 0 && ends_with(operands, ",%rsp"))
+    {
+        fn->prologue_frame += strtol(operands + 1, NULL, 0);
+    }
+
+    fn->prologue_count++;
+    if (fn->prologue_count == kPrologueLength || is_call(mnemonic)
+            || is_branch(mnemonic))
+    {
+        fn->prologue_done = true;
+    }
+}
+
+// objdump -d 的兩種行：
+//   "08000124 <main>:"
+//   " 8000126:\tf000 f8a1 \tbl\t800026c <telemetry_send>"
+static void load_disassembly(FILE *file)
+{
+    char line[512];
+    int current = -1;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned long addr;
+        char name[kMaxName];
+        char *end;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        if (sscanf(line, "%lx <%95[^>]>:", &addr, name) == 2 && !isspace((unsigned char) line[0]))
+        {
+            add_function(addr, name);
+            current = g_function_count - 1;
+            continue;
+        }
+        if (current < 0 || !isspace((unsigned char) line[0]))
+        {
+            continue;
+        }
+        addr = strtoul(line, &end, 16);
+        if (end == line || *end != ':')
+        {
+            continue;
+        }
+        // 位址 \t 機器碼 \t 指令
+        char *code = strchr(end, '\t');
+        char *text = code != NULL ? strchr(code + 1, '\t') : NULL;
+        char mnemonic[32];
+        if (text == NULL || sscanf(text, "%31s", mnemonic) != 1)
+        {
+            continue;
+        }
+        char *operands = strstr(text, mnemonic) + strlen(mnemonic);
+        while (isspace((unsigned char) *operands))
+        {
+            operands++;
+        }
+
+        function_t *fn = &g_functions[current];
+        scan_prologue(fn, mnemonic, operands);
+
+        bool call = is_call(mnemonic);
+        if (!call && !is_branch(mnemonic))
+        {
+            continue;
+        }
+        if (call && (operands[0] == 'r' || operands[0] == '*'))
+        {
+            fn->indirect = true; // blx r3 / call *%rax
+            continue;
+        }
+        // cbz r0, 8000130 <foo+0xc>
+        const char *target_text = strrchr(operands, ',');
+        target_text = target_text != NULL && strchr(operands, '<') > target_text
+                ? target_text + 1 : operands;
+        unsigned long target = strtoul(target_text, &end, 16);
+        if (end == target_text || strchr(end, '<') == NULL)
+        {
+            continue;
+        }
+        // 一般的跳躍只有跳到其他函式的開頭才算 tail call
+        if (call || strchr(end, '+') == NULL)
+        {
+            add_call(fn, target, !call);
+        }
+    }
+}
+
+static int by_address(const void *a, const void *b)
+{
+    const function_t *lhs = a;
+    const function_t *rhs = b;
+
+    return (lhs->addr > rhs->addr) - (lhs->addr < rhs->addr);
+}
+
+static int by_caller(const void *a, const void *b)
+{
+    const call_t *lhs = a;
+    const call_t *rhs = b;
+
+    return lhs->caller - rhs->caller;
+}
+
+// 依位址排序函式並把呼叫目標解析成函式索引
+// (反組譯依 section 輸出，位址不一定遞增)
+static void resolve_calls(void)
+{
+    qsort(g_functions, g_function_count, sizeof(g_functions[0]), by_address);
+
+    for (int i = 0; i < g_call_count; i++)
+    {
+        call_t *call = &g_calls[i];
+        call->caller = function_at(call->caller_addr);
+        int callee = function_at(call->target);
+        if (callee != call->caller || !call->tail)
+        {
+            call->callee = callee;
+        }
+    }
+    qsort(g_calls, g_call_count, sizeof(g_calls[0]), by_caller);
+
+    for (int i = g_call_count - 1; i >= 0; i--)
+    {
+        function_t *fn = &g_functions[g_calls[i].caller];
+        fn->first_call = i;
+        fn->call_count++;
+    }
+}
+
+// .su： "../Src/main.c:70:5:main\t64\tstatic"
+// LTO 的 ltrans .su 與反組譯使用相同的名稱 (foo.lto_priv.0、foo.constprop.0)
+static void load_stack_usage(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[512];
+
+    if (file == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *tab = strchr(line, '\t');
+        if (tab == NULL)
+        {
+            continue;
+        }
+        *tab = '\0';
+
+        char *name = strrchr(line, ':');
+        name = name != NULL ? name + 1 : line;
+        long frame = strtol(tab + 1, &tab, 10);
+        bool dynamic = strstr(tab, "dynamic") != NULL;
+
+        // 不同檔案的同名 static 函式無法區分，都取最大值
+        for (int i = 0; i < g_function_count; i++)
+        {
+            function_t *fn = &g_functions[i];
+            if (strcmp(fn->name, name) == 0 && frame > fn->su_frame)
+            {
+                fn->su_frame = frame;
+                fn->dynamic = fn->dynamic || dynamic;
+            }
+        }
+    }
+    fclose(file);
+}
+
+static long frame_of(const function_t *fn)
+{
+    return fn->su_frame != kUnknown ? fn->su_frame : fn->prologue_frame;
+}
+
+static void analyze(int index)
+{
+    function_t *fn = &g_functions[index];
+    long deepest = 0;
+
+    fn->visit = VISIT_ACTIVE;
+    fn->reaches_indirect = fn->indirect;
+    for (int i = 0; i < fn->call_count; i++)
+    {
+        int callee = g_calls[fn->first_call + i].callee;
+        if (callee < 0)
+        {
+            continue;
+        }
+        function_t *child = &g_functions[callee];
+        if (child->visit == VISIT_ACTIVE)
+        {
+            fn->cycle = fn->cycle < 0 ? callee : fn->cycle; // 深度無上限，不再展開
+            continue;
+        }
+        if (child->visit == VISIT_NONE)
+        {
+            analyze(callee);
+        }
+        fn->cycle = fn->cycle < 0 ? child->cycle : fn->cycle;
+        fn->reaches_indirect = fn->reaches_indirect || child->reaches_indirect;
+        if (child->depth > deepest)
+        {
+            deepest = child->depth;
+            fn->next = callee;
+        }
+    }
+    fn->depth = frame_of(fn) + deepest;
+    fn->visit = VISIT_DONE;
+}
+
+static bool is_handler(const function_t *fn)
+{
+    return ends_with(fn->name, "Handler") && strchr(fn->name, '_') != NULL
+            && strcmp(fn->name, "Reset_Handler") != 0;
+}
+
+static int priority_of(const char *name)
+{
+    for (int i = 0; i < g_priority_count; i++)
+    {
+        if (strcmp(g_priorities[i].name, name) == 0)
+        {
+            g_priorities[i].used = true;
+            return g_priorities[i].priority;
+        }
+    }
+    if (strcmp(name, "NMI_Handler") == 0)
+    {
+        return -2;
+    }
+    if (strcmp(name, "HardFault_Handler") == 0)
+    {
+        return -1;
+    }
+    return 0; // NVIC 重置值
+}
+
+static void add_priority(const char *arg)
+{
+    const char *equals = strchr(arg, '=');
+
+    if (equals == NULL || g_priority_count == kMaxPriorities)
+    {
+        fprintf(stderr, "bad priority '%s' (expected Handler=priority)\n", arg);
+        exit(2);
+    }
+    priority_t *entry = &g_priorities[g_priority_count++];
+    snprintf(entry->name, sizeof(entry->name), "%.*s", (int) (equals - arg), arg);
+    entry->priority = (int) strtol(equals + 1, NULL, 0);
+    entry->used = false;
+}
+
+static void print_path(const function_t *fn)
+{
+    int count = 0;
+
+    printf("%s%s", fn->name, fn->su_frame == kUnknown ? "~" : "");
+    while (fn->next >= 0)
+    {
+        fn = &g_functions[fn->next];
+        if (++count == kMaxPath)
+        {
+            printf(" -> ...");
+            break;
+        }
+        printf(" -> %s%s", fn->name, fn->su_frame == kUnknown ? "~" : "");
+    }
+    printf("\n");
+}
+
+static void print_flags(const function_t *fn)
+{
+    if (fn->cycle >= 0)
+    {
+        printf("        recursion through %s: depth is unbounded\n",
+                g_functions[fn->cycle].name);
+    }
+    if (fn->reaches_indirect)
+    {
+        printf("        calls through function pointers are not counted\n");
+    }
+}
+
+static int by_priority_then_depth(const void *a, const void *b)
+{
+    const function_t *lhs = *(const function_t *const *) a;
+    const function_t *rhs = *(const function_t *const *) b;
+    int lhs_priority = priority_of(lhs->name);
+    int rhs_priority = priority_of(rhs->name);
+
+    if (lhs_priority != rhs_priority)
+    {
+        return rhs_priority - lhs_priority; // 最先被搶占的 (數值大) 排前面
+    }
+    return (rhs->depth > lhs->depth) - (rhs->depth < lhs->depth);
+}
+
+int main(int argc, char **argv)
+{
+    const char *thread_entry = NULL;
+    long stack_reserve = kUnknown;
+    int arg = 1;
+
+    for (; arg + 1 < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg += 2)
+    {
+        if (strcmp(argv[arg], "-s") == 0)
+        {
+            stack_reserve = strtol(argv[arg + 1], NULL, 0);
+        }
+        else if (strcmp(argv[arg], "-p") == 0)
+        {
+            add_priority(argv[arg + 1]);
+        }
+        else if (strcmp(argv[arg], "-t") == 0)
+        {
+            thread_entry = argv[arg + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (arg >= argc)
+    {
+        fprintf(stderr, "usage: %s [-s stack_bytes] [-p Handler=priority ...] "
+                "[-t entry] disassembly.txt|- [*.su ...]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *disassembly = strcmp(argv[arg], "-") == 0 ? stdin : fopen(argv[arg], "r");
+    if (disassembly == NULL)
+    {
+        perror(argv[arg]);
+        return 1;
+    }
+    load_disassembly(disassembly);
+    if (disassembly != stdin)
+    {
+        fclose(disassembly);
+    }
+    resolve_calls();
+    for (arg++; arg < argc; arg++)
+    {
+        load_stack_usage(argv[arg]);
+    }
+
+    int thread = -1;
+    if (thread_entry != NULL)
+    {
+        thread = find_function(thread_entry);
+    }
+    else
+    {
+        thread = find_function("Reset_Handler");
+        thread = thread >= 0 ? thread : find_function("main");
+    }
+    if (thread < 0)
+    {
+        fprintf(stderr, "entry point %s not found in disassembly\n",
+                thread_entry != NULL ? thread_entry : "Reset_Handler");
+        return 1;
+    }
+
+    static const function_t *handlers[kMaxFunctions];
+    int handler_count = 0;
+    for (int i = 0; i < g_function_count; i++)
+    {
+        if (g_functions[i].visit == VISIT_NONE)
+        {
+            analyze(i);
+        }
+        if (is_handler(&g_functions[i]))
+        {
+            handlers[handler_count++] = &g_functions[i];
+        }
+    }
+    qsort(handlers, handler_count, sizeof(handlers[0]), by_priority_then_depth);
+
+    const function_t *main_fn = &g_functions[thread];
+    bool recursive = main_fn->cycle >= 0;
+    printf("worst-case stack (bytes; interrupts include the %d-byte exception frame,\n"
+            "  ~ = frame taken from the disassembly, no .su):\n",
+            kExceptionFrame + kExceptionAlign);
+    printf("  thread        %6ld  ", main_fn->depth);
+    print_path(main_fn);
+    print_flags(main_fn);
+
+    // 每個優先權取最深的中斷，各層巢狀相加
+    long total = main_fn->depth;
+    char nesting[512];
+    int used = snprintf(nesting, sizeof(nesting), "thread %ld", main_fn->depth);
+    for (int i = 0; i < handler_count; i++)
+    {
+        const function_t *fn = handlers[i];
+        int priority = priority_of(fn->name);
+        long depth = fn->depth + kExceptionFrame + kExceptionAlign;
+        bool deepest = i == 0 || priority != priority_of(handlers[i - 1]->name);
+
+        printf("  prio %3d      %6ld  ", priority, depth);
+        print_path(fn);
+        print_flags(fn);
+        recursive = recursive || fn->cycle >= 0;
+        if (deepest)
+        {
+            total += depth;
+            if (used < (int) sizeof(nesting))
+            {
+                used += snprintf(nesting + used, sizeof(nesting) - used,
+                        " + %s %ld", fn->name, depth);
+            }
+        }
+    }
+    for (int i = 0; i < g_priority_count; i++)
+    {
+        if (!g_priorities[i].used)
+        {
+            fprintf(stderr, "warning: %s not found in disassembly\n",
+                    g_priorities[i].name);
+        }
+    }
+
+    printf("nesting: %s\n", nesting);
+    if (stack_reserve == kUnknown)
+    {
+        printf("worst case: %ld\n", total);
+        return 0;
+    }
+    printf("worst case: %ld / %ld%s\n", total, stack_reserve,
+            recursive ? " (recursion, unbounded)" : "");
+    return total > stack_reserve || recursive ? kExitOverBudget : 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * 停車場控制器二進位遙測解碼器 (Linux)
+ *
+ * 用法:
+ *   telemetry_decode [裝置或檔案]      預設讀 stdin
+ *
+ * 若輸入是序列埠 (例如 /dev/ttyUSB0) 會自動設定為 9600 8N1 raw。
+ * 每個 frame 輸出一行；CRC 錯誤、序號跳號都會標示出來，
+ * 夾雜在 frame 之間的文字 (指令回覆) 原樣輸出：每收到一行 ('\n') 或
+ * 累積滿 kMaxEncoded 個位元組就輸出，不必等下一個 frame 的分隔符號。
+ *
+ * 編譯:
+ *   cc -O2 -I../projects/common/Inc -I../projects/5/Inc \
+ *      -o telemetry_decode telemetry_decode.c ../projects/common/Src/cobs.c
+ */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "cobs.h"
+#include "telemetry.h"
+
+#define kMaxEncoded 256
+
+static const char *const kGateNames[] = { "closed", "opening", "open", "closing" };
+
+static uint32_t get_u16(const uint8_t *src)
+{
+    return src[0] | (src[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *src)
+{
+    return (uint32_t) src[0] | ((uint32_t) src[1] << 8)
+            | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+// 與 STM32 CRC 周邊相同：逐 32-bit word、MSB first
+static uint32_t stm32_crc32(const uint8_t *data, size_t words)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t w = 0; w < words; w++)
+    {
+        crc ^= get_u32(&data[w * 4]);
+        for (int bit = 0; bit < 32; bit++)
+        {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static const char *gate_name(unsigned state)
+{
+    return state < 4 ? kGateNames[state] : "?";
+}
+
+static bool is_text(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!isprint(data[i]) && data[i] != '\r' && data[i] != '\n')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_text(const uint8_t *data, size_t len)
+{
+    if (!is_text(data, len))
+    {
+        printf("# %zu bytes of noise\n", len);
+        return;
+    }
+    fwrite(data, 1, len, stdout);
+}
+
+// 收到 '\n' 時是否可以先當成文字輸出。編碼後的 frame 第 2 個位元組一定是
+// kTelemetryVersion (不可列印)，所以至少 2 個位元組且全是文字時不會是 frame 的開頭
+static bool is_text_line(const uint8_t *data, size_t len)
+{
+    return len >= 2 && data[len - 1] == '\n' && is_text(data, len);
+}
+
+static void handle_chunk(const uint8_t *data, size_t len)
+{
+    static bool have_seq = false;
+    static uint16_t expected_seq = 0;
+    static unsigned long crc_errors = 0;
+    static unsigned long lost_frames = 0;
+    uint8_t frame[kMaxEncoded];
+
+    if (len == 0)
+    {
+        return;
+    }
+    size_t frame_len = cobs_decode(data, len, frame, sizeof(frame));
+    if (frame_len != kTelemetryFrameSize
+            || frame[kTelemetryOffVersion] != kTelemetryVersion)
+    {
+        print_text(data, len);
+        return;
+    }
+    if (stm32_crc32(frame, kTelemetryPayloadSize / 4)
+            != get_u32(&frame[kTelemetryPayloadSize]))
+    {
+        printf("# CRC error (%lu)\n", ++crc_errors);
+        return;
+    }
+
+    uint16_t seq = get_u16(&frame[kTelemetryOffSeq]);
+    uint16_t gap = seq - expected_seq;
+    if (have_seq && gap != 0)
+    {
+        if (gap >= 0x8000)
+        {
+            printf("# sequence restarted (controller reset?)\n");
+        }
+        else
+        {
+            lost_frames += gap;
+            printf("# lost %u frame(s), total %lu\n", gap, lost_frames);
+        }
+    }
+    have_seq = true;
+    expected_seq = seq + 1;
+
+    uint8_t gates = frame[kTelemetryOffGates];
+    printf("seq=%u t=%.6f occ=%u/%u echo_in=%uus echo_out=%uus "
+            "gate_in=%s gate_out=%s echo_drop=%u tx_rej=%u rx_trunc=%u "
+            "load=%.1f%% wakeups=%u\n",
+            seq, get_u32(&frame[kTelemetryOffTimestamp]) / 1e6,
+            frame[kTelemetryOffOccupied], frame[kTelemetryOffCapacity],
+            get_u16(&frame[kTelemetryOffEntryEcho]),
+            get_u16(&frame[kTelemetryOffExitEcho]), gate_name(gates & 0x0F),
+            gate_name(gates >> 4), get_u16(&frame[kTelemetryOffEchoDropped]),
+            get_u16(&frame[kTelemetryOffTxRejected]),
+            get_u16(&frame[kTelemetryOffRxTruncated]),
+            get_u16(&frame[kTelemetryOffCpuLoad]) / 10.0,
+            get_u16(&frame[kTelemetryOffWakeups]));
+}
+
+static void configure_tty(int fd)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        return; // 一般檔案或 pipe
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B9600);
+    cfsetospeed(&tio, B9600);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+int main(int argc, char **argv)
+{
+    int fd = STDIN_FILENO;
+    uint8_t chunk[kMaxEncoded];
+    size_t chunk_len = 0;
+    uint8_t buf[512];
+    ssize_t n;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [device|file]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && (fd = open(argv[1], O_RDONLY | O_NOCTTY)) < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    configure_tty(fd);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+    {
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (buf[i] == 0)
+            {
+                handle_chunk(chunk, chunk_len);
+                chunk_len = 0;
+                continue;
+            }
+            chunk[chunk_len++] = buf[i];
+            if (is_text_line(chunk, chunk_len))
+            {
+                print_text(chunk, chunk_len);
+                chunk_len = 0;
+            }
+            else if (chunk_len == sizeof(chunk))
+            {
+                // 比任何 frame 都長：文字照常輸出，其他的回報後丟棄
+                if (is_text(chunk, chunk_len))
+                {
+                    print_text(chunk, chunk_len);
+                }
+                else
+                {
+                    printf("# %zu bytes without a frame delimiter\n", chunk_len);
+                }
+                chunk_len = 0;
+            }
+        }
+    }
+    handle_chunk(chunk, chunk_len);
+    return 0;
+}
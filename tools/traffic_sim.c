@@ -0,0 +1,952 @@
+/*
+ * 停車場車流 Monte Carlo 模擬 (Linux, pthreads)
+ *
+ * 直接以韌體的 parking.c / gate.c 當控制器，模擬大量互相獨立的停車場：
+ * 車輛到達 (Poisson) 與停留 (指數分佈)、感測器雜訊 / 漏波 / 鬼影、跟車，
+ * 分散到所有 CPU 核心平行執行，統計吞吐量、漏偵測、誤偵測、
+ * 等待閘門的延遲分位數與計數誤差。可對任何參數做掃描。
+ *
+ * 用法:
+ *   traffic_sim [-n 座數] [-H 小時] [-j 執行緒] [-s 種子] [-c]
+ *               [參數=值[,值...]] ...
+ *
+ *   給多個值的參數會展開成所有組合，每個組合各跑 -n 座停車場；
+ *   各組合的第 i 座使用相同的亂數種子，差異只來自參數本身。
+ *   -c 以 CSV 輸出。參數與預設值見 traffic_sim -h。
+ *
+ *   例：traffic_sim -n 2000 servo_delay_ms=450,1500,3000 idle_gap_ms=200,500,2000
+ *
+ * 車輛模型 (入口與出口相同)：
+ *   排到隊伍最前面的車停在感測器前 (0.3 ~ 0.9 m)，閘門完全開啟後
+ *   經過反應時間 (reaction_ms 的 0.5 ~ 1.5 倍) 才駛過柵欄；若那時閘門已在
+ *   關閉，車子繼續等待。控制器偵測到車就計數，閘門不會為同一台車再開，
+ *   所以反應時間比閘門全開的時間長時車子過不去、計數卻已增加 (late/h、drift)。
+ *   駛過後車身還要 clear_ms 才離開感測範圍 (期間的回波仍會量到車)。
+ *   等待超過 patience_s 的車會離開。
+ *
+ * 待辦：servo_delay_ms 預設沿用韌體的 kServoDelay (450 ms，全開只有 300 ms)。
+ * 在預設 reaction_ms=1000 下多數駕駛來不及通過，in/h 接近 0、drift 持續增加；
+ * servo_delay_ms=1500 時 in/h 約 8，2000 以上約 12.7 (-n 200)。是否把
+ * kServoDelay 提高到 kServoTravel + 1.5 × 反應時間需另外提出、在實車上確認，
+ * 這裡不改韌體，要比較時請用 servo_delay_ms 掃描。
+ *
+ * 編譯:
+ *   cc -O2 -pthread -I../projects/common/Inc -I../projects/5/Inc -o traffic_sim traffic_sim.c \
+ *      ../projects/5/Src/parking.c ../projects/5/Src/presence.c \
+ *      ../projects/5/Src/gate.c -lm
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "parking.h"
+
+#define kMaxValues 16
+#define kMaxConfigs 4096
+#define kMaxQueue 64
+#define kMaxCapacity 99          // 與 CAP 指令的上限相同
+#define kWaitBinUs 100000        // 等待時間直方圖的解析度 (100 ms)
+#define kWaitBins 6000           // 最長 600 s，超過的算在最後一格
+#define kSoundSpeed 343.0
+#define kSensorRange 4.0         // 超過量程 (或漏波) 時 Echo 為 38 ms
+#define kNoEchoUs 38000
+#define kEchoDelayUs 510         // Trig 10 us + 發波約 500 us
+#define kBackground 3.0          // 車道淨空時量到的距離 (m)
+#define kUsPerHour 3600000000ULL
+#define kReactionSpread 1.5      // 反應時間為平均值的 0.5 ~ 1.5 倍
+
+typedef enum
+{
+    P_IDLE_GAP_MS = 0,
+    P_ACTIVE_GAP_MS,
+    P_SERVO_DELAY_MS,
+    P_SERVO_TRAVEL_MS,
+    P_CAPACITY,
+    P_ARRIVALS,
+    P_DWELL_MIN,
+    P_NOISE_CM,
+    P_DROPOUT,
+    P_GHOST,
+    P_TAILGATE,
+    P_REACTION_MS,
+    P_CLEAR_MS,
+    P_PULLUP_MS,
+    P_PATIENCE_S,
+    P_COUNT
+} param_id_t;
+
+typedef struct
+{
+    const char *name;
+    double value;
+    const char *help;
+} param_t;
+
+static const param_t kParams[P_COUNT] =
+{
+    { "idle_gap_ms", kIdleGap / 1000, "淨空時的量測間隔 (kIdleGap)" },
+    { "active_gap_ms", kActiveGap / 1000, "有車時的量測間隔 (kActiveGap)" },
+    { "servo_delay_ms", kServoDelay, "閘門開啟到關閉的時間 (kServoDelay)" },
+    { "servo_travel_ms", kServoTravel, "Servo 轉動時間 (kServoTravel)" },
+    { "capacity", kDefaultCapacity, "停車格數" },
+    { "arrivals", 30, "每小時到達的車輛數" },
+    { "dwell_min", 120, "平均停留時間 (分)" },
+    { "noise_cm", 2, "距離量測雜訊標準差 (cm)" },
+    { "dropout", 2, "每次量測漏波的機率 (%)" },
+    { "ghost", 0.5, "每次量測出現隨機距離的機率 (%)" },
+    { "tailgate", 5, "閘門開啟時後車跟著通過的機率 (%)" },
+    { "reaction_ms", 1000, "閘門全開到車子駛過柵欄的平均時間" },
+    { "clear_ms", 2500, "駛過後車身離開感測範圍的時間" },
+    { "pullup_ms", 1500, "前車離開後下一台車開到感測器前的時間" },
+    { "patience_s", 120, "等待多久後放棄離開 (s)" },
+};
+
+typedef struct
+{
+    double values[P_COUNT];
+} config_t;
+
+typedef struct
+{
+    uint64_t arrivals;       // 到達入口的車輛
+    uint64_t entered;
+    uint64_t exited;
+    uint64_t turned_away;    // 停車場已滿而放棄
+    uint64_t abandoned;      // 還有空位卻等不到閘門而放棄
+    uint64_t missed;         // 有空位卻從未被計數就離開感測器前的車 (不含跟車)
+    uint64_t false_detect;   // 沒有等待中的車卻判定有車 (鬼影、重複計數)
+    uint64_t tailgaters;
+    uint64_t missed_gate;    // 車子抵達柵欄時閘門已在關閉
+    uint64_t drift;          // 結束時 |控制器計數 - 實際車數| 的總和
+    uint64_t lots;
+    uint64_t wait_count;
+    uint64_t wait_sum_us;
+    uint64_t wait_hist[kWaitBins];
+} stats_t;
+
+// ------------------------------------------------------------
+// 亂數 (每座停車場各自一個產生器，結果與執行緒數量無關)
+// ------------------------------------------------------------
+
+typedef struct
+{
+    uint64_t state;
+} rng_t;
+
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double rng_uniform(rng_t *rng)
+{
+    return (splitmix64(&rng->state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static bool rng_chance(rng_t *rng, double percent)
+{
+    return rng_uniform(rng) * 100.0 < percent;
+}
+
+static double rng_exponential(rng_t *rng, double mean)
+{
+    return -log(1.0 - rng_uniform(rng)) * mean;
+}
+
+static double rng_gaussian(rng_t *rng, double sigma)
+{
+    double u = 1.0 - rng_uniform(rng);
+    double v = rng_uniform(rng);
+
+    return sigma * sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// ------------------------------------------------------------
+// 單一停車場
+// ------------------------------------------------------------
+
+typedef enum
+{
+    LANE_EMPTY = 0,
+    LANE_WAITING,    // 車停在感測器前
+    LANE_REACTING,   // 閘門已開，駕駛正要駛過
+    LANE_CLEARING,   // 已駛過柵欄，車身還在感測範圍內
+    LANE_PULLING     // 前車已離開，下一台車正開到感測器前
+} lane_phase_t;
+
+typedef struct
+{
+    gate_t *gate;
+    uint64_t queue[kMaxQueue]; // 排隊車輛到達的時間
+    uint8_t queue_head;
+    uint8_t queue_len;
+    lane_phase_t phase;
+    uint64_t phase_until;      // REACTING / CLEARING / PULLING 結束的時間
+    uint64_t head_since;       // 最前面的車到達感測器前的時間
+    double car_distance;
+    bool detected;             // 最前面的車已被計數
+    bool missed_read;          // 最前面的車有空位時曾被量成沒車
+    bool echo_pending;
+    uint64_t echo_at;
+    uint32_t echo_width_us;
+} lane_t;
+
+typedef struct
+{
+    const config_t *config;
+    rng_t rng;
+    stats_t *stats;
+    uint64_t now;
+
+    volatile int remaining_spaces;
+    int capacity;
+    int8_t temperature_c;
+    gate_t entry_gate;
+    gate_t exit_gate;
+    uint16_t entry_ccr;        // 取代 TIM1/TIM2 的 CCR1
+    uint16_t exit_ccr;
+    parking_t parking;
+
+    lane_t lanes[ECHO_SENSOR_COUNT];
+    uint64_t next_arrival;
+    uint64_t leave_at[kMaxCapacity + kMaxQueue]; // 停在場內的車何時要離開
+    uint16_t parked;
+} lot_t;
+
+static double param(const lot_t *lot, param_id_t id)
+{
+    return lot->config->values[id];
+}
+
+static uint64_t ms_to_us(double ms)
+{
+    return ms <= 0 ? 0 : (uint64_t) (ms * 1000.0);
+}
+
+static void lane_push(lot_t *lot, lane_t *lane)
+{
+    lane->queue[(lane->queue_head + lane->queue_len) % kMaxQueue] = lot->now;
+    lane->queue_len++;
+}
+
+// 隊伍最前面換人：下一台車開到感測器前
+static void lane_next_car(lot_t *lot, lane_t *lane)
+{
+    lane->detected = false;
+    lane->missed_read = false;
+    if (lane->queue_len == 0)
+    {
+        lane->phase = LANE_EMPTY;
+        return;
+    }
+    lane->phase = LANE_WAITING;
+    lane->head_since = lot->now;
+    lane->car_distance = 0.3 + 0.6 * rng_uniform(&lot->rng);
+}
+
+// 最前面的車離開感測器前 (通過閘門或放棄)
+static void lane_pop(lot_t *lot, lane_t *lane)
+{
+    if (lane->missed_read && !lane->detected)
+    {
+        lot->stats->missed++;
+    }
+    lane->queue_head = (lane->queue_head + 1) % kMaxQueue;
+    lane->queue_len--;
+}
+
+// 下一台車需要 pullup_ms 才會停到感測器前
+static void lane_pull_up(lot_t *lot, lane_t *lane)
+{
+    lane->detected = false;
+    lane->missed_read = false;
+    lane->phase = lane->queue_len > 0 ? LANE_PULLING : LANE_EMPTY;
+    lane->phase_until = lot->now + ms_to_us(param(lot, P_PULLUP_MS));
+}
+
+static void record_wait(lot_t *lot, uint64_t wait_us)
+{
+    uint64_t bin = wait_us / kWaitBinUs;
+
+    lot->stats->wait_count++;
+    lot->stats->wait_sum_us += wait_us;
+    lot->stats->wait_hist[bin < kWaitBins ? bin : kWaitBins - 1]++;
+}
+
+// 一台車通過柵欄 (入口進場、出口離場)
+static void car_passed(lot_t *lot, uint8_t sensor)
+{
+    if (sensor == ECHO_ENTRY)
+    {
+        lot->stats->entered++;
+        lot->leave_at[lot->parked++] = lot->now
+                + ms_to_us(rng_exponential(&lot->rng,
+                        param(lot, P_DWELL_MIN) * 60000.0));
+    }
+    else
+    {
+        lot->stats->exited++;
+    }
+}
+
+static void lane_commit(lot_t *lot, uint8_t sensor)
+{
+    lane_t *lane = &lot->lanes[sensor];
+
+    lane->phase = LANE_CLEARING;
+    lane->phase_until = lot->now + ms_to_us(param(lot, P_CLEAR_MS));
+    record_wait(lot, lot->now - lane->head_since);
+    lane_pop(lot, lane);
+    car_passed(lot, sensor);
+    lane->missed_read = false;
+
+    // 跟車：後面那台不經偵測直接一起通過
+    if (lane->queue_len > 0 && rng_chance(&lot->rng, param(lot, P_TAILGATE))
+            && (sensor == ECHO_EXIT || lot->parked < kMaxCapacity + kMaxQueue))
+    {
+        lot->stats->tailgaters++;
+        record_wait(lot, lot->now - lane->queue[lane->queue_head]);
+        lane_pop(lot, lane);
+        car_passed(lot, sensor);
+    }
+}
+
+static void lane_update(lot_t *lot, uint8_t sensor)
+{
+    lane_t *lane = &lot->lanes[sensor];
+    gate_state_t gate = lane->gate->state;
+
+    if (lane->phase == LANE_EMPTY && lane->queue_len > 0)
+    {
+        lane_next_car(lot, lane);
+    }
+    if (lane->phase == LANE_CLEARING && lot->now >= lane->phase_until)
+    {
+        lane_pull_up(lot, lane);
+    }
+    if (lane->phase == LANE_PULLING && lot->now >= lane->phase_until)
+    {
+        lane_next_car(lot, lane);
+    }
+    if (lane->phase == LANE_REACTING && lot->now >= lane->phase_until)
+    {
+        // leave_at 已滿 (控制器計數早已嚴重偏差) 時不再讓車進場
+        bool room = sensor == ECHO_EXIT || lot->parked < kMaxCapacity + kMaxQueue;
+        if (gate == GATE_OPEN && room)
+        {
+            lane_commit(lot, sensor);
+            return;
+        }
+        lot->stats->missed_gate++;
+        lane->phase = LANE_WAITING;
+    }
+    if (lane->phase != LANE_WAITING)
+    {
+        return;
+    }
+    if (gate == GATE_OPEN)
+    {
+        double reaction = param(lot, P_REACTION_MS)
+                * (kReactionSpread - 1.0 + rng_uniform(&lot->rng));
+        lane->phase = LANE_REACTING;
+        lane->phase_until = lot->now + ms_to_us(reaction);
+    }
+    else if (lot->now - lane->head_since >= ms_to_us(param(lot, P_PATIENCE_S) * 1000.0))
+    {
+        if (sensor == ECHO_ENTRY)
+        {
+            if (lot->remaining_spaces > 0)
+            {
+                lot->stats->abandoned++;
+            }
+            else
+            {
+                lot->stats->turned_away++;
+            }
+        }
+        else
+        {
+            // 出口不會有人放棄，只是一直等；這裡視為被迫離開 (例如按鈕) 並計入
+            lot->stats->abandoned++;
+            lot->stats->exited++;
+        }
+        lane_pop(lot, lane);
+        lane_pull_up(lot, lane);
+    }
+}
+
+// 送出 Trig：依目前車道上的情況產生一筆回波
+static void trigger(lot_t *lot, uint8_t sensor)
+{
+    lane_t *lane = &lot->lanes[sensor];
+    bool empty = lane->phase == LANE_EMPTY || lane->phase == LANE_PULLING;
+    double distance = empty ? kBackground : lane->car_distance;
+    uint32_t width_us;
+
+    distance += rng_gaussian(&lot->rng, param(lot, P_NOISE_CM) / 100.0);
+    if (rng_chance(&lot->rng, param(lot, P_GHOST)))
+    {
+        distance = 0.1 + (kSensorRange - 0.1) * rng_uniform(&lot->rng);
+    }
+    if (rng_chance(&lot->rng, param(lot, P_DROPOUT)) || distance > kSensorRange)
+    {
+        width_us = kNoEchoUs;
+    }
+    else
+    {
+        width_us = (uint32_t) (fmax(distance, 0.02) * 2.0 / kSoundSpeed * 1e6);
+    }
+    lane->echo_pending = true;
+    lane->echo_at = lot->now + kEchoDelayUs + width_us;
+    lane->echo_width_us = width_us;
+}
+
+static void echo_done(lot_t *lot, uint8_t sensor)
+{
+    lane_t *lane = &lot->lanes[sensor];
+    bool car_waiting = (lane->phase == LANE_WAITING || lane->phase == LANE_REACTING)
+            && !lane->detected;
+    bool has_room = sensor == ECHO_ENTRY ? lot->remaining_spaces > 0 :
+            lot->remaining_spaces < lot->capacity;
+
+    lane->echo_pending = false;
+    if (parking_on_echo(&lot->parking, sensor, lane->echo_width_us,
+            (uint32_t) lot->now))
+    {
+        if (car_waiting)
+        {
+            lane->detected = true;
+        }
+        else
+        {
+            lot->stats->false_detect++;
+        }
+    }
+    else if (car_waiting && has_room)
+    {
+        lane->missed_read = true;
+    }
+}
+
+// 韌體的 32-bit 時間點換算成模擬的 64-bit 時間
+static uint64_t to_sim_time(const lot_t *lot, uint32_t deadline_us)
+{
+    int32_t ahead = (int32_t) (deadline_us - (uint32_t) lot->now);
+
+    return ahead > 0 ? lot->now + ahead : lot->now;
+}
+
+static uint64_t next_event(const lot_t *lot)
+{
+    uint64_t next = lot->next_arrival;
+    uint64_t trigger = to_sim_time(lot, parking_next_trigger(&lot->parking));
+    uint32_t deadline;
+
+    next = trigger < next ? trigger : next;
+    for (uint16_t i = 0; i < lot->parked; i++)
+    {
+        next = lot->leave_at[i] < next ? lot->leave_at[i] : next;
+    }
+    for (uint8_t sensor = 0; sensor < ECHO_SENSOR_COUNT; sensor++)
+    {
+        const lane_t *lane = &lot->lanes[sensor];
+
+        if (lane->echo_pending && lane->echo_at < next)
+        {
+            next = lane->echo_at;
+        }
+        if ((lane->phase == LANE_REACTING || lane->phase == LANE_CLEARING
+                || lane->phase == LANE_PULLING) && lane->phase_until < next)
+        {
+            next = lane->phase_until;
+        }
+        if (lane->phase == LANE_WAITING)
+        {
+            uint64_t give_up = lane->head_since
+                    + ms_to_us(param(lot, P_PATIENCE_S) * 1000.0);
+            next = give_up < next ? give_up : next;
+        }
+        if (gate_next_deadline(lane->gate, &deadline))
+        {
+            uint64_t t = to_sim_time(lot, deadline);
+            next = t < next ? t : next;
+        }
+    }
+    return next;
+}
+
+static void run_lot(const config_t *config, uint64_t seed, uint64_t duration_us,
+        stats_t *stats)
+{
+    lot_t *lot = calloc(1, sizeof(*lot));
+    double arrival_mean_us = kUsPerHour / config->values[P_ARRIVALS];
+
+    if (lot == NULL)
+    {
+        perror("calloc");
+        exit(1);
+    }
+    lot->config = config;
+    lot->rng.state = seed;
+    lot->stats = stats;
+    lot->capacity = (int) config->values[P_CAPACITY];
+    lot->remaining_spaces = lot->capacity;
+    lot->temperature_c = kDefaultTemperature; // 與 kSoundSpeed 相符
+
+    uint32_t travel_us = ms_to_us(config->values[P_SERVO_TRAVEL_MS]);
+    uint32_t delay_us = ms_to_us(config->values[P_SERVO_DELAY_MS]);
+    uint32_t hold_us = delay_us > travel_us ? delay_us - travel_us : 0;
+    gate_init(&lot->entry_gate, &lot->entry_ccr, 1500, 2500, travel_us, hold_us);
+    gate_init(&lot->exit_gate, &lot->exit_ccr, 1500, 500, travel_us, hold_us);
+    lot->parking = (parking_t) { .remaining_spaces = &lot->remaining_spaces,
+            .capacity = &lot->capacity, .entry_gate = &lot->entry_gate,
+            .exit_gate = &lot->exit_gate,
+            .idle_gap_us = ms_to_us(config->values[P_IDLE_GAP_MS]),
+            .active_gap_us = ms_to_us(config->values[P_ACTIVE_GAP_MS]),
+            .temperature_c = &lot->temperature_c };
+    parking_init(&lot->parking, 0);
+    lot->lanes[ECHO_ENTRY].gate = &lot->entry_gate;
+    lot->lanes[ECHO_EXIT].gate = &lot->exit_gate;
+    lot->next_arrival = ms_to_us(rng_exponential(&lot->rng, arrival_mean_us) / 1000.0);
+
+    while ((lot->now = next_event(lot)) < duration_us)
+    {
+        // --- 外在世界：到達、離場、車子移動 ---
+        if (lot->now >= lot->next_arrival)
+        {
+            lane_t *entry = &lot->lanes[ECHO_ENTRY];
+            stats->arrivals++;
+            if (entry->queue_len < kMaxQueue)
+            {
+                lane_push(lot, entry);
+            }
+            else
+            {
+                stats->turned_away++;
+            }
+            lot->next_arrival = lot->now
+                    + ms_to_us(rng_exponential(&lot->rng, arrival_mean_us) / 1000.0);
+        }
+        for (uint16_t i = 0; i < lot->parked; i++)
+        {
+            lane_t *exit = &lot->lanes[ECHO_EXIT];
+            if (lot->leave_at[i] <= lot->now && exit->queue_len < kMaxQueue)
+            {
+                lane_push(lot, exit);
+                lot->leave_at[i--] = lot->leave_at[--lot->parked];
+            }
+        }
+
+        // --- 控制器：與 main.c 主迴圈相同的順序 ---
+        uint8_t due = parking_poll_due(&lot->parking, (uint32_t) lot->now);
+        for (uint8_t sensor = 0; sensor < ECHO_SENSOR_COUNT; sensor++)
+        {
+            if ((due & (1U << sensor)) != 0)
+            {
+                trigger(lot, sensor);
+            }
+            if (lot->lanes[sensor].echo_pending && lot->lanes[sensor].echo_at <= lot->now)
+            {
+                echo_done(lot, sensor);
+            }
+        }
+        gate_update(&lot->entry_gate, (uint32_t) lot->now);
+        gate_update(&lot->exit_gate, (uint32_t) lot->now);
+
+        for (uint8_t sensor = 0; sensor < ECHO_SENSOR_COUNT; sensor++)
+        {
+            lane_update(lot, sensor);
+        }
+    }
+
+    int counted = lot->capacity - lot->remaining_spaces;
+    int actual = lot->parked;
+    stats->drift += counted > actual ? counted - actual : actual - counted;
+    stats->lots++;
+    free(lot);
+}
+
+// ------------------------------------------------------------
+// 平行執行
+// ------------------------------------------------------------
+
+typedef struct
+{
+    const config_t *configs;
+    stats_t *results;
+    pthread_mutex_t *locks;
+    uint32_t config_count;
+    uint32_t lots;
+    uint64_t duration_us;
+    uint64_t seed;
+    uint32_t next_job; // 以 __atomic 存取
+} job_queue_t;
+
+static void merge(stats_t *into, const stats_t *from)
+{
+    const uint64_t *src = (const uint64_t *) from;
+    uint64_t *dst = (uint64_t *) into;
+
+    for (size_t i = 0; i < sizeof(stats_t) / sizeof(uint64_t); i++)
+    {
+        dst[i] += src[i];
+    }
+}
+
+static void *worker(void *arg)
+{
+    job_queue_t *queue = arg;
+    stats_t *local = malloc(sizeof(*local));
+    uint32_t total = queue->config_count * queue->lots;
+
+    if (local == NULL)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    for (;;)
+    {
+        uint32_t job = __atomic_fetch_add(&queue->next_job, 1, __ATOMIC_RELAXED);
+        if (job >= total)
+        {
+            break;
+        }
+        uint32_t config = job / queue->lots;
+        uint64_t seed = queue->seed + job % queue->lots;
+
+        memset(local, 0, sizeof(*local));
+        run_lot(&queue->configs[config], splitmix64(&seed), queue->duration_us,
+                local);
+        pthread_mutex_lock(&queue->locks[config]);
+        merge(&queue->results[config], local);
+        pthread_mutex_unlock(&queue->locks[config]);
+    }
+    free(local);
+    return NULL;
+}
+
+// ------------------------------------------------------------
+// 參數、輸出
+// ------------------------------------------------------------
+
+typedef struct
+{
+    double values[kMaxValues];
+    uint8_t count;
+} sweep_t;
+
+static double percentile_s(const stats_t *stats, double fraction)
+{
+    uint64_t target = (uint64_t) ceil(stats->wait_count * fraction);
+    uint64_t seen = 0;
+
+    for (uint32_t bin = 0; bin < kWaitBins; bin++)
+    {
+        seen += stats->wait_hist[bin];
+        if (seen >= target && seen > 0)
+        {
+            return (bin + 1) * (kWaitBinUs / 1e6); // 該格的上界
+        }
+    }
+    return 0;
+}
+
+static void print_result(const config_t *config, const stats_t *stats,
+        const sweep_t *sweeps, double hours, bool csv)
+{
+    double lot_hours = stats->lots * hours;
+    double per_hour[] =
+    {
+        stats->entered / lot_hours, stats->exited / lot_hours,
+        stats->turned_away / lot_hours, stats->abandoned / lot_hours,
+        stats->missed / lot_hours, stats->false_detect / lot_hours,
+        stats->tailgaters / lot_hours, stats->missed_gate / lot_hours,
+    };
+    double drift = (double) stats->drift / stats->lots;
+    double mean_wait = stats->wait_count == 0 ? 0 :
+            stats->wait_sum_us / 1e6 / stats->wait_count;
+
+    for (int p = 0; p < P_COUNT; p++)
+    {
+        if (sweeps[p].count > 1)
+        {
+            printf(csv ? "%g," : "%10g ", config->values[p]);
+        }
+    }
+    for (size_t i = 0; i < sizeof(per_hour) / sizeof(per_hour[0]); i++)
+    {
+        printf(csv ? "%.3f," : "%8.2f ", per_hour[i]);
+    }
+    printf(csv ? "%.3f,%.2f,%.1f,%.1f,%.1f\n" : "%6.2f %6.1f %6.1f %6.1f %6.1f\n",
+            drift, mean_wait, percentile_s(stats, 0.5), percentile_s(stats, 0.9),
+            percentile_s(stats, 0.99));
+}
+
+static void print_header(const sweep_t *sweeps, bool csv)
+{
+    static const char *const kColumns[] =
+    {
+        "in/h", "out/h", "full/h", "quit/h", "miss/h", "false/h", "tail/h",
+        "late/h", "drift", "wait", "p50", "p90", "p99"
+    };
+
+    for (int p = 0; p < P_COUNT; p++)
+    {
+        if (sweeps[p].count > 1)
+        {
+            printf(csv ? "%s," : "%10.10s ", kParams[p].name);
+        }
+    }
+    for (size_t i = 0; i < sizeof(kColumns) / sizeof(kColumns[0]); i++)
+    {
+        bool last = i + 1 == sizeof(kColumns) / sizeof(kColumns[0]);
+        if (csv)
+        {
+            printf("%s%s", kColumns[i], last ? "\n" : ",");
+        }
+        else
+        {
+            printf(i < 8 ? "%8s " : "%6s%s", kColumns[i], last ? "\n" : " ");
+        }
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n lots] [-H hours] [-j threads] [-s seed] [-c]"
+            " [param=value[,value...]]...\n\nparameters:\n", name);
+    for (int p = 0; p < P_COUNT; p++)
+    {
+        fprintf(stderr, "  %-16s %8g  %s\n", kParams[p].name, kParams[p].value,
+                kParams[p].help);
+    }
+    fprintf(stderr, "\ncolumns (per lot and hour unless noted):\n"
+            "  in/h out/h   cars through the entry / exit gate\n"
+            "  full/h       cars that gave up because the lot was full\n"
+            "  quit/h       cars that gave up although there was room\n"
+            "  miss/h       cars that left the sensor uncounted although there was room\n"
+            "  false/h      detections without a waiting car (ghosts, double counts)\n"
+            "  tail/h       cars that followed another one through the gate\n"
+            "  late/h       cars that reached the barrier after it started closing\n"
+            "  drift        mean |counted - actual| cars at the end of a run\n"
+            "  wait p50..   seconds from reaching the sensor to passing the gate\n");
+    exit(2);
+}
+
+static void parse_sweep(const char *arg, sweep_t *sweeps)
+{
+    const char *eq = strchr(arg, '=');
+    int p;
+
+    for (p = 0; eq != NULL && p < P_COUNT; p++)
+    {
+        if (strlen(kParams[p].name) == (size_t) (eq - arg)
+                && strncmp(arg, kParams[p].name, eq - arg) == 0)
+        {
+            break;
+        }
+    }
+    if (eq == NULL || p == P_COUNT)
+    {
+        fprintf(stderr, "unknown parameter: %s\n", arg);
+        exit(2);
+    }
+
+    const char *s = eq + 1;
+    sweeps[p].count = 0;
+    while (*s != '\0')
+    {
+        char *end;
+        double value = strtod(s, &end);
+        if (end == s || (*end != ',' && *end != '\0')
+                || sweeps[p].count >= kMaxValues)
+        {
+            fprintf(stderr, "bad value list: %s\n", arg);
+            exit(2);
+        }
+        sweeps[p].values[sweeps[p].count++] = value;
+        s = *end == ',' ? end + 1 : end;
+    }
+    if (sweeps[p].count == 0)
+    {
+        fprintf(stderr, "bad value list: %s\n", arg);
+        exit(2);
+    }
+}
+
+// 最慢的駕駛來不及在閘門關閉前駛過
+static bool gate_too_short(const config_t *config)
+{
+    const double *v = config->values;
+
+    return v[P_REACTION_MS] * kReactionSpread
+            >= v[P_SERVO_DELAY_MS] - v[P_SERVO_TRAVEL_MS];
+}
+
+static bool valid(const config_t *config)
+{
+    const double *v = config->values;
+
+    return v[P_IDLE_GAP_MS] >= 1 && v[P_ACTIVE_GAP_MS] >= 1
+            && v[P_CAPACITY] >= 1 && v[P_CAPACITY] <= kMaxCapacity
+            && v[P_SERVO_DELAY_MS] >= 0 && v[P_SERVO_TRAVEL_MS] >= 0
+            && v[P_ARRIVALS] > 0 && v[P_DWELL_MIN] > 0 && v[P_PATIENCE_S] > 0;
+}
+
+int main(int argc, char **argv)
+{
+    sweep_t sweeps[P_COUNT];
+    static config_t configs[kMaxConfigs];
+    uint32_t config_count = 1;
+    uint32_t lots = 1000;
+    double hours = 8;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = 1;
+    bool csv = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:H:j:s:ch")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            lots = strtoul(optarg, NULL, 0);
+            break;
+        case 'H':
+            hours = atof(optarg);
+            break;
+        case 'j':
+            threads = strtol(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'c':
+            csv = true;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (lots == 0 || hours <= 0 || threads <= 0)
+    {
+        usage(argv[0]);
+    }
+
+    for (int p = 0; p < P_COUNT; p++)
+    {
+        sweeps[p].values[0] = kParams[p].value;
+        sweeps[p].count = 1;
+    }
+    for (int i = optind; i < argc; i++)
+    {
+        parse_sweep(argv[i], sweeps);
+    }
+
+    // 展開所有組合 (最後一個參數變化最快)
+    for (int p = 0; p < P_COUNT; p++)
+    {
+        if (config_count * sweeps[p].count > kMaxConfigs)
+        {
+            fprintf(stderr, "too many combinations (max %d)\n", kMaxConfigs);
+            return 2;
+        }
+        config_count *= sweeps[p].count;
+    }
+    for (uint32_t c = 0; c < config_count; c++)
+    {
+        uint32_t index = c;
+        for (int p = P_COUNT - 1; p >= 0; p--)
+        {
+            configs[c].values[p] = sweeps[p].values[index % sweeps[p].count];
+            index /= sweeps[p].count;
+        }
+        if (!valid(&configs[c]))
+        {
+            fprintf(stderr, "invalid parameter combination #%u\n", c);
+            return 2;
+        }
+    }
+
+    stats_t *results = calloc(config_count, sizeof(stats_t));
+    pthread_mutex_t *locks = calloc(config_count, sizeof(pthread_mutex_t));
+    pthread_t *workers = calloc(threads, sizeof(pthread_t));
+    if (results == NULL || locks == NULL || workers == NULL)
+    {
+        perror("calloc");
+        return 1;
+    }
+    for (uint32_t c = 0; c < config_count; c++)
+    {
+        pthread_mutex_init(&locks[c], NULL);
+    }
+
+    job_queue_t queue = { configs, results, locks, config_count, lots,
+            (uint64_t) (hours * kUsPerHour), seed, 0 };
+    for (long t = 0; t < threads; t++)
+    {
+        pthread_create(&workers[t], NULL, worker, &queue);
+    }
+    for (long t = 0; t < threads; t++)
+    {
+        pthread_join(workers[t], NULL);
+    }
+
+    bool warned = false;
+    bool warned_firmware = false;
+    for (uint32_t c = 0; c < config_count; c++)
+    {
+        const double *v = configs[c].values;
+
+        if (!gate_too_short(&configs[c]))
+        {
+            continue;
+        }
+        if (!warned)
+        {
+            fprintf(stderr, "note: with reaction_ms up to %g x %g ms some drivers reach "
+                    "the barrier after it starts closing (servo_delay_ms %g - "
+                    "servo_travel_ms %g); they stay counted but never pass\n",
+                    kReactionSpread, v[P_REACTION_MS], v[P_SERVO_DELAY_MS],
+                    v[P_SERVO_TRAVEL_MS]);
+            warned = true;
+        }
+        if (!warned_firmware && v[P_SERVO_DELAY_MS] == kServoDelay)
+        {
+            fprintf(stderr, "note: the firmware's kServoDelay (%d ms) is too short "
+                    "for this reaction time; servo_delay_ms needs at least %g ms\n",
+                    kServoDelay, v[P_SERVO_TRAVEL_MS]
+                    + kReactionSpread * v[P_REACTION_MS]);
+            warned_firmware = true;
+        }
+    }
+    if (!csv)
+    {
+        printf("# %u lots x %g h per row, %ld threads, seed %llu; fixed:",
+                lots, hours, threads, (unsigned long long) seed);
+        for (int p = 0; p < P_COUNT; p++)
+        {
+            if (sweeps[p].count == 1)
+            {
+                printf(" %s=%g", kParams[p].name, sweeps[p].values[0]);
+            }
+        }
+        printf("\n");
+    }
+    print_header(sweeps, csv);
+    for (uint32_t c = 0; c < config_count; c++)
+    {
+        print_result(&configs[c], &results[c], sweeps, hours, csv);
+    }
+    return 0;
+}